@@ -0,0 +1,304 @@
+// NOTE: offline tool that builds the .hha asset pack the game maps at runtime, see handmade_asset_pack.h.
+//
+// usage: asset_packer.exe <output.hha> <asset>...
+//   bitmap <name> <file.bmp>
+//   sound  <name> <file.wav>
+//   font   <name> <atlas.bmp> <first_codepoint> <glyph_width> <glyph_height>
+//
+// Font atlases are a grid of equally sized cells, read left to right and top to bottom. Coverage comes from the alpha
+// channel when the bitmap has one, from the luminance otherwise.
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "base.h"
+#include "handmade_file_formats.h"
+#include "handmade_bitmap.h"
+#include "handmade_asset_pack.h"
+
+#define MAX_ASSET_COUNT 4096
+
+struct Entire_File {
+    uint32_t size;
+    void*    content;
+};
+
+struct Packer {
+    FILE*            out;
+    uint64_t         offset;
+    bool             write_failed;
+    uint32_t         asset_count;
+    Asset_Pack_Entry entries[MAX_ASSET_COUNT];
+};
+
+internal Entire_File
+ReadEntireFile(const char* file_name) {
+    Entire_File result = {};
+
+    FILE* in = fopen(file_name, "rb");
+    if (in) {
+        fseek(in, 0, SEEK_END);
+        result.size = (uint32_t)ftell(in);
+        fseek(in, 0, SEEK_SET);
+
+        result.content = malloc(result.size);
+        if (fread(result.content, result.size, 1, in) != 1) {
+            free(result.content);
+            result = {};
+        }
+        fclose(in);
+    }
+
+    if (!result.content) {
+        fprintf(stderr, "ERROR: unable to read %s\n", file_name);
+    }
+    return result;
+}
+
+// NOTE: decoded and premultiplied the same way the game does it in internal builds, see handmade_bitmap.h
+internal bool
+LoadBMP(const char* file_name, Loaded_Bitmap* result) {
+    bool        loaded = false;
+    Entire_File file   = ReadEntireFile(file_name);
+    if (file.content) {
+        if (BitmapReadBMPSize(file.content, file.size, result)) {
+            result->pitch  = (result->width * 4 + ASSET_PACK_DATA_ALIGNMENT - 1) & ~(ASSET_PACK_DATA_ALIGNMENT - 1);
+            result->memory = calloc(result->height, result->pitch);
+            BitmapDecodeBMP(file.content, result);
+            loaded = true;
+        } else {
+            fprintf(stderr, "ERROR: %s is not an uncompressed 24/32-bit BMP\n", file_name);
+        }
+        free(file.content);
+    }
+    return loaded;
+}
+
+// NOTE: a failed write is only reported at the end, the offsets carry on so the rest of the pack still lines up
+internal void
+WriteBytes(Packer* packer, const void* data, uint64_t size) {
+    if (size && fwrite(data, (size_t)size, 1, packer->out) != 1) {
+        packer->write_failed = true;
+    }
+    packer->offset += size;
+}
+
+internal void
+AlignOutput(Packer* packer) {
+    uint8_t  zeros[ASSET_PACK_DATA_ALIGNMENT] = {};
+    uint64_t misalignment                     = packer->offset % ASSET_PACK_DATA_ALIGNMENT;
+    if (misalignment) {
+        WriteBytes(packer, zeros, ASSET_PACK_DATA_ALIGNMENT - misalignment);
+    }
+}
+
+internal Asset_Pack_Entry*
+BeginAsset(Packer* packer, Asset_Type type, const char* name) {
+    Asset_Pack_Entry* entry = 0;
+    if (packer->asset_count < MAX_ASSET_COUNT) {
+        AlignOutput(packer);
+
+        entry              = &packer->entries[packer->asset_count++];
+        entry->type        = type;
+        entry->data_offset = packer->offset;
+        strncpy(entry->name, name, ASSET_PACK_NAME_LENGTH - 1);
+    } else {
+        fprintf(stderr, "ERROR: too many assets, %s is skipped\n", name);
+    }
+    return entry;
+}
+
+internal void
+EndAsset(Packer* packer, Asset_Pack_Entry* entry) {
+    entry->data_size = packer->offset - entry->data_offset;
+}
+
+internal bool
+PackBitmap(Packer* packer, const char* name, const char* file_name) {
+    Loaded_Bitmap bitmap = {};
+    bool          packed = LoadBMP(file_name, &bitmap);
+    if (packed) {
+        Asset_Pack_Entry* entry = BeginAsset(packer, AssetType_Bitmap, name);
+        if (entry) {
+            entry->bitmap.width  = bitmap.width;
+            entry->bitmap.height = bitmap.height;
+            entry->bitmap.pitch  = bitmap.pitch;
+            WriteBytes(packer, bitmap.memory, (uint64_t)bitmap.pitch * bitmap.height);
+            EndAsset(packer, entry);
+        }
+        free(bitmap.memory);
+    }
+    return packed;
+}
+
+internal bool
+PackSound(Packer* packer, const char* name, const char* file_name) {
+    bool        packed = false;
+    Entire_File file   = ReadEntireFile(file_name);
+    if (file.content) {
+        Wave_Header* header = (Wave_Header*)file.content;
+        Wave_Fmt*    fmt    = 0;
+        void*        data   = 0;
+        uint32_t     size   = 0;
+        bool         is_bad = false;
+        if (file.size >= sizeof(Wave_Header) && header->riff_id == WAVE_ChunkID_RIFF &&
+            header->wave_id == WAVE_ChunkID_WAVE) {
+            // NOTE: a fmt chunk that's cut short or past the end is rejected, a data chunk past the end is cut down to
+            // what the file has, which is what a truncated recording looks like
+            uint64_t offset = sizeof(Wave_Header);
+            while (!is_bad && offset + sizeof(Wave_Chunk) <= file.size) {
+                Wave_Chunk* chunk      = (Wave_Chunk*)((uint8_t*)file.content + offset);
+                uint64_t    chunk_size = chunk->size;
+                uint64_t    remaining  = file.size - offset - sizeof(Wave_Chunk);
+                if (chunk->id == WAVE_ChunkID_fmt) {
+                    fmt    = (Wave_Fmt*)(chunk + 1);
+                    is_bad = chunk_size < sizeof(Wave_Fmt) || chunk_size > remaining;
+                } else if (chunk->id == WAVE_ChunkID_data) {
+                    data = chunk + 1;
+                    size = (uint32_t)(chunk_size < remaining ? chunk_size : remaining);
+                }
+                // NOTE: chunks are padded to an even size
+                offset += sizeof(Wave_Chunk) + ((chunk_size + 1) & ~1ull);
+            }
+        }
+
+        if (!is_bad && fmt && data && fmt->format_tag == 1 && fmt->bits_per_sample == 16 &&
+            (fmt->channel_count == 1 || fmt->channel_count == 2)) {
+            Asset_Pack_Entry* entry = BeginAsset(packer, AssetType_Sound, name);
+            if (entry) {
+                entry->sound.channel_count      = fmt->channel_count;
+                entry->sound.samples_per_second = fmt->samples_per_second;
+                entry->sound.sample_count       = size / (fmt->channel_count * (uint32_t)sizeof(int16_t));
+                WriteBytes(packer, data, entry->sound.sample_count * fmt->channel_count * sizeof(int16_t));
+                EndAsset(packer, entry);
+            }
+            packed = true;
+        } else {
+            fprintf(stderr, "ERROR: %s is not a 16-bit mono/stereo PCM WAV\n", file_name);
+        }
+        free(file.content);
+    }
+    return packed;
+}
+
+internal bool
+PackFont(
+    Packer*     packer,
+    const char* name,
+    const char* file_name,
+    uint32_t    first_codepoint,
+    int         glyph_width,
+    int         glyph_height) {
+
+    Loaded_Bitmap atlas  = {};
+    bool          packed = (glyph_width > 0 && glyph_height > 0) && LoadBMP(file_name, &atlas);
+    if (packed) {
+        int      columns     = atlas.width / glyph_width;
+        int      rows        = atlas.height / glyph_height;
+        uint32_t glyph_count = (uint32_t)(columns * rows);
+        uint8_t* coverage    = (uint8_t*)malloc(glyph_width * glyph_height);
+
+        Asset_Pack_Entry* entry = BeginAsset(packer, AssetType_Font, name);
+        if (entry) {
+            entry->font.first_codepoint = first_codepoint;
+            entry->font.glyph_count     = glyph_count;
+            entry->font.glyph_width     = glyph_width;
+            entry->font.glyph_height    = glyph_height;
+
+            for (uint32_t glyph_idx = 0; glyph_idx < glyph_count; ++glyph_idx) {
+                int origin_x = (glyph_idx % columns) * glyph_width;
+                int origin_y = (glyph_idx / columns) * glyph_height;
+                for (int y = 0; y < glyph_height; ++y) {
+                    uint32_t* row = (uint32_t*)((uint8_t*)atlas.memory + (origin_y + y) * atlas.pitch) + origin_x;
+                    for (int x = 0; x < glyph_width; ++x) {
+                        uint32_t color = row[x];
+                        uint32_t alpha = color >> 24;
+                        if (alpha == 0xFF) {
+                            // NOTE: opaque atlas, use luminance
+                            uint32_t red   = (color >> 16) & 0xFF;
+                            uint32_t green = (color >> 8) & 0xFF;
+                            uint32_t blue  = (color >> 0) & 0xFF;
+                            alpha          = (red * 54 + green * 183 + blue * 19) >> 8;
+                        }
+                        coverage[y * glyph_width + x] = (uint8_t)alpha;
+                    }
+                }
+                WriteBytes(packer, coverage, glyph_width * glyph_height);
+            }
+            EndAsset(packer, entry);
+        }
+        free(coverage);
+        free(atlas.memory);
+    }
+    return packed;
+}
+
+int
+main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <output.hha> [bitmap|sound|font] <name> <file> ...\n", argv[0]);
+        return 1;
+    }
+
+    local_persist Packer packer = {};
+    packer.out                  = fopen(argv[1], "wb");
+    if (!packer.out) {
+        fprintf(stderr, "ERROR: unable to open %s\n", argv[1]);
+        return 1;
+    }
+
+    // NOTE: the header is patched once the index position is known
+    Asset_Pack_Header header = {};
+    WriteBytes(&packer, &header, sizeof(header));
+
+    bool succeeded = true;
+    int  arg_idx   = 2;
+    while (succeeded && arg_idx < argc) {
+        const char* type = argv[arg_idx];
+        if (strcmp(type, "bitmap") == 0 && arg_idx + 2 < argc) {
+            succeeded = PackBitmap(&packer, argv[arg_idx + 1], argv[arg_idx + 2]);
+            arg_idx += 3;
+        } else if (strcmp(type, "sound") == 0 && arg_idx + 2 < argc) {
+            succeeded = PackSound(&packer, argv[arg_idx + 1], argv[arg_idx + 2]);
+            arg_idx += 3;
+        } else if (strcmp(type, "font") == 0 && arg_idx + 5 < argc) {
+            succeeded = PackFont(
+                &packer,
+                argv[arg_idx + 1],
+                argv[arg_idx + 2],
+                (uint32_t)atoi(argv[arg_idx + 3]),
+                atoi(argv[arg_idx + 4]),
+                atoi(argv[arg_idx + 5]));
+            arg_idx += 6;
+        } else {
+            fprintf(stderr, "ERROR: bad asset arguments at '%s'\n", type);
+            succeeded = false;
+        }
+    }
+
+    AlignOutput(&packer);
+    header.magic        = ASSET_PACK_MAGIC;
+    header.version      = ASSET_PACK_VERSION;
+    header.asset_count  = packer.asset_count;
+    header.index_offset = packer.offset;
+    WriteBytes(&packer, packer.entries, packer.asset_count * sizeof(Asset_Pack_Entry));
+    header.file_size = packer.offset;
+
+    fseek(packer.out, 0, SEEK_SET);
+    if (fwrite(&header, sizeof(header), 1, packer.out) != 1) {
+        packer.write_failed = true;
+    }
+    if (fclose(packer.out) != 0 || packer.write_failed) {
+        fprintf(stderr, "ERROR: unable to write %s\n", argv[1]);
+        succeeded = false;
+    }
+
+    if (succeeded) {
+        printf("%s: %u assets, %llu bytes\n", argv[1], packer.asset_count, (unsigned long long)packer.offset);
+    } else {
+        remove(argv[1]);
+    }
+    return succeeded ? 0 : 1;
+}
@@ -19,7 +19,8 @@ typedef double float64_t;
 #endif
 
 // utility macros
-#define ArrayCount(array) (sizeof(array) / sizeof((array)[0]))
+#define ArrayCount(array)           (sizeof(array) / sizeof((array)[0]))
+#define AlignPow2(value, alignment) (((value) + ((alignment) - 1)) & ~((alignment) - 1))
 
 #if COMPILER_MSVC
     #define Trap() __debugbreak()
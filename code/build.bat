@@ -11,8 +11,11 @@ if not exist %build_dir% mkdir %build_dir%
 pushd %build_dir%
 
 set common_compiler_flags=/nologo /MT /GR- /EHa- /Od /Oi /WX /W4 /wd4201 /wd4189 /wd4100 /D BUILD_DEBUG=1 /D HANDMADE_INTERNAL=1 -FC -Z7 
-set common_linker_flags=/opt:ref user32.lib Gdi32.lib Xinput.lib winmm.lib
+set common_linker_flags=/opt:ref user32.lib Gdi32.lib Xinput.lib winmm.lib ws2_32.lib
 
 cl %common_compiler_flags% %code_dir%\handmade.cpp /LD
 cl %common_compiler_flags% %code_dir%\win32_handmade.cpp /link %common_linker_flags%
+cl %common_compiler_flags% %code_dir%\win32_bench.cpp /link %common_linker_flags% /subsystem:console
+cl %common_compiler_flags% %code_dir%\win32_batch.cpp /link %common_linker_flags% /subsystem:console
+cl %common_compiler_flags% %code_dir%\asset_packer.cpp /link /subsystem:console
 popd
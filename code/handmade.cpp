@@ -34,80 +34,794 @@ GameOutputSound(Game_Sound_Output_Buffer* buffer, Game_State* game_state) {
     }
 }
 
+template <typename Pixel>
 internal void
-RenderBitmap(Game_Offscreen_Buffer* buffer, int x_offset, int y_offset) {
+RenderBitmap_(Game_Offscreen_Buffer* buffer, int x_offset, int y_offset) {
     uint8_t* row = (uint8_t*)buffer->memory;
     for (int y = 0; y < buffer->height; ++y) {
-        uint32_t* pixel = (uint32_t*)row;
+        typename Pixel::Type* pixel = (typename Pixel::Type*)row;
 
         for (int x = 0; x < buffer->width; ++x) {
-            // (windows bitmap) byte order: BB GG RR 00
-
             uint8_t blue  = (uint8_t)(y + y_offset);
             uint8_t green = (uint8_t)(x + x_offset);
             uint8_t red   = (uint8_t)(x + y + x_offset + y_offset);
-            *pixel        = (red << 16) | (green << 8) | blue;
+            *pixel        = Pixel::Pack(red, green, blue);
             ++pixel;
         }
 
-        row += buffer->bytes_per_pixel * buffer->width;
+        row += buffer->pitch;
+    }
+}
+
+internal void
+RenderBitmap(Game_Offscreen_Buffer* buffer, int x_offset, int y_offset) {
+    switch (buffer->pixel_format) {
+        case GamePixelFormat_RGB565: {
+            RenderBitmap_<Pixel_RGB565>(buffer, x_offset, y_offset);
+        } break;
+
+        default: {
+            RenderBitmap_<Pixel_BGRX8888>(buffer, x_offset, y_offset);
+        } break;
+    }
+}
+
+// NOTE: a 2x2 dot per entity
+template <typename Pixel>
+internal void
+RenderEntities_(Game_Offscreen_Buffer* buffer, Entity_Store* entities) {
+    typename Pixel::Type color   = Pixel::Pack(255, 255, 255);
+    float32_t            scale_x = (float32_t)buffer->width / GAME_WORLD_WIDTH;
+    float32_t            scale_y = (float32_t)buffer->height / GAME_WORLD_HEIGHT;
+    for (uint32_t entity_idx = 0; entity_idx < entities->count; ++entity_idx) {
+        int x = (int)(scale_x * entities->position_x[entity_idx]);
+        int y = (int)(scale_y * entities->position_y[entity_idx]);
+        if (x < 0 || y < 0 || x + 2 > buffer->width || y + 2 > buffer->height) {
+            continue;
+        }
+
+        uint8_t*              row   = (uint8_t*)buffer->memory + y * buffer->pitch;
+        typename Pixel::Type* pixel = (typename Pixel::Type*)row + x;
+        pixel[0]                    = color;
+        pixel[1]                    = color;
+        pixel                       = (typename Pixel::Type*)(row + buffer->pitch) + x;
+        pixel[0]                    = color;
+        pixel[1]                    = color;
+    }
+}
+
+// NOTE: the glow centered on each entity, blended in linear space so overlapping glows add up like light
+internal void
+RenderEntityGlows(Game_Offscreen_Buffer* buffer, Entity_Store* entities, uint32_t* glow) {
+    Loaded_Bitmap bitmap = {};
+    bitmap.width         = GAME_ENTITY_GLOW_DIM;
+    bitmap.height        = GAME_ENTITY_GLOW_DIM;
+    bitmap.pitch         = GAME_ENTITY_GLOW_DIM * sizeof(uint32_t);
+    bitmap.memory        = glow;
+
+    float32_t scale_x = (float32_t)buffer->width / GAME_WORLD_WIDTH;
+    float32_t scale_y = (float32_t)buffer->height / GAME_WORLD_HEIGHT;
+    for (uint32_t entity_idx = 0; entity_idx < entities->count; ++entity_idx) {
+        int x = (int)(scale_x * entities->position_x[entity_idx]) - GAME_ENTITY_GLOW_DIM / 2;
+        int y = (int)(scale_y * entities->position_y[entity_idx]) - GAME_ENTITY_GLOW_DIM / 2;
+        BlendBitmap(buffer, &bitmap, x, y, BlendMode_Additive);
+    }
+}
+
+// NOTE: dots in RGB565, blending isn't worth it there
+internal void
+RenderEntities(Game_Offscreen_Buffer* buffer, Entity_Store* entities, uint32_t* glow) {
+    switch (buffer->pixel_format) {
+        case GamePixelFormat_RGB565: {
+            RenderEntities_<Pixel_RGB565>(buffer, entities);
+        } break;
+
+        default: {
+            RenderEntityGlows(buffer, entities, glow);
+        } break;
+    }
+}
+
+// NOTE: pale blue, alpha falls off with the square of the distance from the center
+internal void
+MakeEntityGlow(uint32_t* glow) {
+    float32_t radius = 0.5f * GAME_ENTITY_GLOW_DIM;
+    for (int y = 0; y < GAME_ENTITY_GLOW_DIM; ++y) {
+        for (int x = 0; x < GAME_ENTITY_GLOW_DIM; ++x) {
+            float32_t offset_x = (float32_t)x + 0.5f - radius;
+            float32_t offset_y = (float32_t)y + 0.5f - radius;
+            float32_t falloff  = 1.0f - (offset_x * offset_x + offset_y * offset_y) / (radius * radius);
+            falloff            = falloff < 0.0f ? 0.0f : falloff;
+
+            uint32_t alpha                     = (uint32_t)(255.0f * falloff * falloff + 0.5f);
+            glow[y * GAME_ENTITY_GLOW_DIM + x] = BitmapPremultiply((alpha << 24) | (160 << 16) | (200 << 8) | 255);
+        }
+    }
+}
+
+internal uint32_t
+NextRandom(uint32_t* random) {
+    *random ^= *random << 13;
+    *random ^= *random >> 17;
+    *random ^= *random << 5;
+    return *random;
+}
+
+internal void
+SpawnEntities(Entity_Store* entities, uint32_t count) {
+    uint32_t random = 0x12345678;
+    for (uint32_t entity_idx = 0; entity_idx < count; ++entity_idx) {
+        float32_t values[4];
+        for (int value_idx = 0; value_idx < ArrayCount(values); ++value_idx) {
+            values[value_idx] = (float32_t)(NextRandom(&random) & 0xFFFF) / 65535.0f;
+        }
+        EntityAdd(
+            entities,
+            values[0] * GAME_WORLD_WIDTH,
+            values[1] * GAME_WORLD_HEIGHT,
+            200.0f * (values[2] - 0.5f),
+            200.0f * (values[3] - 0.5f));
+    }
+}
+
+// NOTE: rounds towards negative infinity, the camera goes left and up of the origin too
+internal int32_t
+FloorDivide(int32_t numerator, int32_t denominator) {
+    int32_t result = numerator / denominator;
+    if ((numerator % denominator) && ((numerator < 0) != (denominator < 0))) {
+        --result;
+    }
+    return result;
+}
+
+// NOTE: a solid square per filled tile, only the chunks that exist under the camera are looked at
+template <typename Pixel>
+internal void
+RenderTiles_(Game_Offscreen_Buffer* buffer, World* world, int camera_x, int camera_y) {
+    typename Pixel::Type colors[] = {
+        Pixel::Pack(0, 0, 0),
+        Pixel::Pack(192, 176, 112),
+        Pixel::Pack(64, 144, 64),
+        Pixel::Pack(112, 112, 128),
+    };
+
+    World_Chunk_Iterator iterator = WorldIterateChunks(
+        world,
+        FloorDivide(camera_x, GAME_TILE_PIXELS),
+        FloorDivide(camera_y, GAME_TILE_PIXELS),
+        FloorDivide(camera_x + buffer->width - 1, GAME_TILE_PIXELS),
+        FloorDivide(camera_y + buffer->height - 1, GAME_TILE_PIXELS));
+    for (World_Chunk* chunk = WorldNextChunk(&iterator); chunk; chunk = WorldNextChunk(&iterator)) {
+        int chunk_left = chunk->chunk_x * WORLD_CHUNK_DIM * GAME_TILE_PIXELS - camera_x;
+        int chunk_top  = chunk->chunk_y * WORLD_CHUNK_DIM * GAME_TILE_PIXELS - camera_y;
+        for (int tile_y = 0; tile_y < WORLD_CHUNK_DIM; ++tile_y) {
+            for (int tile_x = 0; tile_x < WORLD_CHUNK_DIM; ++tile_x) {
+                uint8_t tile = chunk->tiles[tile_y * WORLD_CHUNK_DIM + tile_x];
+                if (!tile) {
+                    continue;
+                }
+
+                int min_x = chunk_left + tile_x * GAME_TILE_PIXELS;
+                int min_y = chunk_top + tile_y * GAME_TILE_PIXELS;
+                int max_x = min_x + GAME_TILE_PIXELS;
+                int max_y = min_y + GAME_TILE_PIXELS;
+                min_x     = min_x < 0 ? 0 : min_x;
+                min_y     = min_y < 0 ? 0 : min_y;
+                max_x     = max_x > buffer->width ? buffer->width : max_x;
+                max_y     = max_y > buffer->height ? buffer->height : max_y;
+
+                typename Pixel::Type color = colors[tile < ArrayCount(colors) ? tile : ArrayCount(colors) - 1];
+                for (int y = min_y; y < max_y; ++y) {
+                    typename Pixel::Type* pixel = (typename Pixel::Type*)((uint8_t*)buffer->memory + y * buffer->pitch);
+                    for (int x = min_x; x < max_x; ++x) {
+                        pixel[x] = color;
+                    }
+                }
+            }
+        }
+    }
+}
+
+internal void
+RenderTiles(Game_Offscreen_Buffer* buffer, World* world, int camera_x, int camera_y) {
+    switch (buffer->pixel_format) {
+        case GamePixelFormat_RGB565: {
+            RenderTiles_<Pixel_RGB565>(buffer, world, camera_x, camera_y);
+        } break;
+
+        default: {
+            RenderTiles_<Pixel_BGRX8888>(buffer, world, camera_x, camera_y);
+        } break;
+    }
+}
+
+// NOTE: 0 in the mortar between bricks up to 1 a few pixels in, rows of bricks are offset by half a brick. Wraps
+// around so the floor tiles.
+internal float32_t
+FloorHeight(int x, int y) {
+    x           = (x + GAME_FLOOR_DIM) % GAME_FLOOR_DIM;
+    y           = (y + GAME_FLOOR_DIM) % GAME_FLOOR_DIM;
+    int row     = y / GAME_FLOOR_BRICK_HEIGHT;
+    int brick_x = (x + (row & 1) * (GAME_FLOOR_BRICK_WIDTH / 2)) % GAME_FLOOR_BRICK_WIDTH;
+    int brick_y = y % GAME_FLOOR_BRICK_HEIGHT;
+    int edge_x  = brick_x < GAME_FLOOR_BRICK_WIDTH - 1 - brick_x ? brick_x : GAME_FLOOR_BRICK_WIDTH - 1 - brick_x;
+    int edge_y  = brick_y < GAME_FLOOR_BRICK_HEIGHT - 1 - brick_y ? brick_y : GAME_FLOOR_BRICK_HEIGHT - 1 - brick_y;
+    int edge    = edge_x < edge_y ? edge_x : edge_y;
+    return edge >= 3 ? 1.0f : (float32_t)edge / 3.0f;
+}
+
+// NOTE: the normals come from the slope of FloorHeight, each brick gets its own shade of red
+internal void
+MakeFloorSprite(Sprite* floor, Memory_Arena* arena) {
+    Loaded_Bitmap bitmap = {};
+    bitmap.width         = GAME_FLOOR_DIM;
+    bitmap.height        = GAME_FLOOR_DIM;
+    bitmap.pitch         = (int)AlignPow2(GAME_FLOOR_DIM * sizeof(uint32_t), 16);
+    bitmap.memory        = PushSize(arena, (uint64_t)bitmap.pitch * GAME_FLOOR_DIM, MemoryTag_Bitmaps);
+    floor->levels[0]     = bitmap;
+    bitmap.memory        = PushSize(arena, (uint64_t)bitmap.pitch * GAME_FLOOR_DIM, MemoryTag_Bitmaps);
+    floor->normals[0]    = bitmap;
+
+    for (int y = 0; y < GAME_FLOOR_DIM; ++y) {
+        int       row        = y / GAME_FLOOR_BRICK_HEIGHT;
+        uint32_t* color_row  = (uint32_t*)((uint8_t*)floor->levels[0].memory + y * bitmap.pitch);
+        uint32_t* normal_row = (uint32_t*)((uint8_t*)floor->normals[0].memory + y * bitmap.pitch);
+        for (int x = 0; x < GAME_FLOOR_DIM; ++x) {
+            int      column = (x + (row & 1) * (GAME_FLOOR_BRICK_WIDTH / 2)) / GAME_FLOOR_BRICK_WIDTH;
+            uint32_t random = 0x9E3779B9u * (uint32_t)(row * GAME_FLOOR_DIM + column + 1);
+            uint32_t shade  = 192 + (NextRandom(&random) & 63);
+            if (FloorHeight(x, y) > 0.0f) {
+                uint32_t red   = 168 * shade / 255;
+                uint32_t green = 84 * shade / 255;
+                uint32_t blue  = 60 * shade / 255;
+                color_row[x]   = 0xFF000000 | (red << 16) | (green << 8) | blue;
+            } else {
+                color_row[x] = 0xFF605C58;
+            }
+
+            float32_t normal_x = -1.5f * (FloorHeight(x + 1, y) - FloorHeight(x - 1, y));
+            float32_t normal_y = -1.5f * (FloorHeight(x, y + 1) - FloorHeight(x, y - 1));
+            float32_t length   = sqrtf(normal_x * normal_x + normal_y * normal_y + 1.0f);
+            uint32_t  packed_x = (uint32_t)(128.0f + 127.0f * normal_x / length + 0.5f);
+            uint32_t  packed_y = (uint32_t)(128.0f + 127.0f * normal_y / length + 0.5f);
+            uint32_t  packed_z = (uint32_t)(128.0f + 127.0f / length + 0.5f);
+            normal_row[x]      = 0xFF000000 | (packed_x << 16) | (packed_y << 8) | packed_z;
+        }
+    }
+    SpriteBuildMips(floor, arena);
+}
+
+// NOTE: dim light from the top left and a point light on each of the first entities, in screen pixels like the glows
+internal void
+GatherLights(Lighting* lighting, Game_Offscreen_Buffer* buffer, Entity_Store* entities) {
+    local_persist const float32_t palette[][3] = {
+        {1.0f, 0.6f, 0.2f},
+        {0.3f, 0.6f, 1.0f},
+        {0.4f, 1.0f, 0.4f},
+        {1.0f, 0.3f, 0.8f},
+    };
+
+    LightingBegin(lighting, 0.08f, 0.08f, 0.1f);
+    LightingAddDirectional(lighting, -0.5f, -0.5f, 1.0f, 0.15f, 0.15f, 0.12f);
+    float32_t scale_x     = (float32_t)buffer->width / GAME_WORLD_WIDTH;
+    float32_t scale_y     = (float32_t)buffer->height / GAME_WORLD_HEIGHT;
+    uint32_t  light_count = entities->count < GAME_LIGHT_COUNT ? entities->count : GAME_LIGHT_COUNT;
+    for (uint32_t entity_idx = 0; entity_idx < light_count; ++entity_idx) {
+        const float32_t* color = palette[entity_idx % ArrayCount(palette)];
+        LightingAddPoint(
+            lighting,
+            scale_x * entities->position_x[entity_idx],
+            scale_y * entities->position_y[entity_idx],
+            GAME_LIGHT_HEIGHT,
+            GAME_LIGHT_RADIUS,
+            color[0],
+            color[1],
+            color[2]);
+    }
+}
+
+// NOTE: the floor sprite repeated under the camera, each copy only gets the lights that reach it
+internal void
+RenderLitFloor(Game_Offscreen_Buffer* buffer, Sprite* floor, Lighting* lighting, int camera_x, int camera_y) {
+    Clip_Rect clip    = ClipRectForBuffer(buffer);
+    int       first_x = -(camera_x - FloorDivide(camera_x, GAME_FLOOR_DIM) * GAME_FLOOR_DIM);
+    int       first_y = -(camera_y - FloorDivide(camera_y, GAME_FLOOR_DIM) * GAME_FLOOR_DIM);
+    for (int y = first_y; y < buffer->height; y += GAME_FLOOR_DIM) {
+        for (int x = first_x; x < buffer->width; x += GAME_FLOOR_DIM) {
+            float32_t    center = 0.5f * GAME_FLOOR_DIM;
+            Sprite_Basis basis  = SpriteBasisAround(
+                (float32_t)x + center, (float32_t)y + center, GAME_FLOOR_DIM, GAME_FLOOR_DIM, 1.0f, 0.0f);
+            DrawLitSprite(buffer, clip, floor, basis, lighting);
+        }
+    }
+}
+
+// NOTE: round islands of tiles scattered far apart. The first one is under the camera's starting position.
+internal void
+PlanIslands(World_Island* islands, uint32_t island_count) {
+    uint32_t random = 0x9E3779B9;
+    for (uint32_t island_idx = 0; island_idx < island_count; ++island_idx) {
+        World_Island* island = &islands[island_idx];
+        island->center_x     = 40;
+        island->center_y     = 22;
+        if (island_idx > 0) {
+            int32_t spread_tiles = GAME_WORLD_SPREAD * WORLD_CHUNK_DIM;
+            island->center_x     = (int32_t)(NextRandom(&random) % (2 * spread_tiles)) - spread_tiles;
+            island->center_y     = (int32_t)(NextRandom(&random) % (2 * spread_tiles)) - spread_tiles;
+        }
+        island->radius = 4 + (int32_t)(NextRandom(&random) % 8);
+    }
+}
+
+// NOTE: the part of the islands that's in an empty chunk, rock in the middle, grass, then sand on the shore
+internal void
+FillChunk(World_Chunk* chunk, World_Island* islands, uint32_t island_count) {
+    int32_t chunk_min_x = chunk->chunk_x * WORLD_CHUNK_DIM;
+    int32_t chunk_min_y = chunk->chunk_y * WORLD_CHUNK_DIM;
+    for (uint32_t island_idx = 0; island_idx < island_count; ++island_idx) {
+        World_Island* island = &islands[island_idx];
+        int32_t       radius = island->radius;
+        for (int32_t offset_y = -radius; offset_y <= radius; ++offset_y) {
+            int32_t tile_y = island->center_y + offset_y - chunk_min_y;
+            if (tile_y < 0 || tile_y >= WORLD_CHUNK_DIM) {
+                continue;
+            }
+            for (int32_t offset_x = -radius; offset_x <= radius; ++offset_x) {
+                int32_t tile_x      = island->center_x + offset_x - chunk_min_x;
+                int32_t distance_sq = offset_x * offset_x + offset_y * offset_y;
+                if (tile_x < 0 || tile_x >= WORLD_CHUNK_DIM || distance_sq > radius * radius) {
+                    continue;
+                }
+
+                uint8_t tile = 1;
+                if (4 * distance_sq < radius * radius) {
+                    tile = 3;
+                } else if (distance_sq < (radius - 1) * (radius - 1)) {
+                    tile = 2;
+                }
+                uint8_t* dest = &chunk->tiles[tile_y * WORLD_CHUNK_DIM + tile_x];
+                if (!*dest) {
+                    ++chunk->filled_tile_count;
+                }
+                *dest = tile;
+            }
+        }
+    }
+}
+
+// NOTE: with can_yield the idle time is up when the platform says so, otherwise they're all filled
+internal void
+FillPendingChunks(Game_Memory* memory, bool can_yield) {
+    Game_State*      state     = (Game_State*)memory->permanent_storage;
+    Transient_State* transient = (Transient_State*)memory->transient_storage;
+    while (transient->pending_fill_count && !(can_yield && memory->PlatformIdleShouldYield(memory->idle_queue))) {
+        World_Chunk* chunk = transient->pending_fills[--transient->pending_fill_count];
+        FillChunk(chunk, state->islands, GAME_WORLD_ISLANDS);
+        WorldPagerMarkDirty(&transient->world, chunk);
+    }
+}
+
+// NOTE: data is the Game_Memory, which outlives every frame
+internal PLATFORM_IDLE_TASK_CALLBACK(FillPendingChunksTask) {
+    Game_Memory*     memory    = (Game_Memory*)data;
+    Transient_State* transient = (Transient_State*)memory->transient_storage;
+    FillPendingChunks(memory, true);
+    transient->is_fill_queued = transient->pending_fill_count != 0;
+    return !transient->is_fill_queued;
+}
+
+#if HANDMADE_INTERNAL
+internal void
+DebugUpdateFileCopy(Game_Memory* memory, Debug_File_Copy* copy, Memory_Arena* arena) {
+    switch (copy->stage) {
+        case 0: {
+            copy->source = memory->PlatformOpenFile(__FILE__, PlatformOpenFile_Read);
+            if (copy->source.platform_handle) {
+                copy->size   = SafeTruncateUint64(copy->source.size);
+                copy->buffer = PushSize(arena, copy->size, MemoryTag_Debug);
+                copy->op     = memory->PlatformReadFileAsync(&copy->source, 0, copy->size, copy->buffer);
+                copy->stage  = 1;
+            } else {
+                copy->stage = 3;
+            }
+        } break;
+
+        case 1: {
+            if (copy->op.is_busy) {
+                copy->op = memory->PlatformReadFileAsync(&copy->source, 0, copy->size, copy->buffer);
+                break;
+            }
+            Platform_File_Op_State op_state = memory->PlatformPollFileOp(copy->op, 0);
+            if (op_state != PlatformFileOp_Pending) {
+                memory->PlatformCloseFile(&copy->source);
+                copy->stage = 3;
+                if (op_state == PlatformFileOp_Complete) {
+                    copy->dest = memory->PlatformOpenFile("test.out", PlatformOpenFile_Write | PlatformOpenFile_Create);
+                    if (copy->dest.platform_handle) {
+                        copy->op    = memory->PlatformWriteFileAsync(&copy->dest, 0, copy->size, copy->buffer);
+                        copy->stage = 2;
+                    }
+                }
+            }
+        } break;
+
+        case 2: {
+            if (copy->op.is_busy) {
+                copy->op = memory->PlatformWriteFileAsync(&copy->dest, 0, copy->size, copy->buffer);
+            } else if (memory->PlatformPollFileOp(copy->op, 0) != PlatformFileOp_Pending) {
+                memory->PlatformCloseFile(&copy->dest);
+                copy->stage = 3;
+            }
+        } break;
+
+        default: {
+        } break;
+    }
+}
+
+// NOTE: decoded into the arena with rows padded to 16 bytes, the file itself is only needed until then
+internal Loaded_Bitmap
+DebugLoadBMP(Game_Memory* memory, Memory_Arena* arena, const char* file_name) {
+    Loaded_Bitmap          result = {};
+    Debug_Read_File_Result file   = memory->DebugPlatformReadEntireFile(file_name);
+    if (file.content) {
+        // NOTE: the file only vouches for its own rows, the padded ones here have to fit an int pitch and the arena
+        if (BitmapReadBMPSize(file.content, file.content_size, &result)) {
+            uint64_t pitch = AlignPow2((uint64_t)result.width * sizeof(uint32_t), 16);
+            uint64_t size  = pitch * (uint64_t)result.height;
+            if (result.width > 0 && result.height > 0 && pitch <= INT32_MAX && ArenaHasRoom(arena, size)) {
+                result.pitch  = (int)pitch;
+                result.memory = PushSize(arena, size, MemoryTag_Bitmaps);
+                BitmapDecodeBMP(file.content, &result);
+            } else {
+                result = {};
+            }
+        }
+        memory->DebugPlatformFreeFileMemory(file.content);
+    }
+    return result;
+}
+#endif
+
+// NOTE: the transient arena is what's left of transient storage after Transient_State
+internal void
+InitializeTransientArena(Game_State* state, Game_Memory* memory) {
+    uint64_t transient_state_size = AlignPow2(sizeof(Transient_State), 64);
+    InitializeArena(
+        &state->transient_arena,
+        memory->transient_storage_size - transient_state_size,
+        (uint8_t*)memory->transient_storage + transient_state_size);
+}
+
+// NOTE: a stick moves the camera across by how far it's pushed, the dpad a pixel a frame
+internal void
+MoveCamera(Game_Controller_Input* controller_input, int* x_offset, int* y_offset) {
+    if (controller_input->is_analog) {
+        *x_offset += (int)(4.0f * controller_input->stick_avg_x);
+    } else {
+        if (controller_input->move_up.ended_down) {
+            *y_offset -= 1;
+        }
+        if (controller_input->move_down.ended_down) {
+            *y_offset += 1;
+        }
+        if (controller_input->move_left.ended_down) {
+            *x_offset -= 1;
+        }
+        if (controller_input->move_right.ended_down) {
+            *x_offset += 1;
+        }
+    }
+
+    if (controller_input->action_down.ended_down) {
+        *y_offset += 1;
     }
 }
 
+// NOTE: two viewports side by side, three with the last across the bottom, four in quarters. The vertical split is
+// on a 4 pixel boundary so the right hand rows start as aligned as the buffer's.
+internal void
+LayoutViewports(Game_Offscreen_Buffer* buffer, uint32_t viewport_count, Game_Viewport* viewports) {
+    int half_width  = (buffer->width / 2) & ~3;
+    int half_height = buffer->height / 2;
+    int rects[GAME_MAX_VIEWPORTS][4]; // x, y, width, height
+    if (viewport_count == 2) {
+        int layout[2][4] = {
+            {0, 0, half_width, buffer->height},
+            {half_width, 0, buffer->width - half_width, buffer->height},
+        };
+        memcpy(rects, layout, sizeof(layout));
+    } else {
+        int layout[4][4] = {
+            {0, 0, half_width, half_height},
+            {half_width, 0, buffer->width - half_width, half_height},
+            {0, half_height, half_width, buffer->height - half_height},
+            {half_width, half_height, buffer->width - half_width, buffer->height - half_height},
+        };
+        if (viewport_count == 3) {
+            layout[2][2] = buffer->width;
+        }
+        memcpy(rects, layout, sizeof(layout));
+    }
+
+    for (uint32_t viewport_idx = 0; viewport_idx < viewport_count; ++viewport_idx) {
+        int*                   rect = rects[viewport_idx];
+        Game_Offscreen_Buffer* view = &viewports[viewport_idx].buffer;
+        *view                       = *buffer;
+
+        size_t row_offset = (size_t)rect[1] * buffer->pitch;
+        view->memory      = (uint8_t*)buffer->memory + row_offset + (size_t)rect[0] * buffer->bytes_per_pixel;
+        view->width       = rect[2];
+        view->height      = rect[3];
+    }
+}
+
+// NOTE: only reads game state, so viewports can render at the same time as long as their buffers don't overlap
+internal void
+RenderViewport(Game_Viewport* viewport) {
+    Game_Offscreen_Buffer* buffer = &viewport->buffer;
+    Game_State*            state  = viewport->state;
+    Game_Camera            camera = viewport->camera;
+    if (state->floor.level_count && buffer->pixel_format == GamePixelFormat_BGRX8888) {
+        Lighting lighting;
+        GatherLights(&lighting, buffer, &state->entities);
+        RenderLitFloor(buffer, &state->floor, &lighting, camera.x_offset, camera.y_offset);
+    } else {
+        RenderBitmap(buffer, camera.x_offset, camera.y_offset);
+    }
+    RenderTiles(buffer, viewport->world, camera.x_offset, camera.y_offset);
+    if (state->sprite.level_count && buffer->pixel_format == GamePixelFormat_BGRX8888) {
+        float32_t    scale = powf(2.0f, GAME_SPRITE_PULSE_OCTAVES * sinf(GAME_SPRITE_PULSE_SPEED * state->sprite_time));
+        Sprite_Basis basis = SpriteBasisAround(
+            0.5f * (float32_t)buffer->width,
+            0.5f * (float32_t)buffer->height,
+            state->sprite.levels[0].width,
+            state->sprite.levels[0].height,
+            scale,
+            GAME_SPRITE_SPIN_SPEED * state->sprite_time);
+        DrawSprite(buffer, &state->sprite, basis);
+    }
+    RenderEntities(buffer, &state->entities, state->entity_glow);
+}
+
+internal PLATFORM_WORK_QUEUE_CALLBACK(RenderViewportJob) {
+    RenderViewport((Game_Viewport*)data);
+}
+
 extern "C" __declspec(dllexport)
 GAME_GET_SOUND_SAMPLES(GameGetSoundSamples) {
     Assert(sizeof(Game_State) <= memory->permanent_storage_size);
+    Assert(sizeof(Transient_State) <= memory->transient_storage_size);
+
+    Game_State*      state     = (Game_State*)memory->permanent_storage;
+    Transient_State* transient = (Transient_State*)memory->transient_storage;
+    if (!transient->is_initialized) {
+        SoundStreamOpen(&transient->music, memory, GAME_MUSIC_FILE_NAME, true);
+        transient->music.volume   = GAME_MUSIC_VOLUME;
+        transient->is_initialized = true;
+    }
 
-    Game_State* state = (Game_State*)memory->permanent_storage;
     GameOutputSound(sound_buffer, state);
+    SoundStreamUpdate(&transient->music, memory);
+    SoundStreamMix(
+        &transient->music,
+        sound_buffer->samples,
+        (uint32_t)sound_buffer->sample_count,
+        (uint32_t)sound_buffer->samples_per_second);
+    SoundScheduleMix(&transient->sounds, sound_buffer);
+}
+
+// NOTE: the chunks waiting to be filled are pages of the pager, they're filled and written back with the rest
+extern "C" __declspec(dllexport)
+GAME_SHUTDOWN(GameShutdown) {
+    Transient_State* transient = (Transient_State*)memory->transient_storage;
+    FillPendingChunks(memory, false);
+    transient->is_fill_queued = false;
+    WorldPagerClose(&transient->world, memory);
+
+#if HANDMADE_INTERNAL
+    // NOTE: a copy that started runs to the end, its ops write into transient storage
+    Game_State* state = (Game_State*)memory->permanent_storage;
+    while (transient->debug_file_copy.stage == 1 || transient->debug_file_copy.stage == 2) {
+        DebugUpdateFileCopy(memory, &transient->debug_file_copy, &state->transient_arena);
+    }
+#endif
 }
 
 extern "C" __declspec(dllexport)
 GAME_UPDATE_AND_RENDER(GameUpdateAndRender) {
     Assert(sizeof(Game_State) <= memory->permanent_storage_size);
+    Assert(sizeof(Transient_State) <= memory->transient_storage_size);
 
-    Game_State* state = (Game_State*)memory->permanent_storage;
+    Game_State*      state     = (Game_State*)memory->permanent_storage;
+    Transient_State* transient = (Transient_State*)memory->transient_storage;
     if (!memory->is_initialized) {
-#ifdef HANDMADE_INTERNAL
-        const char*            file_name = __FILE__;
-        Debug_Read_File_Result file      = memory->DebugPlatformReadEntireFile(file_name);
-        if (file.content) {
-            memory->DebugPlatformWriteEntireFile("test.out", file);
-            memory->DebugPlatformFreeFileMemory(file.content);
+        state->x_offset = 0;
+        state->y_offset = 0;
+        state->tone_hz  = 256;
+        state->t_sine   = 0.0f;
+
+        InitializeTransientArena(state, memory);
+        InitializeArena(
+            &state->permanent_arena,
+            memory->permanent_storage_size - sizeof(Game_State),
+            (uint8_t*)memory->permanent_storage + sizeof(Game_State));
+        EntityStoreInit(
+            &state->entities, &state->permanent_arena, GAME_ENTITY_CAPACITY, GAME_WORLD_WIDTH, GAME_WORLD_HEIGHT);
+        SpawnEntities(&state->entities, GAME_ENTITY_START_COUNT);
+        MakeEntityGlow(state->entity_glow);
+        PlanIslands(state->islands, GAME_WORLD_ISLANDS);
+        MakeFloorSprite(&state->floor, &state->permanent_arena);
+#if HANDMADE_INTERNAL
+        state->sprite.levels[0] = DebugLoadBMP(memory, &state->permanent_arena, GAME_SPRITE_FILE_NAME);
+        if (state->sprite.levels[0].memory) {
+            SpriteBuildMips(&state->sprite, &state->permanent_arena);
         }
 #endif
 
-        state->x_offset        = 0;
-        state->y_offset        = 0;
-        state->tone_hz         = 256;
-        state->t_sine          = 0.0f;
+        // NOTE: assets are read in place from the mapping, a missing pack just leaves it empty
+        transient->asset_file = memory->PlatformMapFile("handmade.hha");
+        if (!AssetPackOpen(&transient->assets, transient->asset_file.memory, transient->asset_file.size)) {
+            memory->PlatformUnmapFile(&transient->asset_file);
+        }
+
         memory->is_initialized = true;
     }
 
+    // NOTE: a save brings back game state, not platform resources, the ones kept in permanent storage are reset
+    if (memory->storage_was_loaded) {
+        // NOTE: the permanent arena's contents came back, only the address it is at may have changed
+        intptr_t storage_delta =
+            (uint8_t*)memory->permanent_storage - (state->permanent_arena.base - sizeof(Game_State));
+        state->permanent_arena.base += storage_delta;
+        EntityStoreRebase(&state->entities, storage_delta);
+        SpriteRebase(&state->sprite, storage_delta);
+        SpriteRebase(&state->floor, storage_delta);
+
+        InitializeTransientArena(state, memory);
+        memory->storage_was_loaded = false;
+    }
+
+    ArenaBeginFrame(&state->permanent_arena);
+    ArenaBeginFrame(&state->transient_arena);
+    memory->permanent_arena = &state->permanent_arena;
+    memory->transient_arena = &state->transient_arena;
+
+#if HANDMADE_INTERNAL
+    // NOTE: a step per frame that's shown, frames played again after a rollback already had theirs
+    if (!input->is_resimulating) {
+        DebugUpdateFileCopy(memory, &transient->debug_file_copy, &state->transient_arena);
+    }
+#endif
+
+    // NOTE: with more than one gamepad connected each moves its own camera and the keyboard moves the first one's
+    uint32_t viewport_count = 0;
+    int      viewport_gamepads[GAME_MAX_VIEWPORTS];
+    for (int gamepad_idx = 0; gamepad_idx < ArrayCount(input->gamepad_controllers); ++gamepad_idx) {
+        if (input->gamepad_controllers[gamepad_idx].is_connected) {
+            viewport_gamepads[viewport_count++] = gamepad_idx;
+        }
+    }
+    bool is_split_screen = viewport_count > 1;
+
+    // NOTE: every controller pushes the entities, a stick by how far it's pushed and the dpad at full strength
+    float32_t push_x = 0;
+    float32_t push_y = 0;
     for (int controller_idx = 0; controller_idx < ArrayCount(input->controllers); ++controller_idx) {
         Game_Controller_Input* controller_input = &input->controllers[controller_idx];
         if (controller_input->is_analog) {
             state->tone_hz = 256 + (int)(128.0f * controller_input->stick_avg_y);
-            state->x_offset += (int)(4.0f * controller_input->stick_avg_x);
+            push_x += controller_input->stick_avg_x;
+            push_y -= controller_input->stick_avg_y;
         } else {
-            if (controller_input->move_up.ended_down) {
-                state->y_offset -= 1;
-            }
-            if (controller_input->move_down.ended_down) {
-                state->y_offset += 1;
-            }
-            if (controller_input->move_left.ended_down) {
-                state->x_offset -= 1;
-            }
-            if (controller_input->move_right.ended_down) {
-                state->x_offset += 1;
-            }
+            push_y -= controller_input->move_up.ended_down ? 1.0f : 0.0f;
+            push_y += controller_input->move_down.ended_down ? 1.0f : 0.0f;
+            push_x -= controller_input->move_left.ended_down ? 1.0f : 0.0f;
+            push_x += controller_input->move_right.ended_down ? 1.0f : 0.0f;
+        }
+
+        if (is_split_screen) {
+            int          gamepad_idx = controller_idx ? controller_idx - 1 : viewport_gamepads[0];
+            Game_Camera* camera      = &state->player_cameras[gamepad_idx];
+            MoveCamera(controller_input, &camera->x_offset, &camera->y_offset);
+        } else {
+            MoveCamera(controller_input, &state->x_offset, &state->y_offset);
+        }
+    }
+
+    // NOTE: the click goes on the frame's flip, however far into the next sound buffer that turns out to be. The
+    // schedule isn't rolled back, a resimulated frame already queued its clicks.
+    uint64_t flip_sample_idx = SoundScheduleNextFlip(&transient->sounds, GAME_UPDATE_SECONDS);
+    for (int controller_idx = 0; controller_idx < ArrayCount(input->controllers) && !input->is_resimulating;
+         ++controller_idx) {
+        Game_Button_State* action = &input->controllers[controller_idx].action_down;
+        if (flip_sample_idx && action->ended_down && action->half_transition_count) {
+            Sound_Event click = {flip_sample_idx, GAME_CLICK_HZ, GAME_CLICK_VOLUME, GAME_CLICK_SECONDS};
+            SoundScheduleAt(&transient->sounds, click);
         }
+    }
 
-        if (controller_input->action_down.ended_down) {
-            state->y_offset += 1;
+    // NOTE: report the latest tagged press this frame handled, the platform times it until the frame is presented
+    for (uint32_t event_idx = 0; event_idx < input->event_count; ++event_idx) {
+        Game_Input_Event* event = &input->events[event_idx];
+        bool is_press = (event->type == GameInputEvent_Button && event->is_down);
+        if (is_press && event->latency_tag > input->consumed_latency_tag) {
+            input->consumed_latency_tag = event->latency_tag;
         }
     }
 
-    RenderBitmap(offscreen_buffer, state->x_offset, state->y_offset);
+    EntityIntegrate(
+        &state->entities,
+        GAME_ENTITY_ACCELERATION * push_x,
+        GAME_ENTITY_ACCELERATION * push_y,
+        GAME_UPDATE_SECONDS);
+
+    // NOTE: the chunks under the camera that the file doesn't have yet are made here, the file keeps them after that.
+    // The ones only prefetched can wait for idle time, but not past the pager's next update.
+    FillPendingChunks(memory, false);
+    World_Pager* pager = &transient->world;
+    if (pager->state == WorldPager_Closed) {
+        WorldPagerOpen(
+            pager,
+            memory,
+            GAME_WORLD_FILE_NAME,
+            GAME_WORLD_FILE_MIN_CHUNK,
+            GAME_WORLD_FILE_MIN_CHUNK,
+            GAME_WORLD_FILE_SPAN,
+            GAME_WORLD_FILE_SPAN);
+    }
+    Game_Viewport viewports[GAME_MAX_VIEWPORTS];
+    if (is_split_screen) {
+        LayoutViewports(offscreen_buffer, viewport_count, viewports);
+        for (uint32_t viewport_idx = 0; viewport_idx < viewport_count; ++viewport_idx) {
+            viewports[viewport_idx].camera = state->player_cameras[viewport_gamepads[viewport_idx]];
+        }
+    } else {
+        viewport_count      = 1;
+        viewports[0].buffer = *offscreen_buffer;
+        viewports[0].camera = {state->x_offset, state->y_offset};
+    }
+    World_Pager_View views[GAME_MAX_VIEWPORTS];
+    for (uint32_t viewport_idx = 0; viewport_idx < viewport_count; ++viewport_idx) {
+        Game_Viewport* viewport = &viewports[viewport_idx];
+        viewport->state         = state;
+        viewport->world         = &pager->world;
+
+        Game_Camera camera = viewport->camera;
+        views[viewport_idx].min_tile_x = FloorDivide(camera.x_offset, GAME_TILE_PIXELS);
+        views[viewport_idx].min_tile_y = FloorDivide(camera.y_offset, GAME_TILE_PIXELS);
+        views[viewport_idx].max_tile_x = FloorDivide(camera.x_offset + viewport->buffer.width - 1, GAME_TILE_PIXELS);
+        views[viewport_idx].max_tile_y = FloorDivide(camera.y_offset + viewport->buffer.height - 1, GAME_TILE_PIXELS);
+    }
+    WorldPagerUpdate(pager, memory, GAME_WORLD_FILE_NAME, views, viewport_count);
+    for (uint32_t chunk_idx = 0; chunk_idx < pager->new_chunk_count; ++chunk_idx) {
+        World_Chunk* chunk      = pager->new_chunks[chunk_idx];
+        bool         is_in_view = WorldPagerViewsHaveChunk(views, viewport_count, chunk->chunk_x, chunk->chunk_y);
+        if (is_in_view || !memory->PlatformAddIdleTask) {
+            FillChunk(chunk, state->islands, GAME_WORLD_ISLANDS);
+            WorldPagerMarkDirty(pager, chunk);
+        } else {
+            transient->pending_fills[transient->pending_fill_count++] = chunk;
+        }
+    }
+    if (transient->pending_fill_count && !transient->is_fill_queued) {
+        transient->is_fill_queued =
+            memory->PlatformAddIdleTask(memory->idle_queue, FillPendingChunksTask, memory);
+        if (!transient->is_fill_queued) {
+            FillPendingChunks(memory, false);
+        }
+    }
+
+    // NOTE: the viewports only share state they read, so each is a job when there's more than one
+    state->sprite_time += GAME_UPDATE_SECONDS;
+    if (viewport_count > 1 && memory->work_queue && memory->PlatformAddWorkQueueEntry) {
+        for (uint32_t viewport_idx = 0; viewport_idx < viewport_count; ++viewport_idx) {
+            memory->PlatformAddWorkQueueEntry(memory->work_queue, RenderViewportJob, &viewports[viewport_idx]);
+        }
+        memory->PlatformCompleteAllWork(memory->work_queue);
+    } else {
+        for (uint32_t viewport_idx = 0; viewport_idx < viewport_count; ++viewport_idx) {
+            RenderViewport(&viewports[viewport_idx]);
+        }
+    }
 }
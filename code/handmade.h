@@ -3,18 +3,66 @@
 
 #include <stdint.h>
 #include "base.h"
+#include "handmade_asset_pack.h"
+
+// NOTE: BGRX8888 is 0xXXRRGGBB in memory order BB GG RR XX, RGB565 is 5:6:5 packed in a uint16_t
+enum Game_Pixel_Format {
+    GamePixelFormat_BGRX8888,
+    GamePixelFormat_RGB565,
+};
+
+// NOTE: rows start on a cache line, SIMD kernels can work a row at a time without splitting lines. Always step rows by
+// pitch, it is usually more than width * bytes_per_pixel.
+#define FRAMEBUFFER_ROW_ALIGNMENT 64
 
 struct Game_Offscreen_Buffer {
     void* memory;
     int   width;
     int   height;
+    int   pitch;
     int   bytes_per_pixel;
+    int   pixel_format; // Game_Pixel_Format
+};
+
+// NOTE: draw kernels are templated on the pixel format, every format gets its own loop with the packing inlined and
+// RenderBitmap etc. pick one per call
+struct Pixel_BGRX8888 {
+    typedef uint32_t Type;
+
+    static inline Type
+    Pack(uint32_t red, uint32_t green, uint32_t blue) {
+        // (windows bitmap) byte order: BB GG RR 00
+        return (red << 16) | (green << 8) | blue;
+    }
+
+    // NOTE: every channel at half intensity, for darkening what's under a debug panel
+    static inline Type
+    Halve(Type pixel) {
+        return (pixel >> 1) & 0x7F7F7F;
+    }
 };
 
+struct Pixel_RGB565 {
+    typedef uint16_t Type;
+
+    static inline Type
+    Pack(uint32_t red, uint32_t green, uint32_t blue) {
+        return (Type)(((red >> 3) << 11) | ((green >> 2) << 5) | (blue >> 3));
+    }
+
+    static inline Type
+    Halve(Type pixel) {
+        return (Type)((pixel >> 1) & 0x7BEF);
+    }
+};
+
+// NOTE: sample indices count stereo samples from the start of playback, see handmade_sound_schedule.h
 struct Game_Sound_Output_Buffer {
     int      samples_per_second;
     int      sample_count;
     int16_t* samples;
+    uint64_t first_sample_idx; // of samples[0]
+    uint64_t flip_sample_idx;  // projected to be playing when the frame just rendered is shown
 };
 
 // Input
@@ -54,6 +102,26 @@ struct Game_Controller_Input {
     };
 };
 
+// NOTE: every button and stick change in the order it happened, including presses that start and end within one
+// frame. The controller state above is still the summary of the frame, events are there when that isn't enough.
+enum Game_Input_Event_Type {
+    GameInputEvent_Button,
+    GameInputEvent_Stick,
+};
+
+struct Game_Input_Event {
+    int64_t   timestamp;      // NOTE: same clock as Game_Input::frame_timestamp
+    uint8_t   type;           // Game_Input_Event_Type
+    uint8_t   controller_idx; // index into Game_Input::controllers
+    uint8_t   button_idx;     // index into Game_Controller_Input::buttons
+    bool      is_down;
+    uint32_t  latency_tag; // NOTE: nonzero when the platform measures input latency, see consumed_latency_tag
+    float32_t stick_x;
+    float32_t stick_y;
+};
+
+#define GAME_INPUT_MAX_EVENTS 256
+
 struct Game_Input {
     union {
         Game_Controller_Input controllers[5];
@@ -62,14 +130,21 @@ struct Game_Input {
             Game_Controller_Input gamepad_controllers[4];
         };
     };
-};
 
-struct Game_State {
-    int x_offset;
-    int y_offset;
-    int tone_hz;
+    // NOTE: when this frame's input was collected, timestamp_frequency is ticks per second
+    int64_t frame_timestamp;
+    int64_t timestamp_frequency;
 
-    float32_t t_sine;
+    uint32_t         event_count;
+    uint32_t         dropped_event_count;
+    Game_Input_Event events[GAME_INPUT_MAX_EVENTS];
+
+    // NOTE: written by the game, the highest latency_tag it acted on this frame
+    uint32_t consumed_latency_tag;
+
+    // NOTE: set by the platform while it simulates frames again after a rollback. They were played once already, the
+    // game skips what it does outside permanent storage, like queueing sounds, so it doesn't happen twice.
+    bool is_resimulating;
 };
 
 #if BUILD_DEBUG
@@ -88,14 +163,138 @@ typedef DEBUG_PLATFORM_WRITE_ENTIRE_FILE(debug_platform_write_entire_file);
 typedef DEBUG_PLATFORM_FREE_FILE_MEMORY(debug_platform_free_file_memory);
 #endif
 
+// Work queue
+// NOTE: the queue itself is opaque to the game, the platform owns the threads and the storage.
+struct Platform_Work_Queue;
+
+#define PLATFORM_WORK_QUEUE_CALLBACK(name) void name(Platform_Work_Queue* queue, void* data)
+typedef PLATFORM_WORK_QUEUE_CALLBACK(platform_work_queue_callback);
+
+#define PLATFORM_ADD_WORK_QUEUE_ENTRY(name)                                                                            \
+    void name(Platform_Work_Queue* queue, platform_work_queue_callback* callback, void* data)
+typedef PLATFORM_ADD_WORK_QUEUE_ENTRY(platform_add_work_queue_entry);
+
+#define PLATFORM_COMPLETE_ALL_WORK(name) void name(Platform_Work_Queue* queue)
+typedef PLATFORM_COMPLETE_ALL_WORK(platform_complete_all_work);
+
+// Idle tasks
+// NOTE: low priority work the platform runs on the main thread in what's left of a frame after the game is done with
+// it, up to a safety margin before the deadline. A task is called at most once a frame, it should work in small steps
+// and return as soon as PlatformIdleShouldYield says so. It returns true when it's finished, false to be called again
+// next frame, which is also what it does when it has nothing to do for now. Callbacks live in the game dll, the
+// platform runs every task to the end before it unloads the dll.
+struct Platform_Idle_Queue;
+
+#define PLATFORM_IDLE_TASK_CALLBACK(name) bool name(Platform_Idle_Queue* queue, void* data)
+typedef PLATFORM_IDLE_TASK_CALLBACK(platform_idle_task_callback);
+
+// NOTE: returns false when the queue is full
+#define PLATFORM_ADD_IDLE_TASK(name)                                                                                   \
+    bool name(Platform_Idle_Queue* queue, platform_idle_task_callback* callback, void* data)
+typedef PLATFORM_ADD_IDLE_TASK(platform_add_idle_task);
+
+#define PLATFORM_IDLE_SHOULD_YIELD(name) bool name(Platform_Idle_Queue* queue)
+typedef PLATFORM_IDLE_SHOULD_YIELD(platform_idle_should_yield);
+
+// Memory mapped files
+// NOTE: read-only view of the whole file, pages are only loaded by the OS when they are first touched.
+struct Platform_Mapped_File {
+    void*    memory;
+    uint64_t size;
+    void*    platform_handle;
+};
+
+#define PLATFORM_MAP_FILE(name) Platform_Mapped_File name(const char* file_name)
+typedef PLATFORM_MAP_FILE(platform_map_file);
+
+#define PLATFORM_UNMAP_FILE(name) void name(Platform_Mapped_File* file)
+typedef PLATFORM_UNMAP_FILE(platform_unmap_file);
+
+// File I/O
+// NOTE: reads and writes are asynchronous, they go straight into memory the caller owns and complete in the
+// background. Poll an op until it's no longer pending and leave its memory alone until then. Offsets are 64-bit,
+// each op moves at most 4GB.
+struct Platform_File_Handle {
+    void*    platform_handle;
+    uint64_t size;
+};
+
+enum Platform_Open_File_Flags {
+    PlatformOpenFile_Read   = 0x1,
+    PlatformOpenFile_Write  = 0x2,
+    PlatformOpenFile_Create = 0x4, // create or truncate
+};
+
+enum Platform_File_Op_State {
+    PlatformFileOp_Invalid,
+    PlatformFileOp_Pending,
+    PlatformFileOp_Complete,
+    PlatformFileOp_Failed,
+};
+
+// NOTE: generation 0 is never handed out, a zeroed op is an op that was never issued. An op comes back with is_busy
+// and nothing issued when every slot the platform has is in flight, the caller issues it again in a later frame.
+struct Platform_File_Op {
+    uint32_t slot;
+    uint32_t generation;
+    bool     is_busy;
+};
+
+#define PLATFORM_OPEN_FILE(name) Platform_File_Handle name(const char* file_name, uint32_t open_flags)
+typedef PLATFORM_OPEN_FILE(platform_open_file);
+
+// NOTE: every op on the file has to be polled to completion before closing it
+#define PLATFORM_CLOSE_FILE(name) void name(Platform_File_Handle* file)
+typedef PLATFORM_CLOSE_FILE(platform_close_file);
+
+#define PLATFORM_READ_FILE_ASYNC(name)                                                                                 \
+    Platform_File_Op name(Platform_File_Handle* file, uint64_t offset, uint32_t size, void* dest)
+typedef PLATFORM_READ_FILE_ASYNC(platform_read_file_async);
+
+#define PLATFORM_WRITE_FILE_ASYNC(name)                                                                                \
+    Platform_File_Op name(Platform_File_Handle* file, uint64_t offset, uint32_t size, const void* source)
+typedef PLATFORM_WRITE_FILE_ASYNC(platform_write_file_async);
+
+// NOTE: once an op reports complete or failed it is retired, polling it again returns PlatformFileOp_Invalid
+#define PLATFORM_POLL_FILE_OP(name) Platform_File_Op_State name(Platform_File_Op op, uint32_t* bytes_transferred)
+typedef PLATFORM_POLL_FILE_OP(platform_poll_file_op);
+
+struct Memory_Arena;
+
 struct Game_Memory {
     bool is_initialized;
+    // NOTE: set by the platform after it restored permanent storage from a save, handles and pointers the game keeps
+    // there to platform resources or transient storage are from the run that saved it
+    bool storage_was_loaded;
 
     uint64_t permanent_storage_size;
     void*    permanent_storage;
     uint64_t transient_storage_size;
     void*    transient_storage;
 
+    // NOTE: callbacks live in the game dll, the platform drains the queue before it unloads the dll.
+    Platform_Work_Queue*           work_queue;
+    platform_add_work_queue_entry* PlatformAddWorkQueueEntry;
+    platform_complete_all_work*    PlatformCompleteAllWork;
+
+    // NOTE: 0 when the platform has no frame time to spare, e.g. the batch tool
+    Platform_Idle_Queue*        idle_queue;
+    platform_add_idle_task*     PlatformAddIdleTask;
+    platform_idle_should_yield* PlatformIdleShouldYield;
+
+    platform_map_file*   PlatformMapFile;
+    platform_unmap_file* PlatformUnmapFile;
+
+    platform_open_file*        PlatformOpenFile;
+    platform_close_file*       PlatformCloseFile;
+    platform_read_file_async*  PlatformReadFileAsync;
+    platform_write_file_async* PlatformWriteFileAsync;
+    platform_poll_file_op*     PlatformPollFileOp;
+
+    // NOTE: set by the game every update, the platform only reads them for its memory report
+    Memory_Arena* permanent_arena;
+    Memory_Arena* transient_arena;
+
 #if BUILD_DEBUG
     debug_platform_read_entire_file*  DebugPlatformReadEntireFile;
     debug_platform_write_entire_file* DebugPlatformWriteEntireFile;
@@ -103,6 +302,226 @@ struct Game_Memory {
 #endif
 };
 
+// Memory arena
+// NOTE: every push is charged to the subsystem that asked for it, alignment padding included, so the platform can
+// report what each one uses out of the storage it reserved (see Game_Memory::permanent_arena)
+enum Memory_Tag {
+    MemoryTag_Untagged,
+    MemoryTag_Entities,
+    MemoryTag_World,
+    MemoryTag_Debug,
+    MemoryTag_Bitmaps,
+
+    MemoryTag_Count,
+};
+
+global const char* g_memory_tag_names[MemoryTag_Count] = {"untagged", "entities", "world", "debug", "bitmaps"};
+
+struct Memory_Tag_Stats {
+    uint64_t current_bytes;
+    uint64_t peak_bytes;
+    uint32_t allocation_count;       // since the arena was initialized
+    uint32_t frame_allocation_count; // since the last ArenaBeginFrame
+};
+
+struct Memory_Arena {
+    uint64_t size;
+    uint8_t* base;
+    uint64_t used;
+
+    Memory_Tag_Stats tags[MemoryTag_Count];
+};
+
+inline void
+InitializeArena(Memory_Arena* arena, uint64_t size, void* base) {
+    *arena      = {};
+    arena->size = size;
+    arena->base = (uint8_t*)base;
+}
+
+inline void
+ArenaBeginFrame(Memory_Arena* arena) {
+    for (int tag = 0; tag < MemoryTag_Count; ++tag) {
+        arena->tags[tag].frame_allocation_count = 0;
+    }
+}
+
+// NOTE: for sizes that come from outside the game, PushSize asserts there's room
+inline bool
+ArenaHasRoom(Memory_Arena* arena, uint64_t size, uint64_t alignment = 16) {
+    uint64_t alignment_offset = 0;
+    uint64_t unaligned        = (uint64_t)(arena->base + arena->used);
+    if (unaligned & (alignment - 1)) {
+        alignment_offset = alignment - (unaligned & (alignment - 1));
+    }
+    uint64_t remaining = arena->size - arena->used;
+    return alignment_offset <= remaining && size <= remaining - alignment_offset;
+}
+
+#define PushStruct(arena, type, tag)       (type*)PushSize_(arena, sizeof(type), tag)
+#define PushArray(arena, count, type, tag) (type*)PushSize_(arena, (count) * sizeof(type), tag)
+#define PushSize(arena, size, tag)         PushSize_(arena, size, tag)
+inline void*
+PushSize_(Memory_Arena* arena, uint64_t size, Memory_Tag tag, uint64_t alignment = 16) {
+    uint64_t alignment_offset = 0;
+    uint64_t unaligned        = (uint64_t)(arena->base + arena->used);
+    if (unaligned & (alignment - 1)) {
+        alignment_offset = alignment - (unaligned & (alignment - 1));
+    }
+
+    Assert(arena->used + alignment_offset + size <= arena->size);
+    void* result = arena->base + arena->used + alignment_offset;
+    arena->used += alignment_offset + size;
+
+    Memory_Tag_Stats* stats = &arena->tags[tag];
+    stats->current_bytes += alignment_offset + size;
+    if (stats->current_bytes > stats->peak_bytes) {
+        stats->peak_bytes = stats->current_bytes;
+    }
+    ++stats->allocation_count;
+    ++stats->frame_allocation_count;
+    return result;
+}
+
+#include "handmade_entity.h"
+#include "handmade_world.h"
+#include "handmade_world_pager.h"
+#include "handmade_sound_stream.h"
+#include "handmade_sound_schedule.h"
+#include "handmade_debug_overlay.h"
+#include "handmade_bitmap.h"
+#include "handmade_blend.h"
+#include "handmade_sprite.h"
+#include "handmade_lighting.h"
+
+#if HANDMADE_INTERNAL
+// NOTE: copies the game source to test.out with the async file api, one step per frame
+struct Debug_File_Copy {
+    int                  stage;
+    Platform_File_Handle source;
+    Platform_File_Handle dest;
+    Platform_File_Op     op;
+    uint32_t             size;
+    void*                buffer;
+};
+#endif
+
+// NOTE: the platform calls the game at a fixed 30Hz, simulation steps by this much every update
+#define GAME_UPDATE_SECONDS (1.0f / 30.0f)
+
+// NOTE: entities live in world units and are scaled to whatever size the frame buffer is this frame
+#define GAME_WORLD_WIDTH         1280.0f
+#define GAME_WORLD_HEIGHT        720.0f
+#define GAME_ENTITY_CAPACITY     4096
+#define GAME_ENTITY_START_COUNT  1024
+#define GAME_ENTITY_ACCELERATION 600.0f // world units per second per second at full stick
+#define GAME_ENTITY_GLOW_DIM     8      // NOTE: entities are drawn as an additive glow this many pixels across
+
+// NOTE: x_offset and y_offset are the camera, the pixel of the tile world at the top left of the frame buffer. The
+// tiles are paged in around the camera from the world file, which holds the square of chunks from the min on both axes
+// and this many across. Chunks that aren't in it yet are made from the islands.
+#define GAME_TILE_PIXELS          16
+#define GAME_WORLD_ISLANDS        96
+#define GAME_WORLD_SPREAD         48 // islands are scattered over this many chunks each way from the origin
+#define GAME_WORLD_FILE_NAME      "world.hhw"
+#define GAME_WORLD_FILE_MIN_CHUNK (-64)
+#define GAME_WORLD_FILE_SPAN      128
+
+// NOTE: with more than one gamepad connected the screen is split, a viewport and a camera per gamepad rendered as a
+// job each on the work queue
+#define GAME_MAX_VIEWPORTS 4
+
+// NOTE: music plays from this file when it's there, streamed and resampled to whatever rate the platform asks for
+#define GAME_MUSIC_FILE_NAME "music.wav"
+#define GAME_MUSIC_VOLUME    0.5f
+
+// NOTE: an action press clicks on the sample that's playing when the frame that handled it is shown
+#define GAME_CLICK_HZ      1760.0f
+#define GAME_CLICK_VOLUME  0.25f
+#define GAME_CLICK_SECONDS 0.05f
+
+// NOTE: internal builds load this loose and draw it spinning and scaling in the middle of the screen when it's there
+#define GAME_SPRITE_FILE_NAME     "sprite.bmp"
+#define GAME_SPRITE_SPIN_SPEED    0.5f // radians per second
+#define GAME_SPRITE_PULSE_SPEED   0.3f // radians per second of the sine the scale follows
+#define GAME_SPRITE_PULSE_OCTAVES 2.0f // the scale goes between 1/4 and 4 times the bitmap's size
+
+// NOTE: on BGRX buffers the floor is a brick sprite with a normal map, tiled under the camera and lit by the first
+// entities, each carrying a point light this high above the floor that reaches this far, in pixels
+#define GAME_FLOOR_DIM          128
+#define GAME_FLOOR_BRICK_WIDTH  32
+#define GAME_FLOOR_BRICK_HEIGHT 16
+#define GAME_LIGHT_COUNT        32
+#define GAME_LIGHT_HEIGHT       24.0f
+#define GAME_LIGHT_RADIUS       160.0f
+
+// NOTE: lives at the start of transient storage, which saves and rollback leave alone. Streams keep playing through a
+// load and the reads they have in flight still land in memory that's theirs.
+struct Transient_State {
+    bool           is_initialized;
+    Sound_Stream   music;
+    Sound_Schedule sounds;
+    World_Pager    world; // NOTE: opened by the first update, not here
+
+    // NOTE: here and not in Game_State so loading a save doesn't replace the live mapping with one from the run
+    // that saved it
+    Platform_Mapped_File asset_file;
+    Asset_Pack           assets;
+
+    // NOTE: new chunks outside the view are filled in idle time, whatever's left is filled before the pager runs
+    // again and could reuse their pages
+    bool         is_fill_queued;
+    uint32_t     pending_fill_count;
+    World_Chunk* pending_fills[WORLD_PAGER_MAX_OPS];
+
+
+#if HANDMADE_INTERNAL
+    // NOTE: here so a rollback or a loaded save doesn't take it back to a stage whose ops and handles are gone
+    Debug_File_Copy debug_file_copy;
+#endif
+};
+
+struct Game_Camera {
+    int x_offset;
+    int y_offset;
+};
+
+struct World_Island {
+    int32_t center_x; // in tiles
+    int32_t center_y;
+    int32_t radius;
+};
+
+struct Game_State {
+    int x_offset;
+    int y_offset;
+    int tone_hz;
+
+    float32_t t_sine;
+
+    Memory_Arena transient_arena;
+
+    // NOTE: the rest of permanent storage, right after Game_State
+    Memory_Arena permanent_arena;
+    Entity_Store entities;
+    World_Island islands[GAME_WORLD_ISLANDS];
+    Game_Camera  player_cameras[GAME_MAX_VIEWPORTS]; // NOTE: split screen, by gamepad
+
+    uint32_t      entity_glow[GAME_ENTITY_GLOW_DIM * GAME_ENTITY_GLOW_DIM]; // Loaded_Bitmap pixels
+    Sprite        sprite; // NOTE: levels in the permanent arena, level_count is 0 when there's no file
+    float32_t     sprite_time;
+    Sprite        floor; // NOTE: levels and normals in the permanent arena
+
+};
+
+// NOTE: buffer is the viewport's part of the frame buffer, with the frame buffer's pitch
+struct Game_Viewport {
+    Game_Offscreen_Buffer buffer;
+    Game_Camera           camera;
+    Game_State*           state;
+    World*                world;
+};
+
 inline uint32_t
 SafeTruncateUint64(uint64_t val) {
     Assert(val <= 0xFFFFFFFF);
@@ -123,6 +542,12 @@ GAME_UPDATE_AND_RENDER(GameUpdateAndRenderStub) {}
 typedef GAME_GET_SOUND_SAMPLES(game_get_sound_samples);
 GAME_GET_SOUND_SAMPLES(GameGetSoundSamplesStub) {}
 
+// NOTE: the platform calls this before it unloads the game dll and before it exits, with no work or idle tasks left
+// queued. The game writes back and closes the files it keeps open across frames, the next update opens them again.
+#define GAME_SHUTDOWN(name) void name(Game_Memory* memory)
+typedef GAME_SHUTDOWN(game_shutdown);
+GAME_SHUTDOWN(GameShutdownStub) {}
+
 // NOTE: this has to be a very fast function, it cannot be more than 1ms or so
 // TODO: Reduce the pressure on this function's performance by measuring it.
 // declaration
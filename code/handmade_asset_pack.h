@@ -0,0 +1,247 @@
+#ifndef HANDMADE_ASSET_PACK_H
+#define HANDMADE_ASSET_PACK_H
+
+#include <stdint.h>
+#include "base.h"
+#include "handmade_file_formats.h"
+
+/*
+ NOTE: Asset pack (.hha) layout, everything is little endian:
+
+   [Asset_Pack_Header]
+   [asset data ...]      each blob starts on an ASSET_PACK_DATA_ALIGNMENT boundary
+   [Asset_Pack_Entry * asset_count]
+
+ The platform maps the file read-only and the game reads assets in place, so every blob is stored in the exact
+ layout the game consumes: bitmaps as top-down premultiplied BGRA rows (handmade_bitmap.h), sounds as interleaved int16
+ samples, fonts as 8-bit coverage glyph cells. Nothing is parsed or copied at load time, pages come in when they are
+ first touched.
+ */
+#define ASSET_PACK_MAGIC          RIFF_CODE('h', 'h', 'a', 'f')
+#define ASSET_PACK_VERSION        1
+#define ASSET_PACK_DATA_ALIGNMENT 64
+#define ASSET_PACK_NAME_LENGTH    32
+
+enum Asset_Type {
+    AssetType_None,
+    AssetType_Bitmap,
+    AssetType_Sound,
+    AssetType_Font,
+};
+
+#pragma pack(push, 1)
+struct Asset_Pack_Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t asset_count;
+    uint32_t reserved;
+
+    uint64_t index_offset;
+    uint64_t file_size;
+};
+
+struct Asset_Pack_Bitmap {
+    uint32_t width;
+    uint32_t height;
+    uint32_t pitch; // in bytes
+};
+
+struct Asset_Pack_Sound {
+    uint32_t sample_count; // per channel
+    uint32_t channel_count;
+    uint32_t samples_per_second;
+};
+
+struct Asset_Pack_Font {
+    uint32_t first_codepoint;
+    uint32_t glyph_count;
+    uint32_t glyph_width;
+    uint32_t glyph_height;
+};
+
+struct Asset_Pack_Entry {
+    uint32_t type;
+    char     name[ASSET_PACK_NAME_LENGTH];
+
+    uint64_t data_offset;
+    uint64_t data_size;
+
+    union {
+        Asset_Pack_Bitmap bitmap;
+        Asset_Pack_Sound  sound;
+        Asset_Pack_Font   font;
+    };
+};
+#pragma pack(pop)
+
+// NOTE: views into the mapped pack, the pointers stay valid for as long as the pack is mapped.
+struct Asset_Pack {
+    uint8_t*          base;
+    uint64_t          size;
+    uint32_t          asset_count;
+    Asset_Pack_Entry* entries;
+};
+
+struct Asset_Bitmap {
+    int      width;
+    int      height;
+    int      pitch;
+    uint8_t* memory;
+};
+
+struct Asset_Sound {
+    uint32_t       sample_count;
+    uint32_t       channel_count;
+    uint32_t       samples_per_second;
+    const int16_t* samples;
+};
+
+struct Asset_Font {
+    uint32_t       first_codepoint;
+    uint32_t       glyph_count;
+    int            glyph_width;
+    int            glyph_height;
+    const uint8_t* glyphs;
+};
+
+// NOTE: the data has to hold what the entry says it is, and the sizes have to fit the ints the getters hand out. Counts
+// are checked by dividing so a huge one can't wrap the size around.
+inline bool
+AssetPackEntryFitsData(const Asset_Pack_Entry* entry) {
+    bool result = true;
+    switch (entry->type) {
+        case AssetType_Bitmap: {
+            const Asset_Pack_Bitmap* bitmap = &entry->bitmap;
+
+            result = bitmap->width <= INT32_MAX / 4 && bitmap->height <= INT32_MAX && bitmap->pitch <= INT32_MAX &&
+                     bitmap->pitch >= 4 * bitmap->width &&
+                     (uint64_t)bitmap->pitch * bitmap->height <= entry->data_size;
+        } break;
+
+        case AssetType_Sound: {
+            const Asset_Pack_Sound* sound      = &entry->sound;
+            uint64_t                frame_size = (uint64_t)sound->channel_count * sizeof(int16_t);
+
+            result = frame_size ? sound->sample_count <= entry->data_size / frame_size : sound->sample_count == 0;
+        } break;
+
+        case AssetType_Font: {
+            const Asset_Pack_Font* font       = &entry->font;
+            uint64_t               glyph_size = (uint64_t)font->glyph_width * font->glyph_height;
+
+            result = glyph_size <= INT32_MAX && (glyph_size == 0 || font->glyph_count <= entry->data_size / glyph_size);
+        } break;
+    }
+    return result;
+}
+
+// NOTE: validates the header and index against the mapping size, and each entry's declared size against its data.
+// Nothing else is touched.
+inline bool
+AssetPackOpen(Asset_Pack* pack, void* memory, uint64_t size) {
+    *pack = {};
+
+    bool                     is_valid = false;
+    const Asset_Pack_Header* header   = (const Asset_Pack_Header*)memory;
+    if (memory && size >= sizeof(Asset_Pack_Header) && header->magic == ASSET_PACK_MAGIC &&
+        header->version == ASSET_PACK_VERSION && header->file_size == size) {
+        uint64_t index_size = (uint64_t)header->asset_count * sizeof(Asset_Pack_Entry);
+        if (header->index_offset <= size && index_size <= size - header->index_offset) {
+            is_valid = true;
+
+            Asset_Pack_Entry* entries = (Asset_Pack_Entry*)((uint8_t*)memory + header->index_offset);
+            for (uint32_t asset_idx = 0; asset_idx < header->asset_count; ++asset_idx) {
+                Asset_Pack_Entry* entry = &entries[asset_idx];
+                if (entry->data_offset > size || entry->data_size > size - entry->data_offset ||
+                    !AssetPackEntryFitsData(entry)) {
+                    is_valid = false;
+                    break;
+                }
+            }
+
+            if (is_valid) {
+                pack->base        = (uint8_t*)memory;
+                pack->size        = size;
+                pack->asset_count = header->asset_count;
+                pack->entries     = entries;
+            }
+        }
+    }
+    return is_valid;
+}
+
+// NOTE: linear scan, look assets up once at init and keep the index around.
+inline int
+AssetPackFind(Asset_Pack* pack, Asset_Type type, const char* name) {
+    int result = -1;
+    for (uint32_t asset_idx = 0; asset_idx < pack->asset_count; ++asset_idx) {
+        Asset_Pack_Entry* entry = &pack->entries[asset_idx];
+        if (entry->type == (uint32_t)type) {
+            int char_idx = 0;
+            while (char_idx < ASSET_PACK_NAME_LENGTH && entry->name[char_idx] == name[char_idx] && name[char_idx]) {
+                ++char_idx;
+            }
+            if (char_idx == ASSET_PACK_NAME_LENGTH || entry->name[char_idx] == name[char_idx]) {
+                result = (int)asset_idx;
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+inline Asset_Bitmap
+AssetPackGetBitmap(Asset_Pack* pack, int asset_idx) {
+    Asset_Bitmap result = {};
+    if (asset_idx >= 0 && (uint32_t)asset_idx < pack->asset_count &&
+        pack->entries[asset_idx].type == AssetType_Bitmap) {
+        Asset_Pack_Entry* entry = &pack->entries[asset_idx];
+        result.width  = (int)entry->bitmap.width;
+        result.height = (int)entry->bitmap.height;
+        result.pitch  = (int)entry->bitmap.pitch;
+        result.memory = pack->base + entry->data_offset;
+    }
+    return result;
+}
+
+inline Asset_Sound
+AssetPackGetSound(Asset_Pack* pack, int asset_idx) {
+    Asset_Sound result = {};
+    if (asset_idx >= 0 && (uint32_t)asset_idx < pack->asset_count &&
+        pack->entries[asset_idx].type == AssetType_Sound) {
+        Asset_Pack_Entry* entry = &pack->entries[asset_idx];
+        result.sample_count       = entry->sound.sample_count;
+        result.channel_count      = entry->sound.channel_count;
+        result.samples_per_second = entry->sound.samples_per_second;
+        result.samples            = (const int16_t*)(pack->base + entry->data_offset);
+    }
+    return result;
+}
+
+inline Asset_Font
+AssetPackGetFont(Asset_Pack* pack, int asset_idx) {
+    Asset_Font result = {};
+    if (asset_idx >= 0 && (uint32_t)asset_idx < pack->asset_count &&
+        pack->entries[asset_idx].type == AssetType_Font) {
+        Asset_Pack_Entry* entry = &pack->entries[asset_idx];
+        result.first_codepoint = entry->font.first_codepoint;
+        result.glyph_count     = entry->font.glyph_count;
+        result.glyph_width     = (int)entry->font.glyph_width;
+        result.glyph_height    = (int)entry->font.glyph_height;
+        result.glyphs          = pack->base + entry->data_offset;
+    }
+    return result;
+}
+
+// NOTE: coverage of one glyph, glyph_width * glyph_height bytes, NULL when the codepoint isn't in the font
+inline const uint8_t*
+AssetFontGetGlyph(Asset_Font* font, uint32_t codepoint) {
+    const uint8_t* result = 0;
+    if (codepoint >= font->first_codepoint && codepoint - font->first_codepoint < font->glyph_count) {
+        uint32_t glyph_size = (uint32_t)(font->glyph_width * font->glyph_height);
+        result              = font->glyphs + (codepoint - font->first_codepoint) * glyph_size;
+    }
+    return result;
+}
+
+#endif
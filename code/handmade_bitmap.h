@@ -0,0 +1,123 @@
+#ifndef HANDMADE_BITMAP_H
+#define HANDMADE_BITMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include "base.h"
+#include "handmade_file_formats.h"
+
+/*
+ NOTE: bitmaps are stored the way the backbuffer wants them, BGRA in a uint32_t (0xAARRGGBB), top-down, with the color
+ premultiplied by alpha once when they're loaded. Premultiplying happens in the linear space the blend works in, color
+ is squared to get linear so the stored sRGB byte is c * sqrt(a), which squares back to c^2 * a. Nothing at draw time
+ has to look at alpha to know how much color there is.
+
+ Decoding is split so the caller owns the pixels: BitmapReadBMPSize checks the file and fills in the size, the caller
+ picks a pitch and puts pitch * height bytes in memory, BitmapDecodeBMP fills them. The game pushes them on an arena,
+ the asset packer mallocs them. Only uncompressed 24 and 32-bit files, BI_RGB or BI_BITFIELDS with 8-bit channels.
+ */
+
+// NOTE: pitch is in bytes. The game keeps rows 16-byte aligned so they can be read with aligned loads.
+struct Loaded_Bitmap {
+    int   width;
+    int   height;
+    int   pitch;
+    void* memory;
+};
+
+// NOTE: straight alpha sRGB in, premultiplied out, see above
+inline uint32_t
+BitmapPremultiply(uint32_t color) {
+    uint32_t alpha  = color >> 24;
+    uint32_t result = color;
+    if (alpha != 0xFF) {
+        float32_t coverage = sqrtf((float32_t)alpha / 255.0f);
+        uint32_t  red      = (uint32_t)((float32_t)((color >> 16) & 0xFF) * coverage + 0.5f);
+        uint32_t  green    = (uint32_t)((float32_t)((color >> 8) & 0xFF) * coverage + 0.5f);
+        uint32_t  blue     = (uint32_t)((float32_t)((color >> 0) & 0xFF) * coverage + 0.5f);
+        result             = (alpha << 24) | (red << 16) | (green << 8) | (blue << 0);
+    }
+    return result;
+}
+
+inline uint32_t
+BitmapLowestSetBit(uint32_t value) {
+    uint32_t result = 0;
+    for (uint32_t bit_idx = 0; bit_idx < 32; ++bit_idx) {
+        if (value & (1u << bit_idx)) {
+            result = bit_idx;
+            break;
+        }
+    }
+    return result;
+}
+
+// NOTE: the masks are only in the file when compression is BI_BITFIELDS, and the alpha one only after a V4 or V5 info
+// header, a plain 40 byte one is followed by the pixels or the three color masks
+inline bool
+BitmapReadBMPSize(const void* content, uint32_t content_size, Loaded_Bitmap* result) {
+    bool                 is_valid  = false;
+    const Bitmap_Header* header    = (const Bitmap_Header*)content;
+    uint32_t             info_end  = (uint32_t)offsetof(Bitmap_Header, red_mask);
+    uint32_t             masks_end = (uint32_t)sizeof(Bitmap_Header);
+    if (content && content_size >= info_end && header->file_type == 0x4D42 &&
+        (header->bits_per_pixel == 24 || header->bits_per_pixel == 32) &&
+        (header->compression == 0 || (header->compression == 3 && content_size >= masks_end)) && header->width > 0 &&
+        header->height != 0) {
+        int      height       = header->height > 0 ? header->height : -header->height;
+        uint64_t source_pitch = ((uint64_t)header->width * (header->bits_per_pixel / 8) + 3) & ~3ull;
+        if (header->bitmap_offset <= content_size && source_pitch * height <= content_size - header->bitmap_offset) {
+            is_valid       = true;
+            result->width  = header->width;
+            result->height = height;
+        }
+    }
+    return is_valid;
+}
+
+// NOTE: result comes from BitmapReadBMPSize with pitch and memory filled in by the caller
+inline void
+BitmapDecodeBMP(const void* content, Loaded_Bitmap* result) {
+    const Bitmap_Header* header = (const Bitmap_Header*)content;
+
+    uint32_t red_mask   = 0x00FF0000;
+    uint32_t green_mask = 0x0000FF00;
+    uint32_t blue_mask  = 0x000000FF;
+    uint32_t alpha_mask = 0;
+    if (header->compression == 3) {
+        red_mask   = header->red_mask;
+        green_mask = header->green_mask;
+        blue_mask  = header->blue_mask;
+        alpha_mask = header->size > 40 ? header->alpha_mask : 0;
+    }
+    uint32_t red_shift   = BitmapLowestSetBit(red_mask);
+    uint32_t green_shift = BitmapLowestSetBit(green_mask);
+    uint32_t blue_shift  = BitmapLowestSetBit(blue_mask);
+    uint32_t alpha_shift = BitmapLowestSetBit(alpha_mask);
+
+    bool           is_bottom_up    = header->height > 0;
+    int            bytes_per_pixel = header->bits_per_pixel / 8;
+    int            source_pitch    = (header->width * bytes_per_pixel + 3) & ~3;
+    const uint8_t* source          = (const uint8_t*)content + header->bitmap_offset;
+    for (int y = 0; y < result->height; ++y) {
+        int            source_y   = is_bottom_up ? (result->height - 1 - y) : y;
+        const uint8_t* source_row = source + source_y * source_pitch;
+        uint32_t*      dest_row   = (uint32_t*)((uint8_t*)result->memory + y * result->pitch);
+        for (int x = 0; x < result->width; ++x) {
+            const uint8_t* at    = source_row + x * bytes_per_pixel;
+            uint32_t       color = at[0] | (at[1] << 8) | (at[2] << 16);
+            if (bytes_per_pixel == 4) {
+                color |= (uint32_t)at[3] << 24;
+            }
+
+            uint32_t red   = (color & red_mask) >> red_shift;
+            uint32_t green = (color & green_mask) >> green_shift;
+            uint32_t blue  = (color & blue_mask) >> blue_shift;
+            uint32_t alpha = alpha_mask ? ((color & alpha_mask) >> alpha_shift) : 0xFF;
+            dest_row[x]    = BitmapPremultiply((alpha << 24) | (red << 16) | (green << 8) | (blue << 0));
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,188 @@
+#ifndef HANDMADE_BLEND_H
+#define HANDMADE_BLEND_H
+
+#include <stdint.h>
+#include <emmintrin.h>
+#include "base.h"
+#include "handmade_bitmap.h"
+
+/*
+ NOTE: blending onto BGRX8888 buffers in linear space. Colors in bitmaps and in the buffer are sRGB bytes, they're
+ turned into linear floats by squaring (gamma 2, a multiply instead of the sRGB curve) and go back through a square
+ root. A blend comes out within about 10 levels of what the real curve gives, the dark end is where they differ.
+ Bitmaps come premultiplied in that same linear space (see handmade_bitmap.h), so the source's color is added as is
+ and alpha only scales what's underneath. Opaque doesn't unpack anything, it copies the color and drops alpha.
+
+ Four pixels per step, one SSE register per channel. Each row starts with a partial step up to the first 16-byte
+ aligned pixel of the buffer, so the steps in between store aligned wherever the bitmap lands, and ends with a partial
+ step for what's left. Partial steps go through a copy of the pixels so every pixel gets the same math whatever its
+ position.
+
+ The modes are structs like the pixel formats, BlendBitmap_ is instantiated for each so the combine is inlined and
+ opaque never reads the buffer.
+ */
+#define BLEND_SIMD_WIDTH 4
+
+struct Blend_Pixels {
+    __m128 r;
+    __m128 g;
+    __m128 b;
+    __m128 a;
+};
+
+// NOTE: sRGB bytes to linear [0, 1], alpha stays linear
+inline Blend_Pixels
+BlendUnpack(__m128i pixels) {
+    __m128       inverse_255 = _mm_set1_ps(1.0f / 255.0f);
+    __m128i      byte_mask   = _mm_set1_epi32(0xFF);
+    Blend_Pixels result;
+    result.r = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, 16), byte_mask)), inverse_255);
+    result.g = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, 8), byte_mask)), inverse_255);
+    result.b = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(pixels, byte_mask)), inverse_255);
+    result.a = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(pixels, 24)), inverse_255);
+    result.r = _mm_mul_ps(result.r, result.r);
+    result.g = _mm_mul_ps(result.g, result.g);
+    result.b = _mm_mul_ps(result.b, result.b);
+    return result;
+}
+
+// NOTE: one channel, linear back to sRGB bytes, clamped to [0, 1] first and rounded to nearest
+inline __m128i
+BlendLinearToByte(__m128 value) {
+    __m128 clamped = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_sqrt_ps(clamped), _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+}
+
+// NOTE: the X byte is 0 like Pixel::Pack
+inline __m128i
+BlendPack(Blend_Pixels pixels) {
+    __m128i r = _mm_slli_epi32(BlendLinearToByte(pixels.r), 16);
+    __m128i g = _mm_slli_epi32(BlendLinearToByte(pixels.g), 8);
+    __m128i b = BlendLinearToByte(pixels.b);
+    return _mm_or_si128(_mm_or_si128(r, g), b);
+}
+
+// NOTE: Combine gets 4 premultiplied source pixels and the 4 buffer pixels they go over, both packed, and returns
+// what goes in the buffer
+
+// NOTE: the source replaces what's there, alpha is ignored so translucent pixels come out as if over black
+struct Blend_Opaque {
+    static inline __m128i
+    Combine(__m128i source, __m128i dest) {
+        return _mm_and_si128(source, _mm_set1_epi32(0x00FFFFFF));
+    }
+};
+
+// NOTE: source over dest
+struct Blend_Alpha {
+    static inline __m128i
+    Combine(__m128i source, __m128i dest) {
+        Blend_Pixels result        = BlendUnpack(source);
+        Blend_Pixels under         = BlendUnpack(dest);
+        __m128       inverse_alpha = _mm_sub_ps(_mm_set1_ps(1.0f), result.a);
+        result.r                   = _mm_add_ps(result.r, _mm_mul_ps(under.r, inverse_alpha));
+        result.g                   = _mm_add_ps(result.g, _mm_mul_ps(under.g, inverse_alpha));
+        result.b                   = _mm_add_ps(result.b, _mm_mul_ps(under.b, inverse_alpha));
+        return BlendPack(result);
+    }
+};
+
+// NOTE: light, the sum saturates when it's packed
+struct Blend_Additive {
+    static inline __m128i
+    Combine(__m128i source, __m128i dest) {
+        Blend_Pixels result = BlendUnpack(source);
+        Blend_Pixels under  = BlendUnpack(dest);
+        result.r            = _mm_add_ps(result.r, under.r);
+        result.g            = _mm_add_ps(result.g, under.g);
+        result.b            = _mm_add_ps(result.b, under.b);
+        return BlendPack(result);
+    }
+};
+
+// NOTE: dest has to be 16-byte aligned, source doesn't
+template <typename Mode>
+inline void
+BlendStep_(uint32_t* source, uint32_t* dest) {
+    __m128i pixels = Mode::Combine(_mm_loadu_si128((__m128i*)source), _mm_load_si128((__m128i*)dest));
+    _mm_store_si128((__m128i*)dest, pixels);
+}
+
+// NOTE: fewer than BLEND_SIMD_WIDTH pixels, anywhere
+template <typename Mode>
+inline void
+BlendPartialStep_(uint32_t* source, uint32_t* dest, int count) {
+    uint32_t source_lanes[BLEND_SIMD_WIDTH] = {};
+    uint32_t dest_lanes[BLEND_SIMD_WIDTH]   = {};
+    for (int idx = 0; idx < count; ++idx) {
+        source_lanes[idx] = source[idx];
+        dest_lanes[idx]   = dest[idx];
+    }
+    __m128i pixels = Mode::Combine(_mm_loadu_si128((__m128i*)source_lanes), _mm_loadu_si128((__m128i*)dest_lanes));
+    _mm_storeu_si128((__m128i*)dest_lanes, pixels);
+    for (int idx = 0; idx < count; ++idx) {
+        dest[idx] = dest_lanes[idx];
+    }
+}
+
+// NOTE: the bitmap's top left goes at (x, y) in the buffer, clipped to it
+template <typename Mode>
+inline void
+BlendBitmap_(Game_Offscreen_Buffer* buffer, Loaded_Bitmap* bitmap, int x, int y) {
+    int min_x = x < 0 ? 0 : x;
+    int min_y = y < 0 ? 0 : y;
+    int max_x = x + bitmap->width > buffer->width ? buffer->width : x + bitmap->width;
+    int max_y = y + bitmap->height > buffer->height ? buffer->height : y + bitmap->height;
+    if (min_x >= max_x || min_y >= max_y) {
+        return;
+    }
+
+    int count = max_x - min_x;
+    for (int row_y = min_y; row_y < max_y; ++row_y) {
+        uint32_t* dest   = (uint32_t*)((uint8_t*)buffer->memory + row_y * buffer->pitch) + min_x;
+        uint32_t* source = (uint32_t*)((uint8_t*)bitmap->memory + (row_y - y) * bitmap->pitch) + (min_x - x);
+
+        // NOTE: pixels up to the next 16 bytes of the buffer, the pitch can leave every row misaligned differently
+        int head_count = (int)((16 - ((uintptr_t)dest & 15)) & 15) / (int)sizeof(uint32_t);
+        head_count     = head_count > count ? count : head_count;
+        if (head_count) {
+            BlendPartialStep_<Mode>(source, dest, head_count);
+        }
+
+        int group_end = head_count + ((count - head_count) & ~(BLEND_SIMD_WIDTH - 1));
+        for (int idx = head_count; idx < group_end; idx += BLEND_SIMD_WIDTH) {
+            BlendStep_<Mode>(source + idx, dest + idx);
+        }
+
+        if (group_end < count) {
+            BlendPartialStep_<Mode>(source + group_end, dest + group_end, count - group_end);
+        }
+    }
+}
+
+enum Blend_Mode {
+    BlendMode_Opaque,
+    BlendMode_Alpha,
+    BlendMode_Additive,
+};
+
+// NOTE: only BGRX8888 buffers, there's nothing to blend into in RGB565 that's worth the conversions
+inline void
+BlendBitmap(Game_Offscreen_Buffer* buffer, Loaded_Bitmap* bitmap, int x, int y, Blend_Mode mode) {
+    Assert(buffer->pixel_format == GamePixelFormat_BGRX8888);
+    switch (mode) {
+        case BlendMode_Opaque: {
+            BlendBitmap_<Blend_Opaque>(buffer, bitmap, x, y);
+        } break;
+
+        case BlendMode_Alpha: {
+            BlendBitmap_<Blend_Alpha>(buffer, bitmap, x, y);
+        } break;
+
+        case BlendMode_Additive: {
+            BlendBitmap_<Blend_Additive>(buffer, bitmap, x, y);
+        } break;
+    }
+}
+
+#endif
@@ -0,0 +1,529 @@
+#ifndef HANDMADE_DEBUG_OVERLAY_H
+#define HANDMADE_DEBUG_OVERLAY_H
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "base.h"
+
+/*
+ NOTE: debug drawing that doesn't know about the platform. Anything can push rectangles, lines and text during the
+ frame, they're only recorded, DebugOverlayRender draws the whole batch in one pass over the buffer it's given: shades
+ and rectangles first, then lines, then text. Colors are 0xRRGGBB whatever the buffer format is, text uses the 3x5 font
+ below scaled up by whole pixels. Pushes past the end of the batch are dropped and counted.
+
+ Built on that: a rolling graph of the last DEBUG_FRAME_GRAPH_LENGTH frames with a bar per frame stacked by phase and a
+ line at the target frame time, and lanes with the audio cursors as the platform saw them.
+
+ The overlay keeps its own cost under budget_fraction of the target frame time. The caller times the pushes and the
+ render and reports it to DebugOverlayEndFrame, when the average goes over budget the overlay drops to a cheaper level
+ of detail, it goes back up once the cost measured last time at that level fits again. That cost is slowly forgotten
+ while the overlay stays under budget, a level that was too expensive gets tried again once in a while.
+ */
+#define DEBUG_OVERLAY_MAX_RECTS  2048
+#define DEBUG_OVERLAY_MAX_LINES  512
+#define DEBUG_OVERLAY_MAX_TEXTS  64
+#define DEBUG_OVERLAY_TEXT_BYTES 4096
+#define DEBUG_OVERLAY_MAX_PHASES 8
+#define DEBUG_FRAME_GRAPH_LENGTH 128
+
+#define DEBUG_OVERLAY_DROP_FRAMES     4
+#define DEBUG_OVERLAY_RAISE_FRAMES    30
+#define DEBUG_OVERLAY_RAISE_FRACTION  0.75f // of the budget, the next level's cost has to stay below this
+#define DEBUG_OVERLAY_COOLDOWN_FRAMES 15
+#define DEBUG_OVERLAY_FORGET          0.99f // per frame under budget, of the cost remembered for the next level
+
+#define DEBUG_FONT_WIDTH     3
+#define DEBUG_FONT_HEIGHT    5
+#define DEBUG_FONT_FIRST     ' '
+#define DEBUG_FONT_LAST      '_'
+#define DEBUG_TEXT_SCALE     2
+#define DEBUG_TEXT_ADVANCE   ((DEBUG_FONT_WIDTH + 1) * DEBUG_TEXT_SCALE)
+#define DEBUG_TEXT_LINE      ((DEBUG_FONT_HEIGHT + 2) * DEBUG_TEXT_SCALE)
+
+// NOTE: ' ' through '_', 5 rows of 3 bits from the top, the high bit is the left column. Lower case is drawn as upper.
+global const uint16_t g_debug_font[DEBUG_FONT_LAST - DEBUG_FONT_FIRST + 1] = {
+    0x0000, 0x2482, 0x5A00, 0x5F7D, 0x3C9E, 0x52A5, 0x2AAB, 0x2400, 0x1491, 0x4494, 0x55D5, 0x05D0, 0x0014, 0x01C0,
+    0x0002, 0x12A4, 0x7B6F, 0x2C97, 0x73E7, 0x73CF, 0x5BC9, 0x79CF, 0x79EF, 0x7249, 0x7BEF, 0x7BCF, 0x0410, 0x0414,
+    0x1511, 0x0E38, 0x4454, 0x7282, 0x7BE3, 0x2BED, 0x6BAE, 0x3923, 0x6B6E, 0x79A7, 0x79A4, 0x396B, 0x5BED, 0x7497,
+    0x126A, 0x5BAD, 0x4927, 0x5FED, 0x6B6D, 0x2B6A, 0x6BA4, 0x2B73, 0x6BAD, 0x388E, 0x7492, 0x5B6F, 0x5B6A, 0x5BFD,
+    0x5AAD, 0x5A92, 0x72A7, 0x6926, 0x4889, 0x324B, 0x2A00, 0x0007,
+};
+
+enum Debug_Overlay_Detail {
+    DebugOverlayDetail_Text,  // numbers only
+    DebugOverlayDetail_Graph, // and a bar per frame
+    DebugOverlayDetail_Full,  // bars stacked by phase and the audio lanes
+
+    DebugOverlayDetail_Count,
+};
+
+struct Debug_Rect {
+    int      min_x;
+    int      min_y;
+    int      max_x;
+    int      max_y;
+    uint32_t color;
+    bool     is_shade; // NOTE: halves what's under it instead of filling with color
+};
+
+struct Debug_Line {
+    int      x0;
+    int      y0;
+    int      x1;
+    int      y1;
+    uint32_t color;
+};
+
+struct Debug_Text {
+    int      x;
+    int      y;
+    uint32_t color;
+    uint32_t first_byte; // into text_bytes
+    uint32_t byte_count;
+};
+
+struct Debug_Frame_Record {
+    float32_t frame_ms;
+    float32_t phase_ms[DEBUG_OVERLAY_MAX_PHASES];
+};
+
+// NOTE: byte positions in the platform's looping sound buffer, written when it outputs sound and when it flips
+struct Debug_Audio_Marker {
+    uint32_t output_play_cursor;
+    uint32_t output_write_cursor;
+    uint32_t output_location;
+    uint32_t output_bytes;
+
+    uint32_t expected_flip_play_cursor;
+    uint32_t flip_play_cursor;
+    uint32_t flip_write_cursor;
+};
+
+struct Debug_Overlay {
+    // batch, reset every frame
+    uint32_t   rect_count;
+    uint32_t   line_count;
+    uint32_t   text_count;
+    uint32_t   text_byte_count;
+    uint32_t   dropped_count;
+    Debug_Rect rects[DEBUG_OVERLAY_MAX_RECTS];
+    Debug_Line lines[DEBUG_OVERLAY_MAX_LINES];
+    Debug_Text texts[DEBUG_OVERLAY_MAX_TEXTS];
+    char       text_bytes[DEBUG_OVERLAY_TEXT_BYTES];
+
+    // frame graph
+    float32_t          target_ms;
+    int                phase_count;
+    const char*        phase_names[DEBUG_OVERLAY_MAX_PHASES];
+    uint32_t           frame_idx; // where the next frame goes
+    uint32_t           frame_count;
+    Debug_Frame_Record frames[DEBUG_FRAME_GRAPH_LENGTH];
+
+    // own cost
+    float32_t budget_fraction;
+    float32_t cost_ms; // moving average
+    float32_t detail_cost_ms[DebugOverlayDetail_Count];
+    int       detail;
+    int       frames_over;
+    int       frames_under;
+    int       cooldown_frames;
+};
+
+global const uint32_t g_debug_phase_colors[DEBUG_OVERLAY_MAX_PHASES] = {
+    0x4080FF, 0x40D040, 0xFFC040, 0xD050D0, 0x40D0D0, 0xFF6040, 0xA0A0A0, 0xFFFFFF,
+};
+
+inline void
+DebugOverlayInit(
+    Debug_Overlay* overlay,
+    float32_t      target_ms,
+    float32_t      budget_fraction,
+    int            phase_count,
+    const char**   phase_names) {
+
+    Assert(phase_count <= DEBUG_OVERLAY_MAX_PHASES);
+    *overlay                 = {};
+    overlay->target_ms       = target_ms;
+    overlay->budget_fraction = budget_fraction;
+    overlay->phase_count     = phase_count;
+    overlay->detail          = DebugOverlayDetail_Full;
+    for (int phase_idx = 0; phase_idx < phase_count; ++phase_idx) {
+        overlay->phase_names[phase_idx] = phase_names[phase_idx];
+    }
+}
+
+inline void
+DebugOverlayBeginFrame(Debug_Overlay* overlay) {
+    overlay->rect_count      = 0;
+    overlay->line_count      = 0;
+    overlay->text_count      = 0;
+    overlay->text_byte_count = 0;
+    overlay->dropped_count   = 0;
+}
+
+inline void
+DebugPushRect(Debug_Overlay* overlay, int min_x, int min_y, int max_x, int max_y, uint32_t color) {
+    if (overlay->rect_count == DEBUG_OVERLAY_MAX_RECTS) {
+        ++overlay->dropped_count;
+        return;
+    }
+    overlay->rects[overlay->rect_count++] = {min_x, min_y, max_x, max_y, color, false};
+}
+
+inline void
+DebugPushShade(Debug_Overlay* overlay, int min_x, int min_y, int max_x, int max_y) {
+    if (overlay->rect_count == DEBUG_OVERLAY_MAX_RECTS) {
+        ++overlay->dropped_count;
+        return;
+    }
+    overlay->rects[overlay->rect_count++] = {min_x, min_y, max_x, max_y, 0, true};
+}
+
+inline void
+DebugPushLine(Debug_Overlay* overlay, int x0, int y0, int x1, int y1, uint32_t color) {
+    if (overlay->line_count == DEBUG_OVERLAY_MAX_LINES) {
+        ++overlay->dropped_count;
+        return;
+    }
+    overlay->lines[overlay->line_count++] = {x0, y0, x1, y1, color};
+}
+
+// NOTE: printf style, returns the x where the text ended so pieces in different colors can follow each other
+inline int
+DebugPushText(Debug_Overlay* overlay, int x, int y, uint32_t color, const char* format, ...) {
+    uint32_t space = DEBUG_OVERLAY_TEXT_BYTES - overlay->text_byte_count;
+    if (overlay->text_count == DEBUG_OVERLAY_MAX_TEXTS || space < 2) {
+        ++overlay->dropped_count;
+        return x;
+    }
+
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(overlay->text_bytes + overlay->text_byte_count, space, format, args);
+    va_end(args);
+    if (length < 0) {
+        return x;
+    }
+
+    uint32_t    byte_count = (uint32_t)length < space ? (uint32_t)length : space - 1;
+    Debug_Text* text       = &overlay->texts[overlay->text_count++];
+    text->x                = x;
+    text->y                = y;
+    text->color            = color;
+    text->first_byte       = overlay->text_byte_count;
+    text->byte_count       = byte_count;
+    overlay->text_byte_count += byte_count;
+    return x + (int)byte_count * DEBUG_TEXT_ADVANCE;
+}
+
+inline void
+DebugOverlayRecordFrame(Debug_Overlay* overlay, float32_t frame_ms, float32_t* phase_ms) {
+    Debug_Frame_Record* record = &overlay->frames[overlay->frame_idx];
+    record->frame_ms           = frame_ms;
+    for (int phase_idx = 0; phase_idx < overlay->phase_count; ++phase_idx) {
+        record->phase_ms[phase_idx] = phase_ms[phase_idx];
+    }
+    overlay->frame_idx = (overlay->frame_idx + 1) % DEBUG_FRAME_GRAPH_LENGTH;
+    if (overlay->frame_count < DEBUG_FRAME_GRAPH_LENGTH) {
+        ++overlay->frame_count;
+    }
+}
+
+/// Widgets
+// NOTE: a bar_width wide bar per frame, oldest on the left. The graph goes up to twice the target, taller frames are
+// cut off with a red cap. Returns the y below the graph.
+inline int
+DebugOverlayPushFrameGraph(Debug_Overlay* overlay, int x, int y, int bar_width, int height) {
+    int text_y = y;
+    y += DEBUG_TEXT_LINE;
+
+    // NOTE: averages over the whole graph
+    float32_t frame_ms                           = 0.0f;
+    float32_t worst_ms                           = 0.0f;
+    float32_t phase_ms[DEBUG_OVERLAY_MAX_PHASES] = {};
+    for (uint32_t frame_idx = 0; frame_idx < overlay->frame_count; ++frame_idx) {
+        Debug_Frame_Record* record = &overlay->frames[frame_idx];
+        frame_ms += record->frame_ms;
+        worst_ms = record->frame_ms > worst_ms ? record->frame_ms : worst_ms;
+        for (int phase_idx = 0; phase_idx < overlay->phase_count; ++phase_idx) {
+            phase_ms[phase_idx] += record->phase_ms[phase_idx];
+        }
+    }
+    float32_t frame_count = overlay->frame_count ? (float32_t)overlay->frame_count : 1.0f;
+
+    int text_x = DebugPushText(
+        overlay, x, text_y, 0xFFFFFF, "FRAME %.2fMS WORST %.2fMS /", frame_ms / frame_count, worst_ms);
+    for (int phase_idx = 0; phase_idx < overlay->phase_count; ++phase_idx) {
+        text_x = DebugPushText(
+            overlay,
+            text_x,
+            text_y,
+            g_debug_phase_colors[phase_idx],
+            " %s %.2f",
+            overlay->phase_names[phase_idx],
+            phase_ms[phase_idx] / frame_count);
+    }
+    if (overlay->detail < DebugOverlayDetail_Graph) {
+        return y;
+    }
+
+    float32_t pixels_per_ms = (float32_t)height / (2.0f * overlay->target_ms);
+    int       width         = DEBUG_FRAME_GRAPH_LENGTH * bar_width;
+    int       bottom        = y + height;
+    DebugPushShade(overlay, x, y, x + width, bottom);
+
+    uint32_t first_frame = (overlay->frame_idx + DEBUG_FRAME_GRAPH_LENGTH - overlay->frame_count);
+    for (uint32_t bar_idx = 0; bar_idx < overlay->frame_count; ++bar_idx) {
+        Debug_Frame_Record* record = &overlay->frames[(first_frame + bar_idx) % DEBUG_FRAME_GRAPH_LENGTH];
+        int                 bar_x  = x + (int)(DEBUG_FRAME_GRAPH_LENGTH - overlay->frame_count + bar_idx) * bar_width;
+        int                 bar_y  = bottom;
+        if (overlay->detail == DebugOverlayDetail_Full) {
+            float32_t phase_top_ms = 0.0f;
+            for (int phase_idx = 0; phase_idx < overlay->phase_count; ++phase_idx) {
+                phase_top_ms += record->phase_ms[phase_idx];
+                int phase_y = bottom - (int)(pixels_per_ms * phase_top_ms);
+                phase_y     = phase_y < y ? y : phase_y;
+                if (phase_y < bar_y) {
+                    uint32_t color = g_debug_phase_colors[phase_idx];
+                    DebugPushRect(overlay, bar_x, phase_y, bar_x + bar_width - 1, bar_y, color);
+                    bar_y = phase_y;
+                }
+            }
+        }
+
+        // NOTE: the rest of the frame is the wait for the frame boundary
+        int frame_y = bottom - (int)(pixels_per_ms * record->frame_ms);
+        frame_y     = frame_y < y ? y : frame_y;
+        if (frame_y < bar_y) {
+            uint32_t color = record->frame_ms > overlay->target_ms ? 0xC04040 : 0x606060;
+            DebugPushRect(overlay, bar_x, frame_y, bar_x + bar_width - 1, bar_y, color);
+        }
+        if (frame_y == y) {
+            DebugPushRect(overlay, bar_x, y, bar_x + bar_width - 1, y + 2, 0xFF0000);
+        }
+    }
+
+    int target_y = bottom - (int)(pixels_per_ms * overlay->target_ms);
+    int label_y  = target_y - DEBUG_FONT_HEIGHT * DEBUG_TEXT_SCALE / 2;
+    DebugPushLine(overlay, x, target_y, x + width - 1, target_y, 0xFFFFFF);
+    DebugPushText(overlay, x + width + 4, label_y, 0xFFFFFF, "%.1fMS", overlay->target_ms);
+    return bottom;
+}
+
+// NOTE: the sound buffer is width pixels wide. The top lane has the play (white) and write (magenta) cursors at every
+// flip, under it for the latest marker: the cursors when sound was output, the region that was written and the play
+// cursor it expected at the flip (green, across every lane). Returns the y below the lanes.
+inline int
+DebugOverlayPushAudioLanes(
+    Debug_Overlay*      overlay,
+    int                 x,
+    int                 y,
+    int                 width,
+    Debug_Audio_Marker* markers,
+    int                 marker_count,
+    int                 current_marker_idx,
+    uint32_t            buffer_size) {
+
+    if (overlay->detail < DebugOverlayDetail_Full || buffer_size == 0) {
+        return y;
+    }
+
+    int       lane_height = 16;
+    int       lane_gap    = 4;
+    int       bottom      = y + 3 * (lane_height + lane_gap);
+    float32_t scale       = (float32_t)width / (float32_t)buffer_size;
+    uint32_t  play_color  = 0xFFFFFF;
+    uint32_t  write_color = 0xFF00FF;
+    DebugPushShade(overlay, x, y, x + width, bottom);
+
+    for (int marker_idx = 0; marker_idx < marker_count; ++marker_idx) {
+        Debug_Audio_Marker* marker  = &markers[marker_idx];
+        int                 play_x  = x + (int)(scale * (float32_t)(marker->flip_play_cursor % buffer_size));
+        int                 write_x = x + (int)(scale * (float32_t)(marker->flip_write_cursor % buffer_size));
+        DebugPushLine(overlay, play_x, y, play_x, y + lane_height, play_color);
+        DebugPushLine(overlay, write_x, y, write_x, y + lane_height, write_color);
+    }
+
+    if (current_marker_idx >= 0 && current_marker_idx < marker_count) {
+        Debug_Audio_Marker* marker    = &markers[current_marker_idx];
+        uint32_t            values[4] = {
+            marker->output_play_cursor,
+            marker->output_write_cursor,
+            marker->output_location,
+            marker->output_location + marker->output_bytes,
+        };
+        for (int value_idx = 0; value_idx < (int)ArrayCount(values); ++value_idx) {
+            int      lane_y  = y + (1 + value_idx / 2) * (lane_height + lane_gap);
+            int      value_x = x + (int)(scale * (float32_t)(values[value_idx] % buffer_size));
+            uint32_t color   = value_idx % 2 ? write_color : play_color;
+            DebugPushLine(overlay, value_x, lane_y, value_x, lane_y + lane_height, color);
+        }
+
+        int expected_x = x + (int)(scale * (float32_t)(marker->expected_flip_play_cursor % buffer_size));
+        DebugPushLine(overlay, expected_x, y, expected_x, bottom, 0x00FF00);
+    }
+    return bottom;
+}
+
+/// Rendering
+template <typename Pixel>
+inline typename Pixel::Type
+DebugPackColor_(uint32_t color) {
+    return Pixel::Pack((color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF);
+}
+
+template <typename Pixel>
+inline void
+DebugOverlayFillRect_(Game_Offscreen_Buffer* buffer, Debug_Rect* rect) {
+    int min_x = rect->min_x < 0 ? 0 : rect->min_x;
+    int min_y = rect->min_y < 0 ? 0 : rect->min_y;
+    int max_x = rect->max_x > buffer->width ? buffer->width : rect->max_x;
+    int max_y = rect->max_y > buffer->height ? buffer->height : rect->max_y;
+
+    typename Pixel::Type color = DebugPackColor_<Pixel>(rect->color);
+    for (int y = min_y; y < max_y; ++y) {
+        typename Pixel::Type* row = (typename Pixel::Type*)((uint8_t*)buffer->memory + y * buffer->pitch);
+        if (rect->is_shade) {
+            for (int x = min_x; x < max_x; ++x) {
+                row[x] = Pixel::Halve(row[x]);
+            }
+        } else {
+            for (int x = min_x; x < max_x; ++x) {
+                row[x] = color;
+            }
+        }
+    }
+}
+
+template <typename Pixel>
+inline void
+DebugOverlayRender_(Debug_Overlay* overlay, Game_Offscreen_Buffer* buffer) {
+    for (uint32_t rect_idx = 0; rect_idx < overlay->rect_count; ++rect_idx) {
+        DebugOverlayFillRect_<Pixel>(buffer, &overlay->rects[rect_idx]);
+    }
+
+    // NOTE: Bresenham, lines are short and mostly axis aligned, clipping is per pixel
+    for (uint32_t line_idx = 0; line_idx < overlay->line_count; ++line_idx) {
+        Debug_Line*          line   = &overlay->lines[line_idx];
+        typename Pixel::Type color  = DebugPackColor_<Pixel>(line->color);
+        int                  dx     = line->x1 > line->x0 ? line->x1 - line->x0 : line->x0 - line->x1;
+        int                  dy     = line->y1 > line->y0 ? line->y0 - line->y1 : line->y1 - line->y0;
+        int                  step_x = line->x1 > line->x0 ? 1 : -1;
+        int                  step_y = line->y1 > line->y0 ? 1 : -1;
+        int                  error  = dx + dy;
+        int                  x      = line->x0;
+        int                  y      = line->y0;
+        for (;;) {
+            if (x >= 0 && y >= 0 && x < buffer->width && y < buffer->height) {
+                ((typename Pixel::Type*)((uint8_t*)buffer->memory + y * buffer->pitch))[x] = color;
+            }
+            if (x == line->x1 && y == line->y1) {
+                break;
+            }
+            int error2 = 2 * error;
+            if (error2 >= dy) {
+                error += dy;
+                x += step_x;
+            }
+            if (error2 <= dx) {
+                error += dx;
+                y += step_y;
+            }
+        }
+    }
+
+    // NOTE: a DEBUG_TEXT_SCALE square per lit font pixel
+    for (uint32_t text_idx = 0; text_idx < overlay->text_count; ++text_idx) {
+        Debug_Text* text = &overlay->texts[text_idx];
+        Debug_Rect  dot  = {};
+        dot.color        = text->color;
+        for (uint32_t byte_idx = 0; byte_idx < text->byte_count; ++byte_idx) {
+            uint32_t codepoint = (uint8_t)overlay->text_bytes[text->first_byte + byte_idx];
+            if (codepoint >= 'a' && codepoint <= 'z') {
+                codepoint -= 'a' - 'A';
+            }
+            if (codepoint < DEBUG_FONT_FIRST || codepoint > DEBUG_FONT_LAST) {
+                codepoint = '?';
+            }
+
+            uint32_t glyph   = g_debug_font[codepoint - DEBUG_FONT_FIRST];
+            int      glyph_x = text->x + (int)byte_idx * DEBUG_TEXT_ADVANCE;
+            for (int row = 0; row < DEBUG_FONT_HEIGHT; ++row) {
+                for (int column = 0; column < DEBUG_FONT_WIDTH; ++column) {
+                    int bit = (DEBUG_FONT_HEIGHT - 1 - row) * DEBUG_FONT_WIDTH + (DEBUG_FONT_WIDTH - 1 - column);
+                    if (glyph & (1u << bit)) {
+                        dot.min_x = glyph_x + column * DEBUG_TEXT_SCALE;
+                        dot.min_y = text->y + row * DEBUG_TEXT_SCALE;
+                        dot.max_x = dot.min_x + DEBUG_TEXT_SCALE;
+                        dot.max_y = dot.min_y + DEBUG_TEXT_SCALE;
+                        DebugOverlayFillRect_<Pixel>(buffer, &dot);
+                    }
+                }
+            }
+        }
+    }
+}
+
+inline void
+DebugOverlayRender(Debug_Overlay* overlay, Game_Offscreen_Buffer* buffer) {
+    switch (buffer->pixel_format) {
+        case GamePixelFormat_RGB565: {
+            DebugOverlayRender_<Pixel_RGB565>(overlay, buffer);
+        } break;
+
+        default: {
+            DebugOverlayRender_<Pixel_BGRX8888>(overlay, buffer);
+        } break;
+    }
+}
+
+/// Budget
+// NOTE: cost_ms is what the pushes and the render took this frame, returns true when the level of detail changed
+inline bool
+DebugOverlayEndFrame(Debug_Overlay* overlay, float32_t cost_ms) {
+    if (overlay->cost_ms == 0.0f) {
+        overlay->cost_ms = cost_ms;
+    } else {
+        overlay->cost_ms += 0.2f * (cost_ms - overlay->cost_ms);
+    }
+    overlay->detail_cost_ms[overlay->detail] = overlay->cost_ms;
+
+    if (overlay->cooldown_frames > 0) {
+        --overlay->cooldown_frames;
+        return false;
+    }
+
+    float32_t budget_ms = overlay->budget_fraction * overlay->target_ms;
+    if (overlay->cost_ms > budget_ms) {
+        overlay->frames_under = 0;
+        if (++overlay->frames_over >= DEBUG_OVERLAY_DROP_FRAMES && overlay->detail > DebugOverlayDetail_Text) {
+            --overlay->detail;
+            overlay->frames_over     = 0;
+            overlay->cooldown_frames = DEBUG_OVERLAY_COOLDOWN_FRAMES;
+            return true;
+        }
+    } else if (overlay->detail < DebugOverlayDetail_Full) {
+        overlay->frames_over = 0;
+
+        // NOTE: only goes back up when the last cost seen at the next level fits with room to spare
+        float32_t* next_cost_ms = &overlay->detail_cost_ms[overlay->detail + 1];
+        *next_cost_ms *= DEBUG_OVERLAY_FORGET;
+        if (*next_cost_ms < DEBUG_OVERLAY_RAISE_FRACTION * budget_ms) {
+            if (++overlay->frames_under >= DEBUG_OVERLAY_RAISE_FRAMES) {
+                ++overlay->detail;
+                overlay->frames_under    = 0;
+                overlay->cost_ms         = *next_cost_ms;
+                overlay->cooldown_frames = DEBUG_OVERLAY_COOLDOWN_FRAMES;
+                return true;
+            }
+        } else {
+            overlay->frames_under = 0;
+        }
+    } else {
+        overlay->frames_over = 0;
+    }
+    return false;
+}
+
+#endif
@@ -0,0 +1,211 @@
+#ifndef HANDMADE_ENTITY_H
+#define HANDMADE_ENTITY_H
+
+#include <stdint.h>
+#include <emmintrin.h>
+#include "base.h"
+
+/*
+ NOTE: entities are stored as structure of arrays, one array per component, indexed by a dense index in
+ [0, count). Removing an entity moves the last one into its place, so the arrays never have holes and the kernels run
+ over them without checking anything. Arrays are 64-byte aligned and padded to a multiple of ENTITY_SIMD_WIDTH, the
+ kernels always work on whole groups and the lanes past count are scratch.
+
+ The dense index of an entity changes when another one is removed, so the rest of the game holds Entity_Handles
+ instead: a slot that stays with the entity for its whole life plus the slot's generation. A slot's generation is odd
+ while an entity lives in it and goes up on every add and remove, so a handle to a removed entity stops resolving even
+ after the slot is reused.
+
+ All pointers point into the arena the store was made in, see EntityStoreRebase when that memory moves.
+ */
+#define ENTITY_SIMD_WIDTH 4
+
+struct Entity_Handle {
+    uint32_t slot;
+    uint32_t generation; // 0 is the null handle
+};
+
+struct Entity_Store {
+    uint32_t capacity;
+    uint32_t count;
+
+    // NOTE: world rectangle the entities bounce around in and how much velocity they lose per second
+    float32_t min_x;
+    float32_t min_y;
+    float32_t max_x;
+    float32_t max_y;
+    float32_t drag;
+
+    // components, by dense index
+    float32_t* position_x;
+    float32_t* position_y;
+    float32_t* velocity_x;
+    float32_t* velocity_y;
+    uint32_t*  dense_to_slot;
+
+    // handles, by slot
+    uint32_t* slot_generation;
+    uint32_t* slot_to_dense; // next free slot while the slot is free
+    uint32_t  free_slot_head;
+    uint32_t  used_slot_count; // slots at or past this were never handed out
+};
+
+#define ENTITY_NO_SLOT 0xFFFFFFFF
+
+inline void
+EntityStoreInit(Entity_Store* store, Memory_Arena* arena, uint32_t capacity, float32_t width, float32_t height) {
+    uint32_t padded_capacity = AlignPow2(capacity, ENTITY_SIMD_WIDTH);
+
+    *store                 = {};
+    store->capacity        = capacity;
+    store->max_x           = width;
+    store->max_y           = height;
+    store->drag            = 1.0f;
+    store->position_x      = (float32_t*)PushSize_(arena, padded_capacity * sizeof(float32_t), MemoryTag_Entities, 64);
+    store->position_y      = (float32_t*)PushSize_(arena, padded_capacity * sizeof(float32_t), MemoryTag_Entities, 64);
+    store->velocity_x      = (float32_t*)PushSize_(arena, padded_capacity * sizeof(float32_t), MemoryTag_Entities, 64);
+    store->velocity_y      = (float32_t*)PushSize_(arena, padded_capacity * sizeof(float32_t), MemoryTag_Entities, 64);
+    store->dense_to_slot   = (uint32_t*)PushSize_(arena, padded_capacity * sizeof(uint32_t), MemoryTag_Entities, 64);
+    store->slot_generation = (uint32_t*)PushSize_(arena, capacity * sizeof(uint32_t), MemoryTag_Entities, 64);
+    store->slot_to_dense   = (uint32_t*)PushSize_(arena, capacity * sizeof(uint32_t), MemoryTag_Entities, 64);
+    store->free_slot_head  = ENTITY_NO_SLOT;
+    for (uint32_t slot = 0; slot < capacity; ++slot) {
+        store->slot_generation[slot] = 0;
+    }
+}
+
+// NOTE: removes every entity, handles to them stop resolving
+inline void
+EntityStoreClear(Entity_Store* store) {
+    for (uint32_t slot = 0; slot < store->used_slot_count; ++slot) {
+        store->slot_generation[slot] += store->slot_generation[slot] & 1;
+    }
+    store->count           = 0;
+    store->used_slot_count = 0;
+    store->free_slot_head  = ENTITY_NO_SLOT;
+}
+
+// NOTE: for when the memory the store lives in is now at a different address, e.g. a save loaded in another run
+inline void
+EntityStoreRebase(Entity_Store* store, intptr_t delta) {
+    store->position_x      = (float32_t*)((uint8_t*)store->position_x + delta);
+    store->position_y      = (float32_t*)((uint8_t*)store->position_y + delta);
+    store->velocity_x      = (float32_t*)((uint8_t*)store->velocity_x + delta);
+    store->velocity_y      = (float32_t*)((uint8_t*)store->velocity_y + delta);
+    store->dense_to_slot   = (uint32_t*)((uint8_t*)store->dense_to_slot + delta);
+    store->slot_generation = (uint32_t*)((uint8_t*)store->slot_generation + delta);
+    store->slot_to_dense   = (uint32_t*)((uint8_t*)store->slot_to_dense + delta);
+}
+
+// NOTE: returns the null handle when the store is full
+inline Entity_Handle
+EntityAdd(Entity_Store* store, float32_t x, float32_t y, float32_t velocity_x, float32_t velocity_y) {
+    Entity_Handle result = {};
+    if (store->count == store->capacity) {
+        return result;
+    }
+
+    uint32_t slot = store->free_slot_head;
+    if (slot != ENTITY_NO_SLOT) {
+        store->free_slot_head = store->slot_to_dense[slot];
+    } else {
+        slot = store->used_slot_count++;
+    }
+
+    uint32_t dense_idx              = store->count++;
+    store->position_x[dense_idx]    = x;
+    store->position_y[dense_idx]    = y;
+    store->velocity_x[dense_idx]    = velocity_x;
+    store->velocity_y[dense_idx]    = velocity_y;
+    store->dense_to_slot[dense_idx] = slot;
+    store->slot_to_dense[slot]      = dense_idx;
+
+    store->slot_generation[slot] += 1;
+    result.slot       = slot;
+    result.generation = store->slot_generation[slot];
+    return result;
+}
+
+inline bool
+EntityIsAlive(Entity_Store* store, Entity_Handle handle) {
+    return handle.generation != 0 && handle.slot < store->used_slot_count &&
+           store->slot_generation[handle.slot] == handle.generation;
+}
+
+// NOTE: dense index of the entity right now, only good until the next remove. -1 when the handle is stale.
+inline int64_t
+EntityGetIndex(Entity_Store* store, Entity_Handle handle) {
+    return EntityIsAlive(store, handle) ? (int64_t)store->slot_to_dense[handle.slot] : -1;
+}
+
+inline bool
+EntityRemove(Entity_Store* store, Entity_Handle handle) {
+    if (!EntityIsAlive(store, handle)) {
+        return false;
+    }
+
+    uint32_t dense_idx = store->slot_to_dense[handle.slot];
+    uint32_t last_idx  = --store->count;
+    if (dense_idx != last_idx) {
+        uint32_t moved_slot              = store->dense_to_slot[last_idx];
+        store->position_x[dense_idx]     = store->position_x[last_idx];
+        store->position_y[dense_idx]     = store->position_y[last_idx];
+        store->velocity_x[dense_idx]     = store->velocity_x[last_idx];
+        store->velocity_y[dense_idx]     = store->velocity_y[last_idx];
+        store->dense_to_slot[dense_idx]  = moved_slot;
+        store->slot_to_dense[moved_slot] = dense_idx;
+    }
+
+    store->slot_generation[handle.slot] += 1;
+
+    store->slot_to_dense[handle.slot] = store->free_slot_head;
+    store->free_slot_head             = handle.slot;
+    return true;
+}
+
+inline __m128
+EntitySelect(__m128 mask, __m128 if_set, __m128 if_clear) {
+    return _mm_or_ps(_mm_and_ps(mask, if_set), _mm_andnot_ps(mask, if_clear));
+}
+
+// NOTE: reflects the lanes that left [min, max] back in and flips their velocity, one bounce per step is enough as
+// long as nothing moves further than the world is wide in one step
+inline void
+EntityBounce(__m128* position, __m128* velocity, __m128 min, __m128 max) {
+    __m128 sign_bit = _mm_set1_ps(-0.0f);
+    __m128 below    = _mm_cmplt_ps(*position, min);
+    __m128 above    = _mm_cmpgt_ps(*position, max);
+    *position       = EntitySelect(below, _mm_sub_ps(_mm_add_ps(min, min), *position), *position);
+    *position       = EntitySelect(above, _mm_sub_ps(_mm_add_ps(max, max), *position), *position);
+    *velocity       = _mm_xor_ps(*velocity, _mm_and_ps(_mm_or_ps(below, above), sign_bit));
+}
+
+// NOTE: semi-implicit Euler, velocity first with the acceleration and the drag, then the position with the new
+// velocity. Every entity gets the same acceleration, it's what the controllers ask for this frame.
+inline void
+EntityIntegrate(Entity_Store* store, float32_t acceleration_x, float32_t acceleration_y, float32_t dt) {
+    __m128 dt_wide  = _mm_set1_ps(dt);
+    __m128 damping  = _mm_set1_ps(1.0f - store->drag * dt);
+    __m128 delta_vx = _mm_set1_ps(acceleration_x * dt);
+    __m128 delta_vy = _mm_set1_ps(acceleration_y * dt);
+    __m128 min_x    = _mm_set1_ps(store->min_x);
+    __m128 min_y    = _mm_set1_ps(store->min_y);
+    __m128 max_x    = _mm_set1_ps(store->max_x);
+    __m128 max_y    = _mm_set1_ps(store->max_y);
+
+    uint32_t group_end = AlignPow2(store->count, ENTITY_SIMD_WIDTH);
+    for (uint32_t idx = 0; idx < group_end; idx += ENTITY_SIMD_WIDTH) {
+        __m128 velocity_x = _mm_add_ps(_mm_mul_ps(_mm_load_ps(store->velocity_x + idx), damping), delta_vx);
+        __m128 velocity_y = _mm_add_ps(_mm_mul_ps(_mm_load_ps(store->velocity_y + idx), damping), delta_vy);
+        __m128 position_x = _mm_add_ps(_mm_load_ps(store->position_x + idx), _mm_mul_ps(velocity_x, dt_wide));
+        __m128 position_y = _mm_add_ps(_mm_load_ps(store->position_y + idx), _mm_mul_ps(velocity_y, dt_wide));
+        EntityBounce(&position_x, &velocity_x, min_x, max_x);
+        EntityBounce(&position_y, &velocity_y, min_y, max_y);
+        _mm_store_ps(store->velocity_x + idx, velocity_x);
+        _mm_store_ps(store->velocity_y + idx, velocity_y);
+        _mm_store_ps(store->position_x + idx, position_x);
+        _mm_store_ps(store->position_y + idx, position_y);
+    }
+}
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef HANDMADE_FILE_FORMATS_H
+#define HANDMADE_FILE_FORMATS_H
+
+#include <stdint.h>
+
+// NOTE: on-disk layouts of the third party formats we import, shared by the game and the offline tools.
+#pragma pack(push, 1)
+struct Bitmap_Header {
+    uint16_t file_type; // 'BM'
+    uint32_t file_size;
+    uint16_t reserved1;
+    uint16_t reserved2;
+    uint32_t bitmap_offset;
+
+    uint32_t size;
+    int32_t  width;
+    int32_t  height; // NOTE: positive height means the rows are stored bottom-up
+    uint16_t planes;
+    uint16_t bits_per_pixel;
+    uint32_t compression;
+    uint32_t size_of_bitmap;
+    int32_t  horz_resolution;
+    int32_t  vert_resolution;
+    uint32_t colors_used;
+    uint32_t colors_important;
+
+    // NOTE: only valid when compression is BI_BITFIELDS (3)
+    uint32_t red_mask;
+    uint32_t green_mask;
+    uint32_t blue_mask;
+    uint32_t alpha_mask;
+};
+
+#define RIFF_CODE(a, b, c, d)                                                                                          \
+    (((uint32_t)(a) << 0) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+enum {
+    WAVE_ChunkID_fmt  = RIFF_CODE('f', 'm', 't', ' '),
+    WAVE_ChunkID_data = RIFF_CODE('d', 'a', 't', 'a'),
+    WAVE_ChunkID_RIFF = RIFF_CODE('R', 'I', 'F', 'F'),
+    WAVE_ChunkID_WAVE = RIFF_CODE('W', 'A', 'V', 'E'),
+};
+
+struct Wave_Header {
+    uint32_t riff_id;
+    uint32_t size;
+    uint32_t wave_id;
+};
+
+struct Wave_Chunk {
+    uint32_t id;
+    uint32_t size;
+};
+
+struct Wave_Fmt {
+    uint16_t format_tag; // NOTE: 1 is PCM
+    uint16_t channel_count;
+    uint32_t samples_per_second;
+    uint32_t avg_bytes_per_second;
+    uint16_t block_align;
+    uint16_t bits_per_sample;
+};
+#pragma pack(pop)
+
+#endif
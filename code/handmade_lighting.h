@@ -0,0 +1,318 @@
+#ifndef HANDMADE_LIGHTING_H
+#define HANDMADE_LIGHTING_H
+
+#include <stdint.h>
+#include <math.h>
+#include <emmintrin.h>
+#include "base.h"
+#include "handmade_sprite.h"
+
+/*
+ NOTE: lights for sprites that have a normal map. Each pixel's color is the sprite's filtered color times the light
+ that reaches it: ambient, plus N.L from every directional light, plus N.L with a falloff from every point light. The
+ normal comes from the sprite's normal map, read with the color's footprint and turned by the sprite's basis, so a
+ rotated sprite is lit from the right side.
+
+ Point lights fade to nothing at their radius, (1 - d^2 / r^2)^2, so a light only matters inside a circle. Before a
+ sprite is drawn the lights are culled against the pixels it touches in the clip rect and what's left is copied into
+ the shader as arrays, a frame drawn in tiles only pays for the lights near each tile. Lights are in screen pixels,
+ points are at height z above the sprites' plane.
+
+ Everything is linear and premultiplied like the blend, light can go over 1 and the pack clamps.
+ */
+#define LIGHTING_MAX_LIGHTS 64
+
+enum Light_Type {
+    LightType_Point,
+    LightType_Directional,
+};
+
+// NOTE: x, y and z are where a point light is, or for a directional light the unit vector pointing at it
+struct Light {
+    Light_Type type;
+    float32_t  x;
+    float32_t  y;
+    float32_t  z;
+    float32_t  radius;
+    float32_t  red;
+    float32_t  green;
+    float32_t  blue;
+};
+
+struct Lighting {
+    float32_t ambient_red;
+    float32_t ambient_green;
+    float32_t ambient_blue;
+    uint32_t  light_count;
+    Light     lights[LIGHTING_MAX_LIGHTS];
+};
+
+inline void
+LightingBegin(Lighting* lighting, float32_t ambient_red, float32_t ambient_green, float32_t ambient_blue) {
+    lighting->ambient_red   = ambient_red;
+    lighting->ambient_green = ambient_green;
+    lighting->ambient_blue  = ambient_blue;
+    lighting->light_count   = 0;
+}
+
+// NOTE: 0 when the lighting is full
+inline Light*
+LightingAdd(Lighting* lighting, Light_Type type, float32_t red, float32_t green, float32_t blue) {
+    Light* result = 0;
+    if (lighting->light_count < LIGHTING_MAX_LIGHTS) {
+        result        = &lighting->lights[lighting->light_count++];
+        *result       = {};
+        result->type  = type;
+        result->red   = red;
+        result->green = green;
+        result->blue  = blue;
+    }
+    return result;
+}
+
+inline void
+LightingAddPoint(
+    Lighting* lighting,
+    float32_t x,
+    float32_t y,
+    float32_t height,
+    float32_t radius,
+    float32_t red,
+    float32_t green,
+    float32_t blue) {
+
+    Light* light = LightingAdd(lighting, LightType_Point, red, green, blue);
+    if (light) {
+        light->x      = x;
+        light->y      = y;
+        light->z      = height;
+        light->radius = radius;
+    }
+}
+
+inline void
+LightingAddDirectional(
+    Lighting* lighting,
+    float32_t direction_x,
+    float32_t direction_y,
+    float32_t direction_z,
+    float32_t red,
+    float32_t green,
+    float32_t blue) {
+
+    Light*    light  = LightingAdd(lighting, LightType_Directional, red, green, blue);
+    float32_t length = sqrtf(direction_x * direction_x + direction_y * direction_y + direction_z * direction_z);
+    if (light && length > 0.0f) {
+        light->x = direction_x / length;
+        light->y = direction_y / length;
+        light->z = direction_z / length;
+    }
+}
+
+// NOTE: the lights that reach one sprite, structure of arrays so each one is a broadcast away. tangent is where the
+// normal map's x and y point on screen.
+struct Sprite_Lit {
+    Sprite*   sprite;
+    float32_t tangent_x_x;
+    float32_t tangent_x_y;
+    float32_t tangent_y_x;
+    float32_t tangent_y_y;
+    float32_t ambient_red;
+    float32_t ambient_green;
+    float32_t ambient_blue;
+
+    uint32_t  point_count;
+    float32_t point_x[LIGHTING_MAX_LIGHTS];
+    float32_t point_y[LIGHTING_MAX_LIGHTS];
+    float32_t point_z[LIGHTING_MAX_LIGHTS];
+    float32_t point_inverse_radius_sq[LIGHTING_MAX_LIGHTS];
+    float32_t point_red[LIGHTING_MAX_LIGHTS];
+    float32_t point_green[LIGHTING_MAX_LIGHTS];
+    float32_t point_blue[LIGHTING_MAX_LIGHTS];
+
+    uint32_t  directional_count;
+    float32_t directional_x[LIGHTING_MAX_LIGHTS];
+    float32_t directional_y[LIGHTING_MAX_LIGHTS];
+    float32_t directional_z[LIGHTING_MAX_LIGHTS];
+    float32_t directional_red[LIGHTING_MAX_LIGHTS];
+    float32_t directional_green[LIGHTING_MAX_LIGHTS];
+    float32_t directional_blue[LIGHTING_MAX_LIGHTS];
+
+    static inline Blend_Pixels
+    Shade(Sprite_Lit* shader, int level_idx, Sprite_Footprint* footprint, Blend_Pixels color, __m128 x, __m128 y);
+};
+
+// NOTE: the bytes as they are, blue is z, green y and red x
+inline void
+LightingUnpackNormals(__m128i texels, __m128* normal_x, __m128* normal_y, __m128* normal_z) {
+    __m128i byte_mask = _mm_set1_epi32(0xFF);
+    *normal_x         = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(texels, 16), byte_mask));
+    *normal_y         = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(texels, 8), byte_mask));
+    *normal_z         = _mm_cvtepi32_ps(_mm_and_si128(texels, byte_mask));
+}
+
+inline __m128
+LightingLerp(__m128 a, __m128 b, __m128 t) {
+    return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+}
+
+// NOTE: the normal map filtered like the colors. Filtering the bytes and centering after is the same as centering
+// each texel, and it's left 127 times too long since it gets normalized anyway.
+inline void
+LightingSampleNormal(
+    Loaded_Bitmap*    normals,
+    Sprite_Footprint* footprint,
+    __m128*           normal_x,
+    __m128*           normal_y,
+    __m128*           normal_z) {
+
+    __m128i corners[4];
+    __m128  corner_x[4];
+    __m128  corner_y[4];
+    __m128  corner_z[4];
+    SpriteFetch(normals, footprint, corners);
+    for (int corner_idx = 0; corner_idx < 4; ++corner_idx) {
+        LightingUnpackNormals(corners[corner_idx], &corner_x[corner_idx], &corner_y[corner_idx], &corner_z[corner_idx]);
+    }
+
+    __m128 fraction_x = footprint->fraction_x;
+    __m128 fraction_y = footprint->fraction_y;
+    __m128 top_x      = LightingLerp(corner_x[0], corner_x[1], fraction_x);
+    __m128 top_y      = LightingLerp(corner_y[0], corner_y[1], fraction_x);
+    __m128 top_z      = LightingLerp(corner_z[0], corner_z[1], fraction_x);
+    __m128 bottom_x   = LightingLerp(corner_x[2], corner_x[3], fraction_x);
+    __m128 bottom_y   = LightingLerp(corner_y[2], corner_y[3], fraction_x);
+    __m128 bottom_z   = LightingLerp(corner_z[2], corner_z[3], fraction_x);
+    __m128 center     = _mm_set1_ps(128.0f);
+    *normal_x         = _mm_sub_ps(LightingLerp(top_x, bottom_x, fraction_y), center);
+    *normal_y         = _mm_sub_ps(LightingLerp(top_y, bottom_y, fraction_y), center);
+    *normal_z         = _mm_sub_ps(LightingLerp(top_z, bottom_z, fraction_y), center);
+}
+
+inline Blend_Pixels
+Sprite_Lit::Shade(
+    Sprite_Lit*       shader,
+    int               level_idx,
+    Sprite_Footprint* footprint,
+    Blend_Pixels      color,
+    __m128            x,
+    __m128            y) {
+
+    __m128 map_x;
+    __m128 map_y;
+    __m128 normal_z;
+    LightingSampleNormal(&shader->sprite->normals[level_idx], footprint, &map_x, &map_y, &normal_z);
+
+    // NOTE: to screen space and unit length, rsqrt is plenty for lighting
+    __m128 normal_x = _mm_add_ps(
+        _mm_mul_ps(map_x, _mm_set1_ps(shader->tangent_x_x)), _mm_mul_ps(map_y, _mm_set1_ps(shader->tangent_y_x)));
+    __m128 normal_y = _mm_add_ps(
+        _mm_mul_ps(map_x, _mm_set1_ps(shader->tangent_x_y)), _mm_mul_ps(map_y, _mm_set1_ps(shader->tangent_y_y)));
+    __m128 length_sq = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(normal_x, normal_x), _mm_mul_ps(normal_y, normal_y)), _mm_mul_ps(normal_z, normal_z));
+    __m128 inverse_length = _mm_rsqrt_ps(_mm_max_ps(length_sq, _mm_set1_ps(1e-2f)));
+    normal_x              = _mm_mul_ps(normal_x, inverse_length);
+    normal_y              = _mm_mul_ps(normal_y, inverse_length);
+    normal_z              = _mm_mul_ps(normal_z, inverse_length);
+
+    __m128 zero        = _mm_setzero_ps();
+    __m128 one         = _mm_set1_ps(1.0f);
+    __m128 light_red   = _mm_set1_ps(shader->ambient_red);
+    __m128 light_green = _mm_set1_ps(shader->ambient_green);
+    __m128 light_blue  = _mm_set1_ps(shader->ambient_blue);
+    for (uint32_t light_idx = 0; light_idx < shader->directional_count; ++light_idx) {
+        __m128 n_dot_l = _mm_add_ps(
+            _mm_add_ps(
+                _mm_mul_ps(normal_x, _mm_set1_ps(shader->directional_x[light_idx])),
+                _mm_mul_ps(normal_y, _mm_set1_ps(shader->directional_y[light_idx]))),
+            _mm_mul_ps(normal_z, _mm_set1_ps(shader->directional_z[light_idx])));
+        n_dot_l     = _mm_max_ps(n_dot_l, zero);
+        light_red   = _mm_add_ps(light_red, _mm_mul_ps(n_dot_l, _mm_set1_ps(shader->directional_red[light_idx])));
+        light_green = _mm_add_ps(light_green, _mm_mul_ps(n_dot_l, _mm_set1_ps(shader->directional_green[light_idx])));
+        light_blue  = _mm_add_ps(light_blue, _mm_mul_ps(n_dot_l, _mm_set1_ps(shader->directional_blue[light_idx])));
+    }
+
+    for (uint32_t light_idx = 0; light_idx < shader->point_count; ++light_idx) {
+        __m128 to_light_x = _mm_sub_ps(_mm_set1_ps(shader->point_x[light_idx]), x);
+        __m128 to_light_y = _mm_sub_ps(_mm_set1_ps(shader->point_y[light_idx]), y);
+        __m128 to_light_z = _mm_set1_ps(shader->point_z[light_idx]);
+        __m128 distance_sq =
+            _mm_add_ps(_mm_add_ps(_mm_mul_ps(to_light_x, to_light_x), _mm_mul_ps(to_light_y, to_light_y)),
+                       _mm_mul_ps(to_light_z, to_light_z));
+        __m128 n_dot_l = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(normal_x, to_light_x), _mm_mul_ps(normal_y, to_light_y)),
+            _mm_mul_ps(normal_z, to_light_z));
+        n_dot_l        = _mm_max_ps(_mm_mul_ps(n_dot_l, _mm_rsqrt_ps(distance_sq)), zero);
+        __m128 inverse_radius_sq = _mm_set1_ps(shader->point_inverse_radius_sq[light_idx]);
+        __m128 falloff           = _mm_max_ps(_mm_sub_ps(one, _mm_mul_ps(distance_sq, inverse_radius_sq)), zero);
+        __m128 amount            = _mm_mul_ps(n_dot_l, _mm_mul_ps(falloff, falloff));
+        light_red      = _mm_add_ps(light_red, _mm_mul_ps(amount, _mm_set1_ps(shader->point_red[light_idx])));
+        light_green    = _mm_add_ps(light_green, _mm_mul_ps(amount, _mm_set1_ps(shader->point_green[light_idx])));
+        light_blue     = _mm_add_ps(light_blue, _mm_mul_ps(amount, _mm_set1_ps(shader->point_blue[light_idx])));
+    }
+
+    color.r = _mm_mul_ps(color.r, light_red);
+    color.g = _mm_mul_ps(color.g, light_green);
+    color.b = _mm_mul_ps(color.b, light_blue);
+    return color;
+}
+
+// NOTE: keeps the point lights whose circle overlaps bounds, every directional one
+inline void
+LightingCull(Sprite_Lit* shader, Lighting* lighting, Clip_Rect bounds) {
+    shader->ambient_red       = lighting->ambient_red;
+    shader->ambient_green     = lighting->ambient_green;
+    shader->ambient_blue      = lighting->ambient_blue;
+    shader->point_count       = 0;
+    shader->directional_count = 0;
+    for (uint32_t light_idx = 0; light_idx < lighting->light_count; ++light_idx) {
+        Light* light = &lighting->lights[light_idx];
+        if (light->type == LightType_Directional) {
+            uint32_t idx                   = shader->directional_count++;
+            shader->directional_x[idx]     = light->x;
+            shader->directional_y[idx]     = light->y;
+            shader->directional_z[idx]     = light->z;
+            shader->directional_red[idx]   = light->red;
+            shader->directional_green[idx] = light->green;
+            shader->directional_blue[idx]  = light->blue;
+        } else {
+            float32_t nearest_x = light->x < (float32_t)bounds.min_x ? (float32_t)bounds.min_x : light->x;
+            float32_t nearest_y = light->y < (float32_t)bounds.min_y ? (float32_t)bounds.min_y : light->y;
+            nearest_x           = nearest_x > (float32_t)bounds.max_x ? (float32_t)bounds.max_x : nearest_x;
+            nearest_y           = nearest_y > (float32_t)bounds.max_y ? (float32_t)bounds.max_y : nearest_y;
+            float32_t offset_x  = nearest_x - light->x;
+            float32_t offset_y  = nearest_y - light->y;
+            float32_t reach_sq  = light->radius * light->radius - light->z * light->z;
+            if (reach_sq > 0.0f && offset_x * offset_x + offset_y * offset_y < reach_sq) {
+                uint32_t idx                         = shader->point_count++;
+                shader->point_x[idx]                 = light->x;
+                shader->point_y[idx]                 = light->y;
+                shader->point_z[idx]                 = light->z;
+                shader->point_inverse_radius_sq[idx] = 1.0f / (light->radius * light->radius);
+                shader->point_red[idx]               = light->red;
+                shader->point_green[idx]             = light->green;
+                shader->point_blue[idx]              = light->blue;
+            }
+        }
+    }
+}
+
+// NOTE: the sprite has to have normals. Only touches clip, see DrawSprite_.
+inline uint32_t
+DrawLitSprite(Game_Offscreen_Buffer* buffer, Clip_Rect clip, Sprite* sprite, Sprite_Basis basis, Lighting* lighting) {
+    Assert(sprite->normals[0].memory);
+    Sprite_Lit shader;
+    shader.sprite      = sprite;
+    float32_t x_length = sqrtf(basis.x_axis_x * basis.x_axis_x + basis.x_axis_y * basis.x_axis_y);
+    float32_t y_length = sqrtf(basis.y_axis_x * basis.y_axis_x + basis.y_axis_y * basis.y_axis_y);
+    if (x_length > 0.0f && y_length > 0.0f) {
+        shader.tangent_x_x = basis.x_axis_x / x_length;
+        shader.tangent_x_y = basis.x_axis_y / x_length;
+        shader.tangent_y_x = basis.y_axis_x / y_length;
+        shader.tangent_y_y = basis.y_axis_y / y_length;
+    }
+    LightingCull(&shader, lighting, SpriteBounds(&basis, clip));
+    return DrawSprite_<Sprite_Lit>(buffer, clip, sprite, basis, &shader);
+}
+
+#endif
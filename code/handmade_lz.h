@@ -0,0 +1,183 @@
+#ifndef HANDMADE_LZ_H
+#define HANDMADE_LZ_H
+
+#include <stdint.h>
+#include <string.h>
+#include "base.h"
+
+/*
+ NOTE: byte oriented LZ77 in the style of LZ4, no entropy coding so both directions run at memory speed.
+
+ A block is a list of sequences:
+
+   [token] [literal length extension] [literals] [offset, 2 bytes LE] [match length extension]
+
+ The high nibble of the token is the literal count, the low nibble the match length minus LZ_MIN_MATCH. A nibble of
+ 15 means more length follows as bytes that are added up until one is less than 255. The last sequence of a block
+ only has literals, the decoder knows it's the last one because the input ends right after them.
+ */
+#define LZ_MIN_MATCH  4
+#define LZ_MAX_OFFSET 65535
+#define LZ_HASH_BITS  14
+
+#define LZCompressBound(size) ((size) + (size) / 255 + 16)
+
+inline uint32_t
+LZRead32(const uint8_t* at) {
+    uint32_t result;
+    memcpy(&result, at, sizeof(result));
+    return result;
+}
+
+inline uint64_t
+LZRead64(const uint8_t* at) {
+    uint64_t result;
+    memcpy(&result, at, sizeof(result));
+    return result;
+}
+
+inline uint8_t*
+LZWriteLength(uint8_t* out, uint32_t length) {
+    while (length >= 255) {
+        *out++ = 255;
+        length -= 255;
+    }
+    *out++ = (uint8_t)length;
+    return out;
+}
+
+inline uint8_t*
+LZWriteSequence(uint8_t* out, const uint8_t* literals, uint32_t literal_count, uint32_t offset, uint32_t match_length) {
+    uint32_t match_code = match_length ? match_length - LZ_MIN_MATCH : 0;
+    *out++ = (uint8_t)(((literal_count < 15 ? literal_count : 15) << 4) | (match_code < 15 ? match_code : 15));
+    if (literal_count >= 15) {
+        out = LZWriteLength(out, literal_count - 15);
+    }
+    memcpy(out, literals, literal_count);
+    out += literal_count;
+
+    if (match_length) {
+        *out++ = (uint8_t)(offset & 0xFF);
+        *out++ = (uint8_t)(offset >> 8);
+        if (match_code >= 15) {
+            out = LZWriteLength(out, match_code - 15);
+        }
+    }
+    return out;
+}
+
+// NOTE: dest must hold LZCompressBound(source_size) bytes, returns the compressed size
+inline uint32_t
+LZCompress(const uint8_t* source, uint32_t source_size, uint8_t* dest) {
+    // NOTE: last position seen for each hash of 4 bytes, 0 doubles as empty since a match needs pos > candidate
+    uint32_t hash_table[1 << LZ_HASH_BITS];
+    memset(hash_table, 0, sizeof(hash_table));
+
+    uint8_t* out    = dest;
+    uint32_t anchor = 0;
+    uint32_t pos    = 0;
+    while (source_size >= LZ_MIN_MATCH && pos <= source_size - LZ_MIN_MATCH) {
+        uint32_t sequence  = LZRead32(source + pos);
+        uint32_t hash      = (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+        uint32_t candidate = hash_table[hash];
+        hash_table[hash]   = pos;
+
+        if (candidate < pos && pos - candidate <= LZ_MAX_OFFSET && LZRead32(source + candidate) == sequence) {
+            uint32_t match_length = LZ_MIN_MATCH;
+            while (pos + match_length + 8 <= source_size &&
+                   LZRead64(source + candidate + match_length) == LZRead64(source + pos + match_length)) {
+                match_length += 8;
+            }
+            while (pos + match_length < source_size && source[candidate + match_length] == source[pos + match_length]) {
+                ++match_length;
+            }
+
+            out    = LZWriteSequence(out, source + anchor, pos - anchor, pos - candidate, match_length);
+            pos    = pos + match_length;
+            anchor = pos;
+        } else {
+            // NOTE: step further the longer nothing matched, incompressible data goes by quickly
+            pos += 1 + ((pos - anchor) >> 6);
+        }
+    }
+    out = LZWriteSequence(out, source + anchor, source_size - anchor, 0, 0);
+
+    return (uint32_t)(out - dest);
+}
+
+inline bool
+LZReadLength(const uint8_t** in, const uint8_t* in_end, uint32_t* length) {
+    uint8_t byte;
+    do {
+        if (*in >= in_end) {
+            return false;
+        }
+        byte = *(*in)++;
+        *length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+// NOTE: checks every length and offset against the buffers, returns false unless exactly dest_size bytes came out
+inline bool
+LZDecompress(const uint8_t* source, uint32_t source_size, uint8_t* dest, uint32_t dest_size) {
+    const uint8_t* in      = source;
+    const uint8_t* in_end  = source + source_size;
+    uint8_t*       out     = dest;
+    uint8_t*       out_end = dest + dest_size;
+
+    while (in < in_end) {
+        uint8_t  token         = *in++;
+        uint32_t literal_count = token >> 4;
+        if (literal_count == 15 && !LZReadLength(&in, in_end, &literal_count)) {
+            return false;
+        }
+        if (literal_count > (uint32_t)(in_end - in) || literal_count > (uint32_t)(out_end - out)) {
+            return false;
+        }
+        memcpy(out, in, literal_count);
+        in += literal_count;
+        out += literal_count;
+
+        if (in == in_end) {
+            break;
+        }
+
+        if (in_end - in < 2) {
+            return false;
+        }
+        uint32_t offset = in[0] | ((uint32_t)in[1] << 8);
+        in += 2;
+        uint32_t match_length = token & 0xF;
+        if (match_length == 15 && !LZReadLength(&in, in_end, &match_length)) {
+            return false;
+        }
+        match_length += LZ_MIN_MATCH;
+        if (offset == 0 || offset > (uint32_t)(out - dest) || match_length > (uint32_t)(out_end - out)) {
+            return false;
+        }
+
+        const uint8_t* match = out - offset;
+        if (offset == 1) {
+            memset(out, *match, match_length);
+        } else if (offset >= 8) {
+            // NOTE: chunks never read past what has already been written
+            uint32_t copied = 0;
+            for (; copied + 8 <= match_length; copied += 8) {
+                memcpy(out + copied, match + copied, 8);
+            }
+            for (; copied < match_length; ++copied) {
+                out[copied] = match[copied];
+            }
+        } else {
+            for (uint32_t copied = 0; copied < match_length; ++copied) {
+                out[copied] = match[copied];
+            }
+        }
+        out += match_length;
+    }
+
+    return out == out_end;
+}
+
+#endif
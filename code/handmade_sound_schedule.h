@@ -0,0 +1,176 @@
+#ifndef HANDMADE_SOUND_SCHEDULE_H
+#define HANDMADE_SOUND_SCHEDULE_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "base.h"
+
+/*
+ NOTE: sounds that start on an exact output sample instead of wherever the buffer the game is asked for happens to
+ begin. The platform numbers the samples it asks for from the start of playback, first_sample_idx in
+ Game_Sound_Output_Buffer is the number of the first one in the buffer and flip_sample_idx is the one it projects will
+ be playing when the frame it just rendered is shown. The numbers only go up by what was mixed, they don't jump when the
+ platform loses and finds the sound card again.
+
+ Events wait in a queue sorted by the sample they start on, which can be any number of buffers ahead. Mixing splits a
+ buffer where an event starts and starts its voice there, so it lands on its sample even in the middle of a buffer. An
+ event whose sample was already mixed before it was queued starts at the beginning of the next buffer and counts as
+ late, by how many samples it missed.
+
+ A voice is a sine starting at its peak that decays away, enough for clicks and beeps without sample data. The onset is
+ the event's sample itself.
+ */
+#define SOUND_SCHEDULE_MAX_EVENTS 64
+#define SOUND_SCHEDULE_MAX_VOICES 16
+
+struct Sound_Event {
+    uint64_t  sample_idx; // the output sample the voice starts on
+    float32_t hz;
+    float32_t volume;  // 1 is full scale
+    float32_t seconds; // how long until it has decayed away
+};
+
+struct Sound_Voice {
+    float32_t phase;
+    float32_t phase_step;
+    float32_t amplitude;
+    float32_t decay; // amplitude is multiplied by this every sample
+    uint32_t  remaining_count;
+};
+
+struct Sound_Schedule_Stats {
+    uint64_t started_count;
+    uint64_t late_count;
+    uint64_t max_late_samples;
+    uint64_t dropped_count; // the queue or the voices were full
+};
+
+struct Sound_Schedule {
+    uint64_t next_sample_idx;    // first sample of the next buffer
+    uint64_t flip_sample_idx;    // as projected at the last mix
+    uint32_t samples_per_second; // 0 until the first mix
+
+    uint32_t    event_count;
+    Sound_Event events[SOUND_SCHEDULE_MAX_EVENTS];
+    uint32_t    voice_count;
+    Sound_Voice voices[SOUND_SCHEDULE_MAX_VOICES];
+
+    Sound_Schedule_Stats stats;
+};
+
+// NOTE: the sample that will be playing when the frame being updated now is shown, a frame after the flip the
+// platform projected at the last mix. 0 before the first mix, when there's no timeline yet.
+inline uint64_t
+SoundScheduleNextFlip(Sound_Schedule* schedule, float32_t frame_seconds) {
+    if (!schedule->samples_per_second) {
+        return 0;
+    }
+    return schedule->flip_sample_idx + (uint64_t)(frame_seconds * (float32_t)schedule->samples_per_second + 0.5f);
+}
+
+inline bool
+SoundScheduleAt(Sound_Schedule* schedule, Sound_Event event) {
+    if (schedule->event_count == SOUND_SCHEDULE_MAX_EVENTS) {
+        ++schedule->stats.dropped_count;
+        return false;
+    }
+
+    // NOTE: events at the same sample keep the order they were queued in
+    uint32_t event_idx = schedule->event_count++;
+    while (event_idx > 0 && schedule->events[event_idx - 1].sample_idx > event.sample_idx) {
+        schedule->events[event_idx] = schedule->events[event_idx - 1];
+        --event_idx;
+    }
+    schedule->events[event_idx] = event;
+    return true;
+}
+
+inline void
+SoundScheduleStartVoice(Sound_Schedule* schedule, Sound_Event* event, uint32_t samples_per_second) {
+    uint32_t sample_count = (uint32_t)(event->seconds * (float32_t)samples_per_second);
+    if (schedule->voice_count == SOUND_SCHEDULE_MAX_VOICES || sample_count == 0) {
+        ++schedule->stats.dropped_count;
+        return;
+    }
+
+    // NOTE: decays to -60dB by the end
+    Sound_Voice* voice     = &schedule->voices[schedule->voice_count++];
+    voice->phase           = 0.0f;
+    voice->phase_step      = 2.0f * PI * event->hz / (float32_t)samples_per_second;
+    voice->amplitude       = 32767.0f * event->volume;
+    voice->decay           = powf(0.001f, 1.0f / (float32_t)sample_count);
+    voice->remaining_count = sample_count;
+    ++schedule->stats.started_count;
+}
+
+// NOTE: adds every voice to interleaved stereo int16 samples, saturating, and drops the ones that ran out
+inline void
+SoundScheduleMixVoices(Sound_Schedule* schedule, int16_t* samples, uint32_t sample_count) {
+    for (uint32_t voice_idx = 0; voice_idx < schedule->voice_count;) {
+        Sound_Voice* voice = &schedule->voices[voice_idx];
+        uint32_t     count = voice->remaining_count < sample_count ? voice->remaining_count : sample_count;
+        for (uint32_t sample_idx = 0; sample_idx < count; ++sample_idx) {
+            int32_t  value = (int32_t)(voice->amplitude * cosf(voice->phase));
+            int16_t* out   = samples + 2 * sample_idx;
+            for (int channel_idx = 0; channel_idx < 2; ++channel_idx) {
+                int32_t mixed    = out[channel_idx] + value;
+                out[channel_idx] = (int16_t)(mixed > 32767 ? 32767 : (mixed < -32768 ? -32768 : mixed));
+            }
+
+            voice->amplitude *= voice->decay;
+            voice->phase += voice->phase_step;
+            if (voice->phase > 2.0f * PI) {
+                voice->phase -= 2.0f * PI;
+            }
+        }
+
+        voice->remaining_count -= count;
+        if (voice->remaining_count == 0) {
+            *voice = schedule->voices[--schedule->voice_count];
+        } else {
+            ++voice_idx;
+        }
+    }
+}
+
+// NOTE: call after whatever else writes the buffer, the voices are added to it
+inline void
+SoundScheduleMix(Sound_Schedule* schedule, Game_Sound_Output_Buffer* buffer) {
+    uint32_t sample_count        = (uint32_t)buffer->sample_count;
+    uint64_t first_sample_idx    = buffer->first_sample_idx;
+    uint64_t end_sample_idx      = first_sample_idx + sample_count;
+    schedule->flip_sample_idx    = buffer->flip_sample_idx;
+    schedule->samples_per_second = (uint32_t)buffer->samples_per_second;
+
+    // NOTE: the voices playing are mixed up to where the next event starts, then it starts and they go on from there
+    uint32_t mixed_count = 0;
+    for (;;) {
+        uint32_t split_idx     = sample_count;
+        bool     is_event_next = schedule->event_count && schedule->events[0].sample_idx < end_sample_idx;
+        if (is_event_next) {
+            uint64_t start_idx = schedule->events[0].sample_idx;
+            split_idx          = start_idx > first_sample_idx ? (uint32_t)(start_idx - first_sample_idx) : 0;
+        }
+        SoundScheduleMixVoices(schedule, buffer->samples + 2 * mixed_count, split_idx - mixed_count);
+        mixed_count = split_idx;
+        if (!is_event_next) {
+            break;
+        }
+
+        Sound_Event event = schedule->events[0];
+        --schedule->event_count;
+        memmove(schedule->events, schedule->events + 1, schedule->event_count * sizeof(Sound_Event));
+        if (event.sample_idx < first_sample_idx) {
+            uint64_t late_samples = first_sample_idx - event.sample_idx;
+            ++schedule->stats.late_count;
+            if (late_samples > schedule->stats.max_late_samples) {
+                schedule->stats.max_late_samples = late_samples;
+            }
+        }
+        SoundScheduleStartVoice(schedule, &event, schedule->samples_per_second);
+    }
+    schedule->next_sample_idx = end_sample_idx;
+}
+
+#endif
@@ -0,0 +1,421 @@
+#ifndef HANDMADE_SOUND_STREAM_H
+#define HANDMADE_SOUND_STREAM_H
+
+#include <stdint.h>
+#include <string.h>
+#include <emmintrin.h>
+#include "base.h"
+#include "handmade_file_formats.h"
+
+/*
+ NOTE: plays a 16-bit PCM WAV of any length and sample rate without ever holding more than a few chunks of it. The
+ file is read with the async file api into a ring of SOUND_STREAM_CHUNK_COUNT chunks, a chunk is read again with the
+ next part of the file once playback has moved past it. Memory and the work per frame don't depend on the length of
+ the file.
+
+ Frames are numbered from the start of playback and keep counting through loops, frame n of the stream is frame
+ n % frame_count of the file and lives in the ring at n & ring_frame_mask. A chunk that runs over the end of a looping
+ file is read in two parts. Looping needs the file to be at least a chunk long, shorter ones play once.
+
+ Mixing resamples to the output rate with linear interpolation, four output frames per step with SSE2. The position is
+ 32.32 fixed point in stream frames, the step is the source rate over the output rate. Interpolating frame n needs
+ frame n + 1 too, the frame past the end of the ring is a copy of the first one so the pair is always contiguous.
+
+ Everything including the ring is inside Sound_Stream, it must stay where it is while reads are in flight.
+ */
+#define SOUND_STREAM_CHUNK_BYTES  KiloBytes(16)
+#define SOUND_STREAM_CHUNK_COUNT  4 // power of two
+#define SOUND_STREAM_RING_BYTES   (SOUND_STREAM_CHUNK_COUNT * SOUND_STREAM_CHUNK_BYTES)
+#define SOUND_STREAM_HEADER_BYTES 512
+
+enum Sound_Stream_State {
+    SoundStream_Closed,
+    SoundStream_Opening, // looking for the fmt and data chunks
+    SoundStream_Playing,
+    SoundStream_Finished,
+    SoundStream_Failed,
+};
+
+struct Sound_Stream_Chunk {
+    bool             is_ready;
+    uint64_t         first_frame;     // stream frame, ~0 when the slot was never used
+    Platform_File_Op ops[2];          // the second one is the part after the loop point
+    uint64_t         read_offsets[2]; // NOTE: what each op reads, to issue it again when the platform was busy
+    uint32_t         read_sizes[2];
+};
+
+struct Sound_Stream {
+    uint32_t  state; // Sound_Stream_State
+    bool      loop;
+    float32_t volume;
+
+    Platform_File_Handle file;
+    Platform_File_Op     header_op;
+    uint64_t             header_read_offset; // where the file in header starts
+    uint64_t             header_offset;      // next RIFF chunk to look at
+
+    uint32_t channel_count;
+    uint32_t samples_per_second;
+    uint32_t frame_bytes;
+    uint32_t chunk_frames;
+    uint32_t ring_frame_mask;
+    uint64_t data_offset;
+    uint64_t frame_count; // in the file
+
+    uint64_t position;        // 32.32 fixed point stream frame
+    uint64_t next_chunk;      // next chunk to read, in stream chunks
+    uint64_t ready_frame_end; // every stream frame before this is in the ring
+    uint32_t underrun_count;
+
+    Sound_Stream_Chunk chunks[SOUND_STREAM_CHUNK_COUNT];
+    uint8_t            header[SOUND_STREAM_HEADER_BYTES];
+    uint8_t            ring[SOUND_STREAM_RING_BYTES + 2 * sizeof(int16_t)];
+};
+
+inline bool
+SoundStreamOpen(Sound_Stream* stream, Game_Memory* memory, const char* file_name, bool loop) {
+    stream->state          = SoundStream_Failed;
+    stream->loop           = loop;
+    stream->volume         = 1.0f;
+    stream->position       = 0;
+    stream->next_chunk     = 0;
+    stream->underrun_count = 0;
+    stream->channel_count  = 0;
+    stream->header_op      = {};
+    stream->file           = memory->PlatformOpenFile(file_name, PlatformOpenFile_Read);
+    if (!stream->file.platform_handle) {
+        return false;
+    }
+
+    stream->header_read_offset = 0;
+    stream->header_offset      = sizeof(Wave_Header);
+    stream->header_op = memory->PlatformReadFileAsync(&stream->file, 0, SOUND_STREAM_HEADER_BYTES, stream->header);
+    stream->state     = SoundStream_Opening;
+    return true;
+}
+
+// NOTE: waits for the reads in flight, the file can only be closed after that
+inline void
+SoundStreamClose(Sound_Stream* stream, Game_Memory* memory) {
+    if (stream->file.platform_handle) {
+        while (memory->PlatformPollFileOp(stream->header_op, 0) == PlatformFileOp_Pending) {
+        }
+        for (int chunk_idx = 0; chunk_idx < SOUND_STREAM_CHUNK_COUNT; ++chunk_idx) {
+            for (int op_idx = 0; op_idx < 2; ++op_idx) {
+                while (memory->PlatformPollFileOp(stream->chunks[chunk_idx].ops[op_idx], 0) == PlatformFileOp_Pending) {
+                }
+            }
+        }
+        memory->PlatformCloseFile(&stream->file);
+    }
+    stream->state = SoundStream_Closed;
+}
+
+// NOTE: walks the RIFF chunks in the header buffer. Returns true once both fmt and data were found, otherwise
+// header_offset is where the next read has to start.
+inline bool
+SoundStreamParseHeader(Sound_Stream* stream, uint32_t bytes_read) {
+    uint64_t buffer_offset = stream->header_read_offset;
+    if (buffer_offset == 0) {
+        Wave_Header* header = (Wave_Header*)stream->header;
+        if (bytes_read < sizeof(Wave_Header) || header->riff_id != WAVE_ChunkID_RIFF ||
+            header->wave_id != WAVE_ChunkID_WAVE) {
+            stream->state = SoundStream_Failed;
+            return false;
+        }
+    }
+
+    while (stream->header_offset + sizeof(Wave_Chunk) <= buffer_offset + bytes_read) {
+        Wave_Chunk* chunk = (Wave_Chunk*)(stream->header + (stream->header_offset - buffer_offset));
+        if (chunk->id == WAVE_ChunkID_fmt) {
+            if (stream->header_offset + sizeof(Wave_Chunk) + sizeof(Wave_Fmt) > buffer_offset + bytes_read) {
+                return false; // NOTE: read again starting at this chunk
+            }
+
+            Wave_Fmt* fmt              = (Wave_Fmt*)(chunk + 1);
+            stream->channel_count      = fmt->channel_count;
+            stream->samples_per_second = fmt->samples_per_second;
+            if (fmt->format_tag != 1 || fmt->bits_per_sample != 16 || fmt->samples_per_second == 0 ||
+                (fmt->channel_count != 1 && fmt->channel_count != 2)) {
+                stream->state = SoundStream_Failed;
+                return false;
+            }
+        } else if (chunk->id == WAVE_ChunkID_data) {
+            if (!stream->channel_count || stream->header_offset + sizeof(Wave_Chunk) > stream->file.size) {
+                stream->state = SoundStream_Failed;
+                return false;
+            }
+            stream->data_offset = stream->header_offset + sizeof(Wave_Chunk);
+            stream->frame_bytes = stream->channel_count * (uint32_t)sizeof(int16_t);
+            stream->frame_count = chunk->size / stream->frame_bytes;
+            uint64_t file_end   = (stream->file.size - stream->data_offset) / stream->frame_bytes;
+            if (stream->frame_count > file_end) {
+                stream->frame_count = file_end;
+            }
+            return true;
+        }
+        // NOTE: chunks are padded to an even size
+        stream->header_offset += sizeof(Wave_Chunk) + ((chunk->size + 1) & ~1ull);
+    }
+    return false;
+}
+
+inline void
+SoundStreamStartPlaying(Sound_Stream* stream) {
+    stream->chunk_frames    = (uint32_t)(SOUND_STREAM_CHUNK_BYTES / stream->frame_bytes);
+    stream->ring_frame_mask = SOUND_STREAM_CHUNK_COUNT * stream->chunk_frames - 1;
+    stream->ready_frame_end = 0;
+    stream->loop            = stream->loop && stream->frame_count >= stream->chunk_frames;
+    for (int chunk_idx = 0; chunk_idx < SOUND_STREAM_CHUNK_COUNT; ++chunk_idx) {
+        stream->chunks[chunk_idx]             = {};
+        stream->chunks[chunk_idx].first_frame = ~0ull;
+    }
+    stream->state = SoundStream_Playing;
+}
+
+// NOTE: the second part goes in the ring slot right after the first one
+inline void
+SoundStreamIssueRead(Sound_Stream* stream, Game_Memory* memory, uint64_t slot_idx, int op_idx) {
+    Sound_Stream_Chunk* chunk  = &stream->chunks[slot_idx];
+    uint32_t            offset = op_idx ? chunk->read_sizes[0] : 0;
+    uint8_t*            dest   = stream->ring + slot_idx * SOUND_STREAM_CHUNK_BYTES + offset;
+    chunk->ops[op_idx] =
+        memory->PlatformReadFileAsync(&stream->file, chunk->read_offsets[op_idx], chunk->read_sizes[op_idx], dest);
+}
+
+// NOTE: reads stream chunk chunk_idx into its ring slot, zeroes what's past the end of a file that doesn't loop
+inline void
+SoundStreamReadChunk(Sound_Stream* stream, Game_Memory* memory, uint64_t chunk_idx) {
+    uint64_t            slot_idx = chunk_idx & (SOUND_STREAM_CHUNK_COUNT - 1);
+    Sound_Stream_Chunk* chunk    = &stream->chunks[slot_idx];
+    uint8_t*            dest     = stream->ring + slot_idx * SOUND_STREAM_CHUNK_BYTES;
+    chunk->first_frame           = chunk_idx * stream->chunk_frames;
+    chunk->is_ready              = false;
+
+    uint64_t file_frame   = chunk->first_frame;
+    uint64_t frames_to_go = stream->chunk_frames;
+    if (stream->loop) {
+        file_frame %= stream->frame_count;
+    }
+    for (int op_idx = 0; op_idx < 2; ++op_idx) {
+        uint64_t frame_count = 0;
+        if (file_frame < stream->frame_count) {
+            frame_count = stream->frame_count - file_frame;
+        }
+        if (frame_count > frames_to_go) {
+            frame_count = frames_to_go;
+        }
+
+        chunk->ops[op_idx]          = {};
+        chunk->read_offsets[op_idx] = stream->data_offset + file_frame * stream->frame_bytes;
+        chunk->read_sizes[op_idx]   = (uint32_t)(frame_count * stream->frame_bytes);
+        if (frame_count) {
+            SoundStreamIssueRead(stream, memory, slot_idx, op_idx);
+        }
+        dest += frame_count * stream->frame_bytes;
+        frames_to_go -= frame_count;
+        if (!stream->loop) {
+            break;
+        }
+        file_frame = 0;
+    }
+    memset(dest, 0, frames_to_go * stream->frame_bytes);
+}
+
+// NOTE: call once a frame before mixing, moves the header along while opening and keeps the ring topped up
+inline void
+SoundStreamUpdate(Sound_Stream* stream, Game_Memory* memory) {
+    if (stream->state == SoundStream_Opening) {
+        if (stream->header_op.is_busy) {
+            stream->header_op = memory->PlatformReadFileAsync(
+                &stream->file, stream->header_read_offset, SOUND_STREAM_HEADER_BYTES, stream->header);
+        }
+        uint32_t               bytes_read = 0;
+        Platform_File_Op_State op_state   = memory->PlatformPollFileOp(stream->header_op, &bytes_read);
+        if (stream->header_op.is_busy || op_state == PlatformFileOp_Pending) {
+            return;
+        }
+
+        if (op_state != PlatformFileOp_Complete) {
+            stream->state = SoundStream_Failed;
+        } else if (SoundStreamParseHeader(stream, bytes_read)) {
+            SoundStreamStartPlaying(stream);
+        } else if (stream->state == SoundStream_Opening) {
+            // NOTE: a chunk header has to fit, otherwise the file ended before the data chunk
+            if (stream->header_offset + sizeof(Wave_Chunk) > stream->file.size) {
+                stream->state = SoundStream_Failed;
+            } else {
+                stream->header_read_offset = stream->header_offset;
+                stream->header_op          = memory->PlatformReadFileAsync(
+                    &stream->file, stream->header_offset, SOUND_STREAM_HEADER_BYTES, stream->header);
+            }
+        }
+    }
+
+    if (stream->state != SoundStream_Playing) {
+        return;
+    }
+
+    for (int chunk_idx = 0; chunk_idx < SOUND_STREAM_CHUNK_COUNT; ++chunk_idx) {
+        Sound_Stream_Chunk* chunk = &stream->chunks[chunk_idx];
+        if (chunk->is_ready || chunk->first_frame == ~0ull) {
+            continue;
+        }
+
+        bool is_ready = true;
+        for (int op_idx = 0; op_idx < 2; ++op_idx) {
+            if (chunk->ops[op_idx].is_busy) {
+                SoundStreamIssueRead(stream, memory, chunk_idx, op_idx);
+            }
+            if (chunk->ops[op_idx].is_busy) {
+                is_ready = false;
+            } else if (chunk->ops[op_idx].generation) {
+                Platform_File_Op_State op_state = memory->PlatformPollFileOp(chunk->ops[op_idx], 0);
+                if (op_state == PlatformFileOp_Pending) {
+                    is_ready = false;
+                } else if (op_state == PlatformFileOp_Complete) {
+                    chunk->ops[op_idx] = {};
+                } else {
+                    stream->state = SoundStream_Failed;
+                }
+            }
+        }
+        chunk->is_ready = is_ready;
+
+        // NOTE: the guard frame past the end of the ring follows the first slot
+        if (is_ready && chunk_idx == 0) {
+            memcpy(stream->ring + SOUND_STREAM_RING_BYTES, stream->ring, stream->frame_bytes);
+        }
+    }
+
+    for (;;) {
+        Sound_Stream_Chunk* chunk =
+            &stream->chunks[(stream->ready_frame_end / stream->chunk_frames) & (SOUND_STREAM_CHUNK_COUNT - 1)];
+        if (!chunk->is_ready || chunk->first_frame != stream->ready_frame_end) {
+            break;
+        }
+        stream->ready_frame_end += stream->chunk_frames;
+    }
+
+    // NOTE: a slot is free once playback is past every frame in it
+    uint64_t play_chunk = (stream->position >> 32) / stream->chunk_frames;
+    while (stream->next_chunk < play_chunk + SOUND_STREAM_CHUNK_COUNT) {
+        Sound_Stream_Chunk* chunk = &stream->chunks[stream->next_chunk & (SOUND_STREAM_CHUNK_COUNT - 1)];
+        if (chunk->first_frame != ~0ull && !chunk->is_ready) {
+            break;
+        }
+        SoundStreamReadChunk(stream, memory, stream->next_chunk);
+        ++stream->next_chunk;
+    }
+}
+
+// NOTE: frames a and b are interleaved int16 stereo pairs, result is frame a then frame b lerped by their fractions
+inline __m128
+SoundStreamLerpStereo(uint8_t* ring, uint64_t position_a, uint64_t position_b, uint32_t frame_mask) {
+    __m128i   frames_a   = _mm_loadl_epi64((__m128i*)(ring + ((position_a >> 32) & frame_mask) * 4));
+    __m128i   frames_b   = _mm_loadl_epi64((__m128i*)(ring + ((position_b >> 32) & frame_mask) * 4));
+    __m128i   frames     = _mm_unpacklo_epi64(frames_a, frames_b);
+    __m128    lo         = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(frames, frames), 16));
+    __m128    hi         = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(frames, frames), 16));
+    __m128    current    = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(1, 0, 1, 0));
+    __m128    next       = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 2, 3, 2));
+    float32_t fraction_a = (float32_t)(uint32_t)position_a * (1.0f / 4294967296.0f);
+    float32_t fraction_b = (float32_t)(uint32_t)position_b * (1.0f / 4294967296.0f);
+    __m128    fraction   = _mm_set_ps(fraction_b, fraction_b, fraction_a, fraction_a);
+    return _mm_add_ps(current, _mm_mul_ps(_mm_sub_ps(next, current), fraction));
+}
+
+// NOTE: the same four mono frames, each one duplicated to both channels
+inline void
+SoundStreamLerpMono(uint8_t* ring, uint64_t position, uint64_t step, uint32_t frame_mask, __m128* ab, __m128* cd) {
+    __m128i   pairs[4];
+    float32_t fractions[4];
+    for (int lane = 0; lane < 4; ++lane) {
+        int32_t pair;
+        memcpy(&pair, ring + ((position >> 32) & frame_mask) * 2, sizeof(pair));
+        pairs[lane]     = _mm_cvtsi32_si128(pair);
+        fractions[lane] = (float32_t)(uint32_t)position * (1.0f / 4294967296.0f);
+        position += step;
+    }
+    __m128i frames = _mm_unpacklo_epi64(
+        _mm_unpacklo_epi32(pairs[0], pairs[1]), _mm_unpacklo_epi32(pairs[2], pairs[3]));
+    __m128  lo      = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(frames, frames), 16));
+    __m128  hi      = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(frames, frames), 16));
+    __m128  current = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+    __m128  next    = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+    __m128  mixed   = _mm_add_ps(current, _mm_mul_ps(_mm_sub_ps(next, current), _mm_loadu_ps(fractions)));
+    *ab             = _mm_unpacklo_ps(mixed, mixed);
+    *cd             = _mm_unpackhi_ps(mixed, mixed);
+}
+
+// NOTE: adds the stream to interleaved stereo int16 samples at output_rate, saturating. Stops early when the frames it
+// needs haven't been read yet, returns how many output frames it got to. The rest is left alone, the stream picks up
+// where it stopped on the next call.
+inline uint32_t
+SoundStreamMix(Sound_Stream* stream, int16_t* samples, uint32_t sample_count, uint32_t output_rate) {
+    if (stream->state != SoundStream_Playing) {
+        return 0;
+    }
+
+    uint64_t step = ((uint64_t)stream->samples_per_second << 32) / output_rate;
+    uint64_t end  = stream->frame_count << 32;
+
+    // NOTE: output frames until the end of a file that doesn't loop, then the ones that have both of their frames
+    // in the ring
+    uint64_t wanted_count = sample_count;
+    if (!stream->loop) {
+        uint64_t end_count = end > stream->position ? (end - stream->position + step - 1) / step : 0;
+        wanted_count       = end_count < wanted_count ? end_count : wanted_count;
+    }
+    uint64_t ready_end   = stream->ready_frame_end ? ((stream->ready_frame_end - 1) << 32) : 0;
+    uint64_t ready_count = ready_end > stream->position ? (ready_end - stream->position + step - 1) / step : 0;
+    uint32_t count       = (uint32_t)(ready_count < wanted_count ? ready_count : wanted_count);
+    if (count < wanted_count) {
+        ++stream->underrun_count;
+    }
+
+    __m128   volume     = _mm_set1_ps(stream->volume);
+    uint32_t frame_mask = stream->ring_frame_mask;
+    uint64_t position   = stream->position;
+    uint32_t group_end  = count & ~3u;
+    for (uint32_t sample_idx = 0; sample_idx < group_end; sample_idx += 4) {
+        __m128 ab;
+        __m128 cd;
+        if (stream->channel_count == 2) {
+            ab = SoundStreamLerpStereo(stream->ring, position, position + step, frame_mask);
+            cd = SoundStreamLerpStereo(stream->ring, position + 2 * step, position + 3 * step, frame_mask);
+        } else {
+            SoundStreamLerpMono(stream->ring, position, step, frame_mask, &ab, &cd);
+        }
+        __m128i  mixed =
+            _mm_packs_epi32(_mm_cvtps_epi32(_mm_mul_ps(ab, volume)), _mm_cvtps_epi32(_mm_mul_ps(cd, volume)));
+        __m128i* out   = (__m128i*)(samples + 2 * sample_idx);
+        _mm_storeu_si128(out, _mm_adds_epi16(_mm_loadu_si128(out), mixed));
+        position += 4 * step;
+    }
+
+    // NOTE: the last few frames go through the same lanes one at a time, so they round the same way
+    for (uint32_t sample_idx = group_end; sample_idx < count; ++sample_idx) {
+        __m128 ab;
+        __m128 cd;
+        if (stream->channel_count == 2) {
+            ab = SoundStreamLerpStereo(stream->ring, position, position, frame_mask);
+        } else {
+            SoundStreamLerpMono(stream->ring, position, 0, frame_mask, &ab, &cd);
+        }
+        __m128i mixed = _mm_packs_epi32(_mm_cvtps_epi32(_mm_mul_ps(ab, volume)), _mm_setzero_si128());
+        int32_t pair;
+        memcpy(&pair, samples + 2 * sample_idx, sizeof(pair));
+        pair = _mm_cvtsi128_si32(_mm_adds_epi16(_mm_cvtsi32_si128(pair), mixed));
+        memcpy(samples + 2 * sample_idx, &pair, sizeof(pair));
+        position += step;
+    }
+
+    stream->position = position;
+    if (!stream->loop && position >= end) {
+        stream->state = SoundStream_Finished;
+    }
+    return count;
+}
+
+#endif
@@ -0,0 +1,485 @@
+#ifndef HANDMADE_SPRITE_H
+#define HANDMADE_SPRITE_H
+
+#include <stdint.h>
+#include <math.h>
+#include <emmintrin.h>
+#include "base.h"
+#include "handmade_bitmap.h"
+#include "handmade_blend.h"
+
+/*
+ NOTE: sprites drawn at any scale and rotation. A sprite is a bitmap with its mip chain, each level half the size of
+ the one before and box filtered in the blend's linear space, built once when the bitmap is loaded. Drawing picks the
+ level with about one texel per pixel, so a minified sprite reads a small level that stays in cache instead of striding
+ through the big one.
+
+ Where the sprite goes is a basis: the screen position of the bitmap's top left and the screen vectors its width and
+ height map to. Pixel centers are taken back to (u, v) through the inverse of the basis and the four edge tests are
+ u >= 0, u < 1, v >= 0 and v < 1. Each row only walks the span where all four can hold, solved from the same edge
+ equations, and the tests mask the lanes at its ends.
+
+ Four pixels per step like the blend. Texels are fetched one by one (SSE2 has no gather), filtered bilinearly in linear
+ space and go over the buffer premultiplied. Coordinates are clamped so sampling never reads outside the level.
+
+ Between the sample and the blend a shader gets the color, the footprint it came from and the pixel centers, the plain
+ sprite returns the color as is and handmade_lighting.h lights it from the normal map. Drawing is limited to a clip
+ rect so a frame can be split up in tiles.
+ */
+#define SPRITE_MAX_MIP_LEVELS 16
+#define SPRITE_SIMD_WIDTH     4
+
+// NOTE: normals are optional, when normals[0] has memory each level has a normal map the same size and pitch. They're
+// stored as BGRA bytes with x in red, y in green and z in blue, each mapped from [-1, 1] to [1, 255]. x is along the
+// bitmap's width, y along its height and z comes out of the screen.
+struct Sprite {
+    int           level_count;
+    Loaded_Bitmap levels[SPRITE_MAX_MIP_LEVELS]; // NOTE: levels[0] is the bitmap itself
+    Loaded_Bitmap normals[SPRITE_MAX_MIP_LEVELS];
+};
+
+// NOTE: screen pixels, the bitmap's top left goes at origin and its top and left edges along x_axis and y_axis
+struct Sprite_Basis {
+    float32_t origin_x;
+    float32_t origin_y;
+    float32_t x_axis_x;
+    float32_t x_axis_y;
+    float32_t y_axis_x;
+    float32_t y_axis_y;
+};
+
+// NOTE: scale 1 and angle 0 draws the bitmap as it is, a positive angle turns it clockwise on screen
+inline Sprite_Basis
+SpriteBasisAround(float32_t center_x, float32_t center_y, int width, int height, float32_t scale, float32_t angle) {
+    float32_t    cosine = cosf(angle);
+    float32_t    sine   = sinf(angle);
+    Sprite_Basis result;
+    result.x_axis_x = scale * (float32_t)width * cosine;
+    result.x_axis_y = scale * (float32_t)width * sine;
+    result.y_axis_x = -scale * (float32_t)height * sine;
+    result.y_axis_y = scale * (float32_t)height * cosine;
+    result.origin_x = center_x - 0.5f * (result.x_axis_x + result.y_axis_x);
+    result.origin_y = center_y - 0.5f * (result.x_axis_y + result.y_axis_y);
+    return result;
+}
+
+/// Mips
+// NOTE: one premultiplied texel added to a linear sum, scalar since it only runs at load
+inline void
+SpriteAccumulateTexel(uint32_t texel, float32_t* sum) {
+    for (int channel = 0; channel < 3; ++channel) {
+        float32_t value = (float32_t)((texel >> (8 * channel)) & 0xFF) / 255.0f;
+        sum[channel] += value * value;
+    }
+    sum[3] += (float32_t)(texel >> 24) / 255.0f;
+}
+
+inline void
+SpriteAccumulateNormal(uint32_t texel, float32_t* sum) {
+    for (int channel = 0; channel < 3; ++channel) {
+        sum[channel] += ((float32_t)((texel >> (8 * channel)) & 0xFF) - 128.0f) / 127.0f;
+    }
+}
+
+// NOTE: the box of 4 texels in source that one texel of a level half its size covers, the last row or column of an odd
+// sized source is counted twice
+inline void
+SpriteSourceBox(Loaded_Bitmap* source, int x, int y, uint32_t* box) {
+    for (int offset_y = 0; offset_y < 2; ++offset_y) {
+        int       source_y   = 2 * y + offset_y < source->height ? 2 * y + offset_y : source->height - 1;
+        uint32_t* source_row = (uint32_t*)((uint8_t*)source->memory + source_y * source->pitch);
+        for (int offset_x = 0; offset_x < 2; ++offset_x) {
+            int source_x                 = 2 * x + offset_x < source->width ? 2 * x + offset_x : source->width - 1;
+            box[2 * offset_y + offset_x] = source_row[source_x];
+        }
+    }
+}
+
+inline Loaded_Bitmap
+SpriteHalveLevel(Loaded_Bitmap* source, Memory_Arena* arena) {
+    Loaded_Bitmap result;
+    result.width  = source->width > 1 ? source->width / 2 : 1;
+    result.height = source->height > 1 ? source->height / 2 : 1;
+    result.pitch  = (int)AlignPow2(result.width * sizeof(uint32_t), 16);
+    result.memory = PushSize(arena, (uint64_t)result.pitch * result.height, MemoryTag_Bitmaps);
+    return result;
+}
+
+// NOTE: levels[0] (and normals[0] for a lit sprite) has to be set, the rest are pushed on the arena with 16-byte
+// aligned rows. Odd sizes round down. Normals are averaged and made unit length again.
+inline void
+SpriteBuildMips(Sprite* sprite, Memory_Arena* arena) {
+    bool has_normals    = sprite->normals[0].memory != 0;
+    sprite->level_count = 1;
+    while (sprite->level_count < SPRITE_MAX_MIP_LEVELS) {
+        int            level_idx = sprite->level_count;
+        Loaded_Bitmap* source    = &sprite->levels[level_idx - 1];
+        if (source->width == 1 && source->height == 1) {
+            break;
+        }
+
+        Loaded_Bitmap* level = &sprite->levels[level_idx];
+        *level               = SpriteHalveLevel(source, arena);
+        for (int y = 0; y < level->height; ++y) {
+            uint32_t* dest_row = (uint32_t*)((uint8_t*)level->memory + y * level->pitch);
+            for (int x = 0; x < level->width; ++x) {
+                uint32_t  box[4];
+                float32_t sum[4] = {};
+                SpriteSourceBox(source, x, y, box);
+                for (int box_idx = 0; box_idx < 4; ++box_idx) {
+                    SpriteAccumulateTexel(box[box_idx], sum);
+                }
+
+                uint32_t texel = (uint32_t)(0.25f * sum[3] * 255.0f + 0.5f) << 24;
+                for (int channel = 0; channel < 3; ++channel) {
+                    texel |= (uint32_t)(sqrtf(0.25f * sum[channel]) * 255.0f + 0.5f) << (8 * channel);
+                }
+                dest_row[x] = texel;
+            }
+        }
+
+        if (has_normals) {
+            Loaded_Bitmap* normal_source = &sprite->normals[level_idx - 1];
+            Loaded_Bitmap* normals       = &sprite->normals[level_idx];
+            *normals                     = SpriteHalveLevel(normal_source, arena);
+            for (int y = 0; y < normals->height; ++y) {
+                uint32_t* dest_row = (uint32_t*)((uint8_t*)normals->memory + y * normals->pitch);
+                for (int x = 0; x < normals->width; ++x) {
+                    uint32_t  box[4];
+                    float32_t sum[3] = {};
+                    SpriteSourceBox(normal_source, x, y, box);
+                    for (int box_idx = 0; box_idx < 4; ++box_idx) {
+                        SpriteAccumulateNormal(box[box_idx], sum);
+                    }
+
+                    // NOTE: bumps that cancel out leave a flat normal, channel 0 is blue which is z
+                    float32_t length = sqrtf(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+                    if (length < 1e-4f) {
+                        sum[0] = 1.0f;
+                        sum[1] = 0.0f;
+                        sum[2] = 0.0f;
+                        length = 1.0f;
+                    }
+
+                    uint32_t texel = 0xFF000000;
+                    for (int channel = 0; channel < 3; ++channel) {
+                        texel |= (uint32_t)(128.0f + 127.0f * sum[channel] / length + 0.5f) << (8 * channel);
+                    }
+                    dest_row[x] = texel;
+                }
+            }
+        }
+        ++sprite->level_count;
+    }
+}
+
+// NOTE: the level with at most two texels per pixel along the axis that's minified most, one level for the whole
+// sprite, nothing is blended between levels
+inline int
+SpriteSelectLevel(Sprite* sprite, Sprite_Basis* basis) {
+    float32_t x_length = sqrtf(basis->x_axis_x * basis->x_axis_x + basis->x_axis_y * basis->x_axis_y);
+    float32_t y_length = sqrtf(basis->y_axis_x * basis->y_axis_x + basis->y_axis_y * basis->y_axis_y);
+    float32_t texels_x = (float32_t)sprite->levels[0].width / (x_length > 1.0f ? x_length : 1.0f);
+    float32_t texels_y = (float32_t)sprite->levels[0].height / (y_length > 1.0f ? y_length : 1.0f);
+    float32_t texels   = texels_x > texels_y ? texels_x : texels_y;
+
+    int result = 0;
+    while (result + 1 < sprite->level_count && texels >= 2.0f) {
+        texels *= 0.5f;
+        ++result;
+    }
+    return result;
+}
+
+/// Rasterizer
+// NOTE: pixels, max is one past the last
+struct Clip_Rect {
+    int min_x;
+    int min_y;
+    int max_x;
+    int max_y;
+};
+
+// NOTE: where the 2x2 texels for 4 pixels are in a level and how far between them each pixel is. Levels of the same
+// size share it, a normal map is read with the same footprint as the colors.
+struct Sprite_Footprint {
+    uint32_t offsets[SPRITE_SIMD_WIDTH];
+    int      step_x;
+    int      step_y;
+    __m128   fraction_x;
+    __m128   fraction_y;
+};
+
+// NOTE: texel centers are at half texels, the footprint is clamped to the level. A level 1 texel wide or high reads
+// the same texel for both sides.
+inline Sprite_Footprint
+SpriteFootprint(Loaded_Bitmap* level, __m128 u, __m128 v) {
+    __m128 zero      = _mm_setzero_ps();
+    __m128 half      = _mm_set1_ps(0.5f);
+    __m128 texel_x   = _mm_sub_ps(_mm_mul_ps(u, _mm_set1_ps((float32_t)level->width)), half);
+    __m128 texel_y   = _mm_sub_ps(_mm_mul_ps(v, _mm_set1_ps((float32_t)level->height)), half);
+    texel_x          = _mm_min_ps(_mm_max_ps(texel_x, zero), _mm_set1_ps((float32_t)(level->width - 1)));
+    texel_y          = _mm_min_ps(_mm_max_ps(texel_y, zero), _mm_set1_ps((float32_t)(level->height - 1)));
+    int    last_x    = level->width > 1 ? level->width - 2 : 0;
+    int    last_y    = level->height > 1 ? level->height - 2 : 0;
+    __m128 floor_x   = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(texel_x)), _mm_set1_ps((float32_t)last_x));
+    __m128 floor_y   = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(texel_y)), _mm_set1_ps((float32_t)last_y));
+    __m128 texel_row = _mm_set1_ps((float32_t)(level->pitch / (int)sizeof(uint32_t)));
+
+    Sprite_Footprint result;
+    result.step_x     = level->width > 1 ? 1 : 0;
+    result.step_y     = level->height > 1 ? level->pitch / (int)sizeof(uint32_t) : 0;
+    result.fraction_x = _mm_sub_ps(texel_x, floor_x);
+    result.fraction_y = _mm_sub_ps(texel_y, floor_y);
+    _mm_storeu_si128((__m128i*)result.offsets, _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(floor_y, texel_row), floor_x)));
+    return result;
+}
+
+// NOTE: the texel offset from each lane's footprint, one by one since SSE2 has no gather. Built in registers, texels
+// stored to memory and loaded back as a vector stall on store forwarding.
+inline __m128i
+SpriteGather(uint32_t* memory, Sprite_Footprint* footprint, int offset) {
+    uint32_t* offsets = footprint->offsets;
+    return _mm_setr_epi32(
+        (int)memory[offsets[0] + offset],
+        (int)memory[offsets[1] + offset],
+        (int)memory[offsets[2] + offset],
+        (int)memory[offsets[3] + offset]);
+}
+
+// NOTE: corners are top left, top right, bottom left, bottom right, one texel per lane
+inline void
+SpriteFetch(Loaded_Bitmap* level, Sprite_Footprint* footprint, __m128i* corners) {
+    uint32_t* memory = (uint32_t*)level->memory;
+    corners[0]       = SpriteGather(memory, footprint, 0);
+    corners[1]       = SpriteGather(memory, footprint, footprint->step_x);
+    corners[2]       = SpriteGather(memory, footprint, footprint->step_y);
+    corners[3]       = SpriteGather(memory, footprint, footprint->step_y + footprint->step_x);
+}
+
+inline Blend_Pixels
+SpriteLerp(Blend_Pixels a, Blend_Pixels b, __m128 t) {
+    Blend_Pixels result;
+    result.r = _mm_add_ps(a.r, _mm_mul_ps(_mm_sub_ps(b.r, a.r), t));
+    result.g = _mm_add_ps(a.g, _mm_mul_ps(_mm_sub_ps(b.g, a.g), t));
+    result.b = _mm_add_ps(a.b, _mm_mul_ps(_mm_sub_ps(b.b, a.b), t));
+    result.a = _mm_add_ps(a.a, _mm_mul_ps(_mm_sub_ps(b.a, a.a), t));
+    return result;
+}
+
+// NOTE: colors are lerped once they're linear
+inline Blend_Pixels
+SpriteSampleColor(Loaded_Bitmap* level, Sprite_Footprint* footprint) {
+    __m128i corners[4];
+    SpriteFetch(level, footprint, corners);
+    Blend_Pixels top    = SpriteLerp(BlendUnpack(corners[0]), BlendUnpack(corners[1]), footprint->fraction_x);
+    Blend_Pixels bottom = SpriteLerp(BlendUnpack(corners[2]), BlendUnpack(corners[3]), footprint->fraction_x);
+    return SpriteLerp(top, bottom, footprint->fraction_y);
+}
+
+// NOTE: Shade gets the filtered color, premultiplied and linear, for 4 pixels with their footprint in the level and
+// their centers on screen, and returns what goes over the buffer. Like the blend modes, every shader gets its own
+// instance of the rasterizer.
+struct Sprite_Unlit {
+    static inline Blend_Pixels
+    Shade(Sprite_Unlit* shader, int level_idx, Sprite_Footprint* footprint, Blend_Pixels color, __m128 x, __m128 y) {
+        return color;
+    }
+};
+
+// NOTE: 4 pixels of dest at (u, v), the lanes set in mask get the shaded sample blended over them and the rest keep
+// what dest had. dest doesn't have to be aligned.
+template <typename Shader>
+inline void
+SpriteStep_(
+    Shader*   shader,
+    Sprite*   sprite,
+    int       level_idx,
+    uint32_t* dest,
+    __m128    u,
+    __m128    v,
+    __m128    x,
+    __m128    y,
+    __m128i   mask) {
+
+    Loaded_Bitmap*   level     = &sprite->levels[level_idx];
+    Sprite_Footprint footprint = SpriteFootprint(level, u, v);
+    Blend_Pixels     result    = SpriteSampleColor(level, &footprint);
+    result                     = Shader::Shade(shader, level_idx, &footprint, result, x, y);
+
+    __m128i      dest_pixels   = _mm_loadu_si128((__m128i*)dest);
+    Blend_Pixels under         = BlendUnpack(dest_pixels);
+    __m128       inverse_alpha = _mm_sub_ps(_mm_set1_ps(1.0f), result.a);
+    result.r                   = _mm_add_ps(result.r, _mm_mul_ps(under.r, inverse_alpha));
+    result.g                   = _mm_add_ps(result.g, _mm_mul_ps(under.g, inverse_alpha));
+    result.b                   = _mm_add_ps(result.b, _mm_mul_ps(under.b, inverse_alpha));
+
+    __m128i blended = _mm_or_si128(_mm_and_si128(mask, BlendPack(result)), _mm_andnot_si128(mask, dest_pixels));
+    _mm_storeu_si128((__m128i*)dest, blended);
+}
+
+// NOTE: narrows [span_min, span_max) to the x where 0 <= value_at_0 + slope * x < 1, an edge pair of the quad
+inline void
+SpriteClipSpan(float32_t value_at_0, float32_t slope, float32_t* span_min, float32_t* span_max) {
+    if (slope == 0.0f) {
+        if (value_at_0 < 0.0f || value_at_0 >= 1.0f) {
+            *span_max = *span_min;
+        }
+    } else {
+        float32_t enter = -value_at_0 / slope;
+        float32_t leave = (1.0f - value_at_0) / slope;
+        if (slope < 0.0f) {
+            float32_t swap = enter;
+            enter          = leave;
+            leave          = swap;
+        }
+        *span_min = enter > *span_min ? enter : *span_min;
+        *span_max = leave < *span_max ? leave : *span_max;
+    }
+}
+
+// NOTE: the pixels the sprite can touch, clipped, empty when min isn't below max
+inline Clip_Rect
+SpriteBounds(Sprite_Basis* basis, Clip_Rect clip) {
+    float32_t corners_x[4] = {
+        basis->origin_x,
+        basis->origin_x + basis->x_axis_x,
+        basis->origin_x + basis->y_axis_x,
+        basis->origin_x + basis->x_axis_x + basis->y_axis_x,
+    };
+    float32_t corners_y[4] = {
+        basis->origin_y,
+        basis->origin_y + basis->x_axis_y,
+        basis->origin_y + basis->y_axis_y,
+        basis->origin_y + basis->x_axis_y + basis->y_axis_y,
+    };
+    float32_t bounds_min_x = corners_x[0];
+    float32_t bounds_max_x = corners_x[0];
+    float32_t bounds_min_y = corners_y[0];
+    float32_t bounds_max_y = corners_y[0];
+    for (int corner_idx = 1; corner_idx < 4; ++corner_idx) {
+        bounds_min_x = corners_x[corner_idx] < bounds_min_x ? corners_x[corner_idx] : bounds_min_x;
+        bounds_max_x = corners_x[corner_idx] > bounds_max_x ? corners_x[corner_idx] : bounds_max_x;
+        bounds_min_y = corners_y[corner_idx] < bounds_min_y ? corners_y[corner_idx] : bounds_min_y;
+        bounds_max_y = corners_y[corner_idx] > bounds_max_y ? corners_y[corner_idx] : bounds_max_y;
+    }
+
+    // NOTE: compared as floats first, far off screen sprites don't fit in an int
+    Clip_Rect result = clip;
+    if (bounds_max_x < (float32_t)clip.min_x || bounds_max_y < (float32_t)clip.min_y ||
+        bounds_min_x >= (float32_t)clip.max_x || bounds_min_y >= (float32_t)clip.max_y) {
+        result.max_x = result.min_x;
+    } else {
+        result.min_x = bounds_min_x < (float32_t)clip.min_x ? clip.min_x : (int)bounds_min_x;
+        result.min_y = bounds_min_y < (float32_t)clip.min_y ? clip.min_y : (int)bounds_min_y;
+        result.max_x = bounds_max_x + 1.0f > (float32_t)clip.max_x ? clip.max_x : (int)bounds_max_x + 1;
+        result.max_y = bounds_max_y + 1.0f > (float32_t)clip.max_y ? clip.max_y : (int)bounds_max_y + 1;
+    }
+    return result;
+}
+
+// NOTE: only BGRX8888 buffers like the blend. Nothing outside clip is touched, so a frame can be drawn a tile at a time
+// with each tile on its own thread. Returns how many pixels were covered.
+template <typename Shader>
+inline uint32_t
+DrawSprite_(Game_Offscreen_Buffer* buffer, Clip_Rect clip, Sprite* sprite, Sprite_Basis basis, Shader* shader) {
+    Assert(buffer->pixel_format == GamePixelFormat_BGRX8888);
+    uint32_t  covered     = 0;
+    float32_t determinant = basis.x_axis_x * basis.y_axis_y - basis.x_axis_y * basis.y_axis_x;
+    Clip_Rect bounds      = SpriteBounds(&basis, clip);
+    if (fabsf(determinant) < 1e-6f || bounds.min_x >= bounds.max_x || bounds.min_y >= bounds.max_y) {
+        return covered;
+    }
+
+    // NOTE: u and v are linear in the pixel position, these are their steps along x and y
+    float32_t inverse_determinant = 1.0f / determinant;
+    float32_t u_step_x            = basis.y_axis_y * inverse_determinant;
+    float32_t u_step_y            = -basis.y_axis_x * inverse_determinant;
+    float32_t v_step_x            = -basis.x_axis_y * inverse_determinant;
+    float32_t v_step_y            = basis.x_axis_x * inverse_determinant;
+    float32_t u_at_0              = (0.5f - basis.origin_x) * u_step_x + (0.5f - basis.origin_y) * u_step_y;
+    float32_t v_at_0              = (0.5f - basis.origin_x) * v_step_x + (0.5f - basis.origin_y) * v_step_y;
+
+    int    level_idx   = SpriteSelectLevel(sprite, &basis);
+    __m128 zero        = _mm_setzero_ps();
+    __m128 one         = _mm_set1_ps(1.0f);
+    __m128 lane_index  = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+    __m128 lane_center = _mm_add_ps(lane_index, _mm_set1_ps(0.5f));
+    __m128 lane_u_step = _mm_mul_ps(lane_index, _mm_set1_ps(u_step_x));
+    __m128 lane_v_step = _mm_mul_ps(lane_index, _mm_set1_ps(v_step_x));
+    for (int y = bounds.min_y; y < bounds.max_y; ++y) {
+        float32_t row_u    = u_at_0 + (float32_t)y * u_step_y;
+        float32_t row_v    = v_at_0 + (float32_t)y * v_step_y;
+        float32_t span_min = (float32_t)bounds.min_x;
+        float32_t span_max = (float32_t)bounds.max_x;
+        SpriteClipSpan(row_u, u_step_x, &span_min, &span_max);
+        SpriteClipSpan(row_v, v_step_x, &span_min, &span_max);
+        if (span_min >= span_max) {
+            continue;
+        }
+
+        // NOTE: a pixel of slack on each side for rounding, the edge tests decide
+        int       start    = (int)span_min - 1 < bounds.min_x ? bounds.min_x : (int)span_min - 1;
+        int       end      = (int)span_max + 1 > bounds.max_x ? bounds.max_x : (int)span_max + 1;
+        uint32_t* row      = (uint32_t*)((uint8_t*)buffer->memory + y * buffer->pitch);
+        __m128    center_y = _mm_set1_ps((float32_t)y + 0.5f);
+        for (int x = start; x < end; x += SPRITE_SIMD_WIDTH) {
+            __m128 u    = _mm_add_ps(_mm_set1_ps(row_u + (float32_t)x * u_step_x), lane_u_step);
+            __m128 v    = _mm_add_ps(_mm_set1_ps(row_v + (float32_t)x * v_step_x), lane_v_step);
+            __m128 edge = _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmplt_ps(u, one));
+            edge        = _mm_and_ps(edge, _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmplt_ps(v, one)));
+            int    left = end - x;
+            if (left < SPRITE_SIMD_WIDTH) {
+                edge = _mm_and_ps(edge, _mm_cmplt_ps(lane_index, _mm_set1_ps((float32_t)left)));
+            }
+
+            int lanes = _mm_movemask_ps(edge);
+            if (!lanes) {
+                continue;
+            }
+            covered += (lanes & 1) + ((lanes >> 1) & 1) + ((lanes >> 2) & 1) + ((lanes >> 3) & 1);
+
+            __m128i mask     = _mm_castps_si128(edge);
+            __m128  center_x = _mm_add_ps(_mm_set1_ps((float32_t)x), lane_center);
+            if (left >= SPRITE_SIMD_WIDTH) {
+                SpriteStep_<Shader>(shader, sprite, level_idx, row + x, u, v, center_x, center_y, mask);
+            } else {
+                // NOTE: the row's last pixels go through a copy so nothing past the end of the clip is touched
+                uint32_t dest_lanes[SPRITE_SIMD_WIDTH] = {};
+                for (int idx = 0; idx < left; ++idx) {
+                    dest_lanes[idx] = row[x + idx];
+                }
+                SpriteStep_<Shader>(shader, sprite, level_idx, dest_lanes, u, v, center_x, center_y, mask);
+                for (int idx = 0; idx < left; ++idx) {
+                    row[x + idx] = dest_lanes[idx];
+                }
+            }
+        }
+    }
+    return covered;
+}
+
+inline Clip_Rect
+ClipRectForBuffer(Game_Offscreen_Buffer* buffer) {
+    Clip_Rect result = {0, 0, buffer->width, buffer->height};
+    return result;
+}
+
+inline uint32_t
+DrawSprite(Game_Offscreen_Buffer* buffer, Sprite* sprite, Sprite_Basis basis) {
+    Sprite_Unlit shader = {};
+    return DrawSprite_<Sprite_Unlit>(buffer, ClipRectForBuffer(buffer), sprite, basis, &shader);
+}
+
+// NOTE: after a save comes back at another address
+inline void
+SpriteRebase(Sprite* sprite, intptr_t storage_delta) {
+    for (int level_idx = 0; level_idx < sprite->level_count; ++level_idx) {
+        sprite->levels[level_idx].memory = (uint8_t*)sprite->levels[level_idx].memory + storage_delta;
+        if (sprite->normals[level_idx].memory) {
+            sprite->normals[level_idx].memory = (uint8_t*)sprite->normals[level_idx].memory + storage_delta;
+        }
+    }
+}
+
+#endif
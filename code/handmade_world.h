@@ -0,0 +1,301 @@
+#ifndef HANDMADE_WORLD_H
+#define HANDMADE_WORLD_H
+
+#include <stdint.h>
+#include <string.h>
+#include "base.h"
+
+/*
+ NOTE: the world is an unbounded plane of tiles cut into WORLD_CHUNK_DIM x WORLD_CHUNK_DIM chunks. Only chunks that
+ have something in them exist, they are pushed on the arena the first time a tile in them is set and found again
+ through an open addressed hash table (linear probing) keyed on the chunk coordinates. Empty space costs nothing but
+ the table.
+
+ Tile coordinates are int32 on both axes, the chunk a tile is in is its coordinate shifted down by WORLD_CHUNK_SHIFT
+ (an arithmetic shift, so it rounds towards negative infinity) and the tile within the chunk is the low bits.
+
+ Chunks pushed on the arena are never freed, the table never grows, WorldGetChunk returns 0 once it's WORLD_MAX_LOAD
+ full. A world can also be given chunks that live somewhere else (the pager's cache, handmade_world_pager.h) with
+ WorldInsertChunk, and have them taken out again with WorldRemoveChunk.
+ */
+#define WORLD_CHUNK_SHIFT 4
+#define WORLD_CHUNK_DIM   (1 << WORLD_CHUNK_SHIFT)
+#define WORLD_CHUNK_MASK  (WORLD_CHUNK_DIM - 1)
+#define WORLD_MAX_LOAD    0.75f
+
+struct World_Chunk {
+    int32_t  chunk_x;
+    int32_t  chunk_y;
+    uint32_t filled_tile_count;
+    uint32_t pad;
+
+    uint8_t tiles[WORLD_CHUNK_DIM * WORLD_CHUNK_DIM]; // row major, 0 is empty
+};
+
+struct World_Hash_Slot {
+    int32_t      chunk_x;
+    int32_t      chunk_y;
+    World_Chunk* chunk; // 0 when the slot is free
+};
+
+struct World {
+    uint32_t         slot_count; // power of two
+    uint32_t         slot_shift; // 64 - log2(slot_count), for the hash
+    uint32_t         chunk_count;
+    uint32_t         max_chunk_count;
+    World_Hash_Slot* slots;
+};
+
+// NOTE: slots is slot_count entries the world keeps using, they're cleared here
+inline void
+WorldInitWithSlots(World* world, World_Hash_Slot* slots, uint32_t slot_count) {
+    Assert((slot_count & (slot_count - 1)) == 0);
+
+    *world                 = {};
+    world->slot_count      = slot_count;
+    world->slot_shift      = 64;
+    world->max_chunk_count = (uint32_t)(WORLD_MAX_LOAD * (float32_t)slot_count);
+    for (uint32_t count = slot_count; count > 1; count >>= 1) {
+        --world->slot_shift;
+    }
+    world->slots = slots;
+    memset(world->slots, 0, slot_count * sizeof(World_Hash_Slot));
+}
+
+inline void
+WorldInit(World* world, Memory_Arena* arena, uint32_t slot_count) {
+    World_Hash_Slot* slots =
+        (World_Hash_Slot*)PushSize_(arena, slot_count * sizeof(World_Hash_Slot), MemoryTag_World, 64);
+    WorldInitWithSlots(world, slots, slot_count);
+}
+
+// NOTE: for when the memory the world lives in is now at a different address, e.g. a save loaded in another run
+inline void
+WorldRebase(World* world, intptr_t delta) {
+    world->slots = (World_Hash_Slot*)((uint8_t*)world->slots + delta);
+    for (uint32_t slot_idx = 0; slot_idx < world->slot_count; ++slot_idx) {
+        if (world->slots[slot_idx].chunk) {
+            world->slots[slot_idx].chunk = (World_Chunk*)((uint8_t*)world->slots[slot_idx].chunk + delta);
+        }
+    }
+}
+
+// NOTE: fibonacci hashing of both coordinates packed into 64 bits, the top bits are the best mixed
+inline uint32_t
+WorldHashChunk(World* world, int32_t chunk_x, int32_t chunk_y) {
+    uint64_t key = ((uint64_t)(uint32_t)chunk_x << 32) | (uint32_t)chunk_y;
+    return (uint32_t)((key * 11400714819323198485ull) >> world->slot_shift);
+}
+
+// NOTE: returns 0 when the chunk doesn't exist
+inline World_Chunk*
+WorldFindChunk(World* world, int32_t chunk_x, int32_t chunk_y) {
+    uint32_t mask     = world->slot_count - 1;
+    uint32_t slot_idx = WorldHashChunk(world, chunk_x, chunk_y);
+    for (;;) {
+        World_Hash_Slot* slot = &world->slots[slot_idx];
+        if (!slot->chunk) {
+            return 0;
+        }
+        if (slot->chunk_x == chunk_x && slot->chunk_y == chunk_y) {
+            return slot->chunk;
+        }
+        slot_idx = (slot_idx + 1) & mask;
+    }
+}
+
+// NOTE: the chunk mustn't be in the table yet, returns false when the table is full
+inline bool
+WorldInsertChunk(World* world, World_Chunk* chunk) {
+    if (world->chunk_count >= world->max_chunk_count) {
+        return false;
+    }
+
+    uint32_t mask     = world->slot_count - 1;
+    uint32_t slot_idx = WorldHashChunk(world, chunk->chunk_x, chunk->chunk_y);
+    while (world->slots[slot_idx].chunk) {
+        Assert(world->slots[slot_idx].chunk_x != chunk->chunk_x || world->slots[slot_idx].chunk_y != chunk->chunk_y);
+        slot_idx = (slot_idx + 1) & mask;
+    }
+
+    World_Hash_Slot* slot = &world->slots[slot_idx];
+    slot->chunk_x         = chunk->chunk_x;
+    slot->chunk_y         = chunk->chunk_y;
+    slot->chunk           = chunk;
+    ++world->chunk_count;
+    return true;
+}
+
+// NOTE: finds the chunk or makes an empty one, returns 0 only when the table is full
+inline World_Chunk*
+WorldGetChunk(World* world, Memory_Arena* arena, int32_t chunk_x, int32_t chunk_y) {
+    World_Chunk* chunk = WorldFindChunk(world, chunk_x, chunk_y);
+    if (chunk || world->chunk_count >= world->max_chunk_count) {
+        return chunk;
+    }
+
+    chunk = (World_Chunk*)PushSize_(arena, sizeof(World_Chunk), MemoryTag_World, 16);
+    memset(chunk, 0, sizeof(World_Chunk));
+    chunk->chunk_x = chunk_x;
+    chunk->chunk_y = chunk_y;
+    WorldInsertChunk(world, chunk);
+    return chunk;
+}
+
+// NOTE: the chunk's memory is the caller's again. The entries after it in the probe run are shifted back into the
+// hole, so lookups never need tombstones.
+inline void
+WorldRemoveChunk(World* world, int32_t chunk_x, int32_t chunk_y) {
+    uint32_t mask     = world->slot_count - 1;
+    uint32_t hole_idx = WorldHashChunk(world, chunk_x, chunk_y);
+    for (;;) {
+        World_Hash_Slot* slot = &world->slots[hole_idx];
+        if (!slot->chunk) {
+            return;
+        }
+        if (slot->chunk_x == chunk_x && slot->chunk_y == chunk_y) {
+            break;
+        }
+        hole_idx = (hole_idx + 1) & mask;
+    }
+
+    // NOTE: an entry can move into the hole when its home slot is no closer to it than the hole is
+    for (uint32_t slot_idx = (hole_idx + 1) & mask; world->slots[slot_idx].chunk; slot_idx = (slot_idx + 1) & mask) {
+        World_Hash_Slot* slot = &world->slots[slot_idx];
+        uint32_t         home = WorldHashChunk(world, slot->chunk_x, slot->chunk_y);
+        if (((slot_idx - home) & mask) >= ((slot_idx - hole_idx) & mask)) {
+            world->slots[hole_idx] = *slot;
+            hole_idx               = slot_idx;
+        }
+    }
+    world->slots[hole_idx] = {};
+    --world->chunk_count;
+}
+
+inline uint8_t
+WorldGetTile(World* world, int32_t tile_x, int32_t tile_y) {
+    World_Chunk* chunk = WorldFindChunk(world, tile_x >> WORLD_CHUNK_SHIFT, tile_y >> WORLD_CHUNK_SHIFT);
+    if (!chunk) {
+        return 0;
+    }
+    return chunk->tiles[(tile_y & WORLD_CHUNK_MASK) * WORLD_CHUNK_DIM + (tile_x & WORLD_CHUNK_MASK)];
+}
+
+// NOTE: clearing a tile never makes a chunk, returns false when the chunk was needed but the table is full
+inline bool
+WorldSetTile(World* world, Memory_Arena* arena, int32_t tile_x, int32_t tile_y, uint8_t value) {
+    int32_t      chunk_x = tile_x >> WORLD_CHUNK_SHIFT;
+    int32_t      chunk_y = tile_y >> WORLD_CHUNK_SHIFT;
+    World_Chunk* chunk   = 0;
+    if (value) {
+        chunk = WorldGetChunk(world, arena, chunk_x, chunk_y);
+    } else {
+        chunk = WorldFindChunk(world, chunk_x, chunk_y);
+    }
+    if (!chunk) {
+        return value == 0;
+    }
+
+    uint8_t* tile = &chunk->tiles[(tile_y & WORLD_CHUNK_MASK) * WORLD_CHUNK_DIM + (tile_x & WORLD_CHUNK_MASK)];
+    if (*tile && !value) {
+        --chunk->filled_tile_count;
+    } else if (!*tile && value) {
+        ++chunk->filled_tile_count;
+    }
+    *tile = value;
+    return true;
+}
+
+/// Neighbour queries
+// NOTE: a chunk and the 8 around it, looked up once so tile queries near the chunk's edges don't go through the hash
+// again. Missing chunks are 0.
+struct World_Neighbourhood {
+    int32_t      center_chunk_x;
+    int32_t      center_chunk_y;
+    World_Chunk* chunks[3][3]; // [y][x], [1][1] is the center
+};
+
+inline World_Neighbourhood
+WorldGetNeighbourhood(World* world, int32_t chunk_x, int32_t chunk_y) {
+    World_Neighbourhood result;
+    result.center_chunk_x = chunk_x;
+    result.center_chunk_y = chunk_y;
+    for (int offset_y = -1; offset_y <= 1; ++offset_y) {
+        for (int offset_x = -1; offset_x <= 1; ++offset_x) {
+            result.chunks[offset_y + 1][offset_x + 1] = WorldFindChunk(world, chunk_x + offset_x, chunk_y + offset_y);
+        }
+    }
+    return result;
+}
+
+// NOTE: local coordinates are relative to the center chunk's first tile and go from -WORLD_CHUNK_DIM to
+// 2 * WORLD_CHUNK_DIM - 1
+inline uint8_t
+WorldNeighbourhoodTile(World_Neighbourhood* neighbourhood, int local_x, int local_y) {
+    int          row   = (local_y + WORLD_CHUNK_DIM) >> WORLD_CHUNK_SHIFT;
+    int          col   = (local_x + WORLD_CHUNK_DIM) >> WORLD_CHUNK_SHIFT;
+    World_Chunk* chunk = neighbourhood->chunks[row][col];
+    if (!chunk) {
+        return 0;
+    }
+    return chunk->tiles[(local_y & WORLD_CHUNK_MASK) * WORLD_CHUNK_DIM + (local_x & WORLD_CHUNK_MASK)];
+}
+
+// NOTE: how many of the 8 tiles around the tile are filled
+inline int
+WorldCountFilledNeighbours(World_Neighbourhood* neighbourhood, int local_x, int local_y) {
+    int result = 0;
+    for (int offset_y = -1; offset_y <= 1; ++offset_y) {
+        for (int offset_x = -1; offset_x <= 1; ++offset_x) {
+            if (!offset_x && !offset_y) {
+                continue;
+            }
+            if (WorldNeighbourhoodTile(neighbourhood, local_x + offset_x, local_y + offset_y)) {
+                ++result;
+            }
+        }
+    }
+    return result;
+}
+
+/// Camera iteration
+// NOTE: walks the chunks that exist inside a rectangle of tiles, row by row. Each lookup is a hash probe, a view
+// that's mostly empty space costs about as much as one that's full.
+struct World_Chunk_Iterator {
+    World*  world;
+    int32_t min_chunk_x;
+    int32_t max_chunk_x;
+    int32_t max_chunk_y;
+    int32_t chunk_x;
+    int32_t chunk_y;
+};
+
+inline World_Chunk_Iterator
+WorldIterateChunks(World* world, int32_t min_tile_x, int32_t min_tile_y, int32_t max_tile_x, int32_t max_tile_y) {
+    World_Chunk_Iterator result;
+    result.world       = world;
+    result.min_chunk_x = min_tile_x >> WORLD_CHUNK_SHIFT;
+    result.max_chunk_x = max_tile_x >> WORLD_CHUNK_SHIFT;
+    result.max_chunk_y = max_tile_y >> WORLD_CHUNK_SHIFT;
+    result.chunk_x     = result.min_chunk_x;
+    result.chunk_y     = min_tile_y >> WORLD_CHUNK_SHIFT;
+    return result;
+}
+
+// NOTE: returns 0 when done
+inline World_Chunk*
+WorldNextChunk(World_Chunk_Iterator* iterator) {
+    while (iterator->chunk_y <= iterator->max_chunk_y) {
+        World_Chunk* chunk = WorldFindChunk(iterator->world, iterator->chunk_x, iterator->chunk_y);
+        if (++iterator->chunk_x > iterator->max_chunk_x) {
+            iterator->chunk_x = iterator->min_chunk_x;
+            ++iterator->chunk_y;
+        }
+        if (chunk) {
+            return chunk;
+        }
+    }
+    return 0;
+}
+
+#endif
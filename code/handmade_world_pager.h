@@ -0,0 +1,583 @@
+#ifndef HANDMADE_WORLD_PAGER_H
+#define HANDMADE_WORLD_PAGER_H
+
+#include <stdint.h>
+#include <string.h>
+#include "base.h"
+#include "handmade_file_formats.h"
+#include "handmade_world.h"
+
+/*
+ NOTE: a world bigger than memory, paged in from a chunk file a chunk at a time. The file is a dense grid of chunk
+ records over a fixed rectangle of chunks, little endian:
+
+   [World_File_Header]
+   [World_Chunk * span_x * span_y]   row major from (min_chunk_x, min_chunk_y)
+
+ At most WORLD_PAGER_MAX_CHUNKS are in memory. They're in a World like any other chunks, so tile queries and the
+ camera iterator work on the cache as it is, a chunk that isn't in yet reads as empty.
+
+ Every frame the pager gets the rectangle of tiles each camera sees. It reads the chunks in them that aren't in
+ memory with the async file api, then the ones in a margin of WORLD_PAGER_PREFETCH chunks around them, and moves all
+ of them to the front of an LRU list. A chunk that comes in takes the page at the back of the list. A page that was
+ changed is written back in place before it's reused, and pages nobody has looked at this frame are written behind a
+ few at a time so that's rarely needed. Nothing waits for the disk except WorldPagerClose, a chunk that's late turns
+ up in a later frame and the frame draws without it.
+
+ Records past the end of the file or that don't hold the chunk they should come in empty and are listed in new_chunks
+ for that frame, the game fills them and marks them changed and the file grows as the world is explored. A record
+ that was written has WORLD_FILE_MAGIC in its pad, so the zeros in a hole of the file don't pass for chunk (0, 0).
+ Without a file (it's open somewhere else, or can't be created) every chunk is new and changes are gone once a page is
+ reused.
+
+ Everything is inside World_Pager, like the sound stream it must stay where it is while reads and writes are in
+ flight. Transient storage is the place for it, a save or a rollback putting back an old cache under ops in flight
+ would lose writes.
+ */
+#define WORLD_PAGER_MAX_CHUNKS      1024
+#define WORLD_PAGER_SLOT_COUNT      2048 // power of two, WORLD_MAX_LOAD of it has to hold every page
+#define WORLD_PAGER_MAX_OPS         32   // reads and writes in flight, and chunks made in a frame without a file
+#define WORLD_PAGER_WRITES_PER_TICK 4    // write behind
+#define WORLD_PAGER_PREFETCH        2    // chunks around the view that are read ahead
+#define WORLD_PAGER_LIST_HEAD       WORLD_PAGER_MAX_CHUNKS
+#define WORLD_FILE_MAGIC            RIFF_CODE('h', 'h', 'w', 'f')
+#define WORLD_FILE_VERSION          1
+
+#pragma pack(push, 1)
+struct World_File_Header {
+    uint32_t magic;
+    uint32_t version;
+    int32_t  min_chunk_x;
+    int32_t  min_chunk_y;
+    uint32_t span_x;
+    uint32_t span_y;
+};
+#pragma pack(pop)
+
+enum World_Pager_State {
+    WorldPager_Closed,
+    WorldPager_Opening, // reading the header of a file that was there
+    WorldPager_Open,
+};
+
+enum World_Page_State {
+    WorldPage_Free,
+    WorldPage_Reading,
+    WorldPage_Resident,
+    WorldPage_Writing, // still resident, but the page can't be reused until the write is done
+};
+
+// NOTE: pages are in the LRU list from the most recently used (after the head) to the least (before it), free ones
+// included
+struct World_Page {
+    uint32_t         state; // World_Page_State
+    bool             is_dirty;
+    int32_t          chunk_x;
+    int32_t          chunk_y;
+    uint32_t         touched_frame;
+    uint32_t         next; // NOTE: towards the least recently used
+    uint32_t         prev;
+    Platform_File_Op op;
+};
+
+// NOTE: the tiles a camera sees, inclusive
+struct World_Pager_View {
+    int32_t min_tile_x;
+    int32_t min_tile_y;
+    int32_t max_tile_x;
+    int32_t max_tile_y;
+};
+
+struct World_Pager_Stats {
+    uint64_t hits;   // chunks in a view that were in memory
+    uint64_t misses; // chunks in view that weren't, they're drawn empty that frame
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t new_chunks;
+    uint64_t evictions;
+    uint64_t failed_writes; // NOTE: the page stays changed and is written again later
+};
+
+struct World_Pager {
+    uint32_t          state; // World_Pager_State
+    World_File_Header layout;
+    World_File_Header file_header; // what was read from the file
+    Platform_File_Op  header_op;
+
+    Platform_File_Handle file; // no platform_handle when there's no file
+    uint32_t             frame;
+    uint32_t             dirty_count;
+    uint32_t             op_count;
+    uint32_t             op_pages[WORLD_PAGER_MAX_OPS];
+    uint32_t             new_chunk_count; // NOTE: the chunks that came in empty this frame
+    World_Chunk*         new_chunks[WORLD_PAGER_MAX_OPS];
+    World_Pager_Stats    stats;
+
+    World           world;
+    World_Hash_Slot slots[WORLD_PAGER_SLOT_COUNT];
+    World_Page      pages[WORLD_PAGER_MAX_CHUNKS + 1]; // the last one is the LRU list's head
+    World_Chunk     chunks[WORLD_PAGER_MAX_CHUNKS];
+};
+
+/// LRU list
+inline void
+WorldPagerUnlink(World_Pager* pager, uint32_t page_idx) {
+    World_Page* page              = &pager->pages[page_idx];
+    pager->pages[page->prev].next = page->next;
+    pager->pages[page->next].prev = page->prev;
+}
+
+inline void
+WorldPagerPushFront(World_Pager* pager, uint32_t page_idx) {
+    World_Page* head              = &pager->pages[WORLD_PAGER_LIST_HEAD];
+    World_Page* page              = &pager->pages[page_idx];
+    page->next                    = head->next;
+    page->prev                    = WORLD_PAGER_LIST_HEAD;
+    pager->pages[head->next].prev = page_idx;
+    head->next                    = page_idx;
+}
+
+inline void
+WorldPagerTouch(World_Pager* pager, uint32_t page_idx) {
+    pager->pages[page_idx].touched_frame = pager->frame;
+    WorldPagerUnlink(pager, page_idx);
+    WorldPagerPushFront(pager, page_idx);
+}
+
+inline uint32_t
+WorldPagerPageOf(World_Pager* pager, World_Chunk* chunk) {
+    return (uint32_t)(chunk - pager->chunks);
+}
+
+/// File
+inline bool
+WorldPagerHasRecord(World_Pager* pager, int32_t chunk_x, int32_t chunk_y) {
+    int64_t column = (int64_t)chunk_x - pager->layout.min_chunk_x;
+    int64_t row    = (int64_t)chunk_y - pager->layout.min_chunk_y;
+    return column >= 0 && row >= 0 && column < pager->layout.span_x && row < pager->layout.span_y;
+}
+
+inline uint64_t
+WorldPagerRecordOffset(World_Pager* pager, int32_t chunk_x, int32_t chunk_y) {
+    uint64_t column = (uint64_t)((int64_t)chunk_x - pager->layout.min_chunk_x);
+    uint64_t row    = (uint64_t)((int64_t)chunk_y - pager->layout.min_chunk_y);
+    return sizeof(World_File_Header) + (row * pager->layout.span_x + column) * sizeof(World_Chunk);
+}
+
+// NOTE: reads the header of a file that was there, writes the layout into a new one. A busy op is issued again by the
+// next update.
+inline void
+WorldPagerIssueHeaderOp(World_Pager* pager, Game_Memory* memory) {
+    if (pager->state == WorldPager_Opening) {
+        pager->header_op =
+            memory->PlatformReadFileAsync(&pager->file, 0, (uint32_t)sizeof(World_File_Header), &pager->file_header);
+    } else {
+        pager->header_op =
+            memory->PlatformWriteFileAsync(&pager->file, 0, (uint32_t)sizeof(World_File_Header), &pager->layout);
+    }
+}
+
+// NOTE: a file that's empty or was made for another layout starts over, its chunks would be in the wrong places
+inline void
+WorldPagerStartFile(World_Pager* pager, Game_Memory* memory, const char* file_name, bool truncate) {
+    if (truncate) {
+        memory->PlatformCloseFile(&pager->file);
+        pager->file = memory->PlatformOpenFile(
+            file_name, PlatformOpenFile_Read | PlatformOpenFile_Write | PlatformOpenFile_Create);
+    }
+    pager->state = WorldPager_Open;
+    if (pager->file.platform_handle) {
+        WorldPagerIssueHeaderOp(pager, memory);
+    }
+}
+
+// NOTE: the file is opened read-write and made if it isn't there. file_name has to outlive the opening, it's only
+// used again if the header is wrong.
+inline void
+WorldPagerOpen(
+    World_Pager* pager,
+    Game_Memory* memory,
+    const char*  file_name,
+    int32_t      min_chunk_x,
+    int32_t      min_chunk_y,
+    uint32_t     span_x,
+    uint32_t     span_y) {
+
+    pager->state              = WorldPager_Closed;
+    pager->layout.magic       = WORLD_FILE_MAGIC;
+    pager->layout.version     = WORLD_FILE_VERSION;
+    pager->layout.min_chunk_x = min_chunk_x;
+    pager->layout.min_chunk_y = min_chunk_y;
+    pager->layout.span_x      = span_x;
+    pager->layout.span_y      = span_y;
+    pager->header_op          = {};
+    pager->frame              = 0;
+    pager->dirty_count        = 0;
+    pager->op_count           = 0;
+    pager->new_chunk_count    = 0;
+    pager->stats              = {};
+    WorldInitWithSlots(&pager->world, pager->slots, WORLD_PAGER_SLOT_COUNT);
+
+    World_Page* head = &pager->pages[WORLD_PAGER_LIST_HEAD];
+    head->next       = WORLD_PAGER_LIST_HEAD;
+    head->prev       = WORLD_PAGER_LIST_HEAD;
+    for (uint32_t page_idx = 0; page_idx < WORLD_PAGER_MAX_CHUNKS; ++page_idx) {
+        pager->pages[page_idx]       = {};
+        pager->pages[page_idx].state = WorldPage_Free;
+        WorldPagerPushFront(pager, page_idx);
+    }
+
+    pager->file = memory->PlatformOpenFile(file_name, PlatformOpenFile_Read | PlatformOpenFile_Write);
+    if (pager->file.platform_handle && pager->file.size >= sizeof(World_File_Header)) {
+        pager->state = WorldPager_Opening;
+        WorldPagerIssueHeaderOp(pager, memory);
+    } else {
+        WorldPagerStartFile(pager, memory, file_name, false);
+    }
+}
+
+/// Ops
+inline void
+WorldPagerAddOp(World_Pager* pager, uint32_t page_idx) {
+    Assert(pager->op_count < WORLD_PAGER_MAX_OPS);
+    pager->op_pages[pager->op_count++] = page_idx;
+}
+
+// NOTE: the page keeps its place in the LRU list, what it holds is the same until the write is done. When the platform
+// is busy the page just stays changed.
+inline void
+WorldPagerWritePage(World_Pager* pager, Game_Memory* memory, uint32_t page_idx) {
+    World_Page* page = &pager->pages[page_idx];
+    Assert(page->state == WorldPage_Resident && page->is_dirty);
+    pager->chunks[page_idx].pad = WORLD_FILE_MAGIC;
+    page->op                    = memory->PlatformWriteFileAsync(
+        &pager->file,
+        WorldPagerRecordOffset(pager, page->chunk_x, page->chunk_y),
+        (uint32_t)sizeof(World_Chunk),
+        &pager->chunks[page_idx]);
+    if (page->op.is_busy) {
+        page->op = {};
+        return;
+    }
+
+    page->is_dirty = false;
+    --pager->dirty_count;
+    page->state = WorldPage_Writing;
+    WorldPagerAddOp(pager, page_idx);
+    ++pager->stats.writes;
+}
+
+// NOTE: a chunk that didn't come back as itself is a new one
+inline void
+WorldPagerFinishRead(World_Pager* pager, uint32_t page_idx, bool is_valid) {
+    World_Page*  page  = &pager->pages[page_idx];
+    World_Chunk* chunk = &pager->chunks[page_idx];
+    if (!is_valid || chunk->pad != WORLD_FILE_MAGIC || chunk->chunk_x != page->chunk_x ||
+        chunk->chunk_y != page->chunk_y || chunk->filled_tile_count > WORLD_CHUNK_DIM * WORLD_CHUNK_DIM) {
+        memset(chunk, 0, sizeof(World_Chunk));
+        chunk->chunk_x                              = page->chunk_x;
+        chunk->chunk_y                              = page->chunk_y;
+        pager->new_chunks[pager->new_chunk_count++] = chunk;
+        ++pager->stats.new_chunks;
+    }
+    page->state       = WorldPage_Resident;
+    bool was_inserted = WorldInsertChunk(&pager->world, chunk);
+    Assert(was_inserted);
+}
+
+inline void
+WorldPagerPollOps(World_Pager* pager, Game_Memory* memory) {
+    uint32_t op_idx = 0;
+    while (op_idx < pager->op_count) {
+        uint32_t               page_idx          = pager->op_pages[op_idx];
+        World_Page*            page              = &pager->pages[page_idx];
+        uint32_t               bytes_transferred = 0;
+        Platform_File_Op_State op_state          = memory->PlatformPollFileOp(page->op, &bytes_transferred);
+        if (op_state == PlatformFileOp_Pending) {
+            ++op_idx;
+            continue;
+        }
+
+        bool is_complete = op_state == PlatformFileOp_Complete && bytes_transferred == sizeof(World_Chunk);
+        if (page->state == WorldPage_Reading) {
+            WorldPagerFinishRead(pager, page_idx, is_complete);
+        } else {
+            page->state = WorldPage_Resident;
+            if (!is_complete) {
+                ++pager->stats.failed_writes;
+                if (!page->is_dirty) {
+                    page->is_dirty = true;
+                    ++pager->dirty_count;
+                }
+            }
+        }
+        page->op                = {};
+        pager->op_pages[op_idx] = pager->op_pages[--pager->op_count];
+    }
+}
+
+/// Paging
+// NOTE: the least recently used page that can take a chunk, changed pages on the way are written back, leaving an op
+// for the read. Returns WORLD_PAGER_MAX_CHUNKS when they're all in use this frame or busy.
+inline uint32_t
+WorldPagerFindVictim(World_Pager* pager, Game_Memory* memory) {
+    uint32_t page_idx = pager->pages[WORLD_PAGER_LIST_HEAD].prev;
+    while (page_idx != WORLD_PAGER_LIST_HEAD) {
+        World_Page* page = &pager->pages[page_idx];
+        if (page->state == WorldPage_Free) {
+            return page_idx;
+        }
+        if (page->touched_frame == pager->frame) {
+            break;
+        }
+        if (page->state == WorldPage_Resident) {
+            if (!page->is_dirty) {
+                WorldRemoveChunk(&pager->world, page->chunk_x, page->chunk_y);
+                ++pager->stats.evictions;
+                return page_idx;
+            }
+            if (!pager->file.platform_handle) {
+                // NOTE: nowhere to keep the change
+                page->is_dirty = false;
+                --pager->dirty_count;
+                WorldRemoveChunk(&pager->world, page->chunk_x, page->chunk_y);
+                ++pager->stats.evictions;
+                return page_idx;
+            }
+            if (pager->op_count + 1 < WORLD_PAGER_MAX_OPS) {
+                WorldPagerWritePage(pager, memory, page_idx);
+            }
+        }
+        page_idx = page->prev;
+    }
+    return WORLD_PAGER_MAX_CHUNKS;
+}
+
+inline bool
+WorldPagerIsReading(World_Pager* pager, int32_t chunk_x, int32_t chunk_y) {
+    for (uint32_t op_idx = 0; op_idx < pager->op_count; ++op_idx) {
+        World_Page* page = &pager->pages[pager->op_pages[op_idx]];
+        if (page->state == WorldPage_Reading && page->chunk_x == chunk_x && page->chunk_y == chunk_y) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// NOTE: keeps the chunk if it's in, asks for it otherwise. Returns whether it was in and clears keep_requesting once
+// no more reads can be started this frame.
+inline bool
+WorldPagerWant(World_Pager* pager, Game_Memory* memory, int32_t chunk_x, int32_t chunk_y, bool* keep_requesting) {
+    World_Chunk* chunk = WorldFindChunk(&pager->world, chunk_x, chunk_y);
+    if (chunk) {
+        WorldPagerTouch(pager, WorldPagerPageOf(pager, chunk));
+        return true;
+    }
+    if (!*keep_requesting || WorldPagerIsReading(pager, chunk_x, chunk_y)) {
+        return false;
+    }
+
+    bool     is_full  = pager->file.platform_handle ? pager->op_count >= WORLD_PAGER_MAX_OPS
+                                                    : pager->new_chunk_count >= WORLD_PAGER_MAX_OPS;
+    uint32_t page_idx = is_full ? WORLD_PAGER_MAX_CHUNKS : WorldPagerFindVictim(pager, memory);
+    if (page_idx == WORLD_PAGER_MAX_CHUNKS) {
+        *keep_requesting = false;
+        return false;
+    }
+
+    World_Page* page = &pager->pages[page_idx];
+    page->chunk_x    = chunk_x;
+    page->chunk_y    = chunk_y;
+    page->is_dirty   = false;
+    WorldPagerTouch(pager, page_idx);
+    if (pager->file.platform_handle) {
+        page->op = memory->PlatformReadFileAsync(
+            &pager->file,
+            WorldPagerRecordOffset(pager, chunk_x, chunk_y),
+            (uint32_t)sizeof(World_Chunk),
+            &pager->chunks[page_idx]);
+        if (page->op.is_busy) {
+            // NOTE: the page was emptied for nothing, the chunk is asked for again next frame
+            page->op         = {};
+            page->state      = WorldPage_Free;
+            *keep_requesting = false;
+            return false;
+        }
+        page->state = WorldPage_Reading;
+        WorldPagerAddOp(pager, page_idx);
+        ++pager->stats.reads;
+    } else {
+        WorldPagerFinishRead(pager, page_idx, false);
+    }
+    return false;
+}
+
+// NOTE: changed pages that weren't needed this frame, least recently used first
+inline void
+WorldPagerWriteBehind(World_Pager* pager, Game_Memory* memory) {
+    uint32_t write_count = 0;
+    uint32_t page_idx    = pager->pages[WORLD_PAGER_LIST_HEAD].prev;
+    while (pager->dirty_count && page_idx != WORLD_PAGER_LIST_HEAD && write_count < WORLD_PAGER_WRITES_PER_TICK &&
+           pager->op_count < WORLD_PAGER_MAX_OPS) {
+        World_Page* page = &pager->pages[page_idx];
+        if (page->touched_frame == pager->frame) {
+            break;
+        }
+        if (page->state == WorldPage_Resident && page->is_dirty) {
+            WorldPagerWritePage(pager, memory, page_idx);
+            ++write_count;
+        }
+        page_idx = page->prev;
+    }
+}
+
+inline bool
+WorldPagerViewsHaveChunk(World_Pager_View* views, uint32_t view_count, int32_t chunk_x, int32_t chunk_y) {
+    for (uint32_t view_idx = 0; view_idx < view_count; ++view_idx) {
+        World_Pager_View* view = &views[view_idx];
+        if (chunk_x >= (view->min_tile_x >> WORLD_CHUNK_SHIFT) && chunk_x <= (view->max_tile_x >> WORLD_CHUNK_SHIFT) &&
+            chunk_y >= (view->min_tile_y >> WORLD_CHUNK_SHIFT) && chunk_y <= (view->max_tile_y >> WORLD_CHUNK_SHIFT)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// NOTE: once a frame before the world is looked at, with what every camera sees (split screen has one per player).
+// All the views are read first so they're never waiting behind the prefetch.
+inline void
+WorldPagerUpdate(
+    World_Pager*      pager,
+    Game_Memory*      memory,
+    const char*       file_name,
+    World_Pager_View* views,
+    uint32_t          view_count) {
+
+    ++pager->frame;
+    pager->new_chunk_count = 0;
+    if (pager->header_op.is_busy) {
+        WorldPagerIssueHeaderOp(pager, memory);
+    }
+    if (pager->state == WorldPager_Opening) {
+        Platform_File_Op_State op_state = memory->PlatformPollFileOp(pager->header_op, 0);
+        if (pager->header_op.is_busy || op_state == PlatformFileOp_Pending) {
+            return;
+        }
+        bool is_valid = op_state == PlatformFileOp_Complete &&
+                        memcmp(&pager->file_header, &pager->layout, sizeof(World_File_Header)) == 0;
+        pager->header_op = {};
+        if (is_valid) {
+            pager->state = WorldPager_Open;
+        } else {
+            WorldPagerStartFile(pager, memory, file_name, true);
+        }
+    }
+    if (pager->state != WorldPager_Open) {
+        return;
+    }
+
+    // NOTE: records don't depend on the header of a new file being written, it's only kept from holding an op
+    if (pager->header_op.generation &&
+        memory->PlatformPollFileOp(pager->header_op, 0) != PlatformFileOp_Pending) {
+        pager->header_op = {};
+    }
+    WorldPagerPollOps(pager, memory);
+
+    bool keep_requesting = true;
+    for (uint32_t view_idx = 0; view_idx < view_count; ++view_idx) {
+        World_Pager_View* view = &views[view_idx];
+        for (int32_t chunk_y = view->min_tile_y >> WORLD_CHUNK_SHIFT; chunk_y <= view->max_tile_y >> WORLD_CHUNK_SHIFT;
+             ++chunk_y) {
+            for (int32_t chunk_x = view->min_tile_x >> WORLD_CHUNK_SHIFT;
+                 chunk_x <= view->max_tile_x >> WORLD_CHUNK_SHIFT;
+                 ++chunk_x) {
+                if (!WorldPagerHasRecord(pager, chunk_x, chunk_y)) {
+                    continue;
+                }
+                if (WorldPagerWant(pager, memory, chunk_x, chunk_y, &keep_requesting)) {
+                    ++pager->stats.hits;
+                } else {
+                    ++pager->stats.misses;
+                }
+            }
+        }
+    }
+
+    for (uint32_t view_idx = 0; view_idx < view_count; ++view_idx) {
+        World_Pager_View* view        = &views[view_idx];
+        int32_t           min_chunk_x = (view->min_tile_x >> WORLD_CHUNK_SHIFT) - WORLD_PAGER_PREFETCH;
+        int32_t           min_chunk_y = (view->min_tile_y >> WORLD_CHUNK_SHIFT) - WORLD_PAGER_PREFETCH;
+        int32_t           max_chunk_x = (view->max_tile_x >> WORLD_CHUNK_SHIFT) + WORLD_PAGER_PREFETCH;
+        int32_t           max_chunk_y = (view->max_tile_y >> WORLD_CHUNK_SHIFT) + WORLD_PAGER_PREFETCH;
+        for (int32_t chunk_y = min_chunk_y; chunk_y <= max_chunk_y; ++chunk_y) {
+            for (int32_t chunk_x = min_chunk_x; chunk_x <= max_chunk_x; ++chunk_x) {
+                if (WorldPagerHasRecord(pager, chunk_x, chunk_y) &&
+                    !WorldPagerViewsHaveChunk(views, view_count, chunk_x, chunk_y)) {
+                    WorldPagerWant(pager, memory, chunk_x, chunk_y, &keep_requesting);
+                }
+            }
+        }
+    }
+
+    if (pager->file.platform_handle) {
+        WorldPagerWriteBehind(pager, memory);
+    }
+}
+
+/// Changes
+// NOTE: for a chunk the caller wrote tiles into itself, e.g. one of new_chunks it filled
+inline void
+WorldPagerMarkDirty(World_Pager* pager, World_Chunk* chunk) {
+    World_Page* page = &pager->pages[WorldPagerPageOf(pager, chunk)];
+    if (!page->is_dirty) {
+        page->is_dirty = true;
+        ++pager->dirty_count;
+    }
+}
+
+// NOTE: only chunks that are in memory can be changed, returns false when the tile's chunk isn't
+inline bool
+WorldPagerSetTile(World_Pager* pager, int32_t tile_x, int32_t tile_y, uint8_t value) {
+    World_Chunk* chunk = WorldFindChunk(&pager->world, tile_x >> WORLD_CHUNK_SHIFT, tile_y >> WORLD_CHUNK_SHIFT);
+    if (!chunk) {
+        return false;
+    }
+
+    uint8_t* tile = &chunk->tiles[(tile_y & WORLD_CHUNK_MASK) * WORLD_CHUNK_DIM + (tile_x & WORLD_CHUNK_MASK)];
+    if (*tile != value) {
+        if (*tile && !value) {
+            --chunk->filled_tile_count;
+        } else if (!*tile && value) {
+            ++chunk->filled_tile_count;
+        }
+        *tile = value;
+        WorldPagerMarkDirty(pager, chunk);
+    }
+    return true;
+}
+
+// NOTE: writes back every changed chunk and waits for it, the only call that blocks
+inline void
+WorldPagerClose(World_Pager* pager, Game_Memory* memory) {
+    if (pager->file.platform_handle) {
+        while (pager->header_op.is_busy || memory->PlatformPollFileOp(pager->header_op, 0) == PlatformFileOp_Pending) {
+            if (pager->header_op.is_busy) {
+                WorldPagerIssueHeaderOp(pager, memory);
+            }
+        }
+        while (pager->op_count || (pager->state == WorldPager_Open && pager->dirty_count)) {
+            for (uint32_t page_idx = 0; page_idx < WORLD_PAGER_MAX_CHUNKS && pager->op_count < WORLD_PAGER_MAX_OPS;
+                 ++page_idx) {
+                World_Page* page = &pager->pages[page_idx];
+                if (pager->state == WorldPager_Open && page->state == WorldPage_Resident && page->is_dirty) {
+                    WorldPagerWritePage(pager, memory, page_idx);
+                }
+            }
+            WorldPagerPollOps(pager, memory);
+        }
+        memory->PlatformCloseFile(&pager->file);
+    }
+    pager->state = WorldPager_Closed;
+}
+
+#endif
@@ -0,0 +1,427 @@
+// NOTE: console tool that runs many independent games at once with no window, for soak tests and training runs.
+// usage: win32_batch.exe [-instances n] [-frames n] [-step n] [-threads n] [-render WxH] [-sound]
+// The batch runs on 1 thread first as the baseline, then on 2, 4, ... up to all cores, or only on -threads n. -step is
+// how many frames an instance runs each time it's picked up, 1 keeps every instance on the same frame (lockstep) and
+// more cuts the scheduling cost when the instances don't have to wait for each other.
+#include "win32_handmade.cpp"
+
+#define BATCH_MAX_THREADS        64
+#define BATCH_PERMANENT_STORAGE  MegaBytes(1)
+#define BATCH_TRANSIENT_STORAGE  MegaBytes(4)
+#define BATCH_SAMPLES_PER_SECOND 48000
+#define BATCH_FRAMES_PER_SECOND  60
+
+struct Batch_Instance {
+    Game_Memory              memory;
+    Game_Input               input;
+    Game_Offscreen_Buffer    buffer; // NOTE: width and height are 0 when not rendering, the game draws nothing then
+    Game_Sound_Output_Buffer sound_buffer;
+    uint32_t                 random;
+};
+
+// NOTE: instances [next, end) not started yet this step, the owning thread takes from it first and the others steal
+// from it once their own range is empty. Each range is on its own cache line.
+struct Batch_Range {
+    volatile LONG next;
+    LONG          end;
+    uint8_t       pad[64 - 2 * sizeof(LONG)];
+};
+
+struct Batch_Scheduler {
+    Batch_Instance*         instances;
+    int                     instance_count;
+    game_update_and_render* GameUpdateAndRender;
+    game_get_sound_samples* GameGetSoundSamples;
+    game_shutdown*          GameShutdown;
+    int                     frames_per_step;
+
+    Batch_Range ranges[BATCH_MAX_THREADS];
+    int         thread_count; // for this run, the main thread is thread 0
+
+    HANDLE        start_events[BATCH_MAX_THREADS];
+    volatile LONG finished_thread_count;
+    volatile LONG steal_count;
+};
+
+struct Batch_Thread_Info {
+    Batch_Scheduler* scheduler;
+    int              thread_idx;
+};
+
+// NOTE: same shape of input as the game sees from a keyboard, a direction held for a while then another one
+internal void
+BatchUpdateInput(Batch_Instance* instance) {
+    Game_Controller_Input* controller = &instance->input.keyboard_controller;
+    controller->is_connected          = true;
+    for (int button_idx = 0; button_idx < ArrayCount(controller->buttons); ++button_idx) {
+        controller->buttons[button_idx].half_transition_count = 0;
+    }
+
+    instance->random ^= instance->random << 13;
+    instance->random ^= instance->random >> 17;
+    instance->random ^= instance->random << 5;
+    if ((instance->random & 0x1F) == 0) {
+        for (int button_idx = 0; button_idx < ArrayCount(controller->buttons); ++button_idx) {
+            bool is_down = ((instance->random >> (8 + button_idx)) & 3) == 0;
+            if (controller->buttons[button_idx].ended_down != is_down) {
+                controller->buttons[button_idx].ended_down            = is_down;
+                controller->buttons[button_idx].half_transition_count = 1;
+            }
+        }
+    }
+}
+
+internal void
+BatchStepInstance(Batch_Scheduler* scheduler, Batch_Instance* instance) {
+    for (int frame_idx = 0; frame_idx < scheduler->frames_per_step; ++frame_idx) {
+        BatchUpdateInput(instance);
+        scheduler->GameUpdateAndRender(&instance->memory, &instance->input, &instance->buffer);
+        if (instance->sound_buffer.samples) {
+            // NOTE: no sound card in the way, a frame is shown as its samples start and the timeline carries on
+            // across runs like the transient storage does
+            instance->sound_buffer.flip_sample_idx = instance->sound_buffer.first_sample_idx;
+            scheduler->GameGetSoundSamples(&instance->memory, &instance->sound_buffer);
+            instance->sound_buffer.first_sample_idx += instance->sound_buffer.sample_count;
+        }
+    }
+}
+
+// NOTE: returns -1 when the range is used up
+inline int
+BatchClaimInstance(Batch_Range* range) {
+    if (range->next >= range->end) {
+        return -1;
+    }
+    LONG instance_idx = InterlockedIncrement(&range->next) - 1;
+    return instance_idx < range->end ? (int)instance_idx : -1;
+}
+
+internal void
+BatchRunStep(Batch_Scheduler* scheduler, int thread_idx) {
+    int instance_idx;
+    while ((instance_idx = BatchClaimInstance(&scheduler->ranges[thread_idx])) >= 0) {
+        BatchStepInstance(scheduler, &scheduler->instances[instance_idx]);
+    }
+
+    // NOTE: start with the neighbour so thieves don't all pile onto the same range
+    for (int victim_offset = 1; victim_offset < scheduler->thread_count; ++victim_offset) {
+        Batch_Range* victim = &scheduler->ranges[(thread_idx + victim_offset) % scheduler->thread_count];
+        while ((instance_idx = BatchClaimInstance(victim)) >= 0) {
+            InterlockedIncrement(&scheduler->steal_count);
+            BatchStepInstance(scheduler, &scheduler->instances[instance_idx]);
+        }
+    }
+}
+
+internal DWORD WINAPI
+BatchThreadProc(LPVOID parameter) {
+    Batch_Thread_Info* thread_info = (Batch_Thread_Info*)parameter;
+    Batch_Scheduler*   scheduler   = thread_info->scheduler;
+    for (;;) {
+        WaitForSingleObjectEx(scheduler->start_events[thread_info->thread_idx], INFINITE, FALSE);
+        BatchRunStep(scheduler, thread_info->thread_idx);
+        InterlockedIncrement(&scheduler->finished_thread_count);
+    }
+}
+
+// NOTE: frames_per_step frames for every instance. The ranges are reset only once every thread is done with them, and
+// an instance stays with the same thread from step to step unless it gets stolen, so its memory is usually still in
+// that core's cache.
+internal void
+BatchStep(Batch_Scheduler* scheduler) {
+    int thread_count = scheduler->thread_count;
+    for (int thread_idx = 0; thread_idx < thread_count; ++thread_idx) {
+        scheduler->ranges[thread_idx].next = (LONG)(scheduler->instance_count * thread_idx / thread_count);
+        scheduler->ranges[thread_idx].end  = (LONG)(scheduler->instance_count * (thread_idx + 1) / thread_count);
+    }
+    scheduler->finished_thread_count = 0;
+    _WriteBarrier();
+    for (int thread_idx = 1; thread_idx < thread_count; ++thread_idx) {
+        SetEvent(scheduler->start_events[thread_idx]);
+    }
+
+    BatchRunStep(scheduler, 0);
+    while (scheduler->finished_thread_count != thread_count - 1) {
+        _mm_pause();
+    }
+}
+
+// NOTE: the instances run without a world file, the pager then keeps the world in memory only. A file shared by every
+// instance would let one read the chunks another wrote, and the runs would depend on the ones before them. Files that
+// are only read, the music and the asset pack, are opened as usual.
+internal PLATFORM_OPEN_FILE(BatchOpenFile) {
+    if (open_flags & PlatformOpenFile_Write) {
+        return {};
+    }
+    return Win32OpenFile(file_name, open_flags);
+}
+
+// NOTE: every run starts from nothing, the files an instance has open are closed before its storage is cleared
+internal void
+BatchResetInstances(Batch_Scheduler* scheduler) {
+    for (int instance_idx = 0; instance_idx < scheduler->instance_count; ++instance_idx) {
+        Batch_Instance*  instance  = &scheduler->instances[instance_idx];
+        Transient_State* transient = (Transient_State*)instance->memory.transient_storage;
+        scheduler->GameShutdown(&instance->memory);
+        SoundStreamClose(&transient->music, &instance->memory);
+        if (transient->asset_file.memory) {
+            Win32UnmapFile(&transient->asset_file);
+        }
+        memset(instance->memory.permanent_storage, 0, instance->memory.permanent_storage_size);
+        memset(instance->memory.transient_storage, 0, instance->memory.transient_storage_size);
+        instance->memory.is_initialized = false;
+        instance->input                 = {};
+        instance->random                = 0x9E3779B9 ^ (uint32_t)(instance_idx * 2654435761u);
+    }
+}
+
+inline uint64_t
+BatchHash(uint64_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t byte_idx = 0; byte_idx < size; ++byte_idx) {
+        hash = (hash ^ bytes[byte_idx]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// NOTE: the game state every instance ended up in, the same whatever the thread count if the instances are isolated.
+// Covers the camera and tone, every entity, and the chunks the world pager has in memory.
+internal uint64_t
+BatchChecksum(Batch_Scheduler* scheduler) {
+    uint64_t result = 0;
+    for (int instance_idx = 0; instance_idx < scheduler->instance_count; ++instance_idx) {
+        Batch_Instance*  instance  = &scheduler->instances[instance_idx];
+        Game_State*      state     = (Game_State*)instance->memory.permanent_storage;
+        Transient_State* transient = (Transient_State*)instance->memory.transient_storage;
+
+        uint64_t hash = 14695981039346656037ull;
+        hash          = BatchHash(hash, &state->x_offset, sizeof(state->x_offset));
+        hash          = BatchHash(hash, &state->y_offset, sizeof(state->y_offset));
+        hash          = BatchHash(hash, &state->tone_hz, sizeof(state->tone_hz));
+
+        Entity_Store* entities = &state->entities;
+        hash                   = BatchHash(hash, &entities->count, sizeof(entities->count));
+        if (entities->count) {
+            size_t float_size = entities->count * sizeof(float32_t);
+            hash              = BatchHash(hash, entities->position_x, float_size);
+            hash              = BatchHash(hash, entities->position_y, float_size);
+            hash              = BatchHash(hash, entities->velocity_x, float_size);
+            hash              = BatchHash(hash, entities->velocity_y, float_size);
+            hash              = BatchHash(hash, entities->dense_to_slot, entities->count * sizeof(uint32_t));
+        }
+        if (entities->used_slot_count) {
+            hash = BatchHash(hash, entities->slot_generation, entities->used_slot_count * sizeof(uint32_t));
+        }
+
+        World_Pager* pager = &transient->world;
+        for (uint32_t page_idx = 0; page_idx < WORLD_PAGER_MAX_CHUNKS; ++page_idx) {
+            uint32_t page_state = pager->pages[page_idx].state;
+            if (page_state == WorldPage_Resident || page_state == WorldPage_Writing) {
+                World_Chunk* chunk = &pager->chunks[page_idx];
+                hash               = BatchHash(hash, &chunk->chunk_x, sizeof(chunk->chunk_x));
+                hash               = BatchHash(hash, &chunk->chunk_y, sizeof(chunk->chunk_y));
+                hash               = BatchHash(hash, &chunk->filled_tile_count, sizeof(chunk->filled_tile_count));
+                hash               = BatchHash(hash, chunk->tiles, sizeof(chunk->tiles));
+            }
+        }
+
+        result += hash * (2 * instance_idx + 1);
+    }
+    return result;
+}
+
+int
+main(int argc, char** argv) {
+    LARGE_INTEGER perf_count_freq_result;
+    QueryPerformanceFrequency(&perf_count_freq_result);
+    g_perf_count_freq = perf_count_freq_result.QuadPart;
+
+    int  instance_count = 256;
+    int  frame_count    = 600;
+    int  step_count     = 1;
+    int  thread_count   = 0;
+    int  render_width   = 0;
+    int  render_height  = 0;
+    bool has_sound      = false;
+    for (int arg_idx = 1; arg_idx < argc; ++arg_idx) {
+        bool has_value = arg_idx + 1 < argc;
+        if (strcmp(argv[arg_idx], "-instances") == 0 && has_value) {
+            instance_count = atoi(argv[++arg_idx]);
+        } else if (strcmp(argv[arg_idx], "-frames") == 0 && has_value) {
+            frame_count = atoi(argv[++arg_idx]);
+        } else if (strcmp(argv[arg_idx], "-step") == 0 && has_value) {
+            step_count = atoi(argv[++arg_idx]);
+        } else if (strcmp(argv[arg_idx], "-threads") == 0 && has_value) {
+            thread_count = atoi(argv[++arg_idx]);
+        } else if (strcmp(argv[arg_idx], "-render") == 0 && has_value) {
+            sscanf_s(argv[++arg_idx], "%dx%d", &render_width, &render_height);
+        } else if (strcmp(argv[arg_idx], "-sound") == 0) {
+            has_sound = true;
+        } else {
+            printf("usage: win32_batch [-instances n] [-frames n] [-step n] [-threads n] [-render WxH] [-sound]\n");
+            return 1;
+        }
+    }
+    if (instance_count < 1 || frame_count < 1 || step_count < 1 || thread_count < 0 || render_width < 0 ||
+        render_height < 0) {
+        printf("instances, frames and step have to be at least 1\n");
+        return 1;
+    }
+
+    Win32_Game_Code game = Win32LoadGameCode("handmade.dll", "handmade_batch_temp.dll");
+    if (!game.is_valid) {
+        printf("unable to load handmade.dll\n");
+        return 1;
+    }
+
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    int core_count = (int)system_info.dwNumberOfProcessors;
+    if (core_count > BATCH_MAX_THREADS) {
+        core_count = BATCH_MAX_THREADS;
+    }
+    if (thread_count > core_count) {
+        thread_count = core_count;
+    }
+
+    // NOTE: the game's own work queue and file I/O are shared by every instance
+    Platform_Work_Queue* work_queue =
+        (Platform_Work_Queue*)VirtualAlloc(0, sizeof(Platform_Work_Queue), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    Win32_Thread_Info work_thread_infos[2];
+    Win32MakeWorkQueue(work_queue, ArrayCount(work_thread_infos), work_thread_infos);
+    Win32InitFileIO(work_queue);
+
+    Batch_Scheduler* scheduler =
+        (Batch_Scheduler*)VirtualAlloc(0, sizeof(Batch_Scheduler), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    scheduler->instance_count      = instance_count;
+    scheduler->GameUpdateAndRender = game.GameUpdateAndRender;
+    scheduler->GameGetSoundSamples = game.GameGetSoundSamples;
+    scheduler->GameShutdown        = game.GameShutdown;
+    scheduler->instances           = (Batch_Instance*)VirtualAlloc(
+        0, instance_count * sizeof(Batch_Instance), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+    int bytes_per_pixel = 4;
+    int pitch           = AlignPow2(render_width * bytes_per_pixel, FRAMEBUFFER_ROW_ALIGNMENT);
+    int sample_count    = BATCH_SAMPLES_PER_SECOND / BATCH_FRAMES_PER_SECOND;
+    for (int instance_idx = 0; instance_idx < instance_count; ++instance_idx) {
+        Batch_Instance* instance = &scheduler->instances[instance_idx];
+        Game_Memory*    memory   = &instance->memory;
+
+        memory->permanent_storage_size = BATCH_PERMANENT_STORAGE;
+        memory->permanent_storage =
+            VirtualAlloc(0, memory->permanent_storage_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        memory->transient_storage_size = BATCH_TRANSIENT_STORAGE;
+        memory->transient_storage =
+            VirtualAlloc(0, memory->transient_storage_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        memory->work_queue                = work_queue;
+        memory->PlatformAddWorkQueueEntry = Win32AddWorkQueueEntry;
+        memory->PlatformCompleteAllWork   = Win32CompleteAllWork;
+        memory->PlatformMapFile           = Win32MapFile;
+        memory->PlatformUnmapFile         = Win32UnmapFile;
+        memory->PlatformOpenFile          = BatchOpenFile;
+        memory->PlatformCloseFile         = Win32CloseFile;
+        memory->PlatformReadFileAsync     = Win32ReadFileAsync;
+        memory->PlatformWriteFileAsync    = Win32WriteFileAsync;
+        memory->PlatformPollFileOp        = Win32PollFileOp;
+#ifdef HANDMADE_INTERNAL
+        memory->DebugPlatformReadEntireFile  = DebugPlatformReadEntireFile;
+        memory->DebugPlatformWriteEntireFile = DebugPlatformWriteEntireFile;
+        memory->DebugPlatformFreeFileMemory  = DebugPlatformFreeFileMemory;
+#endif
+
+        instance->buffer.width           = render_width;
+        instance->buffer.height          = render_height;
+        instance->buffer.pitch           = pitch;
+        instance->buffer.bytes_per_pixel = bytes_per_pixel;
+        instance->buffer.pixel_format    = GamePixelFormat_BGRX8888;
+        if (render_width && render_height) {
+            instance->buffer.memory =
+                VirtualAlloc(0, (SIZE_T)pitch * render_height, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        }
+
+        instance->sound_buffer.samples_per_second = BATCH_SAMPLES_PER_SECOND;
+        instance->sound_buffer.sample_count       = sample_count;
+        if (has_sound) {
+            instance->sound_buffer.samples = (int16_t*)VirtualAlloc(
+                0, sample_count * 2 * sizeof(int16_t), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        }
+    }
+
+    Batch_Thread_Info thread_infos[BATCH_MAX_THREADS];
+    for (int thread_idx = 1; thread_idx < core_count; ++thread_idx) {
+        thread_infos[thread_idx].scheduler  = scheduler;
+        thread_infos[thread_idx].thread_idx = thread_idx;
+        scheduler->start_events[thread_idx] = CreateEventA(0, FALSE, FALSE, 0);
+
+        DWORD  thread_id;
+        HANDLE thread_handle = CreateThread(0, 0, BatchThreadProc, &thread_infos[thread_idx], 0, &thread_id);
+        CloseHandle(thread_handle);
+    }
+
+    printf(
+        "%d instances, %d frames, %d per step, %s, %s, %d logical cores\n\n",
+        instance_count,
+        frame_count,
+        step_count,
+        render_width && render_height ? "rendering" : "no rendering",
+        has_sound ? "sound" : "no sound",
+        core_count);
+    printf(
+        "%-8s %10s %14s %9s %11s %9s %18s\n",
+        "threads",
+        "ms",
+        "frames/s",
+        "speedup",
+        "efficiency",
+        "stolen",
+        "checksum");
+
+    float32_t single_thread_frames_per_second = 0;
+    uint64_t  first_checksum                  = 0;
+    int run_thread_count = 1;
+    for (;;) {
+        scheduler->thread_count = run_thread_count;
+        scheduler->steal_count  = 0;
+        BatchResetInstances(scheduler);
+
+        LARGE_INTEGER start_counter = Win32GetWallClock();
+        for (int frame_idx = 0; frame_idx < frame_count; frame_idx += step_count) {
+            scheduler->frames_per_step = frame_count - frame_idx < step_count ? frame_count - frame_idx : step_count;
+            BatchStep(scheduler);
+        }
+        float32_t elapsed_ms        = Win32GetMilliSecondsElapsed(start_counter, Win32GetWallClock());
+        float32_t frames_per_second = (float32_t)instance_count * frame_count / (elapsed_ms / 1000.0f);
+        if (run_thread_count == 1) {
+            single_thread_frames_per_second = frames_per_second;
+        }
+
+        uint64_t checksum = BatchChecksum(scheduler);
+        if (!first_checksum) {
+            first_checksum = checksum;
+        }
+
+        float32_t speedup = frames_per_second / single_thread_frames_per_second;
+        printf(
+            "%-8d %10.1f %14.0f %8.2fx %10.0f%% %9ld %016llx%s\n",
+            run_thread_count,
+            elapsed_ms,
+            frames_per_second,
+            speedup,
+            100.0f * speedup / run_thread_count,
+            scheduler->steal_count,
+            checksum,
+            checksum == first_checksum ? "" : " DIFFERS");
+
+        // NOTE: the last run always uses every core, also when that isn't a power of two
+        if (run_thread_count == core_count || (thread_count && run_thread_count == thread_count)) {
+            break;
+        }
+        run_thread_count = thread_count ? thread_count : 2 * run_thread_count;
+        if (run_thread_count > core_count) {
+            run_thread_count = core_count;
+        }
+    }
+
+    Win32CompleteAllWork(work_queue);
+    return 0;
+}
@@ -0,0 +1,3544 @@
+// NOTE: console tool to measure platform and game subsystems outside of the frame loop.
+// usage: win32_bench.exe [benchmark name...], runs everything when no name is given.
+#include "win32_handmade.cpp"
+
+struct Bench_Timer {
+    LARGE_INTEGER start_counter;
+    uint64_t      start_cycle_count;
+};
+
+inline Bench_Timer
+BenchBegin(void) {
+    Bench_Timer timer;
+    timer.start_counter     = Win32GetWallClock();
+    timer.start_cycle_count = __rdtsc();
+    return timer;
+}
+
+inline float32_t
+BenchEndMs(Bench_Timer timer) {
+    return Win32GetMilliSecondsElapsed(timer.start_counter, Win32GetWallClock());
+}
+
+// NOTE: every correctness check goes through here, a run with a failed check exits with how many failed
+global int g_bench_failure_count;
+
+inline bool
+BenchCheck(bool passed) {
+    if (!passed) {
+        ++g_bench_failure_count;
+    }
+    return passed;
+}
+
+/// Work queue
+struct Bench_Work_Job {
+    uint8_t* memory;
+    uint32_t size;
+    uint32_t result;
+};
+
+internal PLATFORM_WORK_QUEUE_CALLBACK(BenchTinyJob) {
+    Bench_Work_Job* job = (Bench_Work_Job*)data;
+    job->result += 1;
+}
+
+internal PLATFORM_WORK_QUEUE_CALLBACK(BenchLargeJob) {
+    Bench_Work_Job* job = (Bench_Work_Job*)data;
+    uint32_t        sum = 0;
+    for (uint32_t byte_idx = 0; byte_idx < job->size; ++byte_idx) {
+        sum += job->memory[byte_idx];
+    }
+    job->result = sum;
+}
+
+struct Bench_Producer {
+    Platform_Work_Queue*          queue;
+    platform_work_queue_callback* callback;
+    Bench_Work_Job*               jobs;
+    int                           job_count;
+};
+
+internal DWORD WINAPI
+BenchProducerThreadProc(LPVOID parameter) {
+    Bench_Producer* producer = (Bench_Producer*)parameter;
+    for (int job_idx = 0; job_idx < producer->job_count; ++job_idx) {
+        Win32AddWorkQueueEntry(producer->queue, producer->callback, &producer->jobs[job_idx]);
+    }
+    return 0;
+}
+
+internal float32_t
+BenchRunWorkQueue(
+    Platform_Work_Queue*          queue,
+    platform_work_queue_callback* callback,
+    Bench_Work_Job*               jobs,
+    int                           job_count,
+    int                           producer_count) {
+
+    Bench_Producer producers[8];
+    HANDLE         producer_handles[8];
+    Assert(producer_count <= ArrayCount(producers));
+
+    Bench_Timer timer = BenchBegin();
+    if (producer_count <= 1) {
+        for (int job_idx = 0; job_idx < job_count; ++job_idx) {
+            Win32AddWorkQueueEntry(queue, callback, &jobs[job_idx]);
+        }
+    } else {
+        int jobs_per_producer = job_count / producer_count;
+        for (int producer_idx = 0; producer_idx < producer_count; ++producer_idx) {
+            Bench_Producer* producer = &producers[producer_idx];
+            producer->queue          = queue;
+            producer->callback       = callback;
+            producer->jobs           = jobs + producer_idx * jobs_per_producer;
+            producer->job_count      = jobs_per_producer;
+
+            producer_handles[producer_idx] = CreateThread(0, 0, BenchProducerThreadProc, producer, 0, 0);
+        }
+        // NOTE: every entry has to be added before the completion goal means anything
+        WaitForMultipleObjects(producer_count, producer_handles, TRUE, INFINITE);
+        for (int producer_idx = 0; producer_idx < producer_count; ++producer_idx) {
+            CloseHandle(producer_handles[producer_idx]);
+        }
+    }
+    Win32CompleteAllWork(queue);
+    return BenchEndMs(timer);
+}
+
+internal void
+BenchWorkQueue(void) {
+    int      job_count  = 1 << 18;
+    uint32_t large_size = KiloBytes(64);
+
+    Bench_Work_Job* jobs =
+        (Bench_Work_Job*)VirtualAlloc(0, job_count * sizeof(Bench_Work_Job), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    uint8_t* large_block = (uint8_t*)VirtualAlloc(0, MegaBytes(16), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    for (int byte_idx = 0; byte_idx < MegaBytes(16); ++byte_idx) {
+        large_block[byte_idx] = (uint8_t)byte_idx;
+    }
+    for (int job_idx = 0; job_idx < job_count; ++job_idx) {
+        jobs[job_idx].memory = large_block + (job_idx * large_size) % MegaBytes(16);
+        jobs[job_idx].size   = large_size;
+    }
+
+    int max_thread_count = Win32GetWorkerThreadCount();
+    printf("work_queue: %d entries, up to %d worker threads\n", WORK_QUEUE_ENTRY_COUNT, max_thread_count);
+    printf("%8s %10s %14s %14s %14s\n", "workers", "producers", "tiny jobs/s", "tiny ns/job", "large MB/s");
+
+    // NOTE: threads are never torn down, each thread count gets its own queue
+    local_persist Platform_Work_Queue queues[8];
+    local_persist Win32_Thread_Info   thread_infos[8][WORK_QUEUE_MAX_THREADS];
+    int                               queue_idx    = 0;
+    bool                              all_ran_once = true;
+    for (int thread_count = 1; queue_idx < ArrayCount(queues); thread_count *= 2) {
+        if (thread_count > max_thread_count) {
+            thread_count = max_thread_count;
+        }
+        Platform_Work_Queue* queue = &queues[queue_idx];
+        Win32MakeWorkQueue(queue, thread_count, thread_infos[queue_idx]);
+        ++queue_idx;
+
+        for (int producer_count = 1; producer_count <= 4; producer_count *= 2) {
+            for (int job_idx = 0; job_idx < job_count; ++job_idx) {
+                jobs[job_idx].result = 0;
+            }
+            float32_t tiny_ms = BenchRunWorkQueue(queue, BenchTinyJob, jobs, job_count, producer_count);
+            for (int job_idx = 0; job_idx < job_count; ++job_idx) {
+                all_ran_once = all_ran_once && jobs[job_idx].result == 1;
+            }
+
+            int       large_count  = job_count / 64;
+            float32_t large_ms     = BenchRunWorkQueue(queue, BenchLargeJob, jobs, large_count, producer_count);
+            float32_t large_mb     = (float32_t)large_count * (float32_t)large_size / (float32_t)MegaBytes(1);
+            float32_t tiny_per_sec = (float32_t)job_count / (tiny_ms / 1000.0f);
+            float32_t tiny_ns      = tiny_ms * 1000.0f * 1000.0f / (float32_t)job_count;
+            float32_t large_mb_sec = large_mb / (large_ms / 1000.0f);
+            printf(
+                "%8d %10d %14.0f %14.1f %14.1f\n", thread_count, producer_count, tiny_per_sec, tiny_ns, large_mb_sec);
+        }
+
+        if (thread_count == max_thread_count) {
+            break;
+        }
+    }
+    printf("every tiny job ran exactly once: %s\n", BenchCheck(all_ran_once) ? "ok" : "FAILED");
+
+    VirtualFree(large_block, 0, MEM_RELEASE);
+    VirtualFree(jobs, 0, MEM_RELEASE);
+}
+
+/// Asset pack
+#define BENCH_ASSET_PACK_NAME "bench_assets.hha"
+
+// NOTE: 256 bitmaps of 512x512, 256MB in total
+internal bool
+BenchWriteAssetPack(const char* file_name, uint32_t asset_count, uint32_t bitmap_dim) {
+    bool   written     = false;
+    HANDLE file_handle = CreateFileA(file_name, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file_handle != INVALID_HANDLE_VALUE) {
+        uint32_t bitmap_size = bitmap_dim * bitmap_dim * 4;
+        uint8_t* pixels      = (uint8_t*)VirtualAlloc(0, bitmap_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+        Asset_Pack_Entry* entries = (Asset_Pack_Entry*)VirtualAlloc(
+            0, asset_count * sizeof(Asset_Pack_Entry), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+        // NOTE: header and bitmap sizes are multiples of the data alignment, no padding needed
+        Asset_Pack_Header header = {};
+        header.magic             = ASSET_PACK_MAGIC;
+        header.version           = ASSET_PACK_VERSION;
+        header.asset_count       = asset_count;
+        header.index_offset      = ASSET_PACK_DATA_ALIGNMENT + (uint64_t)asset_count * bitmap_size;
+        header.file_size         = header.index_offset + asset_count * sizeof(Asset_Pack_Entry);
+
+        uint8_t header_block[ASSET_PACK_DATA_ALIGNMENT] = {};
+        memcpy(header_block, &header, sizeof(header));
+
+        DWORD bytes_written = 0;
+        written             = WriteFile(file_handle, header_block, sizeof(header_block), &bytes_written, NULL);
+        for (uint32_t asset_idx = 0; written && asset_idx < asset_count; ++asset_idx) {
+            for (uint32_t byte_idx = 0; byte_idx < bitmap_size; ++byte_idx) {
+                pixels[byte_idx] = (uint8_t)(asset_idx + byte_idx);
+            }
+            Asset_Pack_Entry* entry = &entries[asset_idx];
+            entry->type             = AssetType_Bitmap;
+            entry->data_offset      = ASSET_PACK_DATA_ALIGNMENT + (uint64_t)asset_idx * bitmap_size;
+            entry->data_size        = bitmap_size;
+            entry->bitmap.width     = bitmap_dim;
+            entry->bitmap.height    = bitmap_dim;
+            entry->bitmap.pitch     = bitmap_dim * 4;
+            sprintf_s(entry->name, "bitmap_%u", asset_idx);
+
+            written = WriteFile(file_handle, pixels, bitmap_size, &bytes_written, NULL);
+        }
+        if (written) {
+            written = WriteFile(
+                file_handle, entries, asset_count * (DWORD)sizeof(Asset_Pack_Entry), &bytes_written, NULL);
+        }
+
+        VirtualFree(entries, 0, MEM_RELEASE);
+        VirtualFree(pixels, 0, MEM_RELEASE);
+        CloseHandle(file_handle);
+    }
+    return written;
+}
+
+// NOTE: reads one byte per page so every page of the range is brought in
+internal uint32_t
+BenchTouchPages(uint8_t* memory, uint64_t size) {
+    uint32_t sum = 0;
+    for (uint64_t offset = 0; offset < size; offset += KiloBytes(4)) {
+        sum += memory[offset];
+    }
+    return sum;
+}
+
+internal void
+BenchAssetPack(void) {
+    // NOTE: an existing pack is reused, so a cold run is: purge the OS file cache (e.g. reboot or RAMMap's
+    // "Empty Standby List"), then run this benchmark again. Without that "first" is a page-fault cold run only.
+    WIN32_FILE_ATTRIBUTE_DATA file_data;
+    if (!GetFileAttributesExA(BENCH_ASSET_PACK_NAME, GetFileExInfoStandard, &file_data)) {
+        printf("writing %s...\n", BENCH_ASSET_PACK_NAME);
+        if (!BenchCheck(BenchWriteAssetPack(BENCH_ASSET_PACK_NAME, 256, 512))) {
+            printf("unable to write %s\n", BENCH_ASSET_PACK_NAME);
+            return;
+        }
+    }
+
+    printf("%-8s %-24s %12s %12s\n", "pass", "method", "ms", "touched MB");
+    const char* pass_names[] = {"first", "repeat"};
+    for (int pass_idx = 0; pass_idx < ArrayCount(pass_names); ++pass_idx) {
+        uint32_t sum = 0;
+
+        // NOTE: whole-file read, everything has to come in before the first asset can be used
+        Bench_Timer            timer = BenchBegin();
+        Debug_Read_File_Result file  = DebugPlatformReadEntireFile(BENCH_ASSET_PACK_NAME);
+        Asset_Pack             pack;
+        if (AssetPackOpen(&pack, file.content, file.content_size)) {
+            Asset_Bitmap bitmap = AssetPackGetBitmap(&pack, pack.asset_count / 2);
+            sum += BenchTouchPages(bitmap.memory, (uint64_t)bitmap.pitch * bitmap.height);
+        }
+        float32_t read_ms = BenchEndMs(timer);
+        printf(
+            "%-8s %-24s %12.2f %12.1f\n",
+            pass_names[pass_idx],
+            "read entire file",
+            read_ms,
+            (float32_t)file.content_size / MegaBytes(1));
+        DebugPlatformFreeFileMemory(file.content);
+
+        // NOTE: mapped, only the index and the asset we use get paged in
+        timer                       = BenchBegin();
+        Platform_Mapped_File mapped = Win32MapFile(BENCH_ASSET_PACK_NAME);
+        float32_t            one_mb = 0.0f;
+        if (AssetPackOpen(&pack, mapped.memory, mapped.size)) {
+            Asset_Bitmap bitmap = AssetPackGetBitmap(&pack, pack.asset_count / 2);
+            sum += BenchTouchPages(bitmap.memory, (uint64_t)bitmap.pitch * bitmap.height);
+            one_mb = (float32_t)(bitmap.pitch * bitmap.height) / MegaBytes(1);
+        }
+        float32_t map_one_ms = BenchEndMs(timer);
+        printf("%-8s %-24s %12.2f %12.1f\n", pass_names[pass_idx], "map, use one asset", map_one_ms, one_mb);
+
+        timer = BenchBegin();
+        sum += BenchTouchPages((uint8_t*)mapped.memory, mapped.size);
+        float32_t map_all_ms = BenchEndMs(timer);
+        printf(
+            "%-8s %-24s %12.2f %12.1f\n",
+            pass_names[pass_idx],
+            "mapped, touch every page",
+            map_all_ms,
+            (float32_t)mapped.size / MegaBytes(1));
+        Win32UnmapFile(&mapped);
+
+        // NOTE: keep the compiler from dropping the reads
+        if (sum == 0xFFFFFFFF) {
+            printf("\n");
+        }
+    }
+}
+
+/// Async file I/O
+#define BENCH_IO_FILE_NAME    "bench_io.bin"
+#define BENCH_IO_FILE_SIZE    GigaBytes(1)
+#define BENCH_IO_BLOCK_SIZE   KiloBytes(256)
+#define BENCH_IO_MAX_DEPTH    64
+#define BENCH_IO_THREAD_COUNT 8
+
+// NOTE: the I/O threads live as long as the process, every benchmark that does file I/O shares them
+internal void
+BenchInitFileIO(void) {
+    local_persist bool                is_initialized;
+    local_persist Platform_Work_Queue io_queue;
+    local_persist Win32_Thread_Info   io_thread_infos[BENCH_IO_THREAD_COUNT];
+    if (!is_initialized) {
+        Win32MakeWorkQueue(&io_queue, BENCH_IO_THREAD_COUNT, io_thread_infos);
+        Win32InitFileIO(&io_queue);
+        is_initialized = true;
+    }
+}
+
+internal bool
+BenchWriteIOFile(const char* file_name, uint64_t file_size) {
+    bool   written     = false;
+    HANDLE file_handle = CreateFileA(file_name, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file_handle != INVALID_HANDLE_VALUE) {
+        uint32_t chunk_size = MegaBytes(4);
+        uint8_t* chunk      = (uint8_t*)VirtualAlloc(0, chunk_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        for (uint32_t byte_idx = 0; byte_idx < chunk_size; ++byte_idx) {
+            chunk[byte_idx] = (uint8_t)(byte_idx * 31);
+        }
+
+        written = true;
+        for (uint64_t offset = 0; written && offset < file_size; offset += chunk_size) {
+            DWORD bytes_written = 0;
+            written             = WriteFile(file_handle, chunk, chunk_size, &bytes_written, NULL);
+        }
+
+        VirtualFree(chunk, 0, MEM_RELEASE);
+        CloseHandle(file_handle);
+    }
+    return written;
+}
+
+// NOTE: keeps queue_depth reads in flight until the whole file went through, returns MB/s
+internal float32_t
+BenchRunAsyncReads(const char* file_name, int queue_depth, uint8_t* buffers) {
+    float32_t            mb_per_second = 0.0f;
+    Platform_File_Handle file =
+        Win32OpenFileWithFlags(file_name, PlatformOpenFile_Read, FILE_FLAG_NO_BUFFERING);
+    if (file.platform_handle) {
+        Platform_File_Op ops[BENCH_IO_MAX_DEPTH] = {};
+        uint64_t         next_offset             = 0;
+        uint64_t         bytes_read              = 0;
+        int              in_flight               = 0;
+        bool             failed                  = false;
+
+        Bench_Timer timer = BenchBegin();
+        for (;;) {
+            for (int op_idx = 0; op_idx < queue_depth; ++op_idx) {
+                uint32_t               bytes_transferred = 0;
+                Platform_File_Op_State state             = Win32PollFileOp(ops[op_idx], &bytes_transferred);
+                if (state == PlatformFileOp_Pending) {
+                    continue;
+                }
+
+                if (state == PlatformFileOp_Complete) {
+                    bytes_read += bytes_transferred;
+                    --in_flight;
+                } else if (state == PlatformFileOp_Failed) {
+                    failed = true;
+                    --in_flight;
+                }
+
+                ops[op_idx] = {};
+                if (!failed && next_offset < file.size) {
+                    uint8_t* dest = buffers + (uint64_t)op_idx * BENCH_IO_BLOCK_SIZE;
+                    ops[op_idx]   = Win32ReadFileAsync(&file, next_offset, BENCH_IO_BLOCK_SIZE, dest);
+                    next_offset += BENCH_IO_BLOCK_SIZE;
+                    ++in_flight;
+                }
+            }
+
+            if (in_flight == 0) {
+                break;
+            }
+            _mm_pause();
+        }
+        float32_t elapsed_ms = BenchEndMs(timer);
+
+        if (BenchCheck(!failed) && elapsed_ms > 0.0f) {
+            mb_per_second = ((float32_t)bytes_read / MegaBytes(1)) / (elapsed_ms / 1000.0f);
+        }
+        Win32CloseFile(&file);
+    }
+    return mb_per_second;
+}
+
+internal void
+BenchAsyncIO(void) {
+    // NOTE: reads bypass the OS file cache (FILE_FLAG_NO_BUFFERING), so every pass goes to the device
+    WIN32_FILE_ATTRIBUTE_DATA file_data;
+    if (!GetFileAttributesExA(BENCH_IO_FILE_NAME, GetFileExInfoStandard, &file_data)) {
+        printf("writing %s...\n", BENCH_IO_FILE_NAME);
+        if (!BenchCheck(BenchWriteIOFile(BENCH_IO_FILE_NAME, BENCH_IO_FILE_SIZE))) {
+            printf("unable to write %s\n", BENCH_IO_FILE_NAME);
+            return;
+        }
+    }
+
+    BenchInitFileIO();
+
+    // NOTE: VirtualAlloc hands out page aligned memory, which satisfies the sector alignment of unbuffered reads
+    uint8_t* buffers = (uint8_t*)VirtualAlloc(
+        0, BENCH_IO_MAX_DEPTH * BENCH_IO_BLOCK_SIZE, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+    printf(
+        "%d KB blocks, %d fallback threads\n",
+        (int)(BENCH_IO_BLOCK_SIZE / KiloBytes(1)),
+        BENCH_IO_THREAD_COUNT);
+    printf("%-8s %16s %16s\n", "depth", "overlapped MB/s", "fallback MB/s");
+    for (int queue_depth = 1; queue_depth <= BENCH_IO_MAX_DEPTH; queue_depth *= 2) {
+        g_file_io.force_fallback = false;
+        float32_t overlapped     = BenchRunAsyncReads(BENCH_IO_FILE_NAME, queue_depth, buffers);
+
+        g_file_io.force_fallback = true;
+        float32_t fallback       = BenchRunAsyncReads(BENCH_IO_FILE_NAME, queue_depth, buffers);
+        g_file_io.force_fallback = false;
+
+        printf("%-8d %16.1f %16.1f\n", queue_depth, overlapped, fallback);
+    }
+
+    VirtualFree(buffers, 0, MEM_RELEASE);
+}
+
+/// Input events
+internal void
+BenchInputEvents(void) {
+    Win32_Input_Event_Queue* queue = (Win32_Input_Event_Queue*)VirtualAlloc(
+        0, sizeof(Win32_Input_Event_Queue), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    Game_Input* input = (Game_Input*)VirtualAlloc(0, sizeof(Game_Input), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    Win32InitInputEventQueue(queue);
+
+    // NOTE: a gamepad tap shorter than a frame, plus a key press the message loop pushed in between but late
+    int64_t          frame_start = Win32GetInputTimestamp();
+    int64_t          tick_us     = g_perf_count_freq / 1000000;
+    Game_Input_Event press       = Win32MakeButtonEvent(frame_start + 100 * tick_us, 1, 5, true);
+    Game_Input_Event release     = Win32MakeButtonEvent(frame_start + 400 * tick_us, 1, 5, false);
+    Game_Input_Event key         = Win32MakeButtonEvent(frame_start + 250 * tick_us, 0, 0, true);
+    Win32InjectInputEvent(queue, &press);
+    Win32InjectInputEvent(queue, &release);
+    Win32InjectInputEvent(queue, &key);
+
+    *input = {};
+    Win32DrainInputEvents(queue, input);
+    Win32ApplyGamepadEventTransitions(input);
+
+    bool is_sorted = true;
+    for (uint32_t event_idx = 1; event_idx < input->event_count; ++event_idx) {
+        is_sorted = is_sorted && input->events[event_idx - 1].timestamp <= input->events[event_idx].timestamp;
+    }
+    // NOTE: the tap is both transitions and ends up, even though it never showed at a frame boundary
+    Game_Button_State* tapped = &input->controllers[1].buttons[5];
+    bool               is_tap_kept =
+        input->event_count == 3 && is_sorted && tapped->half_transition_count == 2 && !tapped->ended_down;
+    printf("sub-frame tap: %u events, sorted %s, ", input->event_count, is_sorted ? "yes" : "NO");
+    printf(
+        "half transitions %d ended_down %d (%s)\n",
+        tapped->half_transition_count,
+        tapped->ended_down,
+        BenchCheck(is_tap_kept) ? "ok" : "FAILED");
+
+    // NOTE: overflow, the ring holds INPUT_EVENT_QUEUE_COUNT and a frame takes GAME_INPUT_MAX_EVENTS
+    int         inject_count = 2 * INPUT_EVENT_QUEUE_COUNT;
+    Bench_Timer timer        = BenchBegin();
+    for (int event_idx = 0; event_idx < inject_count; ++event_idx) {
+        Game_Input_Event event = Win32MakeButtonEvent(frame_start + event_idx, 1, event_idx % 12, (event_idx & 1) != 0);
+        Win32InjectInputEvent(queue, &event);
+    }
+    float32_t inject_ms = BenchEndMs(timer);
+
+    timer = BenchBegin();
+    Win32DrainInputEvents(queue, input);
+    float32_t drain_ms = BenchEndMs(timer);
+
+    // NOTE: nothing is lost without being counted and a frame still gets as many as it holds
+    bool is_overflow_counted = input->event_count == GAME_INPUT_MAX_EVENTS &&
+                               input->event_count + input->dropped_event_count == (uint32_t)inject_count;
+    printf(
+        "overflow: injected %d, delivered %u, dropped %u (%s)\n",
+        inject_count,
+        input->event_count,
+        input->dropped_event_count,
+        BenchCheck(is_overflow_counted) ? "ok" : "FAILED");
+    printf(
+        "inject %.1f ns/event, drain %.3f ms for %d queued\n",
+        inject_ms * 1000000.0f / inject_count,
+        drain_ms,
+        INPUT_EVENT_QUEUE_COUNT);
+
+    VirtualFree(input, 0, MEM_RELEASE);
+    VirtualFree(queue, 0, MEM_RELEASE);
+}
+
+/// Game code
+// NOTE: benchmarks that need the real game load handmade.dll once and share it, run from the build directory so the
+// dll is found
+struct Bench_Game {
+    Win32_Game_Code code;
+    Game_Memory     memory;
+};
+
+// NOTE: permanent storage is write watched like the game's so rollback can run on it
+internal void
+BenchInitGameMemory(Game_Memory* game_memory, Platform_Work_Queue* work_queue) {
+    *game_memory                        = {};
+    game_memory->permanent_storage_size = MegaBytes(64);
+    game_memory->permanent_storage      = Win32AllocateMemory(
+        game_memory->permanent_storage_size, Win32MemoryTag_GameStorage, MEM_WRITE_WATCH);
+    game_memory->transient_storage_size = MegaBytes(256);
+    game_memory->transient_storage =
+        Win32AllocateMemory(game_memory->transient_storage_size, Win32MemoryTag_GameStorage);
+    game_memory->work_queue                = work_queue;
+    game_memory->PlatformAddWorkQueueEntry = Win32AddWorkQueueEntry;
+    game_memory->PlatformCompleteAllWork   = Win32CompleteAllWork;
+    game_memory->PlatformMapFile           = Win32MapFile;
+    game_memory->PlatformUnmapFile         = Win32UnmapFile;
+    game_memory->PlatformOpenFile          = Win32OpenFile;
+    game_memory->PlatformCloseFile         = Win32CloseFile;
+    game_memory->PlatformReadFileAsync     = Win32ReadFileAsync;
+    game_memory->PlatformWriteFileAsync    = Win32WriteFileAsync;
+    game_memory->PlatformPollFileOp        = Win32PollFileOp;
+#ifdef HANDMADE_INTERNAL
+    game_memory->DebugPlatformReadEntireFile  = DebugPlatformReadEntireFile;
+    game_memory->DebugPlatformWriteEntireFile = DebugPlatformWriteEntireFile;
+    game_memory->DebugPlatformFreeFileMemory  = DebugPlatformFreeFileMemory;
+#endif
+}
+
+internal Bench_Game*
+BenchLoadGame(void) {
+    local_persist bool                is_initialized;
+    local_persist Bench_Game          game;
+    local_persist Platform_Work_Queue work_queue;
+    local_persist Win32_Thread_Info   thread_infos[WORK_QUEUE_MAX_THREADS];
+    if (!is_initialized) {
+        game.code = Win32LoadGameCode("handmade.dll", "handmade_bench_temp.dll");
+        if (!BenchCheck(game.code.is_valid)) {
+            printf("unable to load handmade.dll\n");
+            return 0;
+        }
+
+        Win32MakeWorkQueue(&work_queue, Win32GetWorkerThreadCount(), thread_infos);
+        BenchInitFileIO();
+        BenchInitGameMemory(&game.memory, &work_queue);
+        is_initialized = true;
+    }
+    return &game;
+}
+
+internal Game_Offscreen_Buffer
+BenchGetGameBuffer(Win32_Offscreen_Buffer* backbuffer) {
+    Game_Offscreen_Buffer result = {};
+    result.memory                = backbuffer->memory;
+    result.width                 = backbuffer->width;
+    result.height                = backbuffer->height;
+    result.pitch                 = backbuffer->pitch;
+    result.bytes_per_pixel       = backbuffer->bytes_per_pixel;
+    result.pixel_format          = backbuffer->pixel_format;
+    return result;
+}
+
+/// Frame buffer
+// NOTE: the game's gradient kernel and the blit to a 32-bit DIB (what a desktop window is) for both pixel formats,
+// MB/frame is what the kernel writes and the blit reads
+#define BENCH_FRAMEBUFFER_FRAME_COUNT 200
+
+internal void
+BenchFramebuffer(void) {
+    Bench_Game* game = BenchLoadGame();
+    if (!game) {
+        return;
+    }
+
+    Game_Input* input = (Game_Input*)VirtualAlloc(0, sizeof(Game_Input), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+    int         dims[][2]      = {{1280, 720}, {1366, 768}, {1920, 1080}};
+    int         formats[]      = {GamePixelFormat_BGRX8888, GamePixelFormat_RGB565};
+    const char* format_names[] = {"BGRX8888", "RGB565"};
+    printf(
+        "%-10s %-10s %8s %10s %12s %12s %12s\n",
+        "size",
+        "format",
+        "pitch",
+        "MB/frame",
+        "render ms",
+        "render GB/s",
+        "present ms");
+    for (int dim_idx = 0; dim_idx < ArrayCount(dims); ++dim_idx) {
+        for (int format_idx = 0; format_idx < ArrayCount(formats); ++format_idx) {
+            Win32_Offscreen_Buffer backbuffer = {};
+            Win32ResizeDIBSection(&backbuffer, dims[dim_idx][0], dims[dim_idx][1], formats[format_idx]);
+            Game_Offscreen_Buffer game_buffer = BenchGetGameBuffer(&backbuffer);
+
+            Win32_Offscreen_Buffer target = {};
+            Win32ResizeDIBSection(&target, backbuffer.width, backbuffer.height, GamePixelFormat_BGRX8888);
+            void*   target_pixels = 0;
+            HDC     target_dc     = CreateCompatibleDC(0);
+            HBITMAP target_bitmap =
+                CreateDIBSection(target_dc, (BITMAPINFO*)&target.info, DIB_RGB_COLORS, &target_pixels, 0, 0);
+            SelectObject(target_dc, target_bitmap);
+
+            float32_t render_ms  = 0.0f;
+            float32_t present_ms = 0.0f;
+            for (int frame_idx = 0; frame_idx < BENCH_FRAMEBUFFER_FRAME_COUNT; ++frame_idx) {
+                *input            = {};
+                Bench_Timer timer = BenchBegin();
+                game->code.GameUpdateAndRender(&game->memory, input, &game_buffer);
+                render_ms += BenchEndMs(timer);
+
+                timer = BenchBegin();
+                Win32DisplayBufferInWindow(target_dc, backbuffer.width, backbuffer.height, backbuffer);
+                GdiFlush();
+                present_ms += BenchEndMs(timer);
+            }
+            render_ms /= BENCH_FRAMEBUFFER_FRAME_COUNT;
+            present_ms /= BENCH_FRAMEBUFFER_FRAME_COUNT;
+
+            float32_t frame_mb = (float32_t)(backbuffer.pitch * backbuffer.height) / MegaBytes(1);
+            char      size_name[32];
+            sprintf_s(size_name, "%dx%d", backbuffer.width, backbuffer.height);
+            printf(
+                "%-10s %-10s %8d %10.2f %12.3f %12.2f %12.3f\n",
+                size_name,
+                format_names[format_idx],
+                backbuffer.pitch,
+                frame_mb,
+                render_ms,
+                frame_mb / 1024.0f / (render_ms / 1000.0f),
+                present_ms);
+
+            DeleteDC(target_dc);
+            DeleteObject(target_bitmap);
+            VirtualFree(target.memory, 0, MEM_RELEASE);
+            VirtualFree(backbuffer.memory, 0, MEM_RELEASE);
+        }
+    }
+
+    VirtualFree(input, 0, MEM_RELEASE);
+}
+
+/// Input latency
+// NOTE: drives the real game dll without a window. A synthetic press lands at a random point of every frame, the frame
+// loop below has the same order as WinMain's (collect input, update, wait for the frame boundary, present) and presents
+// into an offscreen DC.
+#define BENCH_LATENCY_FRAME_COUNT 600
+
+internal void
+BenchInputLatency(void) {
+    Bench_Game* game = BenchLoadGame();
+    if (!game) {
+        return;
+    }
+    bool sleep_is_granular = (timeBeginPeriod(1) == TIMERR_NOERROR);
+
+    Win32_Input_Event_Queue* queue = (Win32_Input_Event_Queue*)VirtualAlloc(
+        0, sizeof(Win32_Input_Event_Queue), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    Game_Input* input = (Game_Input*)VirtualAlloc(0, sizeof(Game_Input), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    Win32_Latency_Tracker* tracker = (Win32_Latency_Tracker*)VirtualAlloc(
+        0, sizeof(Win32_Latency_Tracker), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    Win32InitInputEventQueue(queue);
+    tracker->is_enabled = true;
+
+    Win32_Offscreen_Buffer backbuffer = {};
+    Win32ResizeDIBSection(&backbuffer, 1280, 720, GamePixelFormat_BGRX8888);
+    void*   present_pixels = 0;
+    HDC     present_dc     = CreateCompatibleDC(0);
+    HBITMAP present_bitmap =
+        CreateDIBSection(present_dc, (BITMAPINFO*)&backbuffer.info, DIB_RGB_COLORS, &present_pixels, 0, 0);
+    SelectObject(present_dc, present_bitmap);
+
+    float32_t target_ms    = 1000.0f / 60.0f;
+    float32_t max_frame_ms = 0.0f;
+    uint32_t  random       = 0x9E3779B9;
+    for (int frame_idx = 0; frame_idx < BENCH_LATENCY_FRAME_COUNT; ++frame_idx) {
+        LARGE_INTEGER frame_start = Win32GetWallClock();
+
+        input->frame_timestamp     = frame_start.QuadPart;
+        input->timestamp_frequency = g_perf_count_freq;
+        Win32DrainInputEvents(queue, input);
+        Win32TagInputEvents(tracker, input);
+
+        Game_Offscreen_Buffer game_buffer = BenchGetGameBuffer(&backbuffer);
+        game->code.GameUpdateAndRender(&game->memory, input, &game_buffer);
+
+        // NOTE: the press for the next frame arrives while this one waits for its flip
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        float32_t press_at_ms = target_ms * (float32_t)(random % 1000) / 1000.0f;
+        bool      pressed     = false;
+        for (;;) {
+            float32_t elapsed_ms = Win32GetMilliSecondsElapsed(frame_start, Win32GetWallClock());
+            if (!pressed && elapsed_ms >= press_at_ms) {
+                int64_t          timestamp = Win32GetInputTimestamp();
+                Game_Input_Event press     = Win32MakeButtonEvent(timestamp, 0, 5, true);
+                Game_Input_Event release   = Win32MakeButtonEvent(timestamp + 1, 0, 5, false);
+                Win32InjectInputEvent(queue, &press);
+                Win32InjectInputEvent(queue, &release);
+                pressed = true;
+            }
+            if (elapsed_ms >= target_ms) {
+                break;
+            }
+            float32_t next_deadline_ms = pressed ? target_ms : press_at_ms;
+            if (sleep_is_granular && next_deadline_ms - elapsed_ms > 2.0f) {
+                Sleep(1);
+            }
+        }
+
+        Win32DisplayBufferInWindow(present_dc, backbuffer.width, backbuffer.height, backbuffer);
+        GdiFlush();
+        LARGE_INTEGER present = Win32GetWallClock();
+        Win32RecordLatencyPresent(tracker, input->consumed_latency_tag, present.QuadPart);
+
+        float32_t frame_ms = Win32GetMilliSecondsElapsed(frame_start, present);
+        max_frame_ms       = frame_ms > max_frame_ms ? frame_ms : max_frame_ms;
+    }
+
+    char report[4096];
+    Win32FormatLatencyReport(tracker, report, sizeof(report));
+    printf("%d frames at 60Hz, one synthetic press per frame\n%s", BENCH_LATENCY_FRAME_COUNT, report);
+
+    // NOTE: a press lands in one frame and is presented at the end of the next, so every press but the last one's is
+    // measured once, after the press and at most two of the longest frame later
+    bool is_every_press_measured = tracker->sample_count == BENCH_LATENCY_FRAME_COUNT - 1;
+    bool is_in_range             = tracker->min_ms > 0.0f && tracker->max_ms <= 2.0f * max_frame_ms;
+    printf(
+        "every press measured once: %s, latency within two frames (longest %.2f ms): %s\n",
+        BenchCheck(is_every_press_measured) ? "ok" : "FAILED",
+        max_frame_ms,
+        BenchCheck(is_in_range) ? "ok" : "FAILED");
+
+    DeleteDC(present_dc);
+    DeleteObject(present_bitmap);
+    VirtualFree(backbuffer.memory, 0, MEM_RELEASE);
+    VirtualFree(tracker, 0, MEM_RELEASE);
+    VirtualFree(input, 0, MEM_RELEASE);
+    VirtualFree(queue, 0, MEM_RELEASE);
+}
+
+/// Dynamic resolution
+// NOTE: first times the upscalers against GDI stretching the same region, then runs the governor on a synthetic load
+// that goes light, heavy, very heavy and back. Frame cost = fixed part + per pixel part * rendered area + noise.
+#define BENCH_UPSCALE_FRAME_COUNT    100
+#define BENCH_GOVERNOR_FRAME_COUNT   720
+#define BENCH_GOVERNOR_FIXED_MS      4.0f
+#define BENCH_GOVERNOR_REPORT_FRAMES 30
+
+internal float32_t
+BenchSyntheticFrameMs(int frame_idx, float32_t scale, uint32_t* random) {
+    // NOTE: cost of the full resolution pixels for each quarter of the run
+    float32_t phase_pixel_ms[] = {15.0f, 34.0f, 55.0f, 15.0f};
+    int       phase_idx        = frame_idx * ArrayCount(phase_pixel_ms) / BENCH_GOVERNOR_FRAME_COUNT;
+
+    *random ^= *random << 13;
+    *random ^= *random >> 17;
+    *random ^= *random << 5;
+    float32_t noise = 0.9f + 0.2f * (float32_t)(*random % 1000) / 1000.0f;
+
+    return BENCH_GOVERNOR_FIXED_MS + noise * phase_pixel_ms[phase_idx] * scale * scale;
+}
+
+internal void
+BenchDynamicResolution(void) {
+    int         formats[]      = {GamePixelFormat_BGRX8888, GamePixelFormat_RGB565};
+    const char* format_names[] = {"BGRX8888", "RGB565"};
+    printf("%-10s %-10s %12s %12s\n", "format", "source", "upscale ms", "gdi ms");
+    for (int format_idx = 0; format_idx < ArrayCount(formats); ++format_idx) {
+        Win32_Offscreen_Buffer source = {};
+        Win32_Offscreen_Buffer dest   = {};
+        Win32ResizeDIBSection(&source, 1280, 720, formats[format_idx]);
+        Win32ResizeDIBSection(&dest, 1280, 720, formats[format_idx]);
+        for (int byte_idx = 0; byte_idx < source.pitch * source.height; ++byte_idx) {
+            ((uint8_t*)source.memory)[byte_idx] = (uint8_t)(byte_idx * 7);
+        }
+
+        void*   gdi_pixels = 0;
+        HDC     gdi_dc     = CreateCompatibleDC(0);
+        HBITMAP gdi_bitmap = CreateDIBSection(gdi_dc, (BITMAPINFO*)&dest.info, DIB_RGB_COLORS, &gdi_pixels, 0, 0);
+        SelectObject(gdi_dc, gdi_bitmap);
+
+        for (int step_idx = 1; step_idx < RESOLUTION_STEP_COUNT; ++step_idx) {
+            Win32_Offscreen_Buffer region = source;
+            region.width                  = (int)(g_resolution_steps[step_idx] * (float32_t)source.width);
+            region.height                 = (int)(g_resolution_steps[step_idx] * (float32_t)source.height);
+
+            Bench_Timer timer = BenchBegin();
+            for (int frame_idx = 0; frame_idx < BENCH_UPSCALE_FRAME_COUNT; ++frame_idx) {
+                Win32UpscaleBuffer(&source, region.width, region.height, &dest);
+            }
+            float32_t upscale_ms = BenchEndMs(timer) / BENCH_UPSCALE_FRAME_COUNT;
+
+            timer = BenchBegin();
+            for (int frame_idx = 0; frame_idx < BENCH_UPSCALE_FRAME_COUNT; ++frame_idx) {
+                Win32DisplayBufferInWindow(gdi_dc, dest.width, dest.height, region);
+                GdiFlush();
+            }
+            float32_t gdi_ms = BenchEndMs(timer) / BENCH_UPSCALE_FRAME_COUNT;
+
+            char source_name[32];
+            sprintf_s(source_name, "%dx%d", region.width, region.height);
+            printf("%-10s %-10s %12.3f %12.3f\n", format_names[format_idx], source_name, upscale_ms, gdi_ms);
+        }
+
+        DeleteDC(gdi_dc);
+        DeleteObject(gdi_bitmap);
+        VirtualFree(dest.memory, 0, MEM_RELEASE);
+        VirtualFree(source.memory, 0, MEM_RELEASE);
+    }
+
+    float32_t budget_ms = 1000.0f / 30.0f;
+
+    Win32_Resolution_Governor governor;
+    Win32InitResolutionGovernor(&governor, budget_ms);
+    uint32_t  random              = 0x9E3779B9;
+    uint32_t  fixed_random        = 0x9E3779B9;
+    int       missed_count        = 0;
+    int       fixed_missed_count  = 0;
+    int       step_change_count   = 0;
+    int       report_missed_count = 0;
+    float32_t report_total_ms     = 0.0f;
+
+    printf("\ngovernor, %.2fms budget\n%8s %8s %10s %8s\n", budget_ms, "frames", "scale", "avg ms", "missed");
+    for (int frame_idx = 0; frame_idx < BENCH_GOVERNOR_FRAME_COUNT; ++frame_idx) {
+        float32_t scale    = g_resolution_steps[governor.step_idx];
+        float32_t frame_ms = BenchSyntheticFrameMs(frame_idx, scale, &random);
+        if (frame_ms > budget_ms) {
+            ++missed_count;
+            ++report_missed_count;
+        }
+        if (BenchSyntheticFrameMs(frame_idx, 1.0f, &fixed_random) > budget_ms) {
+            ++fixed_missed_count;
+        }
+        report_total_ms += frame_ms;
+
+        if (Win32UpdateResolutionGovernor(&governor, frame_ms)) {
+            ++step_change_count;
+        }
+
+        if ((frame_idx + 1) % BENCH_GOVERNOR_REPORT_FRAMES == 0) {
+            printf(
+                "%4d-%-3d %7.0f%% %10.2f %8d\n",
+                frame_idx + 1 - BENCH_GOVERNOR_REPORT_FRAMES,
+                frame_idx,
+                100.0f * scale,
+                report_total_ms / BENCH_GOVERNOR_REPORT_FRAMES,
+                report_missed_count);
+            report_missed_count = 0;
+            report_total_ms     = 0.0f;
+        }
+    }
+    printf(
+        "missed frames: %d with the governor (%d scale changes), %d at fixed full resolution\n",
+        missed_count,
+        step_change_count,
+        fixed_missed_count);
+}
+
+/// Frame phases
+// NOTE: the frame loop without the window or the wait for the frame boundary, the counters are read the same way
+// WinMain reads them
+#define BENCH_PHASES_FRAME_COUNT 300
+
+internal void
+BenchFramePhases(void) {
+    Bench_Game* game = BenchLoadGame();
+    if (!game) {
+        return;
+    }
+
+    Game_Input* input = (Game_Input*)VirtualAlloc(0, sizeof(Game_Input), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+    Win32_Offscreen_Buffer backbuffer = {};
+    Win32ResizeDIBSection(&backbuffer, 1280, 720, GamePixelFormat_BGRX8888);
+    void*   present_pixels = 0;
+    HDC     present_dc     = CreateCompatibleDC(0);
+    HBITMAP present_bitmap =
+        CreateDIBSection(present_dc, (BITMAPINFO*)&backbuffer.info, DIB_RGB_COLORS, &present_pixels, 0, 0);
+    SelectObject(present_dc, present_bitmap);
+
+    int16_t samples[48000 / 30 * 2];
+
+    Win32_Frame_Counters counters;
+    Win32InitFrameCounters(&counters);
+    printf("hardware counters: %s\n", counters.has_pmc ? "fixed PMCs readable" : "not readable from user mode, no ipc");
+
+    for (int frame_idx = 0; frame_idx < BENCH_PHASES_FRAME_COUNT; ++frame_idx) {
+        Win32BeginFramePhase(&counters, Win32FramePhase_Input);
+        *input                     = {};
+        input->frame_timestamp     = Win32GetInputTimestamp();
+        input->timestamp_frequency = g_perf_count_freq;
+
+        Win32BeginFramePhase(&counters, Win32FramePhase_Update);
+        Game_Offscreen_Buffer game_buffer = BenchGetGameBuffer(&backbuffer);
+        game->code.GameUpdateAndRender(&game->memory, input, &game_buffer);
+
+        Win32BeginFramePhase(&counters, Win32FramePhase_Audio);
+        Game_Sound_Output_Buffer sound_buffer = {};
+        sound_buffer.samples_per_second       = 48000;
+        sound_buffer.sample_count             = ArrayCount(samples) / 2;
+        sound_buffer.samples                  = samples;
+        game->code.GameGetSoundSamples(&game->memory, &sound_buffer);
+
+        Win32BeginFramePhase(&counters, Win32FramePhase_Present);
+        Win32DisplayBufferInWindow(present_dc, backbuffer.width, backbuffer.height, backbuffer);
+        GdiFlush();
+        Win32EndFramePhase(&counters);
+        ++counters.frame_count;
+    }
+
+    char report[512];
+    Win32FormatFrameCounters(&counters, report, sizeof(report));
+    printf("average of %d frames\n%s", BENCH_PHASES_FRAME_COUNT, report);
+
+    DeleteDC(present_dc);
+    DeleteObject(present_bitmap);
+    VirtualFree(backbuffer.memory, 0, MEM_RELEASE);
+    VirtualFree(input, 0, MEM_RELEASE);
+}
+
+/// Save states
+// NOTE: 64MB of permanent storage like the game's. A quarter of it looks like game state (small records that repeat
+// with variation), an eighth is noise and the rest is never written, like most of a fresh permanent arena.
+#define BENCH_SAVE_FILE_NAME    "bench_save.hhs"
+#define BENCH_SAVE_STORAGE_SIZE MegaBytes(64)
+
+internal void
+BenchTimeSave(Win32_Save_System* save, Game_Memory* memory, const char* label) {
+    Bench_Timer timer = BenchBegin();
+    if (!Win32BeginSave(save, BENCH_SAVE_FILE_NAME)) {
+        printf("%-12s save already running\n", label);
+        return;
+    }
+    while (save->state != Win32Save_Saved) {
+        Sleep(1);
+    }
+    float32_t total_ms = BenchEndMs(timer);
+    bool      ok       = save->succeeded;
+    Win32UpdateSaveSystem(save, memory);
+
+    printf(
+        "%-12s %12.3f %10.2f %14.1f %10.2f %10.2f %8.2fx%s\n",
+        label,
+        save->snapshot_ms,
+        (float32_t)save->snapshot_bytes / MegaBytes(1),
+        (float32_t)save->storage_size / MegaBytes(1) / (save->compress_ms / 1000.0f),
+        save->write_ms,
+        total_ms,
+        (float32_t)save->storage_size / (float32_t)save->file_size,
+        BenchCheck(ok) ? "" : " (write failed)");
+}
+
+internal void
+BenchSaveStates(void) {
+    BenchInitFileIO();
+
+    uint8_t* storage = (uint8_t*)VirtualAlloc(
+        0, BENCH_SAVE_STORAGE_SIZE, MEM_RESERVE | MEM_COMMIT | MEM_WRITE_WATCH, PAGE_READWRITE);
+    uint8_t* expected =
+        (uint8_t*)VirtualAlloc(0, BENCH_SAVE_STORAGE_SIZE, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+    Game_Memory       memory = {};
+    Win32_Save_System save;
+    Win32InitSaveSystem(&save, storage, BENCH_SAVE_STORAGE_SIZE, g_file_io.fallback_queue);
+    printf("write watch: %s\n", save.has_write_watch ? "yes" : "no, every snapshot copies everything");
+
+    uint32_t random = 0x9E3779B9;
+    for (uint64_t offset = 0; offset < BENCH_SAVE_STORAGE_SIZE / 4; offset += sizeof(uint32_t)) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        uint32_t value = (uint32_t)(offset / 64) % 100 + ((random & 0xF) == 0 ? (random >> 24) : 0);
+        memcpy(storage + offset, &value, sizeof(value));
+    }
+    for (uint64_t offset = BENCH_SAVE_STORAGE_SIZE / 4; offset < BENCH_SAVE_STORAGE_SIZE * 3 / 8; ++offset) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        storage[offset] = (uint8_t)random;
+    }
+
+    // NOTE: what a plain double buffer would cost the frame thread, with the pages of the copy already faulted in
+    memset(expected, 0, BENCH_SAVE_STORAGE_SIZE);
+    Bench_Timer timer = BenchBegin();
+    memcpy(expected, storage, BENCH_SAVE_STORAGE_SIZE);
+    float32_t memcpy_ms = BenchEndMs(timer);
+    printf("full copy of %lldMB: %.3fms\n\n", BENCH_SAVE_STORAGE_SIZE / MegaBytes(1), memcpy_ms);
+
+    printf(
+        "%-12s %12s %10s %14s %10s %10s %9s\n",
+        "save",
+        "snapshot ms",
+        "copied MB",
+        "compress MB/s",
+        "write ms",
+        "total ms",
+        "ratio");
+    BenchTimeSave(&save, &memory, "first");
+
+    // NOTE: a frame's worth of changes, one write to every 100th page
+    for (uint64_t offset = 0; offset < BENCH_SAVE_STORAGE_SIZE; offset += 100 * 4096) {
+        storage[offset] += 1;
+    }
+    BenchTimeSave(&save, &memory, "1% dirty");
+    BenchTimeSave(&save, &memory, "unchanged");
+    memcpy(expected, storage, BENCH_SAVE_STORAGE_SIZE);
+
+    memset(storage, 0xCD, BENCH_SAVE_STORAGE_SIZE);
+    timer = BenchBegin();
+    Win32BeginLoad(&save, BENCH_SAVE_FILE_NAME);
+    while (save.state != Win32Save_Loaded) {
+        Sleep(1);
+    }
+    float32_t read_ms = BenchEndMs(timer);
+    Win32UpdateSaveSystem(&save, &memory);
+    float32_t total_ms = BenchEndMs(timer);
+
+    bool matches = memcmp(storage, expected, BENCH_SAVE_STORAGE_SIZE) == 0;
+    printf(
+        "\nload: read + decompress %.2fms (%.1f MB/s), applied after %.2fms, %s\n",
+        save.load_ms,
+        (float32_t)BENCH_SAVE_STORAGE_SIZE / MegaBytes(1) / (save.load_ms / 1000.0f),
+        total_ms,
+        BenchCheck(matches) ? "storage matches the save" : "STORAGE DOES NOT MATCH THE SAVE");
+
+    DeleteFileA(BENCH_SAVE_FILE_NAME);
+    VirtualFree(expected, 0, MEM_RELEASE);
+    VirtualFree(storage, 0, MEM_RELEASE);
+}
+
+/// Rollback
+// NOTE: a game memory with its own save system, rollback and netplay, two of them play each other over loopback
+#define BENCH_ROLLBACK_WARMUP_FRAMES 60
+#define BENCH_ROLLBACK_REPEAT_COUNT  50
+#define BENCH_NETPLAY_FRAME_COUNT    600
+#define BENCH_NETPLAY_HOLD_FRAMES    (2 * ROLLBACK_MAX_FRAMES)
+
+struct Bench_Peer {
+    Game_Memory           memory;
+    Win32_Save_System     save;
+    Win32_Rollback        rollback;
+    Win32_Netplay         netplay;
+    Game_Input            input;
+    Game_Controller_Input controller;
+    uint32_t              random;
+};
+
+internal Bench_Peer*
+BenchMakePeer(Platform_Work_Queue* work_queue, uint32_t seed) {
+    Bench_Peer* peer = (Bench_Peer*)VirtualAlloc(0, sizeof(Bench_Peer), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    BenchInitGameMemory(&peer->memory, work_queue);
+    Win32InitSaveSystem(
+        &peer->save,
+        (uint8_t*)peer->memory.permanent_storage,
+        peer->memory.permanent_storage_size,
+        g_file_io.fallback_queue);
+    peer->random = seed;
+    return peer;
+}
+
+// NOTE: holds a direction for a while like a player would, so prediction is right most of the time
+internal void
+BenchUpdatePeerController(Bench_Peer* peer) {
+    peer->random ^= peer->random << 13;
+    peer->random ^= peer->random >> 17;
+    peer->random ^= peer->random << 5;
+    if ((peer->random & 0xF) == 0) {
+        peer->controller = {};
+        for (int button_idx = 0; button_idx < ArrayCount(peer->controller.buttons); ++button_idx) {
+            peer->controller.buttons[button_idx].ended_down = ((peer->random >> (8 + button_idx)) & 3) == 0;
+        }
+        peer->controller.is_analog = ((peer->random >> 24) & 7) == 0;
+        if (peer->controller.is_analog) {
+            peer->controller.stick_avg_x = (float32_t)((int)(peer->random >> 28) - 8) / 8.0f;
+            peer->controller.stick_avg_y = (float32_t)((int)((peer->random >> 20) & 0xF) - 8) / 8.0f;
+        }
+    }
+}
+
+internal uint64_t
+BenchGameStateChecksum(Game_Memory* memory) {
+    Game_State* state  = (Game_State*)memory->permanent_storage;
+    uint32_t    t_sine = 0;
+    memcpy(&t_sine, &state->t_sine, sizeof(t_sine));
+    uint64_t result = (uint64_t)(uint32_t)state->x_offset;
+    result          = result * 1000003 + (uint32_t)state->y_offset;
+    result          = result * 1000003 + (uint32_t)state->tone_hz;
+    result          = result * 1000003 + t_sine;
+    return result;
+}
+
+internal void
+BenchRollbackDepths(Bench_Game* game, Game_Offscreen_Buffer* game_buffer) {
+    Bench_Peer* peer = BenchMakePeer(game->memory.work_queue, 0x1234567);
+    if (!Win32InitRollback(&peer->rollback, &peer->save)) {
+        printf("no write watch, rollback can't run\n");
+        return;
+    }
+
+    // NOTE: every input is known up front, no socket and no prediction
+    Win32_Netplay* netplay        = &peer->netplay;
+    netplay->rollback             = &peer->rollback;
+    netplay->remote_confirmed_idx = INT64_MAX;
+
+    int64_t frame_count = BENCH_ROLLBACK_WARMUP_FRAMES + BENCH_ROLLBACK_REPEAT_COUNT;
+    for (int64_t frame_idx = 0; frame_idx < frame_count; ++frame_idx) {
+        BenchUpdatePeerController(peer);
+        netplay->local_inputs[frame_idx % NETPLAY_INPUT_RING]  = Win32MakeNetInput(&peer->controller);
+        netplay->remote_inputs[frame_idx % NETPLAY_INPUT_RING] = {};
+    }
+
+    float32_t frame_ms = 0;
+    for (int64_t frame_idx = 0; frame_idx < frame_count; ++frame_idx) {
+        Bench_Timer timer = BenchBegin();
+        Win32SimulateNetFrame(netplay, game->code.GameUpdateAndRender, &peer->memory, &peer->input, game_buffer);
+        if (frame_idx >= BENCH_ROLLBACK_WARMUP_FRAMES) {
+            frame_ms += BenchEndMs(timer);
+        }
+    }
+    printf("update + record %.3fms/frame\n\n", frame_ms / BENCH_ROLLBACK_REPEAT_COUNT);
+
+    printf(
+        "%-6s %11s %14s %10s %14s %14s %9s\n",
+        "depth",
+        "restore ms",
+        "resimulate ms",
+        "total ms",
+        "% of 16.67ms",
+        "% of 33.33ms",
+        "matches");
+    for (int depth = 1; depth < ROLLBACK_MAX_FRAMES; ++depth) {
+        uint64_t  expected      = BenchGameStateChecksum(&peer->memory);
+        float32_t restore_ms    = 0;
+        float32_t resimulate_ms = 0;
+        bool      matches       = true;
+        for (int repeat_idx = 0; repeat_idx < BENCH_ROLLBACK_REPEAT_COUNT; ++repeat_idx) {
+            int64_t     end_frame_idx = netplay->frame_idx;
+            Bench_Timer timer         = BenchBegin();
+            if (!BenchCheck(Win32RestoreRollbackFrame(&peer->rollback, end_frame_idx - depth))) {
+                printf("restore of %d frames failed\n", depth);
+                return;
+            }
+            restore_ms += BenchEndMs(timer);
+
+            timer                       = BenchBegin();
+            netplay->frame_idx          = end_frame_idx - depth;
+            peer->input.is_resimulating = true;
+            while (netplay->frame_idx < end_frame_idx) {
+                Win32SimulateNetFrame(
+                    netplay, game->code.GameUpdateAndRender, &peer->memory, &peer->input, game_buffer);
+            }
+            peer->input.is_resimulating = false;
+            resimulate_ms += BenchEndMs(timer);
+            matches = matches && BenchGameStateChecksum(&peer->memory) == expected;
+        }
+        restore_ms /= BENCH_ROLLBACK_REPEAT_COUNT;
+        resimulate_ms /= BENCH_ROLLBACK_REPEAT_COUNT;
+        float32_t total_ms = restore_ms + resimulate_ms;
+        printf(
+            "%-6d %11.3f %14.3f %10.3f %13.1f%% %13.1f%% %9s\n",
+            depth,
+            restore_ms,
+            resimulate_ms,
+            total_ms,
+            100.0f * total_ms / (1000.0f / 60.0f),
+            100.0f * total_ms / (1000.0f / 30.0f),
+            BenchCheck(matches) ? "yes" : "NO");
+    }
+}
+
+// NOTE: the input stops changing for the last frames, once both sides have seen that the predictions are all right
+internal void
+BenchStepPeer(Bench_Peer* peer, Bench_Game* game, Game_Offscreen_Buffer* game_buffer) {
+    if (peer->netplay.frame_idx < BENCH_NETPLAY_FRAME_COUNT - BENCH_NETPLAY_HOLD_FRAMES) {
+        BenchUpdatePeerController(peer);
+    }
+    Win32UpdateNetplay(
+        &peer->netplay, &peer->controller, game->code.GameUpdateAndRender, &peer->memory, &peer->input, game_buffer);
+}
+
+// NOTE: each turn the peers get 0 to 2 frames in a random order, so each runs ahead of the other and predicts
+internal void
+BenchRollbackNetplay(Bench_Game* game, Game_Offscreen_Buffer* game_buffer) {
+    Bench_Peer* peers[2] = {
+        BenchMakePeer(game->memory.work_queue, 0xC0FFEE),
+        BenchMakePeer(game->memory.work_queue, 0xBADF00D),
+    };
+    for (int peer_idx = 0; peer_idx < ArrayCount(peers); ++peer_idx) {
+        Bench_Peer* peer = peers[peer_idx];
+        if (!Win32InitRollback(&peer->rollback, &peer->save) ||
+            !Win32InitNetplay(&peer->netplay, &peer->rollback, peer_idx)) {
+            printf("netplay couldn't start for player %d\n", peer_idx);
+            return;
+        }
+    }
+
+    uint32_t    random = 0x2545F491;
+    Bench_Timer timer  = BenchBegin();
+    for (int turn_idx = 0; turn_idx < 100 * BENCH_NETPLAY_FRAME_COUNT; ++turn_idx) {
+        if (peers[0]->netplay.frame_idx >= BENCH_NETPLAY_FRAME_COUNT &&
+            peers[1]->netplay.frame_idx >= BENCH_NETPLAY_FRAME_COUNT) {
+            break;
+        }
+
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        int first_idx = random & 1;
+        for (int order_idx = 0; order_idx < 2; ++order_idx) {
+            Bench_Peer* peer       = peers[first_idx ^ order_idx];
+            uint32_t    step_count = (random >> (4 + 2 * order_idx)) % 3;
+            for (uint32_t step_idx = 0; step_idx < step_count; ++step_idx) {
+                BenchStepPeer(peer, game, game_buffer);
+            }
+        }
+    }
+    float32_t total_ms = BenchEndMs(timer);
+
+    // NOTE: bring both to the same frame, then one more turn each so the one that was ahead rolls back what it guessed
+    for (int turn_idx = 0; turn_idx < 2 * BENCH_NETPLAY_HOLD_FRAMES; ++turn_idx) {
+        int64_t frame_delta = peers[0]->netplay.frame_idx - peers[1]->netplay.frame_idx;
+        if (frame_delta <= 0) {
+            BenchStepPeer(peers[0], game, game_buffer);
+        }
+        if (frame_delta >= 0) {
+            BenchStepPeer(peers[1], game, game_buffer);
+        }
+    }
+    while (peers[0]->netplay.frame_idx != peers[1]->netplay.frame_idx) {
+        int lagging_idx = peers[0]->netplay.frame_idx < peers[1]->netplay.frame_idx ? 0 : 1;
+        BenchStepPeer(peers[lagging_idx], game, game_buffer);
+    }
+    bool is_in_sync   = !peers[0]->netplay.is_out_of_sync && !peers[1]->netplay.is_out_of_sync;
+    bool states_match = is_in_sync &&
+                        BenchGameStateChecksum(&peers[0]->memory) == BenchGameStateChecksum(&peers[1]->memory);
+
+    printf("\n%-8s %8s %10s %12s %8s %8s\n", "player", "frames", "rollbacks", "resimulated", "deepest", "stalls");
+    for (int peer_idx = 0; peer_idx < ArrayCount(peers); ++peer_idx) {
+        Win32_Netplay* netplay = &peers[peer_idx]->netplay;
+        printf(
+            "%-8d %8lld %10u %12u %8u %8u\n",
+            peer_idx,
+            netplay->frame_idx,
+            netplay->rollback_count,
+            netplay->resimulated_frame_count,
+            netplay->max_rollback_depth,
+            netplay->stall_count);
+        closesocket(netplay->socket);
+        WSACleanup();
+    }
+    Game_State* state = (Game_State*)peers[0]->memory.permanent_storage;
+    printf(
+        "%.1fms for both, game state at the end %s (x %d, y %d, tone %d)\n",
+        total_ms,
+        BenchCheck(states_match) ? "matches" : "DIFFERS",
+        state->x_offset,
+        state->y_offset,
+        state->tone_hz);
+}
+
+internal void
+BenchRollback(void) {
+    Bench_Game* game = BenchLoadGame();
+    if (!game) {
+        return;
+    }
+
+    Win32_Offscreen_Buffer backbuffer = {};
+    Win32ResizeDIBSection(&backbuffer, 1280, 720, GamePixelFormat_BGRX8888);
+    Game_Offscreen_Buffer game_buffer = BenchGetGameBuffer(&backbuffer);
+
+    BenchRollbackDepths(game, &game_buffer);
+    BenchRollbackNetplay(game, &game_buffer);
+}
+
+/// Entities
+// NOTE: the same integration over an array of structs laid out like a typical game entity (the fields the kernel needs
+// plus the rest of a 64-byte record), over the SoA store one entity at a time and over the store with the SIMD kernel
+#define BENCH_ENTITY_UPDATES (64 * 1024 * 1024)
+
+struct Bench_AoS_Entity {
+    float32_t position_x;
+    float32_t position_y;
+    float32_t velocity_x;
+    float32_t velocity_y;
+    uint32_t  generation;
+    uint32_t  flags;
+    float32_t health;
+    float32_t radius;
+    uint8_t   other[32];
+};
+
+internal void
+BenchIntegrateAoS(Bench_AoS_Entity* entities, uint32_t count, Entity_Store* bounds, float32_t dt) {
+    float32_t damping  = 1.0f - bounds->drag * dt;
+    float32_t delta_vx = GAME_ENTITY_ACCELERATION * dt;
+    float32_t delta_vy = -GAME_ENTITY_ACCELERATION * dt;
+    for (uint32_t entity_idx = 0; entity_idx < count; ++entity_idx) {
+        Bench_AoS_Entity* entity = &entities[entity_idx];
+        entity->velocity_x       = entity->velocity_x * damping + delta_vx;
+        entity->velocity_y       = entity->velocity_y * damping + delta_vy;
+        entity->position_x       = entity->position_x + entity->velocity_x * dt;
+        entity->position_y       = entity->position_y + entity->velocity_y * dt;
+        if (entity->position_x < bounds->min_x || entity->position_x > bounds->max_x) {
+            float32_t edge     = entity->position_x < bounds->min_x ? bounds->min_x : bounds->max_x;
+            entity->position_x = (edge + edge) - entity->position_x;
+            entity->velocity_x = -entity->velocity_x;
+        }
+        if (entity->position_y < bounds->min_y || entity->position_y > bounds->max_y) {
+            float32_t edge     = entity->position_y < bounds->min_y ? bounds->min_y : bounds->max_y;
+            entity->position_y = (edge + edge) - entity->position_y;
+            entity->velocity_y = -entity->velocity_y;
+        }
+    }
+}
+
+internal void
+BenchIntegrateSoAScalar(Entity_Store* store, float32_t dt) {
+    float32_t damping  = 1.0f - store->drag * dt;
+    float32_t delta_vx = GAME_ENTITY_ACCELERATION * dt;
+    float32_t delta_vy = -GAME_ENTITY_ACCELERATION * dt;
+    for (uint32_t idx = 0; idx < store->count; ++idx) {
+        float32_t velocity_x = store->velocity_x[idx] * damping + delta_vx;
+        float32_t velocity_y = store->velocity_y[idx] * damping + delta_vy;
+        float32_t position_x = store->position_x[idx] + velocity_x * dt;
+        float32_t position_y = store->position_y[idx] + velocity_y * dt;
+        if (position_x < store->min_x || position_x > store->max_x) {
+            float32_t edge = position_x < store->min_x ? store->min_x : store->max_x;
+            position_x     = (edge + edge) - position_x;
+            velocity_x     = -velocity_x;
+        }
+        if (position_y < store->min_y || position_y > store->max_y) {
+            float32_t edge = position_y < store->min_y ? store->min_y : store->max_y;
+            position_y     = (edge + edge) - position_y;
+            velocity_y     = -velocity_y;
+        }
+        store->velocity_x[idx] = velocity_x;
+        store->velocity_y[idx] = velocity_y;
+        store->position_x[idx] = position_x;
+        store->position_y[idx] = position_y;
+    }
+}
+
+internal void
+BenchFillEntities(Entity_Store* store, Bench_AoS_Entity* aos, uint32_t count) {
+    EntityStoreClear(store);
+    uint32_t random = 0x12345678;
+    for (uint32_t entity_idx = 0; entity_idx < count; ++entity_idx) {
+        float32_t values[4];
+        for (int value_idx = 0; value_idx < ArrayCount(values); ++value_idx) {
+            random ^= random << 13;
+            random ^= random >> 17;
+            random ^= random << 5;
+            values[value_idx] = (float32_t)(random & 0xFFFF) / 65535.0f;
+        }
+        Bench_AoS_Entity* entity = &aos[entity_idx];
+        *entity                  = {};
+        entity->position_x       = values[0] * GAME_WORLD_WIDTH;
+        entity->position_y       = values[1] * GAME_WORLD_HEIGHT;
+        entity->velocity_x       = 200.0f * (values[2] - 0.5f);
+        entity->velocity_y       = 200.0f * (values[3] - 0.5f);
+        EntityAdd(store, entity->position_x, entity->position_y, entity->velocity_x, entity->velocity_y);
+    }
+}
+
+// NOTE: removes every third entity, checks the rest still resolve to what they were, then fills the store back up
+internal bool
+BenchEntityChurn(Entity_Store* store, Entity_Handle* handles, uint32_t count) {
+    for (uint32_t entity_idx = 0; entity_idx < count; ++entity_idx) {
+        handles[entity_idx] = EntityAdd(store, (float32_t)entity_idx, 0, 0, 0);
+    }
+    for (uint32_t entity_idx = 0; entity_idx < count; entity_idx += 3) {
+        EntityRemove(store, handles[entity_idx]);
+    }
+
+    bool ok = store->count == count - (count + 2) / 3;
+    for (uint32_t entity_idx = 0; entity_idx < count && ok; ++entity_idx) {
+        int64_t dense_idx = EntityGetIndex(store, handles[entity_idx]);
+        if (entity_idx % 3 == 0) {
+            ok = dense_idx < 0;
+        } else {
+            ok = dense_idx >= 0 && store->position_x[dense_idx] == (float32_t)entity_idx;
+        }
+    }
+
+    // NOTE: reused slots get a new generation, the removed handles must stay dead
+    for (uint32_t entity_idx = 0; entity_idx < count; entity_idx += 3) {
+        Entity_Handle handle = EntityAdd(store, -1.0f, 0, 0, 0);
+        ok                   = ok && handle.generation != 0 && !EntityIsAlive(store, handles[entity_idx]);
+    }
+    return ok && store->count == count;
+}
+
+internal void
+BenchEntities(void) {
+    uint32_t counts[] = {1000, 100000, 1000000};
+    uint32_t capacity = counts[ArrayCount(counts) - 1];
+
+    uint64_t     arena_size   = 64 * (uint64_t)capacity + KiloBytes(64);
+    Memory_Arena arena        = {};
+    void*        arena_memory = VirtualAlloc(0, arena_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    InitializeArena(&arena, arena_size, arena_memory);
+
+    Entity_Store store;
+    EntityStoreInit(&store, &arena, capacity, GAME_WORLD_WIDTH, GAME_WORLD_HEIGHT);
+    Entity_Store check;
+    EntityStoreInit(&check, &arena, capacity, GAME_WORLD_WIDTH, GAME_WORLD_HEIGHT);
+
+    Bench_AoS_Entity* aos = (Bench_AoS_Entity*)VirtualAlloc(
+        0, capacity * sizeof(Bench_AoS_Entity), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+    printf(
+        "%-9s %10s %15s %12s %9s %11s %9s\n",
+        "entities",
+        "AoS ns/e",
+        "SoA 1-wide ns/e",
+        "SoA SSE ns/e",
+        "vs AoS",
+        "SSE GB/s",
+        "matches");
+    for (int count_idx = 0; count_idx < ArrayCount(counts); ++count_idx) {
+        uint32_t  count      = counts[count_idx];
+        uint32_t  iterations = BENCH_ENTITY_UPDATES / count;
+        float32_t dt         = GAME_UPDATE_SECONDS;
+
+        BenchFillEntities(&store, aos, count);
+        BenchFillEntities(&check, aos, count);
+
+        Bench_Timer timer = BenchBegin();
+        for (uint32_t iteration = 0; iteration < iterations; ++iteration) {
+            BenchIntegrateAoS(aos, count, &store, dt);
+        }
+        float32_t aos_ms = BenchEndMs(timer);
+
+        timer = BenchBegin();
+        for (uint32_t iteration = 0; iteration < iterations; ++iteration) {
+            BenchIntegrateSoAScalar(&check, dt);
+        }
+        float32_t scalar_ms = BenchEndMs(timer);
+
+        timer = BenchBegin();
+        for (uint32_t iteration = 0; iteration < iterations; ++iteration) {
+            EntityIntegrate(&store, GAME_ENTITY_ACCELERATION, -GAME_ENTITY_ACCELERATION, dt);
+        }
+        float32_t simd_ms = BenchEndMs(timer);
+
+        bool matches = true;
+        for (uint32_t idx = 0; idx < count; ++idx) {
+            matches = matches && store.position_x[idx] == check.position_x[idx] &&
+                      store.position_y[idx] == check.position_y[idx] && aos[idx].position_x == store.position_x[idx];
+        }
+
+        float32_t updates = (float32_t)count * iterations;
+        printf(
+            "%-9u %10.3f %15.3f %12.3f %8.2fx %11.2f %9s\n",
+            count,
+            1000000.0f * aos_ms / updates,
+            1000000.0f * scalar_ms / updates,
+            1000000.0f * simd_ms / updates,
+            aos_ms / simd_ms,
+            updates * 4 * 2 * sizeof(float32_t) / (simd_ms / 1000.0f) / (float32_t)GigaBytes(1),
+            BenchCheck(matches) ? "yes" : "NO");
+    }
+
+    Entity_Handle* handles =
+        (Entity_Handle*)VirtualAlloc(0, 100000 * sizeof(Entity_Handle), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    EntityStoreClear(&store);
+    printf(
+        "\nadd/remove/re-add of 100000 handles: %s\n",
+        BenchCheck(BenchEntityChurn(&store, handles, 100000)) ? "ok" : "BROKEN");
+
+    VirtualFree(handles, 0, MEM_RELEASE);
+    VirtualFree(aos, 0, MEM_RELEASE);
+    VirtualFree(arena_memory, 0, MEM_RELEASE);
+}
+
+/// World
+#define BENCH_WORLD_LOOKUPS (4 * 1024 * 1024)
+#define BENCH_WORLD_SPREAD  (1 << 20) // scattered chunks are anywhere this many chunks each way from the origin
+#define BENCH_WORLD_VIEWS   (64 * 1024)
+
+enum Bench_World_Pattern {
+    BenchWorldPattern_Scattered,
+    BenchWorldPattern_Block,
+};
+
+// NOTE: scattered is a random point per chunk over a huge area, block is a square of neighbouring chunks, the case
+// a weak hash falls over on
+internal void
+BenchWorldCoordinates(Bench_World_Pattern pattern, uint32_t seed, int32_t* xs, int32_t* ys, uint32_t count) {
+    uint32_t random = seed;
+    uint32_t side   = 1;
+    while (side * side < count) {
+        ++side;
+    }
+    for (uint32_t idx = 0; idx < count; ++idx) {
+        if (pattern == BenchWorldPattern_Scattered) {
+            random ^= random << 13;
+            random ^= random >> 17;
+            random ^= random << 5;
+            xs[idx] = (int32_t)(random % (2 * BENCH_WORLD_SPREAD)) - BENCH_WORLD_SPREAD;
+            random ^= random << 13;
+            random ^= random >> 17;
+            random ^= random << 5;
+            ys[idx] = (int32_t)(random % (2 * BENCH_WORLD_SPREAD)) - BENCH_WORLD_SPREAD;
+        } else {
+            xs[idx] = (int32_t)(idx % side) - (int32_t)(side / 2);
+            ys[idx] = (int32_t)(idx / side) - (int32_t)(side / 2);
+        }
+    }
+}
+
+// NOTE: tiles on both sides of the origin and across chunk edges, the neighbourhood counts have to match going
+// through WorldGetTile one tile at a time
+internal bool
+BenchWorldTilesMatch(World* world, Memory_Arena* arena) {
+    uint32_t random = 0xC0FFEE;
+    for (int tile_idx = 0; tile_idx < 4096; ++tile_idx) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        int32_t tile_x = (int32_t)(random % 128) - 64;
+        int32_t tile_y = (int32_t)((random >> 8) % 128) - 64;
+        WorldSetTile(world, arena, tile_x, tile_y, (uint8_t)(1 + (random >> 24) % 3));
+    }
+    WorldSetTile(world, arena, -1, -1, 0);
+    if (WorldGetTile(world, -1, -1) != 0) {
+        return false;
+    }
+
+    for (int32_t chunk_y = -5; chunk_y <= 4; ++chunk_y) {
+        for (int32_t chunk_x = -5; chunk_x <= 4; ++chunk_x) {
+            World_Neighbourhood neighbourhood = WorldGetNeighbourhood(world, chunk_x, chunk_y);
+            for (int local_y = 0; local_y < WORLD_CHUNK_DIM; ++local_y) {
+                for (int local_x = 0; local_x < WORLD_CHUNK_DIM; ++local_x) {
+                    int32_t tile_x   = chunk_x * WORLD_CHUNK_DIM + local_x;
+                    int32_t tile_y   = chunk_y * WORLD_CHUNK_DIM + local_y;
+                    int     expected = 0;
+                    for (int offset_y = -1; offset_y <= 1; ++offset_y) {
+                        for (int offset_x = -1; offset_x <= 1; ++offset_x) {
+                            if ((offset_x || offset_y) && WorldGetTile(world, tile_x + offset_x, tile_y + offset_y)) {
+                                ++expected;
+                            }
+                        }
+                    }
+                    if (WorldCountFilledNeighbours(&neighbourhood, local_x, local_y) != expected) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+internal void
+BenchWorld(void) {
+    uint32_t  slot_counts[] = {2048, 65536, 262144};
+    float32_t loads[]       = {0.5f, 0.75f};
+    uint32_t  max_count     = slot_counts[ArrayCount(slot_counts) - 1];
+
+    uint64_t arena_size =
+        max_count * sizeof(World_Hash_Slot) + (uint64_t)max_count * AlignPow2(sizeof(World_Chunk), 16) + KiloBytes(64);
+    void*    arena_memory = VirtualAlloc(0, arena_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    int32_t* xs = (int32_t*)VirtualAlloc(0, 4 * max_count * sizeof(int32_t), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    int32_t* ys = xs + max_count;
+    int32_t* miss_xs = ys + max_count;
+    int32_t* miss_ys = miss_xs + max_count;
+
+    printf(
+        "%-9s %7s %5s %10s %8s %8s %8s %6s %9s %6s %8s %10s %11s\n",
+        "pattern",
+        "chunks",
+        "load",
+        "insert/s",
+        "hit ns",
+        "miss ns",
+        "3x3 ns",
+        "in 3x3",
+        "view ns",
+        "in view",
+        "B/chunk",
+        "dense MB",
+        "all found");
+    for (int pattern_idx = 0; pattern_idx < 2; ++pattern_idx) {
+        Bench_World_Pattern pattern = (Bench_World_Pattern)pattern_idx;
+        for (int size_idx = 0; size_idx < ArrayCount(slot_counts); ++size_idx) {
+            for (int load_idx = 0; load_idx < ArrayCount(loads); ++load_idx) {
+                uint32_t slot_count = slot_counts[size_idx];
+                uint32_t count      = (uint32_t)(loads[load_idx] * (float32_t)slot_count);
+                BenchWorldCoordinates(pattern, 0x1234567 + size_idx, xs, ys, count);
+                BenchWorldCoordinates(BenchWorldPattern_Scattered, 0x7654321 + size_idx, miss_xs, miss_ys, count);
+
+                Memory_Arena arena = {};
+                InitializeArena(&arena, arena_size, arena_memory);
+                World world;
+                WorldInit(&world, &arena, slot_count);
+
+                Bench_Timer timer = BenchBegin();
+                for (uint32_t idx = 0; idx < count; ++idx) {
+                    WorldGetChunk(&world, &arena, xs[idx], ys[idx]);
+                }
+                float32_t insert_ms = BenchEndMs(timer);
+
+                uint32_t passes = BENCH_WORLD_LOOKUPS / count + 1;
+                uint32_t found  = 0;
+                timer           = BenchBegin();
+                for (uint32_t pass = 0; pass < passes; ++pass) {
+                    for (uint32_t idx = 0; idx < count; ++idx) {
+                        World_Chunk* chunk = WorldFindChunk(&world, xs[idx], ys[idx]);
+                        found += (chunk && chunk->chunk_x == xs[idx] && chunk->chunk_y == ys[idx]);
+                    }
+                }
+                float32_t hit_ms = BenchEndMs(timer);
+
+                uint32_t missed = 0;
+                timer           = BenchBegin();
+                for (uint32_t pass = 0; pass < passes; ++pass) {
+                    for (uint32_t idx = 0; idx < count; ++idx) {
+                        missed += WorldFindChunk(&world, miss_xs[idx], miss_ys[idx]) == 0;
+                    }
+                }
+                float32_t miss_ms = BenchEndMs(timer);
+
+                uint32_t neighbours = 0;
+                timer               = BenchBegin();
+                for (uint32_t idx = 0; idx < count; ++idx) {
+                    World_Neighbourhood neighbourhood = WorldGetNeighbourhood(&world, xs[idx], ys[idx]);
+                    for (int neighbour_idx = 0; neighbour_idx < 9; ++neighbour_idx) {
+                        neighbours += neighbourhood.chunks[neighbour_idx / 3][neighbour_idx % 3] != 0;
+                    }
+                }
+                float32_t neighbourhood_ms = BenchEndMs(timer);
+
+                // NOTE: a 1280x720 view of 16 pixel tiles, dropped on a chunk that exists
+                uint32_t view_chunks = 0;
+                timer                = BenchBegin();
+                for (uint32_t view_idx = 0; view_idx < BENCH_WORLD_VIEWS; ++view_idx) {
+                    uint32_t             idx      = view_idx % count;
+                    int32_t              min_x    = xs[idx] * WORLD_CHUNK_DIM - 40;
+                    int32_t              min_y    = ys[idx] * WORLD_CHUNK_DIM - 22;
+                    World_Chunk_Iterator iterator = WorldIterateChunks(&world, min_x, min_y, min_x + 79, min_y + 44);
+                    while (WorldNextChunk(&iterator)) {
+                        ++view_chunks;
+                    }
+                }
+                float32_t view_ms = BenchEndMs(timer);
+
+                // NOTE: what a flat array of chunks over the same bounding box would take
+                int32_t bound_min_x = xs[0];
+                int32_t bound_max_x = xs[0];
+                int32_t bound_min_y = ys[0];
+                int32_t bound_max_y = ys[0];
+                for (uint32_t idx = 1; idx < count; ++idx) {
+                    bound_min_x = xs[idx] < bound_min_x ? xs[idx] : bound_min_x;
+                    bound_max_x = xs[idx] > bound_max_x ? xs[idx] : bound_max_x;
+                    bound_min_y = ys[idx] < bound_min_y ? ys[idx] : bound_min_y;
+                    bound_max_y = ys[idx] > bound_max_y ? ys[idx] : bound_max_y;
+                }
+                float64_t dense_chunks =
+                    ((float64_t)bound_max_x - bound_min_x + 1) * ((float64_t)bound_max_y - bound_min_y + 1);
+
+                float32_t lookups = (float32_t)passes * count;
+                printf(
+                    "%-9s %7u %5.2f %10.0f %8.1f %8.1f %8.1f %6.2f %9.1f %6.1f %8.1f %10.0f %11s\n",
+                    pattern == BenchWorldPattern_Scattered ? "scattered" : "block",
+                    world.chunk_count,
+                    (float32_t)world.chunk_count / slot_count,
+                    (float32_t)count / (insert_ms / 1000.0f),
+                    1000000.0f * hit_ms / lookups,
+                    1000000.0f * miss_ms / lookups,
+                    1000000.0f * neighbourhood_ms / count,
+                    (float32_t)neighbours / count,
+                    1000000.0f * view_ms / BENCH_WORLD_VIEWS,
+                    (float32_t)view_chunks / BENCH_WORLD_VIEWS,
+                    (float32_t)arena.used / world.chunk_count,
+                    dense_chunks * sizeof(World_Chunk) / MegaBytes(1),
+                    BenchCheck(found == passes * count && missed == passes * count) ? "yes" : "NO");
+            }
+        }
+    }
+
+    Memory_Arena arena = {};
+    InitializeArena(&arena, arena_size, arena_memory);
+    World world;
+    WorldInit(&world, &arena, 1024);
+    printf(
+        "\ntile set/get and neighbour counts across chunk edges: %s\n",
+        BenchCheck(BenchWorldTilesMatch(&world, &arena)) ? "ok" : "BROKEN");
+    printf(
+        "sizeof(World_Chunk) %u, %u bytes per hash slot\n",
+        (uint32_t)sizeof(World_Chunk),
+        (uint32_t)sizeof(World_Hash_Slot));
+
+    VirtualFree(xs, 0, MEM_RELEASE);
+    VirtualFree(arena_memory, 0, MEM_RELEASE);
+}
+
+/// Sound streams
+#define BENCH_SOUND_OUTPUT_RATE   48000
+#define BENCH_SOUND_FRAME_SAMPLES (BENCH_SOUND_OUTPUT_RATE / 30)
+
+struct Bench_Sound_File {
+    const char* file_name;
+    uint32_t    channel_count;
+    uint32_t    samples_per_second;
+    uint32_t    seconds;
+    bool        loop;
+    uint32_t    padding_chunk_size; // NOTE: a LIST chunk before fmt, so the header takes more than one read
+};
+
+// NOTE: a sweep on the left, noise on the right, both deterministic
+internal int16_t*
+BenchMakeSoundSamples(Bench_Sound_File* sound_file, uint32_t frame_count) {
+    int16_t* samples = (int16_t*)VirtualAlloc(
+        0, frame_count * sound_file->channel_count * sizeof(int16_t), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    uint32_t  random = 0xBADC0DE;
+    float32_t phase  = 0.0f;
+    for (uint32_t frame_idx = 0; frame_idx < frame_count; ++frame_idx) {
+        float32_t hz = 100.0f + 4000.0f * (float32_t)frame_idx / (float32_t)frame_count;
+        phase += 2.0f * PI * hz / (float32_t)sound_file->samples_per_second;
+        if (phase > 2.0f * PI) {
+            phase -= 2.0f * PI;
+        }
+        samples[frame_idx * sound_file->channel_count] = (int16_t)(30000.0f * sinf(phase));
+        if (sound_file->channel_count == 2) {
+            random ^= random << 13;
+            random ^= random >> 17;
+            random ^= random << 5;
+            samples[frame_idx * 2 + 1] = (int16_t)(random & 0xFFFF);
+        }
+    }
+    return samples;
+}
+
+internal bool
+BenchWriteWav(Bench_Sound_File* sound_file, int16_t* samples, uint32_t frame_count) {
+    uint32_t data_size   = frame_count * sound_file->channel_count * (uint32_t)sizeof(int16_t);
+    uint32_t chunk_bytes = (uint32_t)(3 * sizeof(Wave_Chunk) + sizeof(Wave_Fmt)) + sound_file->padding_chunk_size;
+    uint32_t riff_size   = 4 + chunk_bytes + data_size; // NOTE: counts the WAVE id, not the RIFF chunk header
+
+    Wave_Fmt fmt             = {};
+    fmt.format_tag           = 1;
+    fmt.channel_count        = (uint16_t)sound_file->channel_count;
+    fmt.samples_per_second   = sound_file->samples_per_second;
+    fmt.block_align          = (uint16_t)(sound_file->channel_count * sizeof(int16_t));
+    fmt.avg_bytes_per_second = fmt.samples_per_second * fmt.block_align;
+    fmt.bits_per_sample      = 16;
+
+    Wave_Chunk  list_chunk = {RIFF_CODE('L', 'I', 'S', 'T'), sound_file->padding_chunk_size};
+    Wave_Chunk  fmt_chunk  = {WAVE_ChunkID_fmt, sizeof(Wave_Fmt)};
+    Wave_Chunk  data_chunk = {WAVE_ChunkID_data, data_size};
+    Wave_Header header     = {};
+    header.riff_id         = WAVE_ChunkID_RIFF;
+    header.wave_id         = WAVE_ChunkID_WAVE;
+    header.size            = riff_size;
+
+    uint8_t* padding = (uint8_t*)VirtualAlloc(
+        0, sound_file->padding_chunk_size + 1, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    struct {
+        const void* memory;
+        uint32_t    size;
+    } parts[] = {
+        {&header, sizeof(header)},
+        {&list_chunk, sizeof(list_chunk)},
+        {padding, sound_file->padding_chunk_size},
+        {&fmt_chunk, sizeof(fmt_chunk)},
+        {&fmt, sizeof(fmt)},
+        {&data_chunk, sizeof(data_chunk)},
+        {samples, data_size},
+    };
+
+    bool   written     = false;
+    HANDLE file_handle = CreateFileA(
+        sound_file->file_name, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file_handle != INVALID_HANDLE_VALUE) {
+        written = true;
+        for (int part_idx = 0; written && part_idx < ArrayCount(parts); ++part_idx) {
+            DWORD bytes_written = 0;
+            written = WriteFile(file_handle, parts[part_idx].memory, parts[part_idx].size, &bytes_written, NULL) &&
+                      bytes_written == parts[part_idx].size;
+        }
+        CloseHandle(file_handle);
+    }
+    VirtualFree(padding, 0, MEM_RELEASE);
+    return written;
+}
+
+// NOTE: scalar version of what SoundStreamMix does, with the whole file in memory. Same float ops in the same
+// order, so the results have to be identical.
+internal void
+BenchResampleReference(
+    int16_t*          source,
+    uint64_t          source_frame_count,
+    Bench_Sound_File* sound_file,
+    float32_t         volume,
+    int16_t*          samples,
+    uint32_t          sample_count) {
+
+    uint64_t step     = ((uint64_t)sound_file->samples_per_second << 32) / BENCH_SOUND_OUTPUT_RATE;
+    uint64_t position = 0;
+    for (uint32_t sample_idx = 0; sample_idx < sample_count; ++sample_idx) {
+        uint64_t  frame    = (position >> 32) % source_frame_count;
+        uint64_t  next     = frame + 1;
+        float32_t fraction = (float32_t)(uint32_t)position * (1.0f / 4294967296.0f);
+        for (uint32_t channel_idx = 0; channel_idx < 2; ++channel_idx) {
+            uint32_t  source_channel = sound_file->channel_count == 2 ? channel_idx : 0;
+            float32_t current        = (float32_t)source[frame * sound_file->channel_count + source_channel];
+            float32_t following      = 0.0f;
+            if (next < source_frame_count || sound_file->loop) {
+                following = (float32_t)source[(next % source_frame_count) * sound_file->channel_count + source_channel];
+            }
+
+            int32_t value = _mm_cvtss_si32(_mm_set_ss((current + (following - current) * fraction) * volume));
+            value         = value > 32767 ? 32767 : (value < -32768 ? -32768 : value);
+            samples[2 * sample_idx + channel_idx] = (int16_t)value;
+        }
+        position += step;
+    }
+}
+
+internal void
+BenchSoundStreams(void) {
+    Bench_Sound_File sound_files[] = {
+        {"bench_mono_22050.wav", 1, 22050, 20, true, 0},
+        {"bench_stereo_44100.wav", 2, 44100, 60, false, 1000},
+        {"bench_stereo_96000.wav", 2, 96000, 10, false, 0},
+        {"bench_stereo_11025.wav", 2, 11025, 30, true, 700},
+    };
+
+    BenchInitFileIO();
+    local_persist Platform_Work_Queue work_queue;
+    Game_Memory                       memory;
+    BenchInitGameMemory(&memory, &work_queue);
+    Sound_Stream* stream = (Sound_Stream*)memory.transient_storage;
+
+    printf(
+        "%-24s %5s %6s %8s %9s %11s %12s %9s %8s %8s\n",
+        "file",
+        "rate",
+        "loop",
+        "file MB",
+        "played s",
+        "SSE ns/out",
+        "scalar ns/out",
+        "underruns",
+        "stalls",
+        "matches");
+    for (int file_idx = 0; file_idx < ArrayCount(sound_files); ++file_idx) {
+        Bench_Sound_File* sound_file  = &sound_files[file_idx];
+        uint32_t          frame_count = sound_file->samples_per_second * sound_file->seconds;
+        int16_t*          source      = BenchMakeSoundSamples(sound_file, frame_count);
+        if (!BenchCheck(BenchWriteWav(sound_file, source, frame_count))) {
+            printf("unable to write %s\n", sound_file->file_name);
+            VirtualFree(source, 0, MEM_RELEASE);
+            continue;
+        }
+
+        // NOTE: loops play one and a half times through
+        uint64_t played_frames = (uint64_t)frame_count * BENCH_SOUND_OUTPUT_RATE / sound_file->samples_per_second;
+        uint32_t sample_count  = (uint32_t)(sound_file->loop ? played_frames + played_frames / 2 : played_frames);
+        int16_t* reference     = (int16_t*)VirtualAlloc(
+            0, 2 * sample_count * sizeof(int16_t), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        int16_t* streamed = (int16_t*)VirtualAlloc(
+            0, 2 * sample_count * sizeof(int16_t), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+        Bench_Timer timer = BenchBegin();
+        BenchResampleReference(source, frame_count, sound_file, GAME_MUSIC_VOLUME, reference, sample_count);
+        float32_t scalar_ms = BenchEndMs(timer);
+
+        // NOTE: a frame's worth at a time like the game, spinning on the i/o when the ring runs dry
+        SoundStreamOpen(stream, &memory, sound_file->file_name, sound_file->loop);
+        stream->volume = GAME_MUSIC_VOLUME;
+
+        float32_t mix_ms = 0.0f;
+        uint32_t  stalls = 0;
+        uint32_t  mixed  = 0;
+        while (mixed < sample_count && stream->state != SoundStream_Failed) {
+            SoundStreamUpdate(stream, &memory);
+            uint32_t frame_samples = sample_count - mixed;
+            if (frame_samples > BENCH_SOUND_FRAME_SAMPLES) {
+                frame_samples = BENCH_SOUND_FRAME_SAMPLES;
+            }
+
+            timer          = BenchBegin();
+            uint32_t count = SoundStreamMix(stream, streamed + 2 * mixed, frame_samples, BENCH_SOUND_OUTPUT_RATE);
+            mix_ms += BenchEndMs(timer);
+
+            mixed += count;
+            if (count < frame_samples && stream->state == SoundStream_Playing) {
+                ++stalls;
+            } else if (stream->state == SoundStream_Finished) {
+                break;
+            }
+        }
+        uint32_t underrun_count = stream->underrun_count;
+        bool     matches        = mixed == sample_count && stream->state != SoundStream_Failed &&
+                       memcmp(reference, streamed, 2 * sample_count * sizeof(int16_t)) == 0;
+        SoundStreamClose(stream, &memory);
+
+        printf(
+            "%-24s %5u %6s %8.1f %9.1f %11.2f %12.2f %9u %8u %8s\n",
+            sound_file->file_name,
+            sound_file->samples_per_second,
+            sound_file->loop ? "yes" : "no",
+            (float32_t)frame_count * sound_file->channel_count * sizeof(int16_t) / MegaBytes(1),
+            (float32_t)sample_count / BENCH_SOUND_OUTPUT_RATE,
+            1000000.0f * mix_ms / sample_count,
+            1000000.0f * scalar_ms / sample_count,
+            underrun_count,
+            stalls,
+            BenchCheck(matches) ? "yes" : "NO");
+
+        VirtualFree(streamed, 0, MEM_RELEASE);
+        VirtualFree(reference, 0, MEM_RELEASE);
+        VirtualFree(source, 0, MEM_RELEASE);
+    }
+    printf("\n%u bytes per stream whatever the length of the file\n", (uint32_t)sizeof(Sound_Stream));
+
+    VirtualFree(memory.permanent_storage, 0, MEM_RELEASE);
+    VirtualFree(memory.transient_storage, 0, MEM_RELEASE);
+}
+
+/// Debug overlay
+#define BENCH_OVERLAY_WIDTH     1280
+#define BENCH_OVERLAY_HEIGHT    720
+#define BENCH_OVERLAY_REPEATS   200
+#define BENCH_OVERLAY_TARGET_MS (1000.0f / 30.0f)
+
+// NOTE: a full graph of frames that wander around the target, some of them over
+internal void
+BenchFillOverlayFrames(Debug_Overlay* overlay) {
+    uint32_t random = 0x2545F491;
+    for (int frame_idx = 0; frame_idx < DEBUG_FRAME_GRAPH_LENGTH; ++frame_idx) {
+        float32_t phase_ms[Win32FramePhase_Count];
+        float32_t work_ms = 0.0f;
+        for (int phase_idx = 0; phase_idx < Win32FramePhase_Count; ++phase_idx) {
+            random ^= random << 13;
+            random ^= random >> 17;
+            random ^= random << 5;
+            phase_ms[phase_idx] = 0.5f + (float32_t)(random % 1000) / 100.0f;
+            work_ms += phase_ms[phase_idx];
+        }
+        float32_t frame_ms = work_ms > BENCH_OVERLAY_TARGET_MS ? work_ms : BENCH_OVERLAY_TARGET_MS;
+        DebugOverlayRecordFrame(overlay, frame_ms, phase_ms);
+    }
+}
+
+internal void
+BenchDebugOverlay(void) {
+    int         pixel_formats[]                        = {GamePixelFormat_BGRX8888, GamePixelFormat_RGB565};
+    const char* format_names[]                         = {"BGRX8888", "RGB565"};
+    const char* detail_names[DebugOverlayDetail_Count] = {"text", "graph", "full"};
+
+    Debug_Overlay* overlay =
+        (Debug_Overlay*)VirtualAlloc(0, sizeof(Debug_Overlay), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    Game_Offscreen_Buffer buffer = {};
+    buffer.width                 = BENCH_OVERLAY_WIDTH;
+    buffer.height                = BENCH_OVERLAY_HEIGHT;
+    buffer.pitch                 = AlignPow2(BENCH_OVERLAY_WIDTH * 4, FRAMEBUFFER_ROW_ALIGNMENT);
+    buffer.memory = VirtualAlloc(0, buffer.pitch * buffer.height, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+    Win32_Sound_Output sound_output    = {};
+    sound_output.secondary_buffer_size = 48000 * 4;
+    Debug_Audio_Marker markers[15]     = {};
+    for (int marker_idx = 0; marker_idx < ArrayCount(markers); ++marker_idx) {
+        uint32_t cursor                               = (uint32_t)marker_idx * 6400;
+        markers[marker_idx].output_play_cursor        = cursor;
+        markers[marker_idx].output_write_cursor       = cursor + 3840;
+        markers[marker_idx].output_location           = cursor + 7680;
+        markers[marker_idx].output_bytes              = 6400;
+        markers[marker_idx].expected_flip_play_cursor = cursor + 6400;
+        markers[marker_idx].flip_play_cursor          = cursor + 6000;
+        markers[marker_idx].flip_write_cursor         = cursor + 9840;
+    }
+
+    Win32_Offscreen_Buffer backbuffer = {};
+    backbuffer.memory                 = buffer.memory;
+    backbuffer.width                  = buffer.width;
+    backbuffer.height                 = buffer.height;
+    backbuffer.pitch                  = buffer.pitch;
+
+    printf(
+        "%-9s %-6s %6s %6s %6s %9s %10s %8s\n",
+        "format",
+        "detail",
+        "rects",
+        "lines",
+        "texts",
+        "ms/frame",
+        "% of frame",
+        "dropped");
+    for (int format_idx = 0; format_idx < ArrayCount(pixel_formats); ++format_idx) {
+        backbuffer.pixel_format    = pixel_formats[format_idx];
+        backbuffer.bytes_per_pixel = pixel_formats[format_idx] == GamePixelFormat_RGB565 ? 2 : 4;
+        for (int detail = 0; detail < DebugOverlayDetail_Count; ++detail) {
+            DebugOverlayInit(
+                overlay,
+                BENCH_OVERLAY_TARGET_MS,
+                DEBUG_OVERLAY_BUDGET_FRACTION,
+                Win32FramePhase_Count,
+                g_frame_phase_names);
+            BenchFillOverlayFrames(overlay);
+
+            // NOTE: holds the governor off so the detail stays where it was put while measuring
+            overlay->detail          = detail;
+            overlay->cooldown_frames = BENCH_OVERLAY_REPEATS + 1;
+
+            Bench_Timer timer = BenchBegin();
+            for (int repeat_idx = 0; repeat_idx < BENCH_OVERLAY_REPEATS; ++repeat_idx) {
+                Win32DrawDebugOverlay(
+                    overlay,
+                    &backbuffer,
+                    markers,
+                    ArrayCount(markers),
+                    repeat_idx % (int)ArrayCount(markers),
+                    &sound_output,
+                    1.0f,
+                    0.05f);
+            }
+            float32_t ms = BenchEndMs(timer) / BENCH_OVERLAY_REPEATS;
+
+            printf(
+                "%-9s %-6s %6u %6u %6u %9.3f %9.2f%% %8u\n",
+                format_names[format_idx],
+                detail_names[detail],
+                overlay->rect_count,
+                overlay->line_count,
+                overlay->text_count,
+                ms,
+                100.0f * ms / BENCH_OVERLAY_TARGET_MS,
+                overlay->dropped_count);
+        }
+    }
+
+    // NOTE: feeds the governor costs directly, over budget it has to step down to text and come back up once the cost
+    // drops again
+    DebugOverlayInit(
+        overlay, BENCH_OVERLAY_TARGET_MS, DEBUG_OVERLAY_BUDGET_FRACTION, Win32FramePhase_Count, g_frame_phase_names);
+    float32_t budget_ms      = DEBUG_OVERLAY_BUDGET_FRACTION * BENCH_OVERLAY_TARGET_MS;
+    int       frames_to_drop = 0;
+    for (; frames_to_drop < 1000 && overlay->detail != DebugOverlayDetail_Text; ++frames_to_drop) {
+        DebugOverlayEndFrame(overlay, 2.0f * budget_ms);
+    }
+    int frames_to_raise = 0;
+    for (; frames_to_raise < 10000 && overlay->detail != DebugOverlayDetail_Full; ++frames_to_raise) {
+        DebugOverlayEndFrame(overlay, 0.25f * budget_ms);
+    }
+    printf(
+        "\ngovernor at %.2fms budget: down to text in %d frames, back to full in %d frames (%s)\n",
+        budget_ms,
+        frames_to_drop,
+        frames_to_raise,
+        BenchCheck(overlay->detail == DebugOverlayDetail_Full) ? "ok" : "STUCK");
+
+    VirtualFree(buffer.memory, 0, MEM_RELEASE);
+    VirtualFree(overlay, 0, MEM_RELEASE);
+}
+
+/// Memory report
+// NOTE: runs the game for a while and writes the report the game writes on exit and on F2, what it costs is mostly
+// asking the OS which pages of the storage are resident
+#define BENCH_MEMORY_FRAME_COUNT  60
+#define BENCH_MEMORY_REPORT_NAME "bench_memory.txt"
+
+internal void
+BenchMemoryReport(void) {
+    Bench_Game* game = BenchLoadGame();
+    if (!game) {
+        return;
+    }
+
+    Game_Input* input = (Game_Input*)VirtualAlloc(0, sizeof(Game_Input), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    Win32_Offscreen_Buffer backbuffer = {};
+    Win32ResizeDIBSection(&backbuffer, 1280, 720, GamePixelFormat_BGRX8888);
+    Game_Offscreen_Buffer game_buffer = BenchGetGameBuffer(&backbuffer);
+    for (int frame_idx = 0; frame_idx < BENCH_MEMORY_FRAME_COUNT; ++frame_idx) {
+        *input = {};
+        Win32BeginMemoryFrame();
+        game->code.GameUpdateAndRender(&game->memory, input, &game_buffer);
+    }
+
+    char        report[8192];
+    Bench_Timer timer  = BenchBegin();
+    int         length = Win32FormatMemoryReport(&game->memory, report, sizeof(report));
+    float32_t   ms     = BenchEndMs(timer);
+    bool        wrote  = Win32WriteMemoryReport(BENCH_MEMORY_REPORT_NAME, &game->memory);
+
+    printf("%s", report);
+    printf(
+        "\n%d bytes, %.2fms to gather (%.0fMB of storage checked), %s %s\n",
+        length,
+        ms,
+        (float32_t)(game->memory.permanent_storage_size + game->memory.transient_storage_size) / MegaBytes(1),
+        wrote ? "written to" : "COULDN'T WRITE",
+        BENCH_MEMORY_REPORT_NAME);
+
+    Win32FreeMemory(backbuffer.memory, Win32MemoryTag_Framebuffer);
+    VirtualFree(input, 0, MEM_RELEASE);
+}
+
+/// Blending
+// NOTE: every mode against a scalar version of the same math, on a width that leaves a tail, then how far the gamma 2
+// approximation is from the real sRGB curve for alpha blending and how fast each mode goes
+#define BENCH_BLEND_WIDTH   1277
+#define BENCH_BLEND_HEIGHT  720
+#define BENCH_BLEND_REPEATS 20
+#define BENCH_BLEND_SRGB_MAX 12 // levels off the exact curve, handmade_blend.h says about 10
+#define BENCH_BLEND_CLIP_X   7  // the clipped check's bitmap starts this far right
+#define BENCH_BLEND_CLIP_Y   5  // and this far above the top
+
+internal float32_t
+BenchSRGBToLinear(float32_t value) {
+    return value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+}
+
+internal float32_t
+BenchLinearToSRGB(float32_t value) {
+    return value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+}
+
+// NOTE: one pixel at a time from the straight alpha source, premultiplied in floats, is_exact_srgb uses the real curve
+// instead of squaring
+internal void
+BenchBlendReference(Blend_Mode mode, uint32_t* source, uint32_t* dest, int count, bool is_exact_srgb) {
+    for (int idx = 0; idx < count; ++idx) {
+        float32_t alpha  = (float32_t)(source[idx] >> 24) / 255.0f;
+        uint32_t  result = 0;
+        for (int shift = 0; shift <= 16; shift += 8) {
+            float32_t over  = (float32_t)((source[idx] >> shift) & 0xFF) / 255.0f;
+            float32_t under = (float32_t)((dest[idx] >> shift) & 0xFF) / 255.0f;
+            over            = alpha * (is_exact_srgb ? BenchSRGBToLinear(over) : over * over);
+            under           = is_exact_srgb ? BenchSRGBToLinear(under) : under * under;
+
+            float32_t value = over;
+            if (mode == BlendMode_Alpha) {
+                value = over + under * (1.0f - alpha);
+            } else if (mode == BlendMode_Additive) {
+                value = over + under;
+            }
+            value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+            value = is_exact_srgb ? BenchLinearToSRGB(value) : sqrtf(value);
+            result |= (uint32_t)(value * 255.0f + 0.5f) << shift;
+        }
+        dest[idx] = result;
+    }
+}
+
+internal int
+BenchMaxChannelDifference(uint32_t* a, uint32_t* b, int count) {
+    int result = 0;
+    for (int idx = 0; idx < count; ++idx) {
+        for (int shift = 0; shift <= 16; shift += 8) {
+            int difference = (int)((a[idx] >> shift) & 0xFF) - (int)((b[idx] >> shift) & 0xFF);
+            difference     = difference < 0 ? -difference : difference;
+            result         = difference > result ? difference : result;
+        }
+    }
+    return result;
+}
+
+internal void
+BenchBlend(void) {
+    int       pixel_count = BENCH_BLEND_WIDTH * BENCH_BLEND_HEIGHT;
+    uint32_t  pixel_bytes = pixel_count * (uint32_t)sizeof(uint32_t);
+    uint32_t* source      = (uint32_t*)VirtualAlloc(0, 5 * pixel_bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    uint32_t* background  = source + pixel_count;
+    uint32_t* blended     = background + pixel_count;
+    uint32_t* reference   = blended + pixel_count;
+    uint32_t* sprite      = reference + pixel_count;
+
+    // NOTE: alpha is often 0 or 255 in real sprites, a quarter of each here
+    uint32_t random = 0x6D2B79F5;
+    for (int idx = 0; idx < pixel_count; ++idx) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        uint32_t alpha = random >> 24;
+        alpha          = (random & 3) == 0 ? 0 : ((random & 3) == 1 ? 255 : alpha);
+        source[idx]    = (alpha << 24) | (random & 0xFFFFFF);
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        background[idx] = random & 0xFFFFFF;
+        sprite[idx]     = BitmapPremultiply(source[idx]);
+    }
+
+    Game_Offscreen_Buffer buffer = {};
+    buffer.memory                = blended;
+    buffer.width                 = BENCH_BLEND_WIDTH;
+    buffer.height                = BENCH_BLEND_HEIGHT;
+    buffer.pitch                 = BENCH_BLEND_WIDTH * sizeof(uint32_t);
+    buffer.bytes_per_pixel       = 4;
+    buffer.pixel_format          = GamePixelFormat_BGRX8888;
+
+    Loaded_Bitmap bitmap = {};
+    bitmap.width         = BENCH_BLEND_WIDTH;
+    bitmap.height        = BENCH_BLEND_HEIGHT;
+    bitmap.pitch         = BENCH_BLEND_WIDTH * sizeof(uint32_t);
+    bitmap.memory        = sprite;
+
+    // NOTE: clipped on the right and the top with an odd width, so every row has a partial group at both ends
+    Loaded_Bitmap clipped = bitmap;
+    clipped.width         = BENCH_BLEND_WIDTH - 3;
+    int clipped_count     = BENCH_BLEND_WIDTH - BENCH_BLEND_CLIP_X;
+
+    const char* mode_names[] = {"opaque", "alpha", "additive"};
+    printf(
+        "%-9s %10s %10s %10s %8s %12s %12s\n",
+        "mode",
+        "vs scalar",
+        "vs sRGB",
+        "clipped",
+        "matches",
+        "simd Mpx/s",
+        "scalar Mpx/s");
+    for (int mode = BlendMode_Opaque; mode <= BlendMode_Additive; ++mode) {
+        memcpy(blended, background, pixel_bytes);
+        BlendBitmap(&buffer, &clipped, BENCH_BLEND_CLIP_X, -BENCH_BLEND_CLIP_Y, (Blend_Mode)mode);
+        memcpy(reference, background, pixel_bytes);
+        for (int y = 0; y < BENCH_BLEND_HEIGHT - BENCH_BLEND_CLIP_Y; ++y) {
+            uint32_t* source_row = source + (y + BENCH_BLEND_CLIP_Y) * BENCH_BLEND_WIDTH;
+            uint32_t* dest_row   = reference + y * BENCH_BLEND_WIDTH + BENCH_BLEND_CLIP_X;
+            BenchBlendReference((Blend_Mode)mode, source_row, dest_row, clipped_count, false);
+        }
+        int clipped_difference = BenchMaxChannelDifference(blended, reference, pixel_count);
+
+        memcpy(blended, background, pixel_bytes);
+        BlendBitmap(&buffer, &bitmap, 0, 0, (Blend_Mode)mode);
+        memcpy(reference, background, pixel_bytes);
+        BenchBlendReference((Blend_Mode)mode, source, reference, pixel_count, false);
+        int scalar_difference = BenchMaxChannelDifference(blended, reference, pixel_count);
+
+        memcpy(reference, background, pixel_bytes);
+        BenchBlendReference((Blend_Mode)mode, source, reference, pixel_count, true);
+        int srgb_difference = BenchMaxChannelDifference(blended, reference, pixel_count);
+
+        Bench_Timer timer = BenchBegin();
+        for (int repeat_idx = 0; repeat_idx < BENCH_BLEND_REPEATS; ++repeat_idx) {
+            BlendBitmap(&buffer, &bitmap, 0, 0, (Blend_Mode)mode);
+        }
+        float32_t simd_ms = BenchEndMs(timer);
+
+        timer = BenchBegin();
+        for (int repeat_idx = 0; repeat_idx < BENCH_BLEND_REPEATS; ++repeat_idx) {
+            BenchBlendReference((Blend_Mode)mode, source, reference, pixel_count, false);
+        }
+        float32_t scalar_ms = BenchEndMs(timer);
+
+        float32_t megapixels = (float32_t)pixel_count * BENCH_BLEND_REPEATS / 1000000.0f;
+
+        // NOTE: the SIMD path rounds differently from the scalar one by a level at most
+        bool matches = scalar_difference <= 1 && clipped_difference <= 1 && srgb_difference <= BENCH_BLEND_SRGB_MAX;
+        printf(
+            "%-9s %10d %10d %10d %8s %12.1f %12.1f\n",
+            mode_names[mode],
+            scalar_difference,
+            srgb_difference,
+            clipped_difference,
+            BenchCheck(matches) ? "yes" : "NO",
+            1000.0f * megapixels / simd_ms,
+            1000.0f * megapixels / scalar_ms);
+    }
+
+    VirtualFree(source, 0, MEM_RELEASE);
+}
+
+/// Bitmaps
+// NOTE: BMPs written in memory in the layouts the loader takes are decoded and checked against the premultiplied
+// source, then blit throughput for sprites from 16x16 to the whole screen, with the destination on a 16-byte boundary
+// and one pixel off it
+#define BENCH_BITMAP_CHECK_WIDTH   37 // NOTE: odd so 24-bit rows are padded
+#define BENCH_BITMAP_CHECK_HEIGHT  19
+#define BENCH_BITMAP_LOAD_DIM      1024
+#define BENCH_BITMAP_SCREEN_WIDTH  1280
+#define BENCH_BITMAP_SCREEN_HEIGHT 720
+#define BENCH_BITMAP_BLIT_PIXELS   (1 << 24) // NOTE: each size blits about this many pixels per measurement
+
+// NOTE: 32-bit files are BI_BITFIELDS with an alpha mask, 24-bit ones BI_RGB. Returns the file size.
+internal uint32_t
+BenchWriteBMP(uint8_t* memory, uint32_t* pixels, int width, int height, int bits_per_pixel, bool is_top_down) {
+    int            bytes_per_pixel = bits_per_pixel / 8;
+    int            file_pitch      = (width * bytes_per_pixel + 3) & ~3;
+    Bitmap_Header* header          = (Bitmap_Header*)memory;
+    uint32_t       header_size     = bits_per_pixel == 32 ? (uint32_t)sizeof(Bitmap_Header) : 54;
+    *header                        = {};
+    header->file_type              = 0x4D42;
+    header->file_size              = header_size + file_pitch * height;
+    header->bitmap_offset          = header_size;
+    header->size                   = header_size - 14;
+    header->width                  = width;
+    header->height                 = is_top_down ? -height : height;
+    header->planes                 = 1;
+    header->bits_per_pixel         = (uint16_t)bits_per_pixel;
+    if (bits_per_pixel == 32) {
+        header->compression = 3;
+        header->red_mask    = 0x00FF0000;
+        header->green_mask  = 0x0000FF00;
+        header->blue_mask   = 0x000000FF;
+        header->alpha_mask  = 0xFF000000;
+    }
+
+    for (int y = 0; y < height; ++y) {
+        uint8_t* row = memory + header_size + (is_top_down ? y : height - 1 - y) * file_pitch;
+        memset(row, 0, file_pitch);
+        for (int x = 0; x < width; ++x) {
+            memcpy(row + x * bytes_per_pixel, &pixels[y * width + x], bytes_per_pixel);
+        }
+    }
+    return header->file_size;
+}
+
+internal void
+BenchBitmap(void) {
+    uint32_t  screen_count = BENCH_BITMAP_SCREEN_WIDTH * BENCH_BITMAP_SCREEN_HEIGHT;
+    uint32_t  load_count   = BENCH_BITMAP_LOAD_DIM * BENCH_BITMAP_LOAD_DIM;
+    uint32_t  file_bytes   = (uint32_t)sizeof(Bitmap_Header) + load_count * (uint32_t)sizeof(uint32_t);
+    uint32_t  total_bytes  = (2 * screen_count + 2 * load_count) * (uint32_t)sizeof(uint32_t) + file_bytes;
+    uint8_t*  memory       = (uint8_t*)VirtualAlloc(0, total_bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    uint32_t* screen       = (uint32_t*)memory;
+    uint32_t* sprite       = screen + screen_count;
+    uint32_t* source       = sprite + screen_count;
+    uint32_t* decoded      = source + load_count;
+    uint8_t*  file         = (uint8_t*)(decoded + load_count);
+
+    // NOTE: straight alpha, a quarter clear and a quarter opaque like in the blend bench
+    uint32_t random = 0x2545F491;
+    for (uint32_t idx = 0; idx < load_count; ++idx) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        uint32_t alpha = random >> 24;
+        alpha          = (random & 3) == 0 ? 0 : ((random & 3) == 1 ? 255 : alpha);
+        source[idx]    = (alpha << 24) | (random & 0xFFFFFF);
+    }
+
+    const char* format_names[] = {"32-bit bottom-up", "24-bit bottom-up", "32-bit top-down", "24-bit top-down"};
+    printf("%-24s %10s %10s\n", "file", "matches", "Mpx/s");
+    for (int format_idx = 0; format_idx < ArrayCount(format_names); ++format_idx) {
+        int  bits_per_pixel = (format_idx & 1) ? 24 : 32;
+        bool is_top_down    = (format_idx & 2) != 0;
+
+        // NOTE: the small one is checked pixel by pixel, the big one is timed
+        uint32_t file_size = BenchWriteBMP(
+            file, source, BENCH_BITMAP_CHECK_WIDTH, BENCH_BITMAP_CHECK_HEIGHT, bits_per_pixel, is_top_down);
+        Loaded_Bitmap bitmap  = {};
+        bool          matches = !BitmapReadBMPSize(file, file_size - 1, &bitmap);
+        matches               = matches && BitmapReadBMPSize(file, file_size, &bitmap);
+        matches = matches && bitmap.width == BENCH_BITMAP_CHECK_WIDTH && bitmap.height == BENCH_BITMAP_CHECK_HEIGHT;
+        bitmap.pitch  = (int)AlignPow2(bitmap.width * sizeof(uint32_t), 16);
+        bitmap.memory = decoded;
+        BitmapDecodeBMP(file, &bitmap);
+        for (int y = 0; y < bitmap.height; ++y) {
+            uint32_t* row = (uint32_t*)((uint8_t*)bitmap.memory + y * bitmap.pitch);
+            for (int x = 0; x < bitmap.width; ++x) {
+                uint32_t expected = source[y * BENCH_BITMAP_CHECK_WIDTH + x];
+                expected          = BitmapPremultiply(bits_per_pixel == 24 ? (expected | 0xFF000000) : expected);
+                matches           = matches && row[x] == expected;
+            }
+        }
+
+        file_size =
+            BenchWriteBMP(file, source, BENCH_BITMAP_LOAD_DIM, BENCH_BITMAP_LOAD_DIM, bits_per_pixel, is_top_down);
+        Bench_Timer timer = BenchBegin();
+        BitmapReadBMPSize(file, file_size, &bitmap);
+        bitmap.pitch  = bitmap.width * (int)sizeof(uint32_t);
+        bitmap.memory = decoded;
+        BitmapDecodeBMP(file, &bitmap);
+        float32_t ms = BenchEndMs(timer);
+        printf(
+            "%-24s %10s %10.1f\n",
+            format_names[format_idx],
+            BenchCheck(matches) ? "yes" : "NO",
+            load_count / (1000.0f * ms));
+    }
+
+    for (uint32_t idx = 0; idx < screen_count; ++idx) {
+        sprite[idx] = BitmapPremultiply(source[idx]);
+        screen[idx] = source[load_count - 1 - idx] & 0xFFFFFF;
+    }
+
+    Game_Offscreen_Buffer buffer = {};
+    buffer.memory                = screen;
+    buffer.width                 = BENCH_BITMAP_SCREEN_WIDTH;
+    buffer.height                = BENCH_BITMAP_SCREEN_HEIGHT;
+    buffer.pitch                 = BENCH_BITMAP_SCREEN_WIDTH * sizeof(uint32_t);
+    buffer.bytes_per_pixel       = 4;
+    buffer.pixel_format          = GamePixelFormat_BGRX8888;
+
+    // NOTE: sprites share the full screen one's pitch, only their size changes
+    int sprite_dims[][2] = {
+        {16, 16},
+        {64, 64},
+        {256, 256},
+        {BENCH_BITMAP_SCREEN_WIDTH, BENCH_BITMAP_SCREEN_HEIGHT},
+    };
+    printf("\n%-10s %-10s %10s %10s %10s  (pixels/cycle)\n", "sprite", "dest", "opaque", "alpha", "additive");
+    for (int dim_idx = 0; dim_idx < ArrayCount(sprite_dims); ++dim_idx) {
+        Loaded_Bitmap bitmap = {};
+        bitmap.width         = sprite_dims[dim_idx][0];
+        bitmap.height        = sprite_dims[dim_idx][1];
+        bitmap.pitch         = BENCH_BITMAP_SCREEN_WIDTH * sizeof(uint32_t);
+        bitmap.memory        = sprite;
+
+        uint32_t sprite_count = (uint32_t)(bitmap.width * bitmap.height);
+        uint32_t repeats      = BENCH_BITMAP_BLIT_PIXELS / sprite_count;
+        repeats               = repeats ? repeats : 1;
+        for (int offset = 0; offset <= 1; ++offset) {
+            char dim_name[32];
+            sprintf_s(dim_name, sizeof(dim_name), "%dx%d", bitmap.width, bitmap.height);
+            printf("%-10s %-10s", dim_name, offset ? "unaligned" : "aligned");
+            for (int mode = BlendMode_Opaque; mode <= BlendMode_Additive; ++mode) {
+                uint64_t start = __rdtsc();
+                for (uint32_t repeat_idx = 0; repeat_idx < repeats; ++repeat_idx) {
+                    BlendBitmap(&buffer, &bitmap, offset, 0, (Blend_Mode)mode);
+                }
+                uint64_t cycles = __rdtsc() - start;
+                printf(" %10.3f", (float64_t)sprite_count * repeats / (float64_t)cycles);
+            }
+            printf("\n");
+        }
+    }
+    VirtualFree(memory, 0, MEM_RELEASE);
+}
+
+/// Sprites
+// NOTE: a sprite drawn unscaled and unrotated has to come out like the blit, then fill rate for a rotated sprite at a
+// range of scales, with its mips and with only the full size level
+#define BENCH_SPRITE_DIM           1024 // NOTE: big enough that the full size level doesn't fit in cache
+#define BENCH_SPRITE_SCREEN_WIDTH  1280
+#define BENCH_SPRITE_SCREEN_HEIGHT 720
+#define BENCH_SPRITE_ANGLE         0.5f
+#define BENCH_SPRITE_PIXELS        (1 << 22) // NOTE: each scale fills about this many pixels per measurement
+
+internal void
+BenchSprite(void) {
+    uint32_t  screen_count = BENCH_SPRITE_SCREEN_WIDTH * BENCH_SPRITE_SCREEN_HEIGHT;
+    uint32_t  screen_bytes = screen_count * (uint32_t)sizeof(uint32_t);
+    uint32_t  arena_bytes  = 2 * BENCH_SPRITE_DIM * BENCH_SPRITE_DIM * (uint32_t)sizeof(uint32_t);
+    uint32_t  total_bytes  = 3 * screen_bytes + arena_bytes;
+    uint8_t*  memory       = (uint8_t*)VirtualAlloc(0, total_bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    uint32_t* screen       = (uint32_t*)memory;
+    uint32_t* background   = screen + screen_count;
+    uint32_t* reference    = background + screen_count;
+
+    Memory_Arena arena;
+    InitializeArena(&arena, arena_bytes, (uint8_t*)(reference + screen_count));
+
+    Sprite sprite           = {};
+    sprite.levels[0].width  = BENCH_SPRITE_DIM;
+    sprite.levels[0].height = BENCH_SPRITE_DIM;
+    sprite.levels[0].pitch  = BENCH_SPRITE_DIM * sizeof(uint32_t);
+    sprite.levels[0].memory = PushArray(&arena, BENCH_SPRITE_DIM * BENCH_SPRITE_DIM, uint32_t, MemoryTag_Bitmaps);
+
+    uint32_t  random = 0x9E3779B9;
+    uint32_t* texels = (uint32_t*)sprite.levels[0].memory;
+    for (int idx = 0; idx < BENCH_SPRITE_DIM * BENCH_SPRITE_DIM; ++idx) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        uint32_t alpha = random >> 24;
+        alpha          = (random & 3) == 0 ? 0 : ((random & 3) == 1 ? 255 : alpha);
+        texels[idx]    = BitmapPremultiply((alpha << 24) | (random & 0xFFFFFF));
+    }
+    for (uint32_t idx = 0; idx < screen_count; ++idx) {
+        background[idx] = (idx * 2654435761u) & 0xFFFFFF;
+    }
+
+    Bench_Timer timer = BenchBegin();
+    SpriteBuildMips(&sprite, &arena);
+    float32_t mip_ms = BenchEndMs(timer);
+
+    Game_Offscreen_Buffer buffer = {};
+    buffer.memory                = screen;
+    buffer.width                 = BENCH_SPRITE_SCREEN_WIDTH;
+    buffer.height                = BENCH_SPRITE_SCREEN_HEIGHT;
+    buffer.pitch                 = BENCH_SPRITE_SCREEN_WIDTH * sizeof(uint32_t);
+    buffer.bytes_per_pixel       = 4;
+    buffer.pixel_format          = GamePixelFormat_BGRX8888;
+
+    // NOTE: texel centers land on pixel centers, bilinear reads exactly one texel. The bottom is clipped.
+    int          expected = BENCH_SPRITE_DIM * (BENCH_SPRITE_SCREEN_HEIGHT - 37);
+    Sprite_Basis identity = {};
+    identity.origin_x     = 101.0f;
+    identity.origin_y     = 37.0f;
+    identity.x_axis_x     = (float32_t)BENCH_SPRITE_DIM;
+    identity.y_axis_y     = (float32_t)BENCH_SPRITE_DIM;
+    memcpy(screen, background, screen_bytes);
+    uint32_t covered = DrawSprite(&buffer, &sprite, identity);
+    buffer.memory    = reference;
+    memcpy(reference, background, screen_bytes);
+    BlendBitmap(&buffer, &sprite.levels[0], 101, 37, BlendMode_Alpha);
+    buffer.memory  = screen;
+    int difference = BenchMaxChannelDifference(screen, reference, (int)screen_count);
+    printf(
+        "%d levels built in %.2fms, unscaled draw covers %u of %d pixels, %d from the blit, %s\n",
+        sprite.level_count,
+        mip_ms,
+        covered,
+        expected,
+        difference,
+        BenchCheck(difference <= 1 && covered == (uint32_t)expected) ? "matches" : "DOESN'T MATCH");
+
+    Sprite full_size_only      = sprite;
+    full_size_only.level_count = 1;
+
+    float32_t scales[] = {1.0f / 32.0f, 1.0f / 16.0f, 0.125f, 0.25f, 0.5f};
+    printf(
+        "\n%-8s %10s %6s %12s %12s %14s\n", "scale", "pixels", "level", "Mpx/s", "px/cycle", "no mips px/c");
+    for (int scale_idx = 0; scale_idx < ArrayCount(scales); ++scale_idx) {
+        Sprite_Basis basis = SpriteBasisAround(
+            0.5f * BENCH_SPRITE_SCREEN_WIDTH,
+            0.5f * BENCH_SPRITE_SCREEN_HEIGHT,
+            BENCH_SPRITE_DIM,
+            BENCH_SPRITE_DIM,
+            scales[scale_idx],
+            BENCH_SPRITE_ANGLE);
+        memcpy(screen, background, screen_bytes);
+        uint32_t pixels  = DrawSprite(&buffer, &sprite, basis);
+        uint32_t repeats = BENCH_SPRITE_PIXELS / (pixels ? pixels : 1);
+        repeats          = repeats ? repeats : 1;
+
+        timer = BenchBegin();
+        for (uint32_t repeat_idx = 0; repeat_idx < repeats; ++repeat_idx) {
+            DrawSprite(&buffer, &sprite, basis);
+        }
+        uint64_t  cycles = __rdtsc() - timer.start_cycle_count;
+        float32_t ms     = BenchEndMs(timer);
+
+        uint64_t start = __rdtsc();
+        for (uint32_t repeat_idx = 0; repeat_idx < repeats; ++repeat_idx) {
+            DrawSprite(&buffer, &full_size_only, basis);
+        }
+        uint64_t full_size_cycles = __rdtsc() - start;
+
+        float64_t filled = (float64_t)pixels * repeats;
+        printf(
+            "%-8.4f %10u %6d %12.1f %12.3f %14.3f\n",
+            scales[scale_idx],
+            pixels,
+            SpriteSelectLevel(&sprite, &basis),
+            filled / (1000.0 * ms),
+            filled / (float64_t)cycles,
+            filled / (float64_t)full_size_cycles);
+    }
+
+    VirtualFree(memory, 0, MEM_RELEASE);
+}
+
+/// Lighting
+// NOTE: a 1080p frame tiled with a normal mapped sprite under a growing number of point lights, drawn on one thread
+// and split in tiles over the work queue, against the 30Hz frame budget. Worst case every light reaches every pixel.
+#define BENCH_LIGHTING_WIDTH        1920
+#define BENCH_LIGHTING_HEIGHT       1080
+#define BENCH_LIGHTING_SPRITE_DIM   128
+#define BENCH_LIGHTING_TILES_X      8
+#define BENCH_LIGHTING_TILES_Y      8
+#define BENCH_LIGHTING_RADIUS       200.0f
+#define BENCH_LIGHTING_EVERYWHERE   4000.0f // NOTE: a radius that reaches across the whole frame
+#define BENCH_LIGHTING_HEIGHT_ABOVE 32.0f
+#define BENCH_LIGHTING_REPEATS      4
+#define BENCH_LIGHTING_TARGET_MS    (1000.0f / 30.0f)
+
+struct Bench_Lighting_Tile {
+    Game_Offscreen_Buffer* buffer;
+    Sprite*                sprite;
+    Lighting*              lighting;
+    Clip_Rect              clip;
+};
+
+// NOTE: only the copies of the sprite that overlap the clip are drawn, each one culls the lights against the clip
+internal void
+BenchDrawLitTile(Game_Offscreen_Buffer* buffer, Sprite* sprite, Lighting* lighting, Clip_Rect clip) {
+    int dim = BENCH_LIGHTING_SPRITE_DIM;
+    for (int y = clip.min_y / dim; y <= (clip.max_y - 1) / dim; ++y) {
+        for (int x = clip.min_x / dim; x <= (clip.max_x - 1) / dim; ++x) {
+            Sprite_Basis basis = {};
+            basis.origin_x     = (float32_t)(x * dim);
+            basis.origin_y     = (float32_t)(y * dim);
+            basis.x_axis_x     = (float32_t)dim;
+            basis.y_axis_y     = (float32_t)dim;
+            DrawLitSprite(buffer, clip, sprite, basis, lighting);
+        }
+    }
+}
+
+internal PLATFORM_WORK_QUEUE_CALLBACK(BenchLightingTileJob) {
+    Bench_Lighting_Tile* tile = (Bench_Lighting_Tile*)data;
+    BenchDrawLitTile(tile->buffer, tile->sprite, tile->lighting, tile->clip);
+}
+
+internal void
+BenchLighting(void) {
+    uint32_t screen_count = BENCH_LIGHTING_WIDTH * BENCH_LIGHTING_HEIGHT;
+    uint32_t arena_bytes  = 4 * BENCH_LIGHTING_SPRITE_DIM * BENCH_LIGHTING_SPRITE_DIM * (uint32_t)sizeof(uint32_t);
+    uint32_t total_bytes  = screen_count * (uint32_t)sizeof(uint32_t) + arena_bytes;
+    uint8_t* memory       = (uint8_t*)VirtualAlloc(0, total_bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+    Memory_Arena arena;
+    InitializeArena(&arena, arena_bytes, memory + screen_count * sizeof(uint32_t));
+
+    // NOTE: opaque noise over round bumps, the normals are the slope of sin(x) * sin(y)
+    Sprite sprite = {};
+    for (int map_idx = 0; map_idx < 2; ++map_idx) {
+        Loaded_Bitmap* bitmap = map_idx ? &sprite.normals[0] : &sprite.levels[0];
+        bitmap->width         = BENCH_LIGHTING_SPRITE_DIM;
+        bitmap->height        = BENCH_LIGHTING_SPRITE_DIM;
+        bitmap->pitch         = BENCH_LIGHTING_SPRITE_DIM * sizeof(uint32_t);
+        bitmap->memory        = PushArray(
+            &arena, BENCH_LIGHTING_SPRITE_DIM * BENCH_LIGHTING_SPRITE_DIM, uint32_t, MemoryTag_Bitmaps);
+    }
+    uint32_t  random  = 0x9E3779B9;
+    uint32_t* texels  = (uint32_t*)sprite.levels[0].memory;
+    uint32_t* normals = (uint32_t*)sprite.normals[0].memory;
+    for (int y = 0; y < BENCH_LIGHTING_SPRITE_DIM; ++y) {
+        for (int x = 0; x < BENCH_LIGHTING_SPRITE_DIM; ++x) {
+            random ^= random << 13;
+            random ^= random >> 17;
+            random ^= random << 5;
+            float32_t frequency = 2.0f * PI / 16.0f;
+            float32_t slope_x   = -cosf(frequency * (float32_t)x) * sinf(frequency * (float32_t)y);
+            float32_t slope_y   = -sinf(frequency * (float32_t)x) * cosf(frequency * (float32_t)y);
+            float32_t length    = sqrtf(slope_x * slope_x + slope_y * slope_y + 1.0f);
+            uint32_t  packed_x  = (uint32_t)(128.0f + 127.0f * slope_x / length + 0.5f);
+            uint32_t  packed_y  = (uint32_t)(128.0f + 127.0f * slope_y / length + 0.5f);
+            uint32_t  packed_z  = (uint32_t)(128.0f + 127.0f / length + 0.5f);
+
+            int idx      = y * BENCH_LIGHTING_SPRITE_DIM + x;
+            texels[idx]  = 0xFF808080 | (random & 0x3F3F3F);
+            normals[idx] = 0xFF000000 | (packed_x << 16) | (packed_y << 8) | packed_z;
+        }
+    }
+    SpriteBuildMips(&sprite, &arena);
+
+    Game_Offscreen_Buffer buffer = {};
+    buffer.memory                = memory;
+    buffer.width                 = BENCH_LIGHTING_WIDTH;
+    buffer.height                = BENCH_LIGHTING_HEIGHT;
+    buffer.pitch                 = BENCH_LIGHTING_WIDTH * sizeof(uint32_t);
+    buffer.bytes_per_pixel       = 4;
+    buffer.pixel_format          = GamePixelFormat_BGRX8888;
+
+    local_persist Platform_Work_Queue queue;
+    local_persist Win32_Thread_Info   thread_infos[WORK_QUEUE_MAX_THREADS];
+    int                               thread_count = Win32GetWorkerThreadCount();
+    Win32MakeWorkQueue(&queue, thread_count, thread_infos);
+
+    Bench_Lighting_Tile tiles[BENCH_LIGHTING_TILES_X * BENCH_LIGHTING_TILES_Y];
+    local_persist Lighting lighting;
+    for (int tile_y = 0; tile_y < BENCH_LIGHTING_TILES_Y; ++tile_y) {
+        for (int tile_x = 0; tile_x < BENCH_LIGHTING_TILES_X; ++tile_x) {
+            Bench_Lighting_Tile* tile = &tiles[tile_y * BENCH_LIGHTING_TILES_X + tile_x];
+            tile->buffer              = &buffer;
+            tile->sprite              = &sprite;
+            tile->lighting            = &lighting;
+            tile->clip.min_x          = tile_x * BENCH_LIGHTING_WIDTH / BENCH_LIGHTING_TILES_X;
+            tile->clip.min_y          = tile_y * BENCH_LIGHTING_HEIGHT / BENCH_LIGHTING_TILES_Y;
+            tile->clip.max_x          = (tile_x + 1) * BENCH_LIGHTING_WIDTH / BENCH_LIGHTING_TILES_X;
+            tile->clip.max_y          = (tile_y + 1) * BENCH_LIGHTING_HEIGHT / BENCH_LIGHTING_TILES_Y;
+        }
+    }
+
+    printf(
+        "%dx%d, %d tiles on %d worker threads, %.1fms budget\n",
+        BENCH_LIGHTING_WIDTH,
+        BENCH_LIGHTING_HEIGHT,
+        ArrayCount(tiles),
+        thread_count,
+        BENCH_LIGHTING_TARGET_MS);
+    printf(
+        "\n%-7s %8s %10s %10s %12s %12s\n", "lights", "radius", "1 thread", "px/cycle", "tiled ms", "budget");
+
+    // NOTE: scattered lights reach a circle each, the last rows have every light reaching every pixel
+    uint32_t  light_counts[] = {0, 1, 4, 16, 32, 64, 16, 64};
+    Clip_Rect screen_clip    = ClipRectForBuffer(&buffer);
+    for (int row_idx = 0; row_idx < ArrayCount(light_counts); ++row_idx) {
+        float32_t radius = row_idx < ArrayCount(light_counts) - 2 ? BENCH_LIGHTING_RADIUS : BENCH_LIGHTING_EVERYWHERE;
+        LightingBegin(&lighting, 0.05f, 0.05f, 0.05f);
+        uint32_t light_random = 0x12345678;
+        for (uint32_t light_idx = 0; light_idx < light_counts[row_idx]; ++light_idx) {
+            light_random ^= light_random << 13;
+            light_random ^= light_random >> 17;
+            light_random ^= light_random << 5;
+            float32_t x = (float32_t)(light_random % BENCH_LIGHTING_WIDTH);
+            float32_t y = (float32_t)((light_random >> 11) % BENCH_LIGHTING_HEIGHT);
+            LightingAddPoint(&lighting, x, y, BENCH_LIGHTING_HEIGHT_ABOVE, radius, 0.8f, 0.7f, 0.6f);
+        }
+
+        Bench_Timer timer = BenchBegin();
+        for (int repeat_idx = 0; repeat_idx < BENCH_LIGHTING_REPEATS; ++repeat_idx) {
+            BenchDrawLitTile(&buffer, &sprite, &lighting, screen_clip);
+        }
+        uint64_t  cycles    = __rdtsc() - timer.start_cycle_count;
+        float32_t single_ms = BenchEndMs(timer) / BENCH_LIGHTING_REPEATS;
+
+        timer = BenchBegin();
+        for (int repeat_idx = 0; repeat_idx < BENCH_LIGHTING_REPEATS; ++repeat_idx) {
+            for (int tile_idx = 0; tile_idx < ArrayCount(tiles); ++tile_idx) {
+                Win32AddWorkQueueEntry(&queue, BenchLightingTileJob, &tiles[tile_idx]);
+            }
+            Win32CompleteAllWork(&queue);
+        }
+        float32_t tiled_ms = BenchEndMs(timer) / BENCH_LIGHTING_REPEATS;
+
+        float64_t pixels = (float64_t)screen_count * BENCH_LIGHTING_REPEATS;
+        printf(
+            "%-7u %8.0f %10.2f %10.3f %12.2f %12s\n",
+            light_counts[row_idx],
+            radius,
+            single_ms,
+            pixels / (float64_t)cycles,
+            tiled_ms,
+            tiled_ms <= BENCH_LIGHTING_TARGET_MS ? "fits" : "OVER");
+    }
+
+    VirtualFree(memory, 0, MEM_RELEASE);
+}
+
+/// World paging
+#define BENCH_PAGING_FILE_NAME   "bench_world.hhw"
+#define BENCH_PAGING_MIN_CHUNK   (-128)
+#define BENCH_PAGING_SPAN        256 // NOTE: 256 x 256 chunks, 17MB of file for a cache of 1024
+#define BENCH_PAGING_WIDTH       1920
+#define BENCH_PAGING_HEIGHT      1080
+#define BENCH_PAGING_TILE_SHIFT  4 // NOTE: GAME_TILE_PIXELS is 16
+#define BENCH_PAGING_FRAME_COUNT 240
+#define BENCH_PAGING_FRAME_MS    (1000.0f / 30.0f)
+#define BENCH_PAGING_EDIT_COUNT  64
+
+// NOTE: what the file says every tile is before the bench changes any
+inline uint8_t
+BenchPagingTile(int32_t chunk_x, int32_t chunk_y, uint32_t tile_idx) {
+    uint32_t hash = (uint32_t)chunk_x * 0x9E3779B9 ^ (uint32_t)chunk_y * 0x85EBCA6B ^ tile_idx * 0xC2B2AE35;
+    hash ^= hash >> 15;
+    hash *= 0x2C1B3C6D;
+    hash ^= hash >> 12;
+    return (uint8_t)(hash & 3);
+}
+
+// NOTE: row is BENCH_PAGING_SPAN chunks to write a row at a time from
+internal bool
+BenchWritePagingFile(World_Chunk* row) {
+    bool   written     = false;
+    HANDLE file_handle = CreateFileA(
+        BENCH_PAGING_FILE_NAME, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file_handle != INVALID_HANDLE_VALUE) {
+        World_File_Header header = {
+            WORLD_FILE_MAGIC,
+            WORLD_FILE_VERSION,
+            BENCH_PAGING_MIN_CHUNK,
+            BENCH_PAGING_MIN_CHUNK,
+            BENCH_PAGING_SPAN,
+            BENCH_PAGING_SPAN};
+        DWORD bytes_written = 0;
+        written             = WriteFile(file_handle, &header, sizeof(header), &bytes_written, NULL);
+        for (int32_t row_idx = 0; written && row_idx < BENCH_PAGING_SPAN; ++row_idx) {
+            for (int32_t column_idx = 0; column_idx < BENCH_PAGING_SPAN; ++column_idx) {
+                World_Chunk* chunk       = &row[column_idx];
+                chunk->chunk_x           = BENCH_PAGING_MIN_CHUNK + column_idx;
+                chunk->chunk_y           = BENCH_PAGING_MIN_CHUNK + row_idx;
+                chunk->filled_tile_count = 0;
+                chunk->pad               = WORLD_FILE_MAGIC;
+                for (uint32_t tile_idx = 0; tile_idx < WORLD_CHUNK_DIM * WORLD_CHUNK_DIM; ++tile_idx) {
+                    chunk->tiles[tile_idx] = BenchPagingTile(chunk->chunk_x, chunk->chunk_y, tile_idx);
+                    chunk->filled_tile_count += chunk->tiles[tile_idx] ? 1 : 0;
+                }
+            }
+            written = WriteFile(file_handle, row, BENCH_PAGING_SPAN * sizeof(World_Chunk), &bytes_written, NULL);
+        }
+        CloseHandle(file_handle);
+    }
+    return written;
+}
+
+inline void
+BenchOpenPager(World_Pager* pager, Game_Memory* memory) {
+    WorldPagerOpen(
+        pager,
+        memory,
+        BENCH_PAGING_FILE_NAME,
+        BENCH_PAGING_MIN_CHUNK,
+        BENCH_PAGING_MIN_CHUNK,
+        BENCH_PAGING_SPAN,
+        BENCH_PAGING_SPAN);
+}
+
+inline void
+BenchUpdatePager(World_Pager* pager, Game_Memory* memory, int32_t camera_x, int32_t camera_y) {
+    World_Pager_View view;
+    view.min_tile_x = camera_x >> BENCH_PAGING_TILE_SHIFT;
+    view.min_tile_y = camera_y >> BENCH_PAGING_TILE_SHIFT;
+    view.max_tile_x = (camera_x + BENCH_PAGING_WIDTH - 1) >> BENCH_PAGING_TILE_SHIFT;
+    view.max_tile_y = (camera_y + BENCH_PAGING_HEIGHT - 1) >> BENCH_PAGING_TILE_SHIFT;
+    WorldPagerUpdate(pager, memory, BENCH_PAGING_FILE_NAME, &view, 1);
+}
+
+// NOTE: pages until every chunk in view is in, the time it takes from cold is the one wait a game would show a
+// loading screen for
+internal float32_t
+BenchSettlePager(World_Pager* pager, Game_Memory* memory, int32_t camera_x, int32_t camera_y) {
+    Bench_Timer timer = BenchBegin();
+    for (;;) {
+        uint64_t misses = pager->stats.misses;
+        BenchUpdatePager(pager, memory, camera_x, camera_y);
+        if (pager->state == WorldPager_Open && pager->stats.misses == misses) {
+            break;
+        }
+        Sleep(1);
+    }
+    return BenchEndMs(timer);
+}
+
+// NOTE: the camera crosses the file at a few speeds bouncing off its edges, 30 frames a second with the pager's time
+// per frame measured and the rest of the frame slept away so reads land at the rate they would in the game. Tiles are
+// then changed in view, paged out by moving away, and read back through a fresh pager after closing.
+internal void
+BenchWorldPaging(void) {
+    BenchInitFileIO();
+    local_persist Platform_Work_Queue work_queue;
+    Game_Memory                       memory;
+    BenchInitGameMemory(&memory, &work_queue);
+    World_Pager* pager = (World_Pager*)memory.transient_storage;
+    Assert(BENCH_PAGING_SPAN <= WORLD_PAGER_MAX_CHUNKS);
+    if (!BenchCheck(BenchWritePagingFile(pager->chunks))) { // NOTE: the cache isn't in use yet
+        printf("unable to write %s\n", BENCH_PAGING_FILE_NAME);
+        VirtualFree(memory.permanent_storage, 0, MEM_RELEASE);
+        VirtualFree(memory.transient_storage, 0, MEM_RELEASE);
+        return;
+    }
+
+    int32_t world_pixels = BENCH_PAGING_SPAN * WORLD_CHUNK_DIM * GAME_TILE_PIXELS;
+    int32_t min_pixel    = BENCH_PAGING_MIN_CHUNK * WORLD_CHUNK_DIM * GAME_TILE_PIXELS;
+    int32_t speeds[]     = {4, 16, 64, 256, 1024}; // pixels per frame
+    BenchOpenPager(pager, &memory);
+    float32_t settle_ms = BenchSettlePager(pager, &memory, 0, 0);
+    printf(
+        "%u bytes of pager for %u chunks, %.1f MB of file, %.1f ms to page in the first view from cold\n\n",
+        (uint32_t)sizeof(World_Pager),
+        WORLD_PAGER_MAX_CHUNKS,
+        (float32_t)BENCH_PAGING_SPAN * BENCH_PAGING_SPAN * sizeof(World_Chunk) / MegaBytes(1),
+        settle_ms);
+
+    printf(
+        "%12s %8s %8s %8s %10s %8s %8s\n", "px/frame", "hit %", "reads", "evicted", "chunks/s", "avg ms", "max ms");
+    int32_t camera_x = 0;
+    int32_t camera_y = 0;
+    for (int speed_idx = 0; speed_idx < ArrayCount(speeds); ++speed_idx) {
+        // NOTE: not quite diagonal so the path doesn't retrace itself
+        int32_t step_x = speeds[speed_idx];
+        int32_t step_y = speeds[speed_idx] * 5 / 8;
+        pager->stats   = {};
+
+        float32_t total_ms = 0.0f;
+        float32_t max_ms   = 0.0f;
+        for (int frame_idx = 0; frame_idx < BENCH_PAGING_FRAME_COUNT; ++frame_idx) {
+            Bench_Timer frame_timer = BenchBegin();
+            camera_x += step_x;
+            camera_y += step_y;
+            if (camera_x < min_pixel || camera_x + BENCH_PAGING_WIDTH > min_pixel + world_pixels) {
+                step_x = -step_x;
+                camera_x += 2 * step_x;
+            }
+            if (camera_y < min_pixel || camera_y + BENCH_PAGING_HEIGHT > min_pixel + world_pixels) {
+                step_y = -step_y;
+                camera_y += 2 * step_y;
+            }
+
+            Bench_Timer timer = BenchBegin();
+            BenchUpdatePager(pager, &memory, camera_x, camera_y);
+            float32_t update_ms = BenchEndMs(timer);
+            total_ms += update_ms;
+            if (update_ms > max_ms) {
+                max_ms = update_ms;
+            }
+
+            float32_t rest_ms = BENCH_PAGING_FRAME_MS - BenchEndMs(frame_timer);
+            if (rest_ms >= 1.0f) {
+                Sleep((DWORD)rest_ms);
+            }
+        }
+
+        World_Pager_Stats* stats = &pager->stats;
+        printf(
+            "%12d %8.1f %8llu %8llu %10.0f %8.3f %8.3f\n",
+            speeds[speed_idx],
+            100.0 * (float64_t)stats->hits / (float64_t)(stats->hits + stats->misses),
+            stats->reads,
+            stats->evictions,
+            (float32_t)stats->reads / (BENCH_PAGING_FRAME_COUNT * BENCH_PAGING_FRAME_MS / 1000.0f),
+            total_ms / BENCH_PAGING_FRAME_COUNT,
+            max_ms);
+    }
+
+    // NOTE: every edit is a tile in view set to a value the file never has, the camera then jumps to two far corners
+    // and the pager writes them behind while it isn't looking
+    BenchSettlePager(pager, &memory, camera_x, camera_y);
+    int32_t  view_tile_x = camera_x >> BENCH_PAGING_TILE_SHIFT;
+    int32_t  view_tile_y = camera_y >> BENCH_PAGING_TILE_SHIFT;
+    int32_t  edit_xs[BENCH_PAGING_EDIT_COUNT];
+    int32_t  edit_ys[BENCH_PAGING_EDIT_COUNT];
+    uint8_t  edit_values[BENCH_PAGING_EDIT_COUNT];
+    uint32_t random = 0x9E3779B9;
+    for (int edit_idx = 0; edit_idx < BENCH_PAGING_EDIT_COUNT; ++edit_idx) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        edit_xs[edit_idx]     = view_tile_x + (int32_t)((random & 0xFFFF) % (BENCH_PAGING_WIDTH / GAME_TILE_PIXELS));
+        edit_ys[edit_idx]     = view_tile_y + (int32_t)((random >> 16) % (BENCH_PAGING_HEIGHT / GAME_TILE_PIXELS));
+        edit_values[edit_idx] = (uint8_t)(4 + edit_idx % 4);
+        WorldPagerSetTile(pager, edit_xs[edit_idx], edit_ys[edit_idx], edit_values[edit_idx]);
+    }
+    uint64_t writes_before = pager->stats.writes;
+    BenchSettlePager(pager, &memory, min_pixel + world_pixels - BENCH_PAGING_WIDTH, min_pixel);
+    BenchSettlePager(pager, &memory, min_pixel, min_pixel + world_pixels - BENCH_PAGING_HEIGHT);
+    uint64_t written_while_paging = pager->stats.writes - writes_before;
+
+    Bench_Timer timer = BenchBegin();
+    WorldPagerClose(pager, &memory);
+    float32_t close_ms = BenchEndMs(timer);
+
+    BenchOpenPager(pager, &memory);
+    BenchSettlePager(pager, &memory, camera_x, camera_y);
+    // NOTE: when two edits landed on the same tile the later one is what should be there
+    uint32_t matches = 0;
+    for (int edit_idx = 0; edit_idx < BENCH_PAGING_EDIT_COUNT; ++edit_idx) {
+        uint8_t expected = edit_values[edit_idx];
+        for (int later_idx = edit_idx + 1; later_idx < BENCH_PAGING_EDIT_COUNT; ++later_idx) {
+            if (edit_xs[later_idx] == edit_xs[edit_idx] && edit_ys[later_idx] == edit_ys[edit_idx]) {
+                expected = edit_values[later_idx];
+            }
+        }
+        if (WorldGetTile(&pager->world, edit_xs[edit_idx], edit_ys[edit_idx]) == expected) {
+            ++matches;
+        }
+    }
+    bool is_new_file = pager->stats.new_chunks != 0;
+    WorldPagerClose(pager, &memory);
+    printf(
+        "\n%d tiles changed, %llu chunks written back while paging, %.1f ms to close, %u/%d read back (%s)%s\n",
+        BENCH_PAGING_EDIT_COUNT,
+        written_while_paging,
+        close_ms,
+        matches,
+        BENCH_PAGING_EDIT_COUNT,
+        BenchCheck(matches == BENCH_PAGING_EDIT_COUNT) ? "ok" : "FAILED",
+        is_new_file ? " (the file was made again, the header didn't match)" : "");
+
+    DeleteFileA(BENCH_PAGING_FILE_NAME);
+    VirtualFree(memory.permanent_storage, 0, MEM_RELEASE);
+    VirtualFree(memory.transient_storage, 0, MEM_RELEASE);
+}
+
+/// Idle tasks
+// NOTE: frames at 30Hz whose work is a spin of a random length, some of them close to the deadline, with and without
+// two tasks filling the idle time. One compresses a buffer 64KB at a step like an asset cooker would, the other makes
+// world chunks and finishes every so often to be queued again. Paced like WinMain: idle tasks, then sleep and spin.
+#define BENCH_IDLE_FRAME_COUNT    150
+#define BENCH_IDLE_TARGET_MS      (1000.0f / 30.0f)
+#define BENCH_IDLE_LATE_MS        0.5f // NOTE: a frame this much over the target counts as missed
+#define BENCH_IDLE_BUFFER_SIZE    MegaBytes(16)
+#define BENCH_IDLE_BLOCK_SIZE     KiloBytes(64)
+#define BENCH_IDLE_TASK_CHUNKS    65536 // NOTE: long enough that runs get cut off by the deadline
+#define BENCH_IDLE_FLAT_OUT_MS    500.0f
+
+struct Bench_Compress_Task {
+    uint8_t* source;
+    uint8_t* dest;
+    uint32_t offset;
+    uint64_t bytes_done;
+};
+
+struct Bench_Chunk_Task {
+    World_Chunk chunk;
+    uint32_t    chunk_idx;
+    uint64_t    chunks_done;
+
+    // NOTE: calls that yielded before the last chunk, calls that picked up where one of those stopped, and runs that
+    // made every chunk
+    uint32_t interrupted_count;
+    uint32_t resumed_count;
+    uint32_t finished_count;
+};
+
+// NOTE: never finishes, goes around the buffer again
+internal PLATFORM_IDLE_TASK_CALLBACK(BenchCompressTask) {
+    Bench_Compress_Task* task = (Bench_Compress_Task*)data;
+    while (!Win32IdleShouldYield(queue)) {
+        LZCompress(task->source + task->offset, BENCH_IDLE_BLOCK_SIZE, task->dest);
+        task->offset = (task->offset + BENCH_IDLE_BLOCK_SIZE) % BENCH_IDLE_BUFFER_SIZE;
+        task->bytes_done += BENCH_IDLE_BLOCK_SIZE;
+    }
+    return false;
+}
+
+internal PLATFORM_IDLE_TASK_CALLBACK(BenchChunkTask) {
+    Bench_Chunk_Task* task = (Bench_Chunk_Task*)data;
+    if (task->chunk_idx) {
+        ++task->resumed_count;
+    }
+    while (task->chunk_idx < BENCH_IDLE_TASK_CHUNKS && !Win32IdleShouldYield(queue)) {
+        World_Chunk* chunk       = &task->chunk;
+        chunk->chunk_x           = (int32_t)(task->chunk_idx % 64);
+        chunk->chunk_y           = (int32_t)(task->chunk_idx / 64);
+        chunk->filled_tile_count = 0;
+        for (uint32_t tile_idx = 0; tile_idx < WORLD_CHUNK_DIM * WORLD_CHUNK_DIM; ++tile_idx) {
+            chunk->tiles[tile_idx] = BenchPagingTile(chunk->chunk_x, chunk->chunk_y, tile_idx);
+            chunk->filled_tile_count += chunk->tiles[tile_idx] ? 1 : 0;
+        }
+        ++task->chunk_idx;
+        ++task->chunks_done;
+    }
+
+    bool is_finished = task->chunk_idx == BENCH_IDLE_TASK_CHUNKS;
+    if (is_finished) {
+        ++task->finished_count;
+    } else {
+        ++task->interrupted_count;
+    }
+    return is_finished;
+}
+
+inline void
+BenchSpin(LARGE_INTEGER start, float32_t ms) {
+    while (Win32GetMilliSecondsElapsed(start, Win32GetWallClock()) < ms) {
+        _mm_pause();
+    }
+}
+
+internal void
+BenchIdleTasks(void) {
+    bool sleep_is_granular = (timeBeginPeriod(1) == TIMERR_NOERROR);
+
+    Platform_Idle_Queue* queue = (Platform_Idle_Queue*)VirtualAlloc(
+        0, sizeof(Platform_Idle_Queue), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    uint8_t* source =
+        (uint8_t*)VirtualAlloc(0, BENCH_IDLE_BUFFER_SIZE, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    uint8_t* dest = (uint8_t*)VirtualAlloc(
+        0, LZCompressBound(BENCH_IDLE_BLOCK_SIZE), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    Bench_Chunk_Task* chunk_task =
+        (Bench_Chunk_Task*)VirtualAlloc(0, sizeof(Bench_Chunk_Task), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+    // NOTE: short repeats of a few words, about what a level or a save compresses like
+    uint32_t random = 0x9E3779B9;
+    for (uint32_t byte_idx = 0; byte_idx < BENCH_IDLE_BUFFER_SIZE; byte_idx += 4) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        uint32_t word = (random & 0x300) ? 0x01020304u * (random & 7) : random;
+        memcpy(source + byte_idx, &word, sizeof(word));
+    }
+
+    // NOTE: what compression does with the whole core to itself
+    Bench_Compress_Task compress_task = {source, dest, 0, 0};
+    LARGE_INTEGER       flat_out_end  = Win32GetWallClock();
+    flat_out_end.QuadPart += (int64_t)(BENCH_IDLE_FLAT_OUT_MS * (float32_t)g_perf_count_freq / 1000.0f);
+    Win32AddIdleTask(queue, BenchCompressTask, &compress_task);
+    float32_t flat_out_ms            = Win32RunIdleTasks(queue, flat_out_end);
+    float32_t flat_out_mb_per_second = 1000.0f * (float32_t)compress_task.bytes_done / MegaBytes(1) / flat_out_ms;
+
+    printf(
+        "%d frames of %.1f ms per row, work 8 to 24 ms with 1 frame in 8 at 29 to 32 ms, %.1f ms safety margin\n",
+        BENCH_IDLE_FRAME_COUNT,
+        BENCH_IDLE_TARGET_MS,
+        WIN32_IDLE_SAFETY_MS);
+    printf("compression alone on the main thread: %.1f MB/s\n\n", flat_out_mb_per_second);
+    printf(
+        "%-22s %7s %8s %9s %10s %10s %9s %11s %7s\n",
+        "",
+        "missed",
+        "max ms",
+        "idle ms/f",
+        "MB/s",
+        "chunks/s",
+        "finished",
+        "overrun ms",
+        "check");
+
+    // NOTE: without the margin frames are expected to be missed, that's what the row is there to show
+    const char* mode_names[]     = {"no tasks", "tasks", "tasks, no margin"};
+    float32_t   margins[]        = {0.0f, WIN32_IDLE_SAFETY_MS, 0.0f};
+    bool        must_keep_rate[] = {true, true, false};
+    for (int mode_idx = 0; mode_idx < ArrayCount(mode_names); ++mode_idx) {
+        *queue        = {};
+        compress_task = {source, dest, 0, 0};
+        *chunk_task   = {};
+        if (mode_idx > 0) {
+            Win32AddIdleTask(queue, BenchCompressTask, &compress_task);
+            Win32AddIdleTask(queue, BenchChunkTask, chunk_task);
+        }
+
+        random                      = 0x2545F491; // NOTE: the same frames in every mode
+        uint32_t      missed_count  = 0;
+        float32_t     max_frame_ms  = 0.0f;
+        float32_t     total_idle_ms = 0.0f;
+        LARGE_INTEGER run_start     = Win32GetWallClock();
+        LARGE_INTEGER frame_start   = run_start;
+        for (int frame_idx = 0; frame_idx < BENCH_IDLE_FRAME_COUNT; ++frame_idx) {
+            random ^= random << 13;
+            random ^= random >> 17;
+            random ^= random << 5;
+            float32_t work_ms = (random & 7) ? 8.0f + (float32_t)(random >> 8 & 0xFF) / 16.0f
+                                             : 29.0f + (float32_t)(random >> 8 & 0xFF) / 85.0f;
+            BenchSpin(frame_start, work_ms);
+
+            float32_t idle_end_ms = BENCH_IDLE_TARGET_MS - margins[mode_idx];
+            if (queue->task_count && work_ms < idle_end_ms) {
+                LARGE_INTEGER idle_deadline;
+                idle_deadline.QuadPart =
+                    frame_start.QuadPart + (int64_t)(idle_end_ms * (float32_t)g_perf_count_freq / 1000.0f);
+                total_idle_ms += Win32RunIdleTasks(queue, idle_deadline);
+            }
+            if (chunk_task->chunk_idx == BENCH_IDLE_TASK_CHUNKS) {
+                chunk_task->chunk_idx = 0;
+                Win32AddIdleTask(queue, BenchChunkTask, chunk_task);
+            }
+
+            float32_t elapsed_ms = Win32GetMilliSecondsElapsed(frame_start, Win32GetWallClock());
+            if (sleep_is_granular && elapsed_ms < BENCH_IDLE_TARGET_MS) {
+                DWORD sleep_ms = (DWORD)(BENCH_IDLE_TARGET_MS - elapsed_ms);
+                if (sleep_ms > 0) {
+                    Sleep(sleep_ms);
+                }
+            }
+            BenchSpin(frame_start, BENCH_IDLE_TARGET_MS);
+
+            LARGE_INTEGER frame_end = Win32GetWallClock();
+            float32_t     frame_ms  = Win32GetMilliSecondsElapsed(frame_start, frame_end);
+            if (frame_ms > BENCH_IDLE_TARGET_MS + BENCH_IDLE_LATE_MS) {
+                ++missed_count;
+            }
+            if (frame_ms > max_frame_ms) {
+                max_frame_ms = frame_ms;
+            }
+            frame_start = frame_end;
+        }
+
+        // NOTE: the chunk task has to have been cut off by the deadline, and every call that was cut off picked up
+        // where it stopped by a later one, but the last when the run ended half way through. Runs have to finish with
+        // no chunk made twice or skipped. The compression task never finishes, it and the requeued chunk task have to
+        // still be there.
+        bool is_ok = !must_keep_rate[mode_idx] || missed_count == 0;
+        if (mode_idx > 0) {
+            uint32_t left_off = chunk_task->chunk_idx ? 1 : 0;
+            uint64_t expected_chunks =
+                (uint64_t)chunk_task->finished_count * BENCH_IDLE_TASK_CHUNKS + chunk_task->chunk_idx;
+            is_ok = is_ok && chunk_task->interrupted_count &&
+                    chunk_task->resumed_count == chunk_task->interrupted_count - left_off &&
+                    chunk_task->finished_count && chunk_task->chunks_done == expected_chunks && queue->task_count == 2;
+        }
+        BenchCheck(is_ok);
+
+        float32_t run_seconds = Win32GetMilliSecondsElapsed(run_start, Win32GetWallClock()) / 1000.0f;
+        printf(
+            "%-22s %7u %8.2f %9.2f %10.1f %10.0f %9llu %11.3f %7s\n",
+            mode_names[mode_idx],
+            missed_count,
+            max_frame_ms,
+            total_idle_ms / BENCH_IDLE_FRAME_COUNT,
+            (float32_t)compress_task.bytes_done / MegaBytes(1) / run_seconds,
+            (float32_t)chunk_task->chunks_done / run_seconds,
+            queue->finished_count,
+            queue->max_overrun_ms,
+            is_ok ? "ok" : "FAILED");
+    }
+
+    VirtualFree(chunk_task, 0, MEM_RELEASE);
+    VirtualFree(dest, 0, MEM_RELEASE);
+    VirtualFree(source, 0, MEM_RELEASE);
+    VirtualFree(queue, 0, MEM_RELEASE);
+}
+
+/// Split screen
+// NOTE: the real game with 1, 2 and 4 gamepads connected, each stick held at a different strength so the cameras drift
+// apart. The viewports render inline, then as jobs on queues with more and more workers. After that the cameras hold
+// still and one frame is rendered inline and as jobs from the same permanent storage, the two have to be the same.
+#define BENCH_SPLIT_FRAME_COUNT       120
+#define BENCH_SPLIT_MAX_SETTLE_FRAMES 200
+#define BENCH_SPLIT_QUIET_FRAME_COUNT 4
+
+internal void
+BenchSetSplitInput(Game_Input* input, int viewport_count, float32_t stick_step) {
+    *input = {};
+    for (int gamepad_idx = 0; gamepad_idx < viewport_count; ++gamepad_idx) {
+        Game_Controller_Input* gamepad = &input->gamepad_controllers[gamepad_idx];
+        gamepad->is_connected          = true;
+        gamepad->is_analog             = true;
+        gamepad->stick_avg_x           = stick_step * (float32_t)(gamepad_idx + 1);
+    }
+}
+
+// NOTE: still cameras until the pager went a few frames without reading or writing, everything in view is in memory
+// then. Returns false when the frame from inline and the one from jobs aren't byte for byte the same.
+internal bool
+BenchSplitFramesMatch(
+    Bench_Game*            game,
+    Game_Input*            input,
+    int                    viewport_count,
+    Platform_Work_Queue*   queue,
+    Game_Offscreen_Buffer* inline_buffer,
+    Game_Offscreen_Buffer* jobbed_buffer,
+    void*                  saved_storage) {
+
+    Transient_State* transient   = (Transient_State*)game->memory.transient_storage;
+    int              quiet_count = 0;
+    for (int frame_idx = 0; frame_idx < BENCH_SPLIT_MAX_SETTLE_FRAMES && quiet_count < BENCH_SPLIT_QUIET_FRAME_COUNT;
+         ++frame_idx) {
+        BenchSetSplitInput(input, viewport_count, 0.0f);
+        game->code.GameUpdateAndRender(&game->memory, input, inline_buffer);
+        quiet_count = transient->world.op_count || transient->world.dirty_count ? 0 : quiet_count + 1;
+        Sleep(1);
+    }
+
+    memcpy(saved_storage, game->memory.permanent_storage, game->memory.permanent_storage_size);
+    game->memory.work_queue = 0;
+    BenchSetSplitInput(input, viewport_count, 0.0f);
+    game->code.GameUpdateAndRender(&game->memory, input, inline_buffer);
+
+    memcpy(game->memory.permanent_storage, saved_storage, game->memory.permanent_storage_size);
+    game->memory.work_queue = queue;
+    BenchSetSplitInput(input, viewport_count, 0.0f);
+    game->code.GameUpdateAndRender(&game->memory, input, jobbed_buffer);
+
+    return memcmp(inline_buffer->memory, jobbed_buffer->memory, (size_t)inline_buffer->pitch * inline_buffer->height) ==
+           0;
+}
+
+internal void
+BenchSplitScreen(void) {
+    Bench_Game* game = BenchLoadGame();
+    if (!game) {
+        return;
+    }
+
+    Game_Input* input = (Game_Input*)VirtualAlloc(0, sizeof(Game_Input), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+    Win32_Offscreen_Buffer backbuffer        = {};
+    Win32_Offscreen_Buffer jobbed_backbuffer = {};
+    Win32ResizeDIBSection(&backbuffer, 1920, 1080, GamePixelFormat_BGRX8888);
+    Win32ResizeDIBSection(&jobbed_backbuffer, 1920, 1080, GamePixelFormat_BGRX8888);
+    Game_Offscreen_Buffer game_buffer   = BenchGetGameBuffer(&backbuffer);
+    Game_Offscreen_Buffer jobbed_buffer = BenchGetGameBuffer(&jobbed_backbuffer);
+    void*                 saved_storage =
+        VirtualAlloc(0, game->memory.permanent_storage_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+    // NOTE: threads are never torn down, each worker count gets its own queue
+    local_persist Platform_Work_Queue queues[3];
+    local_persist Win32_Thread_Info   thread_infos[3][WORK_QUEUE_MAX_THREADS];
+    int                               max_thread_count = Win32GetWorkerThreadCount();
+    int                               thread_counts[]  = {0, 1, 3, 7};
+    for (int queue_idx = 0; queue_idx < ArrayCount(queues); ++queue_idx) {
+        int* thread_count = &thread_counts[queue_idx + 1];
+        if (*thread_count > max_thread_count) {
+            *thread_count = max_thread_count;
+        }
+        Win32MakeWorkQueue(&queues[queue_idx], *thread_count, thread_infos[queue_idx]);
+    }
+
+    printf("1920x1080 BGRX8888, %d frames per row, 0 workers renders the viewports inline\n", BENCH_SPLIT_FRAME_COUNT);
+    printf("%9s %8s %10s %10s %9s\n", "viewports", "workers", "avg ms", "max ms", "speedup");
+
+    Platform_Work_Queue* game_queue        = game->memory.work_queue;
+    int                  viewport_counts[] = {1, 2, 4};
+    for (int count_idx = 0; count_idx < ArrayCount(viewport_counts); ++count_idx) {
+        float32_t inline_ms = 0.0f;
+        for (int queue_idx = 0; queue_idx < ArrayCount(thread_counts); ++queue_idx) {
+            if (queue_idx > 1 && thread_counts[queue_idx] == thread_counts[queue_idx - 1]) {
+                continue; // NOTE: clamped to the machine's worker count already
+            }
+            game->memory.work_queue = queue_idx ? &queues[queue_idx - 1] : 0;
+
+            float32_t total_ms = 0.0f;
+            float32_t max_ms   = 0.0f;
+            for (int frame_idx = 0; frame_idx < BENCH_SPLIT_FRAME_COUNT; ++frame_idx) {
+                BenchSetSplitInput(input, viewport_counts[count_idx], 0.25f);
+
+                Bench_Timer timer = BenchBegin();
+                game->code.GameUpdateAndRender(&game->memory, input, &game_buffer);
+                float32_t frame_ms = BenchEndMs(timer);
+                total_ms += frame_ms;
+                if (frame_ms > max_ms) {
+                    max_ms = frame_ms;
+                }
+            }
+
+            float32_t avg_ms = total_ms / BENCH_SPLIT_FRAME_COUNT;
+            if (queue_idx == 0) {
+                inline_ms = avg_ms;
+            }
+            printf(
+                "%9d %8d %10.3f %10.3f %8.2fx\n",
+                viewport_counts[count_idx],
+                thread_counts[queue_idx],
+                avg_ms,
+                max_ms,
+                inline_ms / avg_ms);
+        }
+
+        int  last_queue_idx = ArrayCount(queues) - 1;
+        bool matches        = BenchSplitFramesMatch(
+            game,
+            input,
+            viewport_counts[count_idx],
+            &queues[last_queue_idx],
+            &game_buffer,
+            &jobbed_buffer,
+            saved_storage);
+        BenchCheck(matches);
+        printf(
+            "%9d %8d frame from jobs %s the inline one\n",
+            viewport_counts[count_idx],
+            thread_counts[last_queue_idx + 1],
+            matches ? "matches" : "DIFFERS from");
+    }
+    game->memory.work_queue = game_queue;
+
+    VirtualFree(saved_storage, 0, MEM_RELEASE);
+    VirtualFree(jobbed_backbuffer.memory, 0, MEM_RELEASE);
+    VirtualFree(backbuffer.memory, 0, MEM_RELEASE);
+    VirtualFree(input, 0, MEM_RELEASE);
+}
+
+/// Sound schedule
+// NOTE: headless. The platform here asks for a frame of sound give or take a third of a frame every frame and passes
+// the flip exactly, like WinMain's low latency path that fills to a frame past the projected flip. Beats are on a grid
+// of samples off the frame grid, clicks go on the flip of the frame being updated. Every event is mixed once scheduled
+// and once started at the next buffer, which is all the game could do before, then the onsets found in the output are
+// compared with the samples they were meant for.
+#define BENCH_SCHEDULE_RATE        48000
+#define BENCH_SCHEDULE_FRAME       1600 // samples, a 30Hz frame
+#define BENCH_SCHEDULE_JITTER      533  // WinMain's safety_bytes in samples
+#define BENCH_SCHEDULE_FRAME_COUNT 1800
+#define BENCH_SCHEDULE_BEAT        17111 // samples between beats
+#define BENCH_SCHEDULE_GAP         64    // silent samples before an onset
+#define BENCH_SCHEDULE_MAX_ONSETS  1024
+
+internal uint32_t
+BenchFindOnsets(int16_t* samples, uint64_t sample_count, uint64_t* onsets) {
+    uint32_t onset_count  = 0;
+    uint64_t silent_count = BENCH_SCHEDULE_GAP;
+    for (uint64_t sample_idx = 0; sample_idx < sample_count; ++sample_idx) {
+        if (samples[2 * sample_idx] == 0) {
+            ++silent_count;
+            continue;
+        }
+        if (silent_count >= BENCH_SCHEDULE_GAP && onset_count < BENCH_SCHEDULE_MAX_ONSETS) {
+            onsets[onset_count++] = sample_idx;
+        }
+        silent_count = 0;
+    }
+    return onset_count;
+}
+
+internal void
+BenchSoundSchedule(void) {
+    uint64_t max_sample_count = (uint64_t)(BENCH_SCHEDULE_FRAME_COUNT + 3) * BENCH_SCHEDULE_FRAME;
+    int16_t* output           = (int16_t*)VirtualAlloc(
+        0, max_sample_count * 2 * sizeof(int16_t), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    Sound_Schedule* schedule =
+        (Sound_Schedule*)VirtualAlloc(0, sizeof(Sound_Schedule), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    local_persist uint64_t wanted[BENCH_SCHEDULE_MAX_ONSETS];
+    local_persist uint64_t found[BENCH_SCHEDULE_MAX_ONSETS];
+
+    printf(
+        "%d Hz, %d samples a frame +-%d, %d frames, errors in samples (found - wanted)\n",
+        BENCH_SCHEDULE_RATE,
+        BENCH_SCHEDULE_FRAME,
+        BENCH_SCHEDULE_JITTER,
+        BENCH_SCHEDULE_FRAME_COUNT);
+    printf(
+        "%-8s %-12s %7s %7s %9s %9s %9s %8s %8s\n",
+        "events",
+        "start",
+        "wanted",
+        "found",
+        "min err",
+        "max err",
+        "mean |e|",
+        "exact",
+        "on time");
+
+    const char* pattern_names[] = {"beats", "clicks"};
+    const char* mode_names[]    = {"scheduled", "next buffer"};
+    float32_t   frame_seconds   = (float32_t)BENCH_SCHEDULE_FRAME / (float32_t)BENCH_SCHEDULE_RATE;
+    for (int pattern_idx = 0; pattern_idx < ArrayCount(pattern_names); ++pattern_idx) {
+        for (int mode_idx = 0; mode_idx < ArrayCount(mode_names); ++mode_idx) {
+            memset(output, 0, max_sample_count * 2 * sizeof(int16_t));
+            *schedule = {};
+
+            // NOTE: started at the next buffer, a beat can only be queued by the frame it's shown in
+            uint64_t lookahead    = (mode_idx == 0 ? 2 : 1) * BENCH_SCHEDULE_FRAME;
+            uint64_t next_beat    = BENCH_SCHEDULE_BEAT;
+            uint32_t click_frame  = 0;
+            uint32_t wanted_count = 0;
+            uint64_t written      = 0;
+            uint32_t random       = 0x2545F491; // NOTE: the same frames in every mode
+            for (uint32_t frame_idx = 0; frame_idx < BENCH_SCHEDULE_FRAME_COUNT; ++frame_idx) {
+                random ^= random << 13;
+                random ^= random >> 17;
+                random ^= random << 5;
+
+                // NOTE: the game's update
+                uint64_t event_samples[4];
+                uint32_t event_count = 0;
+                uint64_t flip        = SoundScheduleNextFlip(schedule, frame_seconds);
+                if (flip && pattern_idx == 0) {
+                    while (next_beat < flip + lookahead && event_count < ArrayCount(event_samples)) {
+                        event_samples[event_count++] = next_beat;
+                        next_beat += BENCH_SCHEDULE_BEAT;
+                    }
+                } else if (flip && (random & 7) == 0 && frame_idx > click_frame + 1) {
+                    // NOTE: a frame apart at least, so their onsets can't run together
+                    event_samples[event_count++] = flip;
+                    click_frame                  = frame_idx;
+                }
+                for (uint32_t event_idx = 0; event_idx < event_count; ++event_idx) {
+                    if (wanted_count < BENCH_SCHEDULE_MAX_ONSETS) {
+                        wanted[wanted_count++] = event_samples[event_idx];
+                    }
+                    Sound_Event event = {mode_idx == 0 ? event_samples[event_idx] : 0, 880.0f, 0.5f, 0.02f};
+                    SoundScheduleAt(schedule, event);
+                }
+
+                // NOTE: the platform's audio, to a frame past the flip give or take the jitter
+                uint32_t jitter_span = 2 * BENCH_SCHEDULE_JITTER + 1;
+                int32_t  jitter      = (int32_t)((random >> 8) % jitter_span) - BENCH_SCHEDULE_JITTER;
+                uint64_t target_end  = (uint64_t)((int64_t)(frame_idx + 2) * BENCH_SCHEDULE_FRAME + jitter);
+                Game_Sound_Output_Buffer sound_buffer = {};
+                sound_buffer.samples_per_second       = BENCH_SCHEDULE_RATE;
+                sound_buffer.sample_count             = target_end > written ? (int)(target_end - written) : 0;
+                sound_buffer.samples                  = output + 2 * written;
+                sound_buffer.first_sample_idx         = written;
+                sound_buffer.flip_sample_idx          = (uint64_t)(frame_idx + 1) * BENCH_SCHEDULE_FRAME;
+                SoundScheduleMix(schedule, &sound_buffer);
+                written += sound_buffer.sample_count;
+            }
+
+            uint32_t found_count = BenchFindOnsets(output, written, found);
+            uint32_t pair_count  = wanted_count < found_count ? wanted_count : found_count;
+            int64_t  min_error   = 0;
+            int64_t  max_error   = 0;
+            uint64_t total_error = 0;
+            uint32_t exact_count = 0;
+            for (uint32_t pair_idx = 0; pair_idx < pair_count; ++pair_idx) {
+                int64_t error = (int64_t)found[pair_idx] - (int64_t)wanted[pair_idx];
+                min_error     = (pair_idx == 0 || error < min_error) ? error : min_error;
+                max_error     = (pair_idx == 0 || error > max_error) ? error : max_error;
+                total_error += (uint64_t)(error < 0 ? -error : error);
+                exact_count += (error == 0);
+            }
+
+            // NOTE: scheduled beats land exactly. A click can only be late, by as much as the buffer already reached
+            // past its flip, which is the jitter at most. Starting at the next buffer is the baseline, not checked.
+            const char* on_time = "-";
+            if (mode_idx == 0) {
+                int64_t max_late  = pattern_idx == 0 ? 0 : BENCH_SCHEDULE_JITTER;
+                bool    is_found  = wanted_count && found_count == wanted_count;
+                bool    is_placed = min_error >= 0 && max_error <= max_late;
+                on_time           = BenchCheck(is_found && is_placed) ? "ok" : "FAILED";
+            }
+            printf(
+                "%-8s %-12s %7u %7u %9lld %9lld %9.1f %7.1f%% %8s\n",
+                pattern_names[pattern_idx],
+                mode_names[mode_idx],
+                wanted_count,
+                found_count,
+                min_error,
+                max_error,
+                pair_count ? (float32_t)total_error / (float32_t)pair_count : 0.0f,
+                pair_count ? 100.0f * (float32_t)exact_count / (float32_t)pair_count : 0.0f,
+                on_time);
+        }
+    }
+
+    VirtualFree(schedule, 0, MEM_RELEASE);
+    VirtualFree(output, 0, MEM_RELEASE);
+}
+
+struct Bench_Entry {
+    const char* name;
+    void (*Run)(void);
+};
+
+global Bench_Entry g_benches[] = {
+    {"work_queue", BenchWorkQueue},
+    {"asset_pack", BenchAssetPack},
+    {"async_io", BenchAsyncIO},
+    {"input_events", BenchInputEvents},
+    {"input_latency", BenchInputLatency},
+    {"framebuffer", BenchFramebuffer},
+    {"dynamic_resolution", BenchDynamicResolution},
+    {"frame_phases", BenchFramePhases},
+    {"save_states", BenchSaveStates},
+    {"rollback", BenchRollback},
+    {"entities", BenchEntities},
+    {"world", BenchWorld},
+    {"sound_stream", BenchSoundStreams},
+    {"debug_overlay", BenchDebugOverlay},
+    {"memory_report", BenchMemoryReport},
+    {"blend", BenchBlend},
+    {"bitmap", BenchBitmap},
+    {"sprite", BenchSprite},
+    {"lighting", BenchLighting},
+    {"world_paging", BenchWorldPaging},
+    {"idle_tasks", BenchIdleTasks},
+    {"split_screen", BenchSplitScreen},
+    {"sound_schedule", BenchSoundSchedule},
+};
+
+int
+main(int argc, char** argv) {
+    LARGE_INTEGER perf_count_freq_result;
+    QueryPerformanceFrequency(&perf_count_freq_result);
+    g_perf_count_freq = perf_count_freq_result.QuadPart;
+
+    for (int bench_idx = 0; bench_idx < ArrayCount(g_benches); ++bench_idx) {
+        Bench_Entry* bench   = &g_benches[bench_idx];
+        bool         enabled = (argc <= 1);
+        for (int arg_idx = 1; arg_idx < argc; ++arg_idx) {
+            if (strcmp(argv[arg_idx], bench->name) == 0) {
+                enabled = true;
+            }
+        }
+
+        if (enabled) {
+            printf("== %s\n", bench->name);
+            bench->Run();
+        }
+    }
+
+    if (g_bench_failure_count) {
+        printf("\n%d checks FAILED\n", g_bench_failure_count);
+    }
+    return g_bench_failure_count;
+}
@@ -1,14 +1,18 @@
+#include <winsock2.h> // NOTE: has to come before anything that pulls in windows.h
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <dsound.h>
 #include <intrin.h>
 #include <math.h>
 #include <windows.h>
+#include <psapi.h>
 #include <xinput.h>
 
 #include "base.h"
+#include "handmade_lz.h"
 #include "win32_handmade.h"
 
 /*
@@ -32,11 +36,15 @@
 #pragma intrinsic(__rdtsc)
 
 /// Global variables
-global bool                   g_app_running;
-global bool                   g_pause;
-global Win32_Offscreen_Buffer g_backbuffer;
-global LPDIRECTSOUNDBUFFER    g_dsound_secondary_buffer;
-global int64_t                g_perf_count_freq;
+global bool                    g_app_running;
+global bool                    g_pause;
+global bool                    g_show_debug_overlay = true;
+global bool                    g_write_memory_report; // NOTE: F2, written at the end of the frame
+global Win32_Offscreen_Buffer  g_backbuffer;
+global Win32_Offscreen_Buffer  g_upscaled_buffer; // NOTE: only used while rendering below full resolution
+global Win32_Offscreen_Buffer* g_display_buffer;  // whichever of the two went to the window last
+global LPDIRECTSOUNDBUFFER     g_dsound_secondary_buffer;
+global int64_t                 g_perf_count_freq;
 
 /// Dynamically loading XInput functions
 // NOTE: define x_input_get_state as a function type, same as XInputGetState's signature
@@ -59,10 +67,56 @@ global x_input_set_state* XInputSetState_ = XInputSetStateStub;
 #define DSOUND_CREATE(name) HRESULT WINAPI name(LPCGUID pcGuidDevice, LPDIRECTSOUND* ppDS, LPUNKNOWN pUnkOuter)
 typedef DSOUND_CREATE(direct_sound_create);
 
+/// Tagged allocations
+global Memory_Tag_Stats g_platform_memory[Win32MemoryTag_Count];
+global const char*      g_platform_memory_tag_names[Win32MemoryTag_Count] = {
+    "game_storage", "framebuffer", "sound", "save_state", "rollback", "debug_file"};
+
+// NOTE: what an allocation costs is what VirtualQuery says the region is, whole pages
+internal uint64_t
+Win32GetAllocationSize(void* memory) {
+    MEMORY_BASIC_INFORMATION info = {};
+    if (!memory || !VirtualQuery(memory, &info, sizeof(info))) {
+        return 0;
+    }
+    return info.RegionSize;
+}
+
+// NOTE: reserved and committed, extra_flags is for MEM_WRITE_WATCH
+internal void*
+Win32AllocateMemory(uint64_t size, Win32_Memory_Tag tag, DWORD extra_flags = 0) {
+    void* result = VirtualAlloc(0, (SIZE_T)size, MEM_RESERVE | MEM_COMMIT | extra_flags, PAGE_READWRITE);
+    if (result) {
+        Memory_Tag_Stats* stats = &g_platform_memory[tag];
+        stats->current_bytes += Win32GetAllocationSize(result);
+        if (stats->current_bytes > stats->peak_bytes) {
+            stats->peak_bytes = stats->current_bytes;
+        }
+        ++stats->allocation_count;
+        ++stats->frame_allocation_count;
+    }
+    return result;
+}
+
+internal void
+Win32FreeMemory(void* memory, Win32_Memory_Tag tag) {
+    if (memory) {
+        g_platform_memory[tag].current_bytes -= Win32GetAllocationSize(memory);
+        VirtualFree(memory, 0, MEM_RELEASE);
+    }
+}
+
+internal void
+Win32BeginMemoryFrame(void) {
+    for (int tag = 0; tag < Win32MemoryTag_Count; ++tag) {
+        g_platform_memory[tag].frame_allocation_count = 0;
+    }
+}
+
 #ifdef HANDMADE_INTERNAL
 void
 DebugPlatformFreeFileMemory(void* memory) {
-    VirtualFree(memory, 0, MEM_RELEASE);
+    Win32FreeMemory(memory, Win32MemoryTag_DebugFile);
 }
 
 Debug_Read_File_Result
@@ -76,7 +130,7 @@ DebugPlatformReadEntireFile(const char* file_name) {
         if (GetFileSizeEx(file_handle, &file_size)) {
             uint32_t file_size32 = SafeTruncateUint64(file_size.QuadPart);
 
-            result.content = VirtualAlloc(0, file_size32, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+            result.content = Win32AllocateMemory(file_size32, Win32MemoryTag_DebugFile);
             if (result.content) {
                 DWORD bytes_read = 0;
                 if (ReadFile(file_handle, result.content, file_size32, &bytes_read, NULL) &&
@@ -125,6 +179,397 @@ DebugPlatformWriteEntireFile(const char* file_name, Debug_Read_File_Result read_
 }
 #endif
 
+/// Memory mapped files
+internal PLATFORM_MAP_FILE(Win32MapFile) {
+    Platform_Mapped_File result = {};
+
+    HANDLE file_handle =
+        CreateFileA(file_name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+    if (file_handle != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER file_size;
+        if (GetFileSizeEx(file_handle, &file_size) && file_size.QuadPart > 0) {
+            // NOTE: size 0 maps the whole file, no 4GB limit here
+            HANDLE mapping_handle = CreateFileMappingA(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (mapping_handle) {
+                result.memory = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+                if (result.memory) {
+                    result.size            = (uint64_t)file_size.QuadPart;
+                    result.platform_handle = mapping_handle;
+                } else {
+                    // TODO: logging
+                    CloseHandle(mapping_handle);
+                }
+            } else {
+                // TODO: logging
+            }
+        } else {
+            // TODO: logging
+        }
+
+        // NOTE: the mapping keeps its own reference to the file
+        CloseHandle(file_handle);
+    } else {
+        // TODO: logging
+    }
+
+    return result;
+}
+
+internal PLATFORM_UNMAP_FILE(Win32UnmapFile) {
+    if (file->memory) {
+        UnmapViewOfFile(file->memory);
+        CloseHandle((HANDLE)file->platform_handle);
+    }
+    *file = {};
+}
+
+/// Work queue
+internal bool
+Win32TryEnqueueWorkEntry(Platform_Work_Queue* queue, platform_work_queue_callback* callback, void* data) {
+    LONG64                     pos   = queue->enqueue_pos;
+    Platform_Work_Queue_Entry* entry = 0;
+    for (;;) {
+        entry           = &queue->entries[pos & (WORK_QUEUE_ENTRY_COUNT - 1)];
+        LONG64 sequence = entry->sequence;
+        LONG64 diff     = sequence - pos;
+        if (diff == 0) {
+            // NOTE: the slot is free for this position, try to claim it
+            LONG64 original_pos = InterlockedCompareExchange64(&queue->enqueue_pos, pos + 1, pos);
+            if (original_pos == pos) {
+                break;
+            }
+            pos = original_pos;
+        } else if (diff < 0) {
+            // NOTE: the consumer hasn't released this slot yet, the queue is full
+            return false;
+        } else {
+            pos = queue->enqueue_pos;
+        }
+    }
+
+    entry->callback = callback;
+    entry->data     = data;
+    // NOTE: make sure the entry is written before publishing it to the consumers
+    _WriteBarrier();
+    entry->sequence = pos + 1;
+    return true;
+}
+
+internal bool
+Win32TryDequeueWorkEntry(Platform_Work_Queue* queue, Platform_Work_Queue_Entry* result) {
+    LONG64                     pos   = queue->dequeue_pos;
+    Platform_Work_Queue_Entry* entry = 0;
+    for (;;) {
+        entry           = &queue->entries[pos & (WORK_QUEUE_ENTRY_COUNT - 1)];
+        LONG64 sequence = entry->sequence;
+        LONG64 diff     = sequence - (pos + 1);
+        if (diff == 0) {
+            LONG64 original_pos = InterlockedCompareExchange64(&queue->dequeue_pos, pos + 1, pos);
+            if (original_pos == pos) {
+                break;
+            }
+            pos = original_pos;
+        } else if (diff < 0) {
+            // NOTE: nothing has been published at this position, the queue is empty
+            return false;
+        } else {
+            pos = queue->dequeue_pos;
+        }
+    }
+
+    result->callback = entry->callback;
+    result->data     = entry->data;
+    _ReadWriteBarrier();
+    // NOTE: hand the slot back to producers one lap later
+    entry->sequence = pos + WORK_QUEUE_ENTRY_COUNT;
+    return true;
+}
+
+// NOTE: returns false when there was nothing to do
+internal bool
+Win32DoNextWorkQueueEntry(Platform_Work_Queue* queue) {
+    Platform_Work_Queue_Entry entry;
+    bool                      did_work = Win32TryDequeueWorkEntry(queue, &entry);
+    if (did_work) {
+        entry.callback(queue, entry.data);
+        InterlockedIncrement64(&queue->completion_count);
+    }
+    return did_work;
+}
+
+internal PLATFORM_ADD_WORK_QUEUE_ENTRY(Win32AddWorkQueueEntry) {
+    InterlockedIncrement64(&queue->completion_goal);
+    while (!Win32TryEnqueueWorkEntry(queue, callback, data)) {
+        // NOTE: the queue is full, help draining it instead of spinning
+        if (!Win32DoNextWorkQueueEntry(queue)) {
+            _mm_pause();
+        }
+    }
+    ReleaseSemaphore(queue->semaphore_handle, 1, 0);
+}
+
+internal PLATFORM_COMPLETE_ALL_WORK(Win32CompleteAllWork) {
+    // NOTE: the calling thread works on the queue too instead of just waiting for the workers
+    while (queue->completion_count != queue->completion_goal) {
+        if (!Win32DoNextWorkQueueEntry(queue)) {
+            _mm_pause();
+        }
+    }
+}
+
+internal DWORD WINAPI
+Win32WorkerThreadProc(LPVOID parameter) {
+    Win32_Thread_Info*   thread_info = (Win32_Thread_Info*)parameter;
+    Platform_Work_Queue* queue       = thread_info->queue;
+
+    for (;;) {
+        if (!Win32DoNextWorkQueueEntry(queue)) {
+            WaitForSingleObjectEx(queue->semaphore_handle, INFINITE, FALSE);
+        }
+    }
+}
+
+// NOTE: thread_count is the number of worker threads, the thread calling Win32CompleteAllWork is not included.
+internal void
+Win32MakeWorkQueue(Platform_Work_Queue* queue, int thread_count, Win32_Thread_Info* thread_infos) {
+    Assert(thread_count <= WORK_QUEUE_MAX_THREADS);
+
+    queue->enqueue_pos      = 0;
+    queue->dequeue_pos      = 0;
+    queue->completion_goal  = 0;
+    queue->completion_count = 0;
+    queue->thread_count     = thread_count;
+    for (LONG64 entry_idx = 0; entry_idx < WORK_QUEUE_ENTRY_COUNT; ++entry_idx) {
+        queue->entries[entry_idx].sequence = entry_idx;
+    }
+
+    queue->semaphore_handle = CreateSemaphoreExA(0, 0, thread_count, 0, 0, SEMAPHORE_ALL_ACCESS);
+
+    for (int thread_idx = 0; thread_idx < thread_count; ++thread_idx) {
+        Win32_Thread_Info* thread_info  = &thread_infos[thread_idx];
+        thread_info->logical_thread_idx = thread_idx + 1; // 0 is the main thread
+        thread_info->queue              = queue;
+
+        DWORD  thread_id;
+        HANDLE thread_handle = CreateThread(0, 0, Win32WorkerThreadProc, thread_info, 0, &thread_id);
+        CloseHandle(thread_handle);
+    }
+}
+
+internal int
+Win32GetWorkerThreadCount(void) {
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+
+    // NOTE: leave one logical core for the main thread
+    int thread_count = (int)system_info.dwNumberOfProcessors - 1;
+    if (thread_count < 1) {
+        thread_count = 1;
+    }
+    if (thread_count > WORK_QUEUE_MAX_THREADS) {
+        thread_count = WORK_QUEUE_MAX_THREADS;
+    }
+    return thread_count;
+}
+
+/// File I/O
+global Win32_File_IO g_file_io;
+
+internal void
+Win32InitFileIO(Platform_Work_Queue* fallback_queue) {
+    g_file_io.fallback_queue = fallback_queue;
+    for (int op_idx = 0; op_idx < WIN32_MAX_FILE_OPS; ++op_idx) {
+        Win32_File_Op* op     = &g_file_io.ops[op_idx];
+        op->state             = Win32FileOp_Free;
+        op->overlapped.hEvent = CreateEventA(0, TRUE, FALSE, 0);
+    }
+}
+
+internal HANDLE
+Win32CreateFileForFlags(const char* file_name, uint32_t open_flags, DWORD extra_flags) {
+    DWORD access   = 0;
+    DWORD creation = OPEN_EXISTING;
+    if (open_flags & PlatformOpenFile_Read) {
+        access |= GENERIC_READ;
+    }
+    if (open_flags & PlatformOpenFile_Write) {
+        access |= GENERIC_WRITE;
+        creation = OPEN_ALWAYS;
+    }
+    if (open_flags & PlatformOpenFile_Create) {
+        creation = CREATE_ALWAYS;
+    }
+
+    DWORD  attributes = FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED | extra_flags;
+    HANDLE result     = CreateFileA(file_name, access, FILE_SHARE_READ, NULL, creation, attributes, NULL);
+    return result;
+}
+
+// NOTE: extra_flags is for callers that want e.g. FILE_FLAG_NO_BUFFERING, the game goes through Win32OpenFile
+internal Platform_File_Handle
+Win32OpenFileWithFlags(const char* file_name, uint32_t open_flags, DWORD extra_flags) {
+    Platform_File_Handle result = {};
+
+    HANDLE file_handle = Win32CreateFileForFlags(file_name, open_flags, extra_flags);
+    if (file_handle != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER file_size;
+        if (GetFileSizeEx(file_handle, &file_size)) {
+            result.platform_handle = file_handle;
+            result.size            = (uint64_t)file_size.QuadPart;
+        } else {
+            // TODO: logging
+            CloseHandle(file_handle);
+        }
+    } else {
+        // TODO: logging
+    }
+
+    return result;
+}
+
+internal PLATFORM_OPEN_FILE(Win32OpenFile) {
+    return Win32OpenFileWithFlags(file_name, open_flags, 0);
+}
+
+internal PLATFORM_CLOSE_FILE(Win32CloseFile) {
+    if (file->platform_handle) {
+        CloseHandle((HANDLE)file->platform_handle);
+    }
+    *file = {};
+}
+
+// NOTE: the op goes through a blocking overlapped call here, this only runs on the I/O threads
+internal PLATFORM_WORK_QUEUE_CALLBACK(Win32DoFileOpFallback) {
+    Win32_File_Op* op = (Win32_File_Op*)data;
+
+    BOOL issued = op->is_write ? WriteFile(op->file_handle, op->memory, op->size, NULL, &op->overlapped)
+                               : ReadFile(op->file_handle, op->memory, op->size, NULL, &op->overlapped);
+    DWORD bytes_transferred = 0;
+    bool  succeeded         = false;
+    if (issued || GetLastError() == ERROR_IO_PENDING) {
+        succeeded = GetOverlappedResult(op->file_handle, &op->overlapped, &bytes_transferred, TRUE);
+    }
+
+    op->bytes_transferred = bytes_transferred;
+    InterlockedExchange(&op->state, succeeded ? Win32FileOp_Complete : Win32FileOp_Failed);
+}
+
+// NOTE: the errors where the kernel couldn't queue the op for lack of resources, the op itself is fine and can be done
+// blocking on an I/O thread
+internal bool
+Win32IsFileOpRefused(DWORD error) {
+    return error == ERROR_NOT_ENOUGH_MEMORY || error == ERROR_INVALID_USER_BUFFER || error == ERROR_NOT_ENOUGH_QUOTA ||
+           error == ERROR_WORKING_SET_QUOTA || error == ERROR_NO_SYSTEM_RESOURCES;
+}
+
+internal Platform_File_Op
+Win32IssueFileOp(Platform_File_Handle* file, uint64_t offset, uint32_t size, void* memory, bool is_write) {
+    Platform_File_Op result = {};
+
+    // NOTE: find a free slot, starting after the last one handed out
+    Win32_File_Op* op         = 0;
+    LONG           start_slot = InterlockedIncrement(&g_file_io.next_slot);
+    for (int slot_offset = 0; slot_offset < WIN32_MAX_FILE_OPS; ++slot_offset) {
+        uint32_t       slot      = (uint32_t)(start_slot + slot_offset) % WIN32_MAX_FILE_OPS;
+        Win32_File_Op* candidate = &g_file_io.ops[slot];
+        if (InterlockedCompareExchange(&candidate->state, Win32FileOp_Reserved, Win32FileOp_Free) ==
+            Win32FileOp_Free) {
+            op = candidate;
+
+            LONG generation = InterlockedIncrement(&op->generation);
+            if (generation == 0) {
+                generation = InterlockedIncrement(&op->generation);
+            }
+            result.slot       = slot;
+            result.generation = (uint32_t)generation;
+            break;
+        }
+    }
+
+    if (op && file->platform_handle) {
+        HANDLE event_handle = op->overlapped.hEvent;
+        ResetEvent(event_handle);
+
+        op->overlapped            = {};
+        op->overlapped.Offset     = (DWORD)(offset & 0xFFFFFFFF);
+        op->overlapped.OffsetHigh = (DWORD)(offset >> 32);
+        op->overlapped.hEvent     = event_handle;
+        op->file_handle           = (HANDLE)file->platform_handle;
+        op->memory                = memory;
+        op->size                  = size;
+        op->is_write              = is_write;
+        op->bytes_transferred     = 0;
+
+        bool is_overlapped = false;
+        bool is_refused    = true;
+        if (!g_file_io.force_fallback) {
+            BOOL  issued  = is_write ? WriteFile(op->file_handle, memory, size, NULL, &op->overlapped)
+                                     : ReadFile(op->file_handle, memory, size, NULL, &op->overlapped);
+            DWORD error   = issued ? ERROR_SUCCESS : GetLastError();
+            is_overlapped = issued || error == ERROR_IO_PENDING;
+            is_refused    = Win32IsFileOpRefused(error);
+        }
+
+        if (is_overlapped) {
+            InterlockedExchange(&op->state, Win32FileOp_Overlapped);
+        } else if (is_refused) {
+            // NOTE: the kernel couldn't queue it right now, do it on an I/O thread
+            InterlockedExchange(&op->state, Win32FileOp_Queued);
+            Win32AddWorkQueueEntry(g_file_io.fallback_queue, Win32DoFileOpFallback, op);
+        } else {
+            // NOTE: a bad handle, offset or end of file fails the same way however it is issued
+            InterlockedExchange(&op->state, Win32FileOp_Failed);
+        }
+    } else if (op) {
+        InterlockedExchange(&op->state, Win32FileOp_Failed);
+    } else {
+        result.is_busy = true;
+    }
+
+    return result;
+}
+
+internal PLATFORM_READ_FILE_ASYNC(Win32ReadFileAsync) {
+    return Win32IssueFileOp(file, offset, size, dest, false);
+}
+
+internal PLATFORM_WRITE_FILE_ASYNC(Win32WriteFileAsync) {
+    return Win32IssueFileOp(file, offset, size, (void*)source, true);
+}
+
+internal PLATFORM_POLL_FILE_OP(Win32PollFileOp) {
+    Platform_File_Op_State result = PlatformFileOp_Invalid;
+
+    if (op.generation && op.slot < WIN32_MAX_FILE_OPS) {
+        Win32_File_Op* file_op = &g_file_io.ops[op.slot];
+        LONG           state   = file_op->state;
+        if ((uint32_t)file_op->generation == op.generation && state != Win32FileOp_Free) {
+            result = PlatformFileOp_Pending;
+
+            if (state == Win32FileOp_Overlapped) {
+                DWORD bytes = 0;
+                if (GetOverlappedResult(file_op->file_handle, &file_op->overlapped, &bytes, FALSE)) {
+                    file_op->bytes_transferred = bytes;
+                    state                      = Win32FileOp_Complete;
+                } else if (GetLastError() != ERROR_IO_INCOMPLETE) {
+                    state = Win32FileOp_Failed;
+                }
+            }
+
+            if (state == Win32FileOp_Complete || state == Win32FileOp_Failed) {
+                result = (state == Win32FileOp_Complete) ? PlatformFileOp_Complete : PlatformFileOp_Failed;
+                if (bytes_transferred) {
+                    *bytes_transferred = file_op->bytes_transferred;
+                }
+                // NOTE: retire the op, the slot can be handed out again
+                InterlockedExchange(&file_op->state, Win32FileOp_Free);
+            }
+        }
+    }
+
+    return result;
+}
+
 internal void
 Win32LoadXInput(void) {
     HMODULE XInputLib = LoadLibraryA("XInput1_3.dll");
@@ -136,37 +581,39 @@ Win32LoadXInput(void) {
 
 internal FILETIME
 Win32GetFileLastWriteTime(const char* file_name) {
-    FILETIME        last_writ_time = {};
-    WIN32_FIND_DATA find_data;
+    FILETIME                  last_write_time = {};
+    WIN32_FILE_ATTRIBUTE_DATA file_data;
 
-    HANDLE find_handle = FindFirstFileA(file_name, &find_data);
-    if (find_handle) {
-        last_writ_time = find_data.ftLastWriteTime;
-        FindClose(find_handle);
+    if (GetFileAttributesExA(file_name, GetFileExInfoStandard, &file_data)) {
+        last_write_time = file_data.ftLastWriteTime;
     }
 
-    return last_writ_time;
+    return last_write_time;
 }
 
 internal Win32_Game_Code
 Win32LoadGameCode(const char* source_dll_name, const char* temp_dll_name) {
     Win32_Game_Code result = {};
 
-    CopyFileA(source_dll_name, temp_dll_name, FALSE);
-    result.game_code_dll       = LoadLibraryA(temp_dll_name);
+    // NOTE: take the write time before copying, a rebuild that lands mid-copy then shows up as another change
     result.dll_last_write_time = Win32GetFileLastWriteTime(source_dll_name);
+    if (CopyFileA(source_dll_name, temp_dll_name, FALSE)) {
+        result.game_code_dll = LoadLibraryA(temp_dll_name);
+    }
 
     if (result.game_code_dll) {
         result.GameGetSoundSamples =
             (game_get_sound_samples*)GetProcAddress(result.game_code_dll, "GameGetSoundSamples");
         result.GameUpdateAndRender =
             (game_update_and_render*)GetProcAddress(result.game_code_dll, "GameUpdateAndRender");
-        result.is_valid = result.GameUpdateAndRender && result.GameGetSoundSamples;
+        result.GameShutdown = (game_shutdown*)GetProcAddress(result.game_code_dll, "GameShutdown");
+        result.is_valid     = result.GameUpdateAndRender && result.GameGetSoundSamples && result.GameShutdown;
     }
 
     if (!result.is_valid) {
         result.GameGetSoundSamples = GameGetSoundSamplesStub;
         result.GameUpdateAndRender = GameUpdateAndRenderStub;
+        result.GameShutdown        = GameShutdownStub;
     }
 
     return result;
@@ -179,6 +626,7 @@ Win32UnloadGameCode(Win32_Game_Code* game_code) {
         game_code->game_code_dll       = NULL;
         game_code->GameGetSoundSamples = GameGetSoundSamplesStub;
         game_code->GameUpdateAndRender = GameUpdateAndRenderStub;
+        game_code->GameShutdown        = GameShutdownStub;
         game_code->is_valid            = false;
     }
 }
@@ -254,31 +702,45 @@ Win32GetWindowDimension(HWND window) {
 }
 
 internal void
-Win32ResizeDIBSection(Win32_Offscreen_Buffer* buffer, int width, int height) {
+Win32ResizeDIBSection(Win32_Offscreen_Buffer* buffer, int width, int height, int pixel_format) {
 
     if (buffer->memory) {
         // maybe we can use MEM_DECOMMIT
-        VirtualFree(buffer->memory, 0, MEM_RELEASE);
+        Win32FreeMemory(buffer->memory, Win32MemoryTag_Framebuffer);
         // VirtualProtect?
     }
 
     buffer->width           = width;
     buffer->height          = height;
-    buffer->bytes_per_pixel = 4;
+    buffer->pixel_format    = pixel_format;
+    buffer->bytes_per_pixel = (pixel_format == GamePixelFormat_RGB565) ? 2 : 4;
+    buffer->pitch           = AlignPow2(width * buffer->bytes_per_pixel, FRAMEBUFFER_ROW_ALIGNMENT);
 
+    // NOTE: GDI takes the row stride from biWidth, so the DIB is as wide as the padded row and we only ever blit the
+    // first width pixels of each row
+    buffer->info                   = {};
     buffer->info.bmiHeader.biSize  = sizeof(buffer->info.bmiHeader);
-    buffer->info.bmiHeader.biWidth = width;
+    buffer->info.bmiHeader.biWidth = buffer->pitch / buffer->bytes_per_pixel;
     // If biHeight is negative, the bitmap is a top-down DIB with the origin at the upper left
     // corner.
 
-    buffer->info.bmiHeader.biHeight      = -height;
-    buffer->info.bmiHeader.biPlanes      = 1;  // must be 1
-    buffer->info.bmiHeader.biBitCount    = 32; // alignment?
-    buffer->info.bmiHeader.biCompression = BI_RGB;
+    buffer->info.bmiHeader.biHeight = -height;
+    buffer->info.bmiHeader.biPlanes = 1; // must be 1
+    if (pixel_format == GamePixelFormat_RGB565) {
+        buffer->info.bmiHeader.biBitCount    = 16;
+        buffer->info.bmiHeader.biCompression = BI_BITFIELDS;
+        buffer->info.color_masks[0]          = 0xF800;
+        buffer->info.color_masks[1]          = 0x07E0;
+        buffer->info.color_masks[2]          = 0x001F;
+    } else {
+        buffer->info.bmiHeader.biBitCount    = 32;
+        buffer->info.bmiHeader.biCompression = BI_RGB;
+    }
 
-    int bitmap_memory_size = width * height * buffer->bytes_per_pixel;
+    // NOTE: VirtualAlloc hands out pages, so every row starts on a cache line
+    int bitmap_memory_size = buffer->pitch * height;
     // need both reserve and commit
-    buffer->memory = VirtualAlloc(0, bitmap_memory_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    buffer->memory = Win32AllocateMemory(bitmap_memory_size, Win32MemoryTag_Framebuffer);
 }
 
 internal void
@@ -297,11 +759,169 @@ Win32DisplayBufferInWindow(HDC device_ctx, int window_width, int window_height,
         buffer.width,
         buffer.height,
         buffer.memory,
-        &buffer.info,
+        (BITMAPINFO*)&buffer.info,
         DIB_RGB_COLORS,
         SRCCOPY);
 }
 
+/// Dynamic resolution
+// NOTE: linear scale of each step, the rendered area goes down with the square
+global float32_t g_resolution_steps[RESOLUTION_STEP_COUNT] = {1.0f, 0.9f, 0.8f, 0.7f, 0.6f, 0.5f};
+
+internal void
+Win32InitResolutionGovernor(Win32_Resolution_Governor* governor, float32_t budget_ms) {
+    *governor           = {};
+    governor->budget_ms = budget_ms;
+}
+
+internal void
+Win32SetResolutionStep(Win32_Resolution_Governor* governor, int step_idx) {
+    float32_t old_scale = g_resolution_steps[governor->step_idx];
+    float32_t new_scale = g_resolution_steps[step_idx];
+
+    // NOTE: assume the cost follows the pixel count so the average doesn't have to relearn from scratch
+    governor->average_ms *= (new_scale * new_scale) / (old_scale * old_scale);
+    governor->step_idx        = step_idx;
+    governor->frames_over     = 0;
+    governor->frames_under    = 0;
+    governor->cooldown_frames = RESOLUTION_COOLDOWN_FRAMES;
+}
+
+// NOTE: feed it the work time of every frame, returns true when the render scale changed
+internal bool
+Win32UpdateResolutionGovernor(Win32_Resolution_Governor* governor, float32_t work_ms) {
+    if (governor->average_ms == 0.0f) {
+        governor->average_ms = work_ms;
+    } else {
+        governor->average_ms += 0.2f * (work_ms - governor->average_ms);
+    }
+
+    if (governor->cooldown_frames > 0) {
+        --governor->cooldown_frames;
+        return false;
+    }
+
+    int  step_idx    = governor->step_idx;
+    bool missed      = work_ms > governor->budget_ms;
+    bool over_budget = governor->average_ms > RESOLUTION_DROP_FRACTION * governor->budget_ms;
+    if (missed || over_budget) {
+        governor->frames_under = 0;
+        ++governor->frames_over;
+        // NOTE: a missed frame is already a visible hitch, don't wait for the average to catch up
+        if ((missed || governor->frames_over >= RESOLUTION_DROP_FRAMES) && step_idx < RESOLUTION_STEP_COUNT - 1) {
+            Win32SetResolutionStep(governor, step_idx + 1);
+            return true;
+        }
+    } else if (step_idx > 0) {
+        governor->frames_over = 0;
+
+        float32_t scale      = g_resolution_steps[step_idx];
+        float32_t next_scale = g_resolution_steps[step_idx - 1];
+        float32_t predicted  = governor->average_ms * (next_scale * next_scale) / (scale * scale);
+        if (predicted < RESOLUTION_RAISE_FRACTION * governor->budget_ms) {
+            if (++governor->frames_under >= RESOLUTION_RAISE_FRAMES) {
+                Win32SetResolutionStep(governor, step_idx - 1);
+                return true;
+            }
+        } else {
+            governor->frames_under = 0;
+        }
+    } else {
+        governor->frames_over = 0;
+    }
+    return false;
+}
+
+internal void
+Win32UpscaleBilinearBGRX(
+    Win32_Offscreen_Buffer* source, int source_width, int source_height, Win32_Offscreen_Buffer* dest) {
+    Assert(source_width >= 2 && source_height >= 2);
+
+    // NOTE: 16.16 fixed point source positions of the dest pixel centers, weights are 8 bits
+    int32_t step_x  = (source_width << 16) / dest->width;
+    int32_t step_y  = (source_height << 16) / dest->height;
+    int32_t start_x = step_x / 2 - 0x8000;
+    int32_t sy      = step_y / 2 - 0x8000;
+
+    __m128i zero = _mm_setzero_si128();
+
+    uint8_t* dest_row = (uint8_t*)dest->memory;
+    for (int y = 0; y < dest->height; ++y) {
+        int y0 = sy < 0 ? 0 : (sy >> 16);
+        int fy = sy < 0 ? 0 : ((sy >> 8) & 0xFF);
+        if (y0 > source_height - 2) {
+            y0 = source_height - 2;
+            fy = 256;
+        }
+        uint32_t* row0 = (uint32_t*)((uint8_t*)source->memory + y0 * source->pitch);
+        uint32_t* row1 = (uint32_t*)((uint8_t*)row0 + source->pitch);
+
+        __m128i wy0 = _mm_set1_epi16((int16_t)(256 - fy));
+        __m128i wy1 = _mm_set1_epi16((int16_t)fy);
+
+        uint32_t* dest_pixel = (uint32_t*)dest_row;
+        int32_t   sx         = start_x;
+        for (int x = 0; x < dest->width; ++x) {
+            int x0 = sx < 0 ? 0 : (sx >> 16);
+            int fx = sx < 0 ? 0 : ((sx >> 8) & 0xFF);
+            if (x0 > source_width - 2) {
+                x0 = source_width - 2;
+                fx = 256;
+            }
+
+            // NOTE: both neighbours of a row in one load, left pixel in the low four words after unpacking.
+            // 255 * 256 still fits in an unsigned word so the weighted sums can't overflow.
+            __m128i top = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i*)(row0 + x0)), zero);
+            __m128i bot = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i*)(row1 + x0)), zero);
+            __m128i col = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(top, wy0), _mm_mullo_epi16(bot, wy1)), 8);
+
+            int16_t wx0   = (int16_t)(256 - fx);
+            int16_t wx1   = (int16_t)fx;
+            __m128i mixed = _mm_mullo_epi16(col, _mm_set_epi16(wx1, wx1, wx1, wx1, wx0, wx0, wx0, wx0));
+            mixed         = _mm_srli_epi16(_mm_add_epi16(mixed, _mm_srli_si128(mixed, 8)), 8);
+
+            *dest_pixel++ = (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(mixed, mixed));
+            sx += step_x;
+        }
+        dest_row += dest->pitch;
+        sy += step_y;
+    }
+}
+
+// NOTE: 565 channels don't line up with bytes, nearest is good enough for the low bandwidth mode
+internal void
+Win32UpscaleNearest565(
+    Win32_Offscreen_Buffer* source, int source_width, int source_height, Win32_Offscreen_Buffer* dest) {
+    int32_t step_x = (source_width << 16) / dest->width;
+    int32_t step_y = (source_height << 16) / dest->height;
+
+    uint8_t* dest_row = (uint8_t*)dest->memory;
+    int32_t  sy       = step_y / 2;
+    for (int y = 0; y < dest->height; ++y) {
+        uint16_t* source_row = (uint16_t*)((uint8_t*)source->memory + (sy >> 16) * source->pitch);
+        uint16_t* dest_pixel = (uint16_t*)dest_row;
+        int32_t   sx         = step_x / 2;
+        for (int x = 0; x < dest->width; ++x) {
+            *dest_pixel++ = source_row[sx >> 16];
+            sx += step_x;
+        }
+        dest_row += dest->pitch;
+        sy += step_y;
+    }
+}
+
+// NOTE: stretches the top left source_width x source_height pixels of source over the whole of dest, both buffers
+// have the same pixel format
+internal void
+Win32UpscaleBuffer(Win32_Offscreen_Buffer* source, int source_width, int source_height, Win32_Offscreen_Buffer* dest) {
+    Assert(source->pixel_format == dest->pixel_format);
+    if (source->pixel_format == GamePixelFormat_RGB565) {
+        Win32UpscaleNearest565(source, source_width, source_height, dest);
+    } else {
+        Win32UpscaleBilinearBGRX(source, source_width, source_height, dest);
+    }
+}
+
 internal LRESULT CALLBACK
 MainWindowCallback(HWND window, UINT message, WPARAM wparam, LPARAM lparam) {
     LRESULT result = 0;
@@ -344,7 +964,7 @@ MainWindowCallback(HWND window, UINT message, WPARAM wparam, LPARAM lparam) {
 
             // redraw the window using the back buffer.
             Win32_Window_Dimension dimension = Win32GetWindowDimension(window);
-            Win32DisplayBufferInWindow(device_ctx, dimension.width, dimension.height, g_backbuffer);
+            Win32DisplayBufferInWindow(device_ctx, dimension.width, dimension.height, *g_display_buffer);
 
             EndPaint(window, &paint);
         } break;
@@ -431,6 +1051,109 @@ Win32ClearSoundBuffer(Win32_Sound_Output* sound_output) {
     }
 }
 
+/// Input events
+internal void
+Win32InitInputEventQueue(Win32_Input_Event_Queue* queue) {
+    queue->enqueue_pos   = 0;
+    queue->dequeue_pos   = 0;
+    queue->dropped_count = 0;
+    for (LONG64 entry_idx = 0; entry_idx < INPUT_EVENT_QUEUE_COUNT; ++entry_idx) {
+        queue->entries[entry_idx].sequence = entry_idx;
+    }
+}
+
+// NOTE: can be called from any thread, also how tests feed synthetic input. Input threads never wait on the game,
+// when the queue is full the event is dropped and counted.
+internal void
+Win32InjectInputEvent(Win32_Input_Event_Queue* queue, Game_Input_Event* event) {
+    LONG64                         pos   = queue->enqueue_pos;
+    Win32_Input_Event_Queue_Entry* entry = 0;
+    for (;;) {
+        entry           = &queue->entries[pos & (INPUT_EVENT_QUEUE_COUNT - 1)];
+        LONG64 sequence = entry->sequence;
+        LONG64 diff     = sequence - pos;
+        if (diff == 0) {
+            LONG64 original_pos = InterlockedCompareExchange64(&queue->enqueue_pos, pos + 1, pos);
+            if (original_pos == pos) {
+                break;
+            }
+            pos = original_pos;
+        } else if (diff < 0) {
+            InterlockedIncrement(&queue->dropped_count);
+            return;
+        } else {
+            pos = queue->enqueue_pos;
+        }
+    }
+
+    entry->event = *event;
+    _WriteBarrier();
+    entry->sequence = pos + 1;
+}
+
+inline int64_t
+Win32GetInputTimestamp(void) {
+    LARGE_INTEGER result;
+    QueryPerformanceCounter(&result);
+    return result.QuadPart;
+}
+
+// NOTE: window messages are stamped with the tick count, so this is only as precise as the system timer, but it does
+// account for the time the message sat in the queue before we got to it.
+// TODO: raw input on its own thread would let us stamp keys with the performance counter directly
+internal int64_t
+Win32GetMessageTimestamp(DWORD message_time) {
+    int64_t now    = Win32GetInputTimestamp();
+    DWORD   age_ms = GetTickCount() - message_time;
+    int64_t result = now - (int64_t)age_ms * g_perf_count_freq / 1000;
+    return result;
+}
+
+internal Game_Input_Event
+Win32MakeButtonEvent(int64_t timestamp, int controller_idx, int button_idx, bool is_down) {
+    Game_Input_Event result = {};
+    result.timestamp        = timestamp;
+    result.type             = GameInputEvent_Button;
+    result.controller_idx   = (uint8_t)controller_idx;
+    result.button_idx       = (uint8_t)button_idx;
+    result.is_down          = is_down;
+    return result;
+}
+
+// NOTE: each producer pushes in time order, sorting here interleaves the keyboard and the gamepads
+internal void
+Win32DrainInputEvents(Win32_Input_Event_Queue* queue, Game_Input* input) {
+    input->event_count          = 0;
+    input->dropped_event_count  = (uint32_t)InterlockedExchange(&queue->dropped_count, 0);
+    input->consumed_latency_tag = 0;
+    for (;;) {
+        Win32_Input_Event_Queue_Entry* entry = &queue->entries[queue->dequeue_pos & (INPUT_EVENT_QUEUE_COUNT - 1)];
+        if (entry->sequence != queue->dequeue_pos + 1) {
+            break;
+        }
+        _ReadWriteBarrier();
+
+        if (input->event_count < ArrayCount(input->events)) {
+            input->events[input->event_count++] = entry->event;
+        } else {
+            ++input->dropped_event_count;
+        }
+        _ReadWriteBarrier();
+        entry->sequence = queue->dequeue_pos + INPUT_EVENT_QUEUE_COUNT;
+        ++queue->dequeue_pos;
+    }
+
+    for (uint32_t event_idx = 1; event_idx < input->event_count; ++event_idx) {
+        Game_Input_Event event     = input->events[event_idx];
+        uint32_t         insert_at = event_idx;
+        while (insert_at > 0 && input->events[insert_at - 1].timestamp > event.timestamp) {
+            input->events[insert_at] = input->events[insert_at - 1];
+            --insert_at;
+        }
+        input->events[insert_at] = event;
+    }
+}
+
 internal void
 Win32ProcessKeyboardMessage(Game_Button_State* new_state, bool is_down) {
     // BUG(resolved): this assertion fails when I keep pressing the same button and don't release
@@ -445,7 +1168,8 @@ Win32ProcessKeyboardMessage(Game_Button_State* new_state, bool is_down) {
 }
 
 internal void
-Win32ProcessPendingMessages(Game_Controller_Input* keyboard_controller) {
+Win32ProcessPendingMessages(
+    Game_Controller_Input* keyboard_controller, Win32_Input_Event_Queue* event_queue, Win32_Save_System* save_system) {
     MSG message = {};
     while (PeekMessage(&message, 0, 0, 0, PM_REMOVE)) {
         switch (message.message) {
@@ -463,48 +1187,78 @@ Win32ProcessPendingMessages(Game_Controller_Input* keyboard_controller) {
 
                 // half transition
                 if (was_down != is_down) {
+                    Game_Button_State* button = 0;
                     switch (vk_code) {
                         case 'W': {
-                            Win32ProcessKeyboardMessage(&keyboard_controller->move_up, is_down);
+                            button = &keyboard_controller->move_up;
                         } break;
                         case 'A': {
-                            Win32ProcessKeyboardMessage(&keyboard_controller->move_left, is_down);
+                            button = &keyboard_controller->move_left;
                         } break;
                         case 'S': {
-                            Win32ProcessKeyboardMessage(&keyboard_controller->move_down, is_down);
+                            button = &keyboard_controller->move_down;
                         } break;
                         case 'D': {
-                            Win32ProcessKeyboardMessage(&keyboard_controller->move_right, is_down);
+                            button = &keyboard_controller->move_right;
                         } break;
                         case 'Q': {
-                            Win32ProcessKeyboardMessage(&keyboard_controller->left_shoulder, is_down);
+                            button = &keyboard_controller->left_shoulder;
                         } break;
                         case 'E': {
-                            Win32ProcessKeyboardMessage(&keyboard_controller->right_shoulder, is_down);
+                            button = &keyboard_controller->right_shoulder;
                         } break;
                         case VK_UP: {
-                            Win32ProcessKeyboardMessage(&keyboard_controller->action_up, is_down);
+                            button = &keyboard_controller->action_up;
                         } break;
                         case VK_LEFT: {
-                            Win32ProcessKeyboardMessage(&keyboard_controller->action_left, is_down);
+                            button = &keyboard_controller->action_left;
                         } break;
                         case VK_DOWN: {
-                            Win32ProcessKeyboardMessage(&keyboard_controller->action_down, is_down);
+                            button = &keyboard_controller->action_down;
                         } break;
                         case VK_RIGHT: {
-                            Win32ProcessKeyboardMessage(&keyboard_controller->action_right, is_down);
+                            button = &keyboard_controller->action_right;
                         } break;
                         case VK_ESCAPE: {
-                            Win32ProcessKeyboardMessage(&keyboard_controller->back, is_down);
+                            button = &keyboard_controller->back;
                         } break;
                         case VK_SPACE: {
-                            Win32ProcessKeyboardMessage(&keyboard_controller->start, is_down);
+                            button = &keyboard_controller->start;
                         } break;
                         case 'P': {
                             if (is_down) {
                                 g_pause = !g_pause;
                             }
                         } break;
+                        case VK_F1: {
+                            if (is_down) {
+                                g_show_debug_overlay = !g_show_debug_overlay;
+                            }
+                        } break;
+                        case VK_F2: {
+                            if (is_down) {
+                                g_write_memory_report = true;
+                            }
+                        } break;
+                        case VK_F5: {
+                            if (is_down) {
+                                save_system->requested_state = Win32Save_Saving;
+                            }
+                        } break;
+                        case VK_F9: {
+                            if (is_down) {
+                                save_system->requested_state = Win32Save_Loading;
+                            }
+                        } break;
+                    }
+
+                    if (button && !g_pause) {
+                        Win32ProcessKeyboardMessage(button, is_down);
+
+                        int              button_idx = (int)(button - keyboard_controller->buttons);
+                        Game_Input_Event event =
+                            Win32MakeButtonEvent(Win32GetMessageTimestamp(message.time), 0, button_idx, is_down);
+                        Win32InjectInputEvent(event_queue, &event);
                     }
                 }
 
@@ -540,125 +1294,1457 @@ Win32NormalizeAnalogStickInput(int16_t stick, int16_t deadzone) {
     return normalized_input;
 }
 
-inline LARGE_INTEGER
-Win32GetWallClock(void) {
-    LARGE_INTEGER result;
-    QueryPerformanceCounter(&result);
-    return result;
-}
-
-inline float32_t
-Win32GetMilliSecondsElapsed(LARGE_INTEGER start, LARGE_INTEGER end) {
-    float32_t ms_elapsed = 1000.0f * (float32_t)(end.QuadPart - start.QuadPart) / (float32_t)g_perf_count_freq;
-    return ms_elapsed;
-}
-
+// NOTE: shared by the frame loop and the poll thread so both see the same mapping
 internal void
-Win32DebugDrawVertical(Win32_Offscreen_Buffer* backbuffer, int x, int top, int bottom, uint32_t color) {
-    int      pitch = backbuffer->width * backbuffer->bytes_per_pixel;
-    uint8_t* pixel = (uint8_t*)backbuffer->memory + top * pitch + x * backbuffer->bytes_per_pixel;
-
-    for (int y = top; y < bottom; ++y) {
-        *(uint32_t*)pixel = color;
-        pixel += pitch;
+Win32ProcessXInputGamepad(
+    XINPUT_GAMEPAD* gamepad, Game_Controller_Input* old_controller, Game_Controller_Input* new_controller) {
+    // XInput -> Game_Input
+    Win32ProcessXInputDigitalButton(
+        gamepad->wButtons, XINPUT_GAMEPAD_START, &old_controller->start, &new_controller->start);
+    Win32ProcessXInputDigitalButton(
+        gamepad->wButtons, XINPUT_GAMEPAD_BACK, &old_controller->back, &new_controller->back);
+
+    Win32ProcessXInputDigitalButton(
+        gamepad->wButtons,
+        XINPUT_GAMEPAD_LEFT_SHOULDER,
+        &old_controller->left_shoulder,
+        &new_controller->left_shoulder);
+    Win32ProcessXInputDigitalButton(
+        gamepad->wButtons,
+        XINPUT_GAMEPAD_RIGHT_SHOULDER,
+        &old_controller->right_shoulder,
+        &new_controller->right_shoulder);
+
+    Win32ProcessXInputDigitalButton(
+        gamepad->wButtons, XINPUT_GAMEPAD_X, &old_controller->action_left, &new_controller->action_left);
+    Win32ProcessXInputDigitalButton(
+        gamepad->wButtons, XINPUT_GAMEPAD_Y, &old_controller->action_up, &new_controller->action_up);
+    Win32ProcessXInputDigitalButton(
+        gamepad->wButtons, XINPUT_GAMEPAD_A, &old_controller->action_down, &new_controller->action_down);
+    Win32ProcessXInputDigitalButton(
+        gamepad->wButtons, XINPUT_GAMEPAD_B, &old_controller->action_right, &new_controller->action_right);
+
+    // sticks
+    new_controller->is_analog   = true;
+    new_controller->stick_avg_x = Win32NormalizeAnalogStickInput(gamepad->sThumbLX, XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE);
+    new_controller->stick_avg_y = Win32NormalizeAnalogStickInput(gamepad->sThumbLY, XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE);
+
+    bool dpad_up    = gamepad->wButtons & XINPUT_GAMEPAD_DPAD_UP;
+    bool dpad_down  = gamepad->wButtons & XINPUT_GAMEPAD_DPAD_DOWN;
+    bool dpad_left  = gamepad->wButtons & XINPUT_GAMEPAD_DPAD_LEFT;
+    bool dpad_right = gamepad->wButtons & XINPUT_GAMEPAD_DPAD_RIGHT;
+    if (dpad_up) {
+        new_controller->stick_avg_y = -1.0;
+        new_controller->is_analog   = false;
     }
+    if (dpad_down) {
+        new_controller->stick_avg_y = 1.0;
+        new_controller->is_analog   = false;
+    }
+    if (dpad_left) {
+        new_controller->stick_avg_x = -1.0;
+        new_controller->is_analog   = false;
+    }
+    if (dpad_right) {
+        new_controller->stick_avg_x = 1.0;
+        new_controller->is_analog   = false;
+    }
+    float32_t threshold = 0.5f;
+    Win32ProcessXInputDigitalButton(
+        new_controller->stick_avg_x < -threshold ? 1 : 0, 1, &old_controller->move_left, &new_controller->move_left);
+    Win32ProcessXInputDigitalButton(
+        new_controller->stick_avg_x > threshold ? 1 : 0, 1, &old_controller->move_right, &new_controller->move_right);
+    Win32ProcessXInputDigitalButton(
+        new_controller->stick_avg_y < -threshold ? 1 : 0, 1, &old_controller->move_up, &new_controller->move_up);
+    Win32ProcessXInputDigitalButton(
+        new_controller->stick_avg_y > threshold ? 1 : 0, 1, &old_controller->move_down, &new_controller->move_down);
 }
 
-inline void
-Win32DrawSoundBufferMarker(
-    Win32_Offscreen_Buffer* backbuffer,
-    Win32_Sound_Output*     sound_output,
-    int                     padx,
-    int                     top,
-    int                     bottom,
-    DWORD                   value,
-    uint32_t                color) {
+// NOTE: Sleep(1) relies on timeBeginPeriod(1) having been called, otherwise this polls at the scheduler granularity
+internal DWORD WINAPI
+Win32XInputPollThreadProc(LPVOID parameter) {
+    Win32_XInput_Poller* poller = (Win32_XInput_Poller*)parameter;
+    for (uint32_t poll_idx = 0;; ++poll_idx) {
+        for (int gamepad_idx = 0; gamepad_idx < WIN32_MAX_GAMEPADS; ++gamepad_idx) {
+            Game_Controller_Input* old_controller = &poller->controllers[gamepad_idx];
+
+            // NOTE: XInputGetState on an empty port is slow, only look for new controllers every so often
+            if (!old_controller->is_connected && (poll_idx % 512) != 0) {
+                continue;
+            }
+
+            XINPUT_STATE controller_state = {};
+            if (XInputGetState(gamepad_idx, &controller_state) != ERROR_SUCCESS) {
+                old_controller->is_connected = false;
+                continue;
+            }
+            // NOTE: the packet number only changes when the controller state does
+            DWORD packet_number = controller_state.dwPacketNumber;
+            if (old_controller->is_connected && packet_number == poller->packet_numbers[gamepad_idx]) {
+                continue;
+            }
+            poller->packet_numbers[gamepad_idx] = packet_number;
+
+            int64_t               timestamp      = Win32GetInputTimestamp();
+            int                   controller_idx = gamepad_idx + 1; // 0 is the keyboard
+            Game_Controller_Input new_controller = {};
+            new_controller.is_connected          = true;
+            Win32ProcessXInputGamepad(&controller_state.Gamepad, old_controller, &new_controller);
+
+            for (int button_idx = 0; button_idx < ArrayCount(new_controller.buttons); ++button_idx) {
+                bool is_down = new_controller.buttons[button_idx].ended_down;
+                if (is_down != old_controller->buttons[button_idx].ended_down) {
+                    Game_Input_Event event = Win32MakeButtonEvent(timestamp, controller_idx, button_idx, is_down);
+                    Win32InjectInputEvent(poller->queue, &event);
+                }
+            }
+
+            if (new_controller.stick_avg_x != old_controller->stick_avg_x ||
+                new_controller.stick_avg_y != old_controller->stick_avg_y) {
+                Game_Input_Event event = {};
+                event.timestamp        = timestamp;
+                event.type             = GameInputEvent_Stick;
+                event.controller_idx   = (uint8_t)controller_idx;
+                event.stick_x          = new_controller.stick_avg_x;
+                event.stick_y          = new_controller.stick_avg_y;
+                Win32InjectInputEvent(poller->queue, &event);
+            }
+
+            *old_controller = new_controller;
+        }
+        Sleep(1);
+    }
+}
+
+internal void
+Win32StartXInputPoller(Win32_XInput_Poller* poller, Win32_Input_Event_Queue* queue) {
+    poller->queue = queue;
+
+    DWORD  thread_id;
+    HANDLE thread_handle = CreateThread(0, 0, Win32XInputPollThreadProc, poller, 0, &thread_id);
+    CloseHandle(thread_handle);
+}
+
+// NOTE: the once per frame XInput sample can't see a press and release that both happen between two frames, the
+// poll thread's events can. Make sure the summary counts at least as many transitions as there were events.
+internal void
+Win32ApplyGamepadEventTransitions(Game_Input* input) {
+    int transition_counts[ArrayCount(input->controllers)][ArrayCount(input->controllers[0].buttons)] = {};
+    for (uint32_t event_idx = 0; event_idx < input->event_count; ++event_idx) {
+        Game_Input_Event* event = &input->events[event_idx];
+        if (event->type == GameInputEvent_Button && event->controller_idx > 0) {
+            ++transition_counts[event->controller_idx][event->button_idx];
+        }
+    }
+
+    for (int controller_idx = 1; controller_idx < ArrayCount(input->controllers); ++controller_idx) {
+        Game_Controller_Input* controller = &input->controllers[controller_idx];
+        for (int button_idx = 0; button_idx < ArrayCount(controller->buttons); ++button_idx) {
+            Game_Button_State* button = &controller->buttons[button_idx];
+            if (button->half_transition_count < transition_counts[controller_idx][button_idx]) {
+                button->half_transition_count = transition_counts[controller_idx][button_idx];
+            }
+        }
+    }
+}
+
+inline LARGE_INTEGER
+Win32GetWallClock(void) {
+    LARGE_INTEGER result;
+    QueryPerformanceCounter(&result);
+    return result;
+}
+
+inline float32_t
+Win32GetMilliSecondsElapsed(LARGE_INTEGER start, LARGE_INTEGER end) {
+    float32_t ms_elapsed = 1000.0f * (float32_t)(end.QuadPart - start.QuadPart) / (float32_t)g_perf_count_freq;
+    return ms_elapsed;
+}
+
+/// Idle tasks
+internal PLATFORM_ADD_IDLE_TASK(Win32AddIdleTask) {
+    bool added = queue->task_count < WIN32_MAX_IDLE_TASKS;
+    if (added) {
+        Win32_Idle_Task* task = &queue->tasks[queue->task_count++];
+        task->callback        = callback;
+        task->data            = data;
+    }
+    return added;
+}
+
+internal PLATFORM_IDLE_SHOULD_YIELD(Win32IdleShouldYield) {
+    return !queue->must_finish && Win32GetWallClock().QuadPart >= queue->deadline;
+}
+
+// NOTE: every task gets a call in turn until the deadline, the ones that finish leave the queue. Returns the time
+// spent in ms.
+internal float32_t
+Win32RunIdleTasks(Platform_Idle_Queue* queue, LARGE_INTEGER deadline) {
+    LARGE_INTEGER start = Win32GetWallClock();
+    queue->deadline     = deadline.QuadPart;
+
+    uint32_t call_count = queue->task_count;
+    if (queue->next_task_idx >= queue->task_count) {
+        queue->next_task_idx = 0;
+    }
+    for (uint32_t call_idx = 0; call_idx < call_count && !Win32IdleShouldYield(queue); ++call_idx) {
+        Win32_Idle_Task task = queue->tasks[queue->next_task_idx];
+        ++queue->call_count;
+        if (task.callback(queue, task.data)) {
+            // NOTE: keeps the order, the next task slides into this one's place
+            --queue->task_count;
+            memmove(
+                &queue->tasks[queue->next_task_idx],
+                &queue->tasks[queue->next_task_idx + 1],
+                (queue->task_count - queue->next_task_idx) * sizeof(Win32_Idle_Task));
+            ++queue->finished_count;
+        } else {
+            ++queue->next_task_idx;
+        }
+        if (queue->next_task_idx >= queue->task_count) {
+            queue->next_task_idx = 0;
+        }
+    }
+
+    LARGE_INTEGER end        = Win32GetWallClock();
+    float32_t     overrun_ms = 1000.0f * (float32_t)(end.QuadPart - deadline.QuadPart) / (float32_t)g_perf_count_freq;
+    if (overrun_ms > queue->max_overrun_ms) {
+        queue->max_overrun_ms = overrun_ms;
+    }
+    float32_t ms = Win32GetMilliSecondsElapsed(start, end);
+    queue->total_ms += ms;
+    return ms;
+}
+
+// NOTE: for when the game code is about to go away, tasks that are waiting on something are spun on
+internal void
+Win32FinishIdleTasks(Platform_Idle_Queue* queue) {
+    queue->must_finish = true;
+    while (queue->task_count) {
+        LARGE_INTEGER no_deadline;
+        no_deadline.QuadPart = INT64_MAX;
+        Win32RunIdleTasks(queue, no_deadline);
+    }
+    queue->must_finish = false;
+}
+
+/// Game code reloading
+internal void
+Win32InitGameCodeReloader(
+    Win32_Game_Code_Reloader* reloader, const char* exe_directory, Platform_Work_Queue* load_queue) {
+    sprintf_s(reloader->source_dll_path, "%shandmade.dll", exe_directory);
+    for (int temp_idx = 0; temp_idx < ArrayCount(reloader->temp_dll_paths); ++temp_idx) {
+        sprintf_s(reloader->temp_dll_paths[temp_idx], "%shandmade_temp_%d.dll", exe_directory, temp_idx);
+    }
+    reloader->next_temp_idx = 0;
+    reloader->load_queue    = load_queue;
+    reloader->state         = Win32Reload_Idle;
+    reloader->change_handle = FindFirstChangeNotificationA(exe_directory, FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE);
+}
+
+internal Win32_Game_Code
+Win32LoadInitialGameCode(Win32_Game_Code_Reloader* reloader) {
+    Win32_Game_Code result  = Win32LoadGameCode(reloader->source_dll_path, reloader->temp_dll_paths[0]);
+    reloader->next_temp_idx = 1;
+    return result;
+}
+
+internal PLATFORM_WORK_QUEUE_CALLBACK(Win32LoadGameCodeWork) {
+    Win32_Game_Code_Reloader* reloader      = (Win32_Game_Code_Reloader*)data;
+    const char*               temp_dll_path = reloader->temp_dll_paths[reloader->next_temp_idx];
+    LARGE_INTEGER             start         = Win32GetWallClock();
+
+    // NOTE: one attempt, the frame thread queues another if the linker wasn't done with the dll yet
+    Win32_Game_Code game_code = Win32LoadGameCode(reloader->source_dll_path, temp_dll_path);
+    if (!game_code.is_valid) {
+        Win32UnloadGameCode(&game_code);
+    }
+
+    reloader->pending = game_code;
+    reloader->load_ms = Win32GetMilliSecondsElapsed(start, Win32GetWallClock());
+    _WriteBarrier();
+    InterlockedExchange(&reloader->state, Win32Reload_Ready);
+}
+
+// NOTE: called once per frame. Only the swap waits on the file system, while the old dll writes back its files.
+internal void
+Win32UpdateGameCodeReload(
+    Win32_Game_Code_Reloader* reloader,
+    Win32_Game_Code*          game,
+    Game_Memory*              memory,
+    Platform_Work_Queue*      work_queue,
+    Platform_Idle_Queue*      idle_queue) {
+    LONG state = reloader->state;
+    _ReadWriteBarrier();
+
+    if (state == Win32Reload_Idle) {
+        bool directory_changed = true;
+        if (reloader->change_handle != INVALID_HANDLE_VALUE) {
+            directory_changed = (WaitForSingleObject(reloader->change_handle, 0) == WAIT_OBJECT_0);
+            if (directory_changed) {
+                FindNextChangeNotification(reloader->change_handle);
+            }
+        }
+
+        // NOTE: anything in the directory fires the notification (our own temp copies included), check the dll. A
+        // failed attempt checks again without waiting for another notification.
+        if (directory_changed || reloader->failed_attempt_count) {
+            FILETIME last_write_time = Win32GetFileLastWriteTime(reloader->source_dll_path);
+            if (CompareFileTime(&last_write_time, &game->dll_last_write_time) != 0) {
+                reloader->state = Win32Reload_Loading;
+                Win32AddWorkQueueEntry(reloader->load_queue, Win32LoadGameCodeWork, reloader);
+            } else {
+                reloader->failed_attempt_count = 0;
+            }
+        }
+    } else if (state == Win32Reload_Ready) {
+        LARGE_INTEGER swap_start = Win32GetWallClock();
+        bool          swapped    = reloader->pending.is_valid;
+        if (swapped) {
+            // NOTE: queued callbacks point into the old dll, finish them before it goes away
+            Win32CompleteAllWork(work_queue);
+            Win32FinishIdleTasks(idle_queue);
+            game->GameShutdown(memory);
+            Win32UnloadGameCode(game);
+            *game                          = reloader->pending;
+            reloader->next_temp_idx        = !reloader->next_temp_idx;
+            reloader->failed_attempt_count = 0;
+        } else if (++reloader->failed_attempt_count == WIN32_RELOAD_MAX_ATTEMPTS) {
+            // NOTE: keep running the old code, but don't retry this build until it changes again
+            game->dll_last_write_time      = reloader->pending.dll_last_write_time;
+            reloader->failed_attempt_count = 0;
+        }
+        reloader->pending  = {};
+        reloader->stall_ms = Win32GetMilliSecondsElapsed(swap_start, Win32GetWallClock());
+        reloader->state    = Win32Reload_Idle;
+
+        // NOTE: an attempt that is going to be retried isn't reported
+        if (swapped || !reloader->failed_attempt_count) {
+            char text_buffer[256];
+            sprintf_s(
+                text_buffer,
+                "game code reload %s: load %.2f ms (background), stall %.3f ms (frame)\n",
+                swapped ? "ok" : "failed",
+                reloader->load_ms,
+                reloader->stall_ms);
+            OutputDebugStringA(text_buffer);
+        }
+    }
+}
+
+/// Save states
+internal void
+Win32InitSaveSystem(Win32_Save_System* save, void* storage, uint64_t storage_size, Platform_Work_Queue* queue) {
+    *save              = {};
+    save->storage      = (uint8_t*)storage;
+    save->storage_size = storage_size;
+    save->queue        = queue;
+
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    save->page_size       = system_info.dwPageSize;
+    save->max_dirty_pages = (ULONG_PTR)(storage_size / system_info.dwPageSize);
+    save->dirty_pages   = (void**)Win32AllocateMemory(save->max_dirty_pages * sizeof(void*), Win32MemoryTag_SaveState);
+    save->unsaved_pages = (uint8_t*)Win32AllocateMemory(save->max_dirty_pages, Win32MemoryTag_SaveState);
+
+    // NOTE: the watch covers every write since the storage was allocated and the shadow starts out zeroed like the
+    // storage did, so the first snapshot only copies what the game touched
+    save->shadow = (uint8_t*)Win32AllocateMemory(storage_size, Win32MemoryTag_SaveState);
+
+    ULONG_PTR page_count = save->max_dirty_pages;
+    DWORD     page_size  = 0;
+    save->has_write_watch =
+        GetWriteWatch(0, save->storage, save->storage_size, save->dirty_pages, &page_count, &page_size) == 0;
+
+    uint64_t block_count = (storage_size + SAVE_FILE_BLOCK_SIZE - 1) / SAVE_FILE_BLOCK_SIZE;
+    save->file_capacity =
+        sizeof(Save_File_Header) + block_count * (sizeof(uint32_t) + LZCompressBound(SAVE_FILE_BLOCK_SIZE));
+    save->file_memory = (uint8_t*)Win32AllocateMemory(save->file_capacity, Win32MemoryTag_SaveState);
+}
+
+// NOTE: pages written since the last call end up in save->dirty_pages, returns how many. They are also remembered for
+// the next snapshot, so other users of the write watch don't take them away from the save.
+internal ULONG_PTR
+Win32CollectWrittenPages(Win32_Save_System* save) {
+    ULONG_PTR page_count = save->max_dirty_pages;
+    DWORD     page_size  = 0;
+    if (!save->has_write_watch) {
+        return 0;
+    }
+    if (GetWriteWatch(
+            WRITE_WATCH_FLAG_RESET,
+            save->storage,
+            save->storage_size,
+            save->dirty_pages,
+            &page_count,
+            &page_size) != 0) {
+        return 0;
+    }
+
+    for (ULONG_PTR page_idx = 0; page_idx < page_count; ++page_idx) {
+        uint64_t offset = (uint64_t)((uint8_t*)save->dirty_pages[page_idx] - save->storage);
+        save->unsaved_pages[offset / save->page_size] = 1;
+    }
+    return page_count;
+}
+
+// NOTE: brings the shadow up to date with the storage, this is the only part of a save on the frame thread
+internal void
+Win32SnapshotStorage(Win32_Save_System* save) {
+    if (save->has_write_watch) {
+        Win32CollectWrittenPages(save);
+
+        uint64_t copied_page_count = 0;
+        for (ULONG_PTR page_idx = 0; page_idx < save->max_dirty_pages; ++page_idx) {
+            if (save->unsaved_pages[page_idx]) {
+                uint64_t offset = (uint64_t)page_idx * save->page_size;
+                memcpy(save->shadow + offset, save->storage + offset, save->page_size);
+                save->unsaved_pages[page_idx] = 0;
+                ++copied_page_count;
+            }
+        }
+        save->snapshot_bytes = copied_page_count * save->page_size;
+    } else {
+        memcpy(save->shadow, save->storage, save->storage_size);
+        save->snapshot_bytes = save->storage_size;
+    }
+}
+
+// NOTE: returns the file size, file_memory needs room for the worst case (see Win32InitSaveSystem)
+internal uint64_t
+Win32CompressSave(uint8_t* storage, uint64_t storage_size, uint8_t* file_memory) {
+    Save_File_Header* header = (Save_File_Header*)file_memory;
+    header->magic            = SAVE_FILE_MAGIC;
+    header->version          = SAVE_FILE_VERSION;
+    header->block_size       = SAVE_FILE_BLOCK_SIZE;
+    header->block_count      = (uint32_t)((storage_size + SAVE_FILE_BLOCK_SIZE - 1) / SAVE_FILE_BLOCK_SIZE);
+    header->storage_size     = storage_size;
+
+    uint8_t* out = file_memory + sizeof(Save_File_Header);
+    for (uint32_t block_idx = 0; block_idx < header->block_count; ++block_idx) {
+        uint64_t offset    = (uint64_t)block_idx * SAVE_FILE_BLOCK_SIZE;
+        uint64_t remaining = storage_size - offset;
+        uint32_t raw_size  = (uint32_t)(remaining < SAVE_FILE_BLOCK_SIZE ? remaining : SAVE_FILE_BLOCK_SIZE);
+
+        uint32_t size = LZCompress(storage + offset, raw_size, out + sizeof(uint32_t));
+        if (size >= raw_size) {
+            memcpy(out + sizeof(uint32_t), storage + offset, raw_size);
+            size = raw_size;
+        }
+        memcpy(out, &size, sizeof(uint32_t));
+        out += sizeof(uint32_t) + size;
+    }
+    header->file_size = (uint64_t)(out - file_memory);
+    return header->file_size;
+}
+
+internal bool
+Win32DecompressSave(uint8_t* file_memory, uint64_t file_size, uint8_t* storage, uint64_t storage_size) {
+    Save_File_Header* header = (Save_File_Header*)file_memory;
+    if (file_size < sizeof(Save_File_Header) || header->magic != SAVE_FILE_MAGIC ||
+        header->version != SAVE_FILE_VERSION || header->file_size != file_size ||
+        header->storage_size != storage_size || header->block_size == 0 ||
+        (uint64_t)header->block_count * header->block_size < storage_size) {
+        return false;
+    }
+
+    uint8_t* in     = file_memory + sizeof(Save_File_Header);
+    uint8_t* in_end = file_memory + file_size;
+    for (uint32_t block_idx = 0; block_idx < header->block_count; ++block_idx) {
+        uint64_t offset = (uint64_t)block_idx * header->block_size;
+        if (offset >= storage_size || in_end - in < (int64_t)sizeof(uint32_t)) {
+            return false;
+        }
+        uint64_t remaining = storage_size - offset;
+        uint32_t raw_size  = (uint32_t)(remaining < header->block_size ? remaining : header->block_size);
+
+        uint32_t size;
+        memcpy(&size, in, sizeof(uint32_t));
+        in += sizeof(uint32_t);
+        if (size > (uint64_t)(in_end - in)) {
+            return false;
+        }
+
+        if (size == raw_size) {
+            memcpy(storage + offset, in, raw_size);
+        } else if (!LZDecompress(in, size, storage + offset, raw_size)) {
+            return false;
+        }
+        in += size;
+    }
+    return in == in_end;
+}
+
+// NOTE: the new file goes next to the old one first, only a complete and flushed file replaces it
+internal bool
+Win32WriteFileAtomic(const char* file_name, void* memory, uint64_t size) {
+    char temp_name[MAX_PATH];
+    sprintf_s(temp_name, "%s.tmp", file_name);
+
+    bool   result      = false;
+    HANDLE file_handle = CreateFileA(temp_name, GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+    if (file_handle != INVALID_HANDLE_VALUE) {
+        result             = true;
+        uint8_t* at        = (uint8_t*)memory;
+        uint64_t remaining = size;
+        while (result && remaining) {
+            DWORD chunk_size    = remaining > MegaBytes(16) ? (DWORD)MegaBytes(16) : (DWORD)remaining;
+            DWORD bytes_written = 0;
+            if (!WriteFile(file_handle, at, chunk_size, &bytes_written, 0) || bytes_written != chunk_size) {
+                result = false;
+            }
+            at += chunk_size;
+            remaining -= chunk_size;
+        }
+        result = result && FlushFileBuffers(file_handle);
+        CloseHandle(file_handle);
+
+        if (result) {
+            result = MoveFileExA(temp_name, file_name, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+        }
+        if (!result) {
+            DeleteFileA(temp_name);
+        }
+    }
+    return result;
+}
+
+internal PLATFORM_WORK_QUEUE_CALLBACK(Win32SaveWork) {
+    Win32_Save_System* save = (Win32_Save_System*)data;
+
+    LARGE_INTEGER start_counter = Win32GetWallClock();
+    save->file_size             = Win32CompressSave(save->shadow, save->storage_size, save->file_memory);
+    LARGE_INTEGER write_counter = Win32GetWallClock();
+    save->succeeded             = Win32WriteFileAtomic(save->file_name, save->file_memory, save->file_size);
+    save->compress_ms           = Win32GetMilliSecondsElapsed(start_counter, write_counter);
+    save->write_ms              = Win32GetMilliSecondsElapsed(write_counter, Win32GetWallClock());
+
+    InterlockedExchange(&save->state, Win32Save_Saved);
+}
+
+internal PLATFORM_WORK_QUEUE_CALLBACK(Win32LoadWork) {
+    Win32_Save_System* save = (Win32_Save_System*)data;
+
+    LARGE_INTEGER start_counter = Win32GetWallClock();
+    save->succeeded             = false;
+    HANDLE file_handle =
+        CreateFileA(save->file_name, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+    if (file_handle != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER file_size;
+        if (GetFileSizeEx(file_handle, &file_size) && (uint64_t)file_size.QuadPart <= save->file_capacity) {
+            bool     read_ok   = true;
+            uint8_t* at        = save->file_memory;
+            uint64_t remaining = (uint64_t)file_size.QuadPart;
+            while (read_ok && remaining) {
+                DWORD chunk_size = remaining > MegaBytes(16) ? (DWORD)MegaBytes(16) : (DWORD)remaining;
+                DWORD bytes_read = 0;
+                if (!ReadFile(file_handle, at, chunk_size, &bytes_read, 0) || bytes_read != chunk_size) {
+                    read_ok = false;
+                }
+                at += chunk_size;
+                remaining -= chunk_size;
+            }
+            save->file_size = (uint64_t)file_size.QuadPart;
+            save->succeeded = read_ok &&
+                              Win32DecompressSave(save->file_memory, save->file_size, save->shadow, save->storage_size);
+        }
+        CloseHandle(file_handle);
+    }
+    save->load_ms = Win32GetMilliSecondsElapsed(start_counter, Win32GetWallClock());
+
+    InterlockedExchange(&save->state, Win32Save_Loaded);
+}
+
+// NOTE: the frame thread only pays for the snapshot, returns false while a previous save or load is still running
+internal bool
+Win32BeginSave(Win32_Save_System* save, const char* file_name) {
+    bool result = false;
+    if (save->state == Win32Save_Idle) {
+        LARGE_INTEGER start_counter = Win32GetWallClock();
+        Win32SnapshotStorage(save);
+        save->snapshot_ms = Win32GetMilliSecondsElapsed(start_counter, Win32GetWallClock());
+
+        strcpy_s(save->file_name, file_name);
+        save->state = Win32Save_Saving;
+        Win32AddWorkQueueEntry(save->queue, Win32SaveWork, save);
+        result = true;
+    }
+    return result;
+}
+
+// NOTE: decompresses into the shadow, the storage is only replaced by Win32UpdateSaveSystem between frames
+internal bool
+Win32BeginLoad(Win32_Save_System* save, const char* file_name) {
+    bool result = false;
+    if (save->state == Win32Save_Idle) {
+        strcpy_s(save->file_name, file_name);
+        save->state = Win32Save_Loading;
+        Win32AddWorkQueueEntry(save->queue, Win32LoadWork, save);
+        result = true;
+    }
+    return result;
+}
+
+// NOTE: call between frames, starts what the keys asked for and finishes whatever the worker completed. Returns true
+// when a load replaced the storage.
+internal bool
+Win32UpdateSaveSystem(Win32_Save_System* save, Game_Memory* memory) {
+    if (save->requested_state == Win32Save_Saving) {
+        Win32BeginSave(save, SAVE_FILE_NAME);
+    } else if (save->requested_state == Win32Save_Loading) {
+        Win32BeginLoad(save, SAVE_FILE_NAME);
+    }
+    save->requested_state = Win32Save_Idle;
+
+    bool result = false;
+    char text_buffer[256];
+    if (save->state == Win32Save_Saved) {
+        sprintf_s(
+            text_buffer,
+            "save %s: %s, snapshot %.3fms (%lluKB), compress %.2fms, write %.2fms, %lluKB on disk\n",
+            save->file_name,
+            save->succeeded ? "ok" : "failed",
+            save->snapshot_ms,
+            save->snapshot_bytes / 1024,
+            save->compress_ms,
+            save->write_ms,
+            save->file_size / 1024);
+        OutputDebugStringA(text_buffer);
+        save->state = Win32Save_Idle;
+    } else if (save->state == Win32Save_Loaded) {
+        if (save->succeeded) {
+            memcpy(save->storage, save->shadow, save->storage_size);
+            if (save->has_write_watch) {
+                ResetWriteWatch(save->storage, save->storage_size);
+            }
+            memory->storage_was_loaded = true;
+            result                     = true;
+        } else {
+            // NOTE: a failed load may have left half a save in the shadow
+            memcpy(save->shadow, save->storage, save->storage_size);
+        }
+        memset(save->unsaved_pages, 0, save->max_dirty_pages);
+        sprintf_s(
+            text_buffer, "load %s: %s, %.2fms\n", save->file_name, save->succeeded ? "ok" : "failed", save->load_ms);
+        OutputDebugStringA(text_buffer);
+        save->state = Win32Save_Idle;
+    }
+    return result;
+}
+
+/// Rollback
+internal void
+Win32ResetRollback(Win32_Rollback* rollback) {
+    // NOTE: what was written so far is part of the starting point, not of a frame
+    Win32CollectWrittenPages(rollback->save);
+    memcpy(rollback->mirror, rollback->save->storage, rollback->save->storage_size);
+    for (int slot_idx = 0; slot_idx < ROLLBACK_MAX_FRAMES; ++slot_idx) {
+        rollback->frames[slot_idx].frame_idx = -1;
+    }
+}
+
+// NOTE: needs the save system's write watch, returns false without it
+internal bool
+Win32InitRollback(Win32_Rollback* rollback, Win32_Save_System* save) {
+    *rollback = {};
+    if (!save->has_write_watch) {
+        return false;
+    }
+
+    rollback->save    = save;
+    rollback->mirror  = (uint8_t*)Win32AllocateMemory(save->storage_size, Win32MemoryTag_Rollback);
+    rollback->scratch = (uint8_t*)Win32AllocateMemory(ROLLBACK_FRAME_CAPACITY, Win32MemoryTag_Rollback);
+    for (int slot_idx = 0; slot_idx < ROLLBACK_MAX_FRAMES; ++slot_idx) {
+        rollback->frames[slot_idx].data =
+            (uint8_t*)Win32AllocateMemory(ROLLBACK_FRAME_CAPACITY, Win32MemoryTag_Rollback);
+    }
+    Win32ResetRollback(rollback);
+    return true;
+}
+
+// NOTE: dest ^= source for one page, returns false when the two were the same
+internal bool
+Win32XorPage(uint8_t* dest, uint8_t* source, DWORD page_size) {
+    __m128i any_bits = _mm_setzero_si128();
+    for (DWORD offset = 0; offset < page_size; offset += 16) {
+        __m128i value =
+            _mm_xor_si128(_mm_loadu_si128((__m128i*)(dest + offset)), _mm_loadu_si128((__m128i*)(source + offset)));
+        _mm_storeu_si128((__m128i*)(dest + offset), value);
+        any_bits = _mm_or_si128(any_bits, value);
+    }
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(any_bits, _mm_setzero_si128())) != 0xFFFF;
+}
+
+// NOTE: call right after the frame was simulated, stores what it changed so it can be undone. The changed pages are
+// xored into the scratch one after another and compressed in one go.
+internal void
+Win32RecordRollbackFrame(Win32_Rollback* rollback) {
+    Win32_Save_System*    save  = rollback->save;
+    Win32_Rollback_Frame* frame = &rollback->frames[rollback->frame_idx % ROLLBACK_MAX_FRAMES];
+    frame->frame_idx            = rollback->frame_idx++;
+    frame->page_count           = 0;
+    frame->data_size            = 0;
+
+    uint32_t* record_pages = (uint32_t*)frame->data;
+    ULONG_PTR page_count   = Win32CollectWrittenPages(save);
+    for (ULONG_PTR page_idx = 0; page_idx < page_count; ++page_idx) {
+        uint8_t* page        = (uint8_t*)save->dirty_pages[page_idx];
+        uint8_t* mirror_page = rollback->mirror + (page - save->storage);
+
+        uint32_t kept_count = frame->page_count + 1;
+        uint32_t kept_size  = kept_count * save->page_size;
+        uint32_t kept_bound = kept_count * (uint32_t)sizeof(uint32_t) + LZCompressBound(kept_size);
+        if (frame->frame_idx >= 0 && kept_bound > ROLLBACK_FRAME_CAPACITY) {
+            // NOTE: keep the mirror going, this frame just can't be undone
+            frame->frame_idx = -1;
+        }
+        if (frame->frame_idx >= 0) {
+            uint8_t* xor_page = rollback->scratch + (kept_size - save->page_size);
+            memcpy(xor_page, mirror_page, save->page_size);
+            if (Win32XorPage(xor_page, page, save->page_size)) {
+                record_pages[frame->page_count++] = (uint32_t)((page - save->storage) / save->page_size);
+            }
+        }
+        memcpy(mirror_page, page, save->page_size);
+    }
+
+    if (frame->frame_idx >= 0 && frame->page_count) {
+        uint32_t pages_size = frame->page_count * (uint32_t)sizeof(uint32_t);
+        uint32_t xor_size   = frame->page_count * save->page_size;
+        frame->data_size    = pages_size + LZCompress(rollback->scratch, xor_size, frame->data + pages_size);
+    }
+}
+
+// NOTE: puts the storage back to how it was before target_frame_idx was simulated, the caller simulates forward from
+// there. Returns false when a frame on the way wasn't kept or doesn't decompress, the storage is then left as it was
+// before the oldest frame that could be undone.
+internal bool
+Win32RestoreRollbackFrame(Win32_Rollback* rollback, int64_t target_frame_idx) {
+    Win32_Save_System* save = rollback->save;
+    for (int64_t frame_idx = target_frame_idx; frame_idx < rollback->frame_idx; ++frame_idx) {
+        if (rollback->frame_idx - frame_idx > ROLLBACK_MAX_FRAMES ||
+            rollback->frames[frame_idx % ROLLBACK_MAX_FRAMES].frame_idx != frame_idx) {
+            return false;
+        }
+    }
 
-    float32_t c = (float32_t)backbuffer->width / (float32_t)sound_output->secondary_buffer_size;
-    int       x = padx + (int)(c * (float32_t)value);
-    Win32DebugDrawVertical(backbuffer, x, top, bottom, color);
+    // NOTE: anything written since the last recorded frame goes back to the mirror first
+    ULONG_PTR page_count = Win32CollectWrittenPages(save);
+    for (ULONG_PTR page_idx = 0; page_idx < page_count; ++page_idx) {
+        uint8_t* page = (uint8_t*)save->dirty_pages[page_idx];
+        memcpy(page, rollback->mirror + (page - save->storage), save->page_size);
+    }
+
+    bool result = true;
+    for (int64_t frame_idx = rollback->frame_idx - 1; frame_idx >= target_frame_idx; --frame_idx) {
+        Win32_Rollback_Frame* frame        = &rollback->frames[frame_idx % ROLLBACK_MAX_FRAMES];
+        uint32_t*             record_pages = (uint32_t*)frame->data;
+        uint32_t              pages_size   = frame->page_count * (uint32_t)sizeof(uint32_t);
+        if (!LZDecompress(
+                frame->data + pages_size,
+                frame->data_size - pages_size,
+                rollback->scratch,
+                frame->page_count * save->page_size)) {
+            result = false;
+            break;
+        }
+
+        for (uint32_t record_idx = 0; record_idx < frame->page_count; ++record_idx) {
+            uint8_t* xor_page = rollback->scratch + (uint64_t)record_idx * save->page_size;
+            uint64_t offset   = (uint64_t)record_pages[record_idx] * save->page_size;
+            Win32XorPage(save->storage + offset, xor_page, save->page_size);
+            Win32XorPage(rollback->mirror + offset, xor_page, save->page_size);
+        }
+        frame->frame_idx    = -1;
+        rollback->frame_idx = frame_idx;
+    }
+
+    // NOTE: the restore itself wrote the pages, storage and mirror agree on them so they aren't part of any frame
+    Win32CollectWrittenPages(save);
+    return result;
+}
+
+/// Netplay
+internal Net_Input
+Win32MakeNetInput(Game_Controller_Input* controller) {
+    Net_Input result = {};
+    for (int button_idx = 0; button_idx < ArrayCount(controller->buttons); ++button_idx) {
+        if (controller->buttons[button_idx].ended_down) {
+            result.buttons |= (uint16_t)(1 << button_idx);
+        }
+    }
+    result.is_analog = controller->is_analog;
+    result.stick_x   = controller->stick_avg_x;
+    result.stick_y   = controller->stick_avg_y;
+    return result;
 }
 
+// NOTE: transitions come from comparing with the previous frame, presses shorter than a frame don't make it over
 internal void
-Win32DebugSyncDisplay(
-    Win32_Offscreen_Buffer*  backbuffer,
-    int                      marker_count,
-    int                      current_marker_idx,
-    Win32_Debug_Time_Marker* debug_time_markers,
-    Win32_Sound_Output*      sound_output) {
+Win32ApplyNetInput(Net_Input* net_input, Net_Input* previous, Game_Controller_Input* controller) {
+    controller->is_connected = true;
+    controller->is_analog    = net_input->is_analog != 0;
+    controller->stick_avg_x  = net_input->stick_x;
+    controller->stick_avg_y  = net_input->stick_y;
+    for (int button_idx = 0; button_idx < ArrayCount(controller->buttons); ++button_idx) {
+        bool is_down  = (net_input->buttons & (1 << button_idx)) != 0;
+        bool was_down = (previous->buttons & (1 << button_idx)) != 0;
+        controller->buttons[button_idx].ended_down            = is_down;
+        controller->buttons[button_idx].half_transition_count = (is_down != was_down) ? 1 : 0;
+    }
+}
 
-    int padx = 16;
-    int pady = 16;
+internal bool
+Win32InitNetplay(Win32_Netplay* netplay, Win32_Rollback* rollback, int local_player) {
+    *netplay                      = {};
+    netplay->socket               = INVALID_SOCKET;
+    netplay->rollback             = rollback;
+    netplay->local_player         = local_player;
+    netplay->frame_idx            = rollback->frame_idx;
+    netplay->remote_confirmed_idx = rollback->frame_idx - 1;
+
+    WSADATA wsa_data;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) {
+        return false;
+    }
+
+    netplay->socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (netplay->socket == INVALID_SOCKET) {
+        return false;
+    }
 
-    int line_height = 64;
+    sockaddr_in local_address     = {};
+    local_address.sin_family      = AF_INET;
+    local_address.sin_port        = htons((u_short)(NETPLAY_PORT + local_player));
+    local_address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    netplay->peer_address          = local_address;
+    netplay->peer_address.sin_port = htons((u_short)(NETPLAY_PORT + 1 - local_player));
+
+    // NOTE: connecting a UDP socket just filters out everything that isn't from the peer
+    u_long non_blocking = 1;
+    if (bind(netplay->socket, (sockaddr*)&local_address, sizeof(local_address)) != 0 ||
+        connect(netplay->socket, (sockaddr*)&netplay->peer_address, sizeof(netplay->peer_address)) != 0 ||
+        ioctlsocket(netplay->socket, FIONBIO, &non_blocking) != 0) {
+        closesocket(netplay->socket);
+        netplay->socket = INVALID_SOCKET;
+        return false;
+    }
+    return true;
+}
 
-    for (int marker_idx = 0; marker_idx < marker_count; ++marker_idx) {
-        Win32_Debug_Time_Marker marker = debug_time_markers[marker_idx];
+// NOTE: the last NETPLAY_SEND_FRAMES local inputs that were simulated
+internal void
+Win32SendNetInputs(Win32_Netplay* netplay) {
+    int64_t last_frame_idx = netplay->frame_idx - 1;
+    if (last_frame_idx < 0) {
+        return;
+    }
 
-        Assert(marker.output_location < sound_output->secondary_buffer_size);
-        Assert(marker.output_play_cursor < sound_output->secondary_buffer_size);
-        Assert(marker.output_write_cursor < sound_output->secondary_buffer_size);
-        Assert(marker.output_bytes < sound_output->secondary_buffer_size);
-        Assert(marker.flip_play_cursor < sound_output->secondary_buffer_size);
-        Assert(marker.flip_write_cursor < sound_output->secondary_buffer_size);
+    Net_Input_Packet packet = {};
+    packet.magic            = NETPLAY_MAGIC;
+    packet.first_frame_idx  = last_frame_idx - NETPLAY_SEND_FRAMES + 1;
+    if (packet.first_frame_idx < 0) {
+        packet.first_frame_idx = 0;
+    }
+    packet.input_count = (uint32_t)(last_frame_idx - packet.first_frame_idx + 1);
+    for (uint32_t input_idx = 0; input_idx < packet.input_count; ++input_idx) {
+        packet.inputs[input_idx] = netplay->local_inputs[(packet.first_frame_idx + input_idx) % NETPLAY_INPUT_RING];
+    }
+    send(netplay->socket, (char*)&packet, sizeof(packet), 0);
+}
 
-        DWORD play_cusor_color  = 0xFFFFFFFF; // white
-        DWORD write_cusor_color = 0x00FF00FF; // magenta
+// NOTE: returns the first frame that was simulated with a wrong prediction, -1 when there is none
+internal int64_t
+Win32ReceiveNetInputs(Win32_Netplay* netplay) {
+    int64_t          mispredicted_idx = -1;
+    Net_Input_Packet packet;
+    for (;;) {
+        int bytes_received = recv(netplay->socket, (char*)&packet, sizeof(packet), 0);
+        if (bytes_received == SOCKET_ERROR) {
+            // NOTE: an ICMP port unreachable for an earlier send shows up here while the peer isn't running yet
+            if (WSAGetLastError() == WSAECONNRESET) {
+                continue;
+            }
+            break;
+        }
+        if (bytes_received != sizeof(packet) || packet.magic != NETPLAY_MAGIC ||
+            packet.input_count > NETPLAY_SEND_FRAMES) {
+            continue;
+        }
 
-        int top    = pady;
-        int bottom = pady + line_height;
-        if (marker_idx == current_marker_idx) {
-            top += pady + line_height;
-            bottom += pady + line_height;
+        // NOTE: only the next frame after what we have is taken, the overlap between packets fills the gaps
+        for (uint32_t input_idx = 0; input_idx < packet.input_count; ++input_idx) {
+            int64_t frame_idx = packet.first_frame_idx + input_idx;
+            if (frame_idx != netplay->remote_confirmed_idx + 1) {
+                continue;
+            }
 
-            int first_top = top;
+            Net_Input* remote_input = &netplay->remote_inputs[frame_idx % NETPLAY_INPUT_RING];
+            if (frame_idx < netplay->frame_idx && mispredicted_idx < 0 &&
+                memcmp(remote_input, &packet.inputs[input_idx], sizeof(Net_Input)) != 0) {
+                mispredicted_idx = frame_idx;
+            }
+            *remote_input                 = packet.inputs[input_idx];
+            netplay->remote_confirmed_idx = frame_idx;
+        }
+    }
+    return mispredicted_idx;
+}
 
-            Win32DrawSoundBufferMarker(
-                backbuffer, sound_output, padx, top, bottom, marker.output_play_cursor, play_cusor_color);
-            Win32DrawSoundBufferMarker(
-                backbuffer, sound_output, padx, top, bottom, marker.output_write_cursor, write_cusor_color);
+internal void
+Win32SimulateNetFrame(
+    Win32_Netplay*          netplay,
+    game_update_and_render* GameUpdateAndRender,
+    Game_Memory*            memory,
+    Game_Input*             input,
+    Game_Offscreen_Buffer*  buffer) {
+
+    int64_t frame_idx = netplay->frame_idx;
+    if (frame_idx > netplay->remote_confirmed_idx) {
+        Net_Input predicted = {};
+        if (netplay->remote_confirmed_idx >= 0) {
+            predicted = netplay->remote_inputs[netplay->remote_confirmed_idx % NETPLAY_INPUT_RING];
+        }
+        netplay->remote_inputs[frame_idx % NETPLAY_INPUT_RING] = predicted;
+    }
 
-            top += pady + line_height;
-            bottom += pady + line_height;
+    Net_Input  no_input        = {};
+    Net_Input* previous_local  = &no_input;
+    Net_Input* previous_remote = &no_input;
+    if (frame_idx > 0) {
+        previous_local  = &netplay->local_inputs[(frame_idx - 1) % NETPLAY_INPUT_RING];
+        previous_remote = &netplay->remote_inputs[(frame_idx - 1) % NETPLAY_INPUT_RING];
+    }
 
-            Win32DrawSoundBufferMarker(
-                backbuffer, sound_output, padx, top, bottom, marker.output_location, play_cusor_color);
-            Win32DrawSoundBufferMarker(
-                backbuffer,
-                sound_output,
-                padx,
-                top,
-                bottom,
-                marker.output_location + marker.output_bytes,
-                write_cusor_color);
+    // NOTE: only the controller state goes over the wire, events don't
+    for (int controller_idx = 0; controller_idx < ArrayCount(input->controllers); ++controller_idx) {
+        input->controllers[controller_idx] = {};
+    }
+    input->event_count = 0;
+    Win32ApplyNetInput(
+        &netplay->local_inputs[frame_idx % NETPLAY_INPUT_RING],
+        previous_local,
+        &input->controllers[netplay->local_player]);
+    Win32ApplyNetInput(
+        &netplay->remote_inputs[frame_idx % NETPLAY_INPUT_RING],
+        previous_remote,
+        &input->controllers[1 - netplay->local_player]);
+
+    GameUpdateAndRender(memory, input, buffer);
+    Win32RecordRollbackFrame(netplay->rollback);
+    ++netplay->frame_idx;
+}
 
-            top += pady + line_height;
-            bottom += pady + line_height;
+// NOTE: one frame of the frame loop in netplay, returns false when the frame was held back because the remote input
+// is too far behind to predict, or when the peers went out of sync and the session has to end
+internal bool
+Win32UpdateNetplay(
+    Win32_Netplay*          netplay,
+    Game_Controller_Input*  local_controller,
+    game_update_and_render* GameUpdateAndRender,
+    Game_Memory*            memory,
+    Game_Input*             input,
+    Game_Offscreen_Buffer*  buffer) {
+
+    int64_t mispredicted_idx = Win32ReceiveNetInputs(netplay);
+    if (mispredicted_idx >= 0) {
+        int64_t end_frame_idx = netplay->frame_idx;
+        if (Win32RestoreRollbackFrame(netplay->rollback, mispredicted_idx)) {
+            netplay->frame_idx     = mispredicted_idx;
+            input->is_resimulating = true;
+            while (netplay->frame_idx < end_frame_idx) {
+                Win32SimulateNetFrame(netplay, GameUpdateAndRender, memory, input, buffer);
+            }
+            input->is_resimulating = false;
 
-            Win32DrawSoundBufferMarker(
-                backbuffer, sound_output, padx, first_top, bottom, marker.expected_flip_play_cursor, 0x0000FF00);
+            uint32_t depth = (uint32_t)(end_frame_idx - mispredicted_idx);
+            ++netplay->rollback_count;
+            netplay->resimulated_frame_count += depth;
+            if (depth > netplay->max_rollback_depth) {
+                netplay->max_rollback_depth = depth;
+            }
+        } else {
+            // NOTE: the peers can't agree on the state from here on, the caller ends the session
+            char text_buffer[256];
+            sprintf_s(
+                text_buffer,
+                "netplay: frame %lld mispredicted and can't be rolled back, the peers are out of sync\n",
+                mispredicted_idx);
+            OutputDebugStringA(text_buffer);
+            netplay->is_out_of_sync = true;
+            return false;
         }
+    }
 
-        Win32DrawSoundBufferMarker(
-            backbuffer, sound_output, padx, top, bottom, marker.flip_play_cursor, play_cusor_color);
-        Win32DrawSoundBufferMarker(
-            backbuffer, sound_output, padx, top, bottom, marker.flip_write_cursor, write_cusor_color);
+    bool result = false;
+    if (netplay->frame_idx - netplay->remote_confirmed_idx < ROLLBACK_MAX_FRAMES) {
+        // NOTE: the first frame runs without input on both sides, the game initializes in it and it never gets undone
+        Net_Input local_input = {};
+        if (netplay->frame_idx > 0) {
+            local_input = Win32MakeNetInput(local_controller);
+        }
+        netplay->local_inputs[netplay->frame_idx % NETPLAY_INPUT_RING] = local_input;
+        Win32SimulateNetFrame(netplay, GameUpdateAndRender, memory, input, buffer);
+        result = true;
+    } else {
+        ++netplay->stall_count;
     }
+    Win32SendNetInputs(netplay);
+    return result;
 }
 
+internal void
+Win32StopNetplay(Win32_Netplay* netplay) {
+    char report[256];
+    sprintf_s(
+        report,
+        "netplay: %lld frames, %u rollbacks, %u frames resimulated, deepest %u, %u stalls\n",
+        netplay->frame_idx,
+        netplay->rollback_count,
+        netplay->resimulated_frame_count,
+        netplay->max_rollback_depth,
+        netplay->stall_count);
+    OutputDebugStringA(report);
+    closesocket(netplay->socket);
+    netplay->socket = INVALID_SOCKET;
+    WSACleanup();
+}
+
+/// Input latency
+internal void
+Win32TagInputEvents(Win32_Latency_Tracker* tracker, Game_Input* input) {
+    if (tracker->is_enabled) {
+        for (uint32_t event_idx = 0; event_idx < input->event_count; ++event_idx) {
+            Game_Input_Event* event = &input->events[event_idx];
+            if (event->type == GameInputEvent_Button && event->is_down) {
+                uint32_t tag = ++tracker->next_tag;
+                if (tag == 0) {
+                    tag = ++tracker->next_tag;
+                }
+                event->latency_tag = tag;
+
+                Win32_Latency_Pending* pending = &tracker->pending[tag % LATENCY_PENDING_COUNT];
+                pending->tag                   = tag;
+                pending->input_timestamp       = event->timestamp;
+            }
+        }
+    }
+}
+
+// NOTE: present_timestamp is taken right after the frame went to the window
+internal void
+Win32RecordLatencyPresent(Win32_Latency_Tracker* tracker, uint32_t consumed_tag, int64_t present_timestamp) {
+    Win32_Latency_Pending* pending = &tracker->pending[consumed_tag % LATENCY_PENDING_COUNT];
+    if (tracker->is_enabled && consumed_tag && consumed_tag != tracker->last_consumed_tag &&
+        pending->tag == consumed_tag) {
+        tracker->last_consumed_tag = consumed_tag;
+
+        int64_t   elapsed    = present_timestamp - pending->input_timestamp;
+        float32_t ms         = 1000.0f * (float32_t)elapsed / (float32_t)g_perf_count_freq;
+        int       bucket_idx = (int)ms;
+        if (bucket_idx < 0) {
+            bucket_idx = 0;
+        } else if (bucket_idx >= LATENCY_BUCKET_COUNT) {
+            bucket_idx = LATENCY_BUCKET_COUNT - 1;
+        }
+        ++tracker->buckets[bucket_idx];
+
+        if (tracker->sample_count == 0 || ms < tracker->min_ms) {
+            tracker->min_ms = ms;
+        }
+        if (tracker->sample_count == 0 || ms > tracker->max_ms) {
+            tracker->max_ms = ms;
+        }
+        tracker->total_ms += ms;
+        ++tracker->sample_count;
+    }
+}
+
+// NOTE: upper edge of the bucket the percentile falls in
+internal int
+Win32GetLatencyPercentileMs(Win32_Latency_Tracker* tracker, float32_t fraction) {
+    uint32_t target = (uint32_t)(fraction * (float32_t)tracker->sample_count);
+    uint32_t seen   = 0;
+    for (int bucket_idx = 0; bucket_idx < LATENCY_BUCKET_COUNT; ++bucket_idx) {
+        seen += tracker->buckets[bucket_idx];
+        if (seen > target) {
+            return bucket_idx + 1;
+        }
+    }
+    return LATENCY_BUCKET_COUNT;
+}
+
+// NOTE: writes a text histogram, returns the length. Both the game loop and win32_bench print it.
+internal int
+Win32FormatLatencyReport(Win32_Latency_Tracker* tracker, char* buffer, int buffer_size) {
+    int length = 0;
+    if (tracker->sample_count) {
+        length += sprintf_s(
+            buffer + length,
+            buffer_size - length,
+            "input latency: %u samples, min %.2f avg %.2f max %.2f ms, p50 <%d p95 <%d p99 <%d ms\n",
+            tracker->sample_count,
+            tracker->min_ms,
+            tracker->total_ms / (float32_t)tracker->sample_count,
+            tracker->max_ms,
+            Win32GetLatencyPercentileMs(tracker, 0.5f),
+            Win32GetLatencyPercentileMs(tracker, 0.95f),
+            Win32GetLatencyPercentileMs(tracker, 0.99f));
+
+        for (int bucket_idx = 0; bucket_idx < LATENCY_BUCKET_COUNT; ++bucket_idx) {
+            uint32_t count = tracker->buckets[bucket_idx];
+            if (count && buffer_size - length > 128) {
+                int bar_length = (int)(50 * (uint64_t)count / tracker->sample_count) + 1;
+                length += sprintf_s(
+                    buffer + length,
+                    buffer_size - length,
+                    "%3d%s ms %6u %.*s\n",
+                    bucket_idx,
+                    bucket_idx == LATENCY_BUCKET_COUNT - 1 ? "+" : " ",
+                    count,
+                    bar_length,
+                    "##################################################");
+            }
+        }
+    } else {
+        length += sprintf_s(buffer, buffer_size, "input latency: no samples\n");
+    }
+    return length;
+}
+
+/// Frame phase counters
+// NOTE: reading a PMC that user mode isn't allowed to read faults. One that is allowed but not programmed just
+// returns the same value, so check it moves.
+internal bool
+Win32ProbeHardwareCounters(void) {
+    bool result = false;
+    __try {
+        uint64_t start_instructions = __readpmc(WIN32_PMC_FIXED_INSTRUCTIONS);
+        uint64_t start_cycles       = __readpmc(WIN32_PMC_FIXED_CORE_CYCLES);
+
+        volatile uint32_t sum = 0;
+        for (uint32_t i = 0; i < 1000; ++i) {
+            sum += i;
+        }
+        result = __readpmc(WIN32_PMC_FIXED_INSTRUCTIONS) != start_instructions &&
+                 __readpmc(WIN32_PMC_FIXED_CORE_CYCLES) != start_cycles;
+    } __except (EXCEPTION_EXECUTE_HANDLER) {
+        result = false;
+    }
+    return result;
+}
+
+global const char* g_frame_phase_names[Win32FramePhase_Count] = {"input", "update", "audio", "present"};
+#if HANDMADE_INTERNAL
+global Debug_Overlay g_debug_overlay;
+#endif
+
+internal void
+Win32InitFrameCounters(Win32_Frame_Counters* counters) {
+    *counters               = {};
+    counters->thread_handle = GetCurrentThread();
+    counters->has_pmc       = Win32ProbeHardwareCounters();
+    counters->current_phase = -1;
+}
+
+internal Win32_Phase_Counters
+Win32ReadPhaseCounters(Win32_Frame_Counters* counters) {
+    Win32_Phase_Counters result = {};
+    result.wall                 = Win32GetWallClock().QuadPart;
+    result.tsc                  = __rdtsc();
+    QueryThreadCycleTime(counters->thread_handle, &result.thread_cycles);
+    if (counters->has_pmc) {
+        result.instructions = __readpmc(WIN32_PMC_FIXED_INSTRUCTIONS);
+        result.core_cycles  = __readpmc(WIN32_PMC_FIXED_CORE_CYCLES);
+    }
+    return result;
+}
+
+internal void
+Win32EndFramePhase(Win32_Frame_Counters* counters) {
+    if (counters->current_phase >= 0) {
+        Win32_Phase_Counters  now   = Win32ReadPhaseCounters(counters);
+        Win32_Phase_Counters* phase = &counters->phases[counters->current_phase];
+        phase->wall += now.wall - counters->phase_start.wall;
+        phase->tsc += now.tsc - counters->phase_start.tsc;
+        phase->thread_cycles += now.thread_cycles - counters->phase_start.thread_cycles;
+        phase->instructions += now.instructions - counters->phase_start.instructions;
+        phase->core_cycles += now.core_cycles - counters->phase_start.core_cycles;
+        counters->frame_wall[counters->current_phase] += now.wall - counters->phase_start.wall;
+        counters->current_phase = -1;
+    }
+}
+
+// NOTE: ends the running phase, time outside of any phase (waiting for the frame boundary) isn't counted
+internal void
+Win32BeginFramePhase(Win32_Frame_Counters* counters, int phase) {
+    Win32EndFramePhase(counters);
+    if (phase == Win32FramePhase_Input) {
+        memset(counters->frame_wall, 0, sizeof(counters->frame_wall));
+    }
+    counters->current_phase = phase;
+    counters->phase_start   = Win32ReadPhaseCounters(counters);
+}
+
+// NOTE: averages per frame since the last report, then starts over
+internal int
+Win32FormatFrameCounters(Win32_Frame_Counters* counters, char* buffer, int buffer_size) {
+    int length      = 0;
+    int frame_count = counters->frame_count > 0 ? counters->frame_count : 1;
+    for (int phase_idx = 0; phase_idx < Win32FramePhase_Count; ++phase_idx) {
+        Win32_Phase_Counters* phase     = &counters->phases[phase_idx];
+        float32_t             ms        = 1000.0f * (float32_t)phase->wall / (float32_t)g_perf_count_freq;
+        float32_t             tsc_mc    = (float32_t)phase->tsc / 1000000.0f;
+        float32_t             thread_mc = (float32_t)phase->thread_cycles / 1000000.0f;
+        length += sprintf_s(
+            buffer + length,
+            buffer_size - length,
+            "%s%s %.2fms %.2fmc (thread %.2fmc)",
+            phase_idx ? " | " : "",
+            g_frame_phase_names[phase_idx],
+            ms / frame_count,
+            tsc_mc / frame_count,
+            thread_mc / frame_count);
+        if (counters->has_pmc && phase->core_cycles) {
+            length += sprintf_s(
+                buffer + length,
+                buffer_size - length,
+                " ipc %.2f",
+                (float32_t)phase->instructions / (float32_t)phase->core_cycles);
+        }
+    }
+    length += sprintf_s(buffer + length, buffer_size - length, counters->has_pmc ? "\n" : " | ipc n/a\n");
+
+    for (int phase_idx = 0; phase_idx < Win32FramePhase_Count; ++phase_idx) {
+        counters->phases[phase_idx] = {};
+    }
+    counters->frame_count = 0;
+    return length;
+}
+
+/// Memory report
+// NOTE: how much of [base, base + size) is in the working set right now. Committed pages the process never touched
+// aren't, so this is what the reserved storage really costs.
+internal uint64_t
+Win32QueryResidentBytes(void* base, uint64_t size) {
+    local_persist PSAPI_WORKING_SET_EX_INFORMATION pages[WIN32_RESIDENCY_BATCH_PAGES];
+
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    uint64_t page_size  = system_info.dwPageSize;
+    uint64_t page_count = size / page_size;
+    uint64_t result     = 0;
+    for (uint64_t first_page = 0; first_page < page_count; first_page += WIN32_RESIDENCY_BATCH_PAGES) {
+        uint64_t batch_count = page_count - first_page;
+        batch_count          = batch_count < WIN32_RESIDENCY_BATCH_PAGES ? batch_count : WIN32_RESIDENCY_BATCH_PAGES;
+        for (uint64_t page_idx = 0; page_idx < batch_count; ++page_idx) {
+            pages[page_idx].VirtualAddress = (uint8_t*)base + (first_page + page_idx) * page_size;
+        }
+        if (!QueryWorkingSetEx(
+                GetCurrentProcess(), pages, (DWORD)(batch_count * sizeof(PSAPI_WORKING_SET_EX_INFORMATION)))) {
+            break;
+        }
+        for (uint64_t page_idx = 0; page_idx < batch_count; ++page_idx) {
+            if (pages[page_idx].VirtualAttributes.Valid) {
+                result += page_size;
+            }
+        }
+    }
+    return result;
+}
+
+internal int
+Win32FormatTagStats(char* buffer, int buffer_size, const char* prefix, const char* name, Memory_Tag_Stats* stats) {
+    return sprintf_s(
+        buffer,
+        buffer_size,
+        "%s.%s.current %llu\n%s.%s.peak %llu\n%s.%s.allocations %u\n%s.%s.frame_allocations %u\n",
+        prefix,
+        name,
+        stats->current_bytes,
+        prefix,
+        name,
+        stats->peak_bytes,
+        prefix,
+        name,
+        stats->allocation_count,
+        prefix,
+        name,
+        stats->frame_allocation_count);
+}
+
+// NOTE: the whole process, game storage reserved against resident, the game's arenas by tag and the platform's own
+// allocations by tag, see WIN32_MEMORY_REPORT_FILE_NAME for the format
+internal int
+Win32FormatMemoryReport(Game_Memory* game_memory, char* buffer, int buffer_size) {
+    int length = sprintf_s(buffer, buffer_size, "# handmade memory report %d\n", WIN32_MEMORY_REPORT_VERSION);
+
+    PROCESS_MEMORY_COUNTERS_EX process = {};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS*)&process, sizeof(process))) {
+        length += sprintf_s(
+            buffer + length,
+            buffer_size - length,
+            "process.working_set %llu\nprocess.peak_working_set %llu\nprocess.private %llu\n",
+            (uint64_t)process.WorkingSetSize,
+            (uint64_t)process.PeakWorkingSetSize,
+            (uint64_t)process.PrivateUsage);
+    }
+
+    const char*   storage_names[2] = {"permanent", "transient"};
+    void*         storages[2]      = {game_memory->permanent_storage, game_memory->transient_storage};
+    uint64_t      storage_sizes[2] = {game_memory->permanent_storage_size, game_memory->transient_storage_size};
+    Memory_Arena* arenas[2]        = {game_memory->permanent_arena, game_memory->transient_arena};
+    for (int storage_idx = 0; storage_idx < 2; ++storage_idx) {
+        length += sprintf_s(
+            buffer + length,
+            buffer_size - length,
+            "storage.%s.reserved %llu\nstorage.%s.resident %llu\n",
+            storage_names[storage_idx],
+            storage_sizes[storage_idx],
+            storage_names[storage_idx],
+            Win32QueryResidentBytes(storages[storage_idx], storage_sizes[storage_idx]));
+
+        // NOTE: the arenas are there once the game ran a frame
+        Memory_Arena* arena = arenas[storage_idx];
+        if (arena) {
+            char prefix[32];
+            sprintf_s(prefix, "arena.%s", storage_names[storage_idx]);
+            length += sprintf_s(
+                buffer + length,
+                buffer_size - length,
+                "%s.offset %llu\n%s.size %llu\n%s.used %llu\n",
+                prefix,
+                (uint64_t)(arena->base - (uint8_t*)storages[storage_idx]),
+                prefix,
+                arena->size,
+                prefix,
+                arena->used);
+            for (int tag = 0; tag < MemoryTag_Count; ++tag) {
+                length += Win32FormatTagStats(
+                    buffer + length, buffer_size - length, prefix, g_memory_tag_names[tag], &arena->tags[tag]);
+            }
+        }
+    }
+
+    for (int tag = 0; tag < Win32MemoryTag_Count; ++tag) {
+        const char* name = g_platform_memory_tag_names[tag];
+        length += Win32FormatTagStats(buffer + length, buffer_size - length, "platform", name, &g_platform_memory[tag]);
+    }
+    return length;
+}
+
+internal bool
+Win32WriteMemoryReport(const char* file_name, Game_Memory* game_memory) {
+    char  buffer[8192];
+    int   length = Win32FormatMemoryReport(game_memory, buffer, sizeof(buffer));
+    bool  result = false;
+    DWORD bytes_written;
+
+    HANDLE file_handle = CreateFileA(file_name, GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+    if (file_handle != INVALID_HANDLE_VALUE) {
+        result = WriteFile(file_handle, buffer, (DWORD)length, &bytes_written, 0) && bytes_written == (DWORD)length;
+        CloseHandle(file_handle);
+    }
+    return result;
+}
+
+#if HANDMADE_INTERNAL
+// NOTE: the wall clock of each phase this frame
+internal void
+Win32RecordDebugOverlayFrame(Debug_Overlay* overlay, Win32_Frame_Counters* counters, float32_t frame_ms) {
+    float32_t phase_ms[Win32FramePhase_Count];
+    for (int phase_idx = 0; phase_idx < Win32FramePhase_Count; ++phase_idx) {
+        phase_ms[phase_idx] = 1000.0f * (float32_t)counters->frame_wall[phase_idx] / (float32_t)g_perf_count_freq;
+    }
+    DebugOverlayRecordFrame(overlay, frame_ms, phase_ms);
+}
+
+// NOTE: builds and draws the overlay over the buffer that's about to go to the window and times both, the cost is
+// what the overlay uses to pick its level of detail for the next frame
+internal void
+Win32DrawDebugOverlay(
+    Debug_Overlay*          overlay,
+    Win32_Offscreen_Buffer* backbuffer,
+    Debug_Audio_Marker*     markers,
+    int                     marker_count,
+    int                     current_marker_idx,
+    Win32_Sound_Output*     sound_output,
+    float32_t               render_scale,
+    float32_t               audio_latency_seconds) {
+
+    LARGE_INTEGER start_counter = Win32GetWallClock();
+    DebugOverlayBeginFrame(overlay);
+
+    const char* detail_names[DebugOverlayDetail_Count] = {"TEXT", "GRAPH", "FULL"};
+
+    int x = 16;
+    int y = 16;
+    DebugPushShade(overlay, 8, 8, backbuffer->width - 8, 8 + 3 * DEBUG_TEXT_LINE);
+    DebugPushText(
+        overlay,
+        x,
+        y,
+        0xFFFFFF,
+        "RENDER SCALE %.0f%% / AUDIO LATENCY %.1fMS / OVERLAY %s %.2fMS (F1)",
+        100.0f * render_scale,
+        1000.0f * audio_latency_seconds,
+        detail_names[overlay->detail],
+        overlay->cost_ms);
+    y += DEBUG_TEXT_LINE;
+
+    int bar_width = (backbuffer->width - 2 * x - 64) / DEBUG_FRAME_GRAPH_LENGTH;
+    y             = DebugOverlayPushFrameGraph(overlay, x, y, bar_width > 0 ? bar_width : 1, 96) + 8;
+    DebugOverlayPushAudioLanes(
+        overlay,
+        x,
+        y,
+        backbuffer->width - 2 * x,
+        markers,
+        marker_count,
+        current_marker_idx,
+        sound_output->secondary_buffer_size);
+
+    Game_Offscreen_Buffer buffer = {};
+    buffer.memory                = backbuffer->memory;
+    buffer.width                 = backbuffer->width;
+    buffer.height                = backbuffer->height;
+    buffer.pitch                 = backbuffer->pitch;
+    buffer.bytes_per_pixel       = backbuffer->bytes_per_pixel;
+    buffer.pixel_format          = backbuffer->pixel_format;
+    DebugOverlayRender(overlay, &buffer);
+
+    float32_t cost_ms = Win32GetMilliSecondsElapsed(start_counter, Win32GetWallClock());
+    if (DebugOverlayEndFrame(overlay, cost_ms)) {
+        char text_buffer[256];
+        sprintf_s(
+            text_buffer,
+            "debug overlay detail %s (%.2fms, budget %.2fms)\n",
+            detail_names[overlay->detail],
+            overlay->cost_ms,
+            overlay->budget_fraction * overlay->target_ms);
+        OutputDebugStringA(text_buffer);
+    }
+}
+#endif
+
 int WINAPI
 WinMain(HINSTANCE instance, HINSTANCE prev_instance, LPSTR cmd_line, int show_cmd) {
     LARGE_INTEGER perf_count_freq_result;
     QueryPerformanceFrequency(&perf_count_freq_result);
     g_perf_count_freq = perf_count_freq_result.QuadPart;
 
-    bool sleep_is_granular = (bool)timeBeginPeriod(1);
+    bool sleep_is_granular = (timeBeginPeriod(1) == TIMERR_NOERROR);
 
     Win32LoadXInput();
 
     WNDCLASSA windowClass = {};
 
-    Win32ResizeDIBSection(&g_backbuffer, 1280, 720);
+    // NOTE: -rgb565 halves the bytes per pixel for bandwidth bound machines
+    int pixel_format = strstr(cmd_line, "-rgb565") ? GamePixelFormat_RGB565 : GamePixelFormat_BGRX8888;
+    Win32ResizeDIBSection(&g_backbuffer, 1280, 720, pixel_format);
+    Win32ResizeDIBSection(&g_upscaled_buffer, 1280, 720, pixel_format);
+    g_display_buffer = &g_backbuffer;
 
     windowClass.style         = CS_VREDRAW | CS_HREDRAW;
     windowClass.lpfnWndProc   = MainWindowCallback;
@@ -700,9 +2786,20 @@ WinMain(HINSTANCE instance, HINSTANCE prev_instance, LPSTR cmd_line, int show_cm
             // [Left, Right] [Left, Right] ...
             // Left or Right has 16 bits, each left right tuple is called a sample
 
+            // NOTE: -samplerate n runs the device at n Hz, the game resamples its sounds to whatever this is
+            int         samples_per_second = 48000;
+            const char* sample_rate_arg    = strstr(cmd_line, "-samplerate ");
+            if (sample_rate_arg) {
+                int requested_rate = atoi(sample_rate_arg + strlen("-samplerate "));
+                if (requested_rate >= 8000 && requested_rate <= 192000) {
+                    samples_per_second = requested_rate;
+                }
+            }
+
             Win32_Sound_Output sound_output    = {};
-            sound_output.samples_per_second    = 48000;
+            sound_output.samples_per_second    = samples_per_second;
             sound_output.running_sample_idx    = 0;
+            sound_output.game_sample_idx       = 0;
             sound_output.bytes_per_sample      = sizeof(int16_t) * 2; // 2 channels, one channel is 16 bits
             sound_output.secondary_buffer_size = sound_output.samples_per_second * sound_output.bytes_per_sample;
             // 2 frames of delay
@@ -724,11 +2821,44 @@ WinMain(HINSTANCE instance, HINSTANCE prev_instance, LPSTR cmd_line, int show_cm
             // Game memory
             Game_Memory game_memory            = {};
             game_memory.permanent_storage_size = MegaBytes(64);
-            game_memory.permanent_storage =
-                VirtualAlloc(0, game_memory.permanent_storage_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+            // NOTE: write watch lets a save snapshot copy only the pages the game wrote
+            game_memory.permanent_storage = Win32AllocateMemory(
+                game_memory.permanent_storage_size, Win32MemoryTag_GameStorage, MEM_WRITE_WATCH);
             game_memory.transient_storage_size = GigaBytes(4);
             game_memory.transient_storage =
-                VirtualAlloc(0, game_memory.transient_storage_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+                Win32AllocateMemory(game_memory.transient_storage_size, Win32MemoryTag_GameStorage);
+
+            // Threading
+            Platform_Work_Queue work_queue = {};
+            Win32_Thread_Info   thread_infos[WORK_QUEUE_MAX_THREADS];
+            Win32MakeWorkQueue(&work_queue, Win32GetWorkerThreadCount(), thread_infos);
+
+            // NOTE: file ops that can't go overlapped block on these, keep them off the game's work queue
+            Platform_Work_Queue io_queue = {};
+            Win32_Thread_Info   io_thread_infos[2];
+            Win32MakeWorkQueue(&io_queue, (int)ArrayCount(io_thread_infos), io_thread_infos);
+            Win32InitFileIO(&io_queue);
+
+            Platform_Idle_Queue idle_queue = {};
+
+            // NOTE: F5 saves, F9 loads
+            Win32_Save_System save_system;
+            Win32InitSaveSystem(
+                &save_system, game_memory.permanent_storage, game_memory.permanent_storage_size, &io_queue);
+
+            game_memory.work_queue                = &work_queue;
+            game_memory.PlatformAddWorkQueueEntry = Win32AddWorkQueueEntry;
+            game_memory.PlatformCompleteAllWork   = Win32CompleteAllWork;
+            game_memory.idle_queue                = &idle_queue;
+            game_memory.PlatformAddIdleTask       = Win32AddIdleTask;
+            game_memory.PlatformIdleShouldYield   = Win32IdleShouldYield;
+            game_memory.PlatformMapFile           = Win32MapFile;
+            game_memory.PlatformUnmapFile         = Win32UnmapFile;
+            game_memory.PlatformOpenFile          = Win32OpenFile;
+            game_memory.PlatformCloseFile         = Win32CloseFile;
+            game_memory.PlatformReadFileAsync     = Win32ReadFileAsync;
+            game_memory.PlatformWriteFileAsync    = Win32WriteFileAsync;
+            game_memory.PlatformPollFileOp        = Win32PollFileOp;
 #ifdef HANDMADE_INTERNAL
             game_memory.DebugPlatformReadEntireFile  = DebugPlatformReadEntireFile;
             game_memory.DebugPlatformWriteEntireFile = DebugPlatformWriteEntireFile;
@@ -740,21 +2870,58 @@ WinMain(HINSTANCE instance, HINSTANCE prev_instance, LPSTR cmd_line, int show_cm
             Game_Input* old_input      = &game_inputs[0];
             Game_Input* new_input      = &game_inputs[1];
 
+            Win32_Input_Event_Queue input_event_queue = {};
+            Win32InitInputEventQueue(&input_event_queue);
+            Win32_XInput_Poller xinput_poller = {};
+            Win32StartXInputPoller(&xinput_poller, &input_event_queue);
+
+            // NOTE: run with -latency to collect the input-to-present histogram
+            Win32_Latency_Tracker latency_tracker = {};
+            latency_tracker.is_enabled            = strstr(cmd_line, "-latency") != 0;
+
+            // NOTE: -fixedres keeps rendering at full resolution however long the frames take
+            Win32_Resolution_Governor resolution_governor;
+            Win32InitResolutionGovernor(&resolution_governor, target_ms_per_frame);
+            bool fixed_resolution = strstr(cmd_line, "-fixedres") != 0;
+
+            Win32_Frame_Counters frame_counters;
+            Win32InitFrameCounters(&frame_counters);
+
+            // NOTE: -netplay 0 and -netplay 1 in two processes on this machine, the keyboard drives the local player
+            Win32_Rollback rollback;
+            Win32_Netplay  netplay;
+            bool           is_netplay = false;
+            if (strstr(cmd_line, "-netplay")) {
+                int local_player = strstr(cmd_line, "-netplay 1") ? 1 : 0;
+                is_netplay       = Win32InitRollback(&rollback, &save_system) &&
+                             Win32InitNetplay(&netplay, &rollback, local_player);
+                if (!is_netplay) {
+                    OutputDebugStringA("netplay: couldn't start, running locally\n");
+                }
+            }
+
             // Performance
             LARGE_INTEGER last_counter    = Win32GetWallClock();
             LARGE_INTEGER flip_wall_clock = Win32GetWallClock();
             QueryPerformanceCounter(&last_counter);
             uint64_t last_cycle_count = __rdtsc();
 
-            int                     debug_time_marker_idx  = 0;
-            Win32_Debug_Time_Marker debug_time_markers[15] = {0}; // game_refresh_hz / 2
+            int                debug_time_marker_idx  = 0;
+            Debug_Audio_Marker debug_time_markers[15] = {0}; // game_refresh_hz / 2
+#if HANDMADE_INTERNAL
+            DebugOverlayInit(
+                &g_debug_overlay,
+                target_ms_per_frame,
+                DEBUG_OVERLAY_BUDGET_FRACTION,
+                Win32FramePhase_Count,
+                g_frame_phase_names);
+#endif
 
             // Direct sound
             bool      is_sound_valid        = false;
             DWORD     audio_latency_bytes   = 0;
             float32_t audio_latency_seconds = 0;
-            int16_t*  samples =
-                (int16_t*)VirtualAlloc(0, sound_output.secondary_buffer_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+            int16_t*  samples = (int16_t*)Win32AllocateMemory(sound_output.secondary_buffer_size, Win32MemoryTag_Sound);
 
             // get working directory
             char exe_file_path[MAX_PATH];
@@ -766,30 +2933,22 @@ WinMain(HINSTANCE instance, HINSTANCE prev_instance, LPSTR cmd_line, int show_cm
                 }
             }
             last_slash_pos++;
+            *last_slash_pos = '\0';
 
-            const char* source_dll_name = "handmade.dll";
-            char        source_dll_full_path[MAX_PATH];
-            strncpy_s(source_dll_full_path, MAX_PATH, exe_file_path, last_slash_pos - exe_file_path);
-            strncpy_s(
-                source_dll_full_path + (last_slash_pos - exe_file_path),
-                MAX_PATH,
-                source_dll_name,
-                strlen(source_dll_name));
-
-            const char* temp_dll_name = "handmade_temp.dll";
-            char        temp_dll_full_path[MAX_PATH];
-            strncpy_s(temp_dll_full_path, MAX_PATH, exe_file_path, last_slash_pos - exe_file_path);
-            strncpy_s(
-                temp_dll_full_path + (last_slash_pos - exe_file_path), MAX_PATH, temp_dll_name, strlen(temp_dll_name));
-
-            Win32_Game_Code game = Win32LoadGameCode(source_dll_full_path, temp_dll_full_path);
+            Win32_Game_Code_Reloader game_code_reloader = {};
+            Win32InitGameCodeReloader(&game_code_reloader, exe_file_path, &io_queue);
+            Win32_Game_Code game = Win32LoadInitialGameCode(&game_code_reloader);
 
             while (g_app_running) {
-                FILETIME last_write_time = Win32GetFileLastWriteTime(source_dll_full_path);
-                if (CompareFileTime(&last_write_time, &game.dll_last_write_time) != 0) {
-                    Win32UnloadGameCode(&game);
-                    game = Win32LoadGameCode(source_dll_full_path, temp_dll_full_path);
+                Win32BeginFramePhase(&frame_counters, Win32FramePhase_Input);
+                Win32BeginMemoryFrame();
+                Win32UpdateGameCodeReload(&game_code_reloader, &game, &game_memory, &work_queue, &idle_queue);
+                if (is_netplay && save_system.requested_state == Win32Save_Loading) {
+                    // NOTE: the peer keeps its own state, loading on one side only would put them out of sync
+                    OutputDebugStringA("netplay: loading a save is disabled while playing\n");
+                    save_system.requested_state = Win32Save_Idle;
                 }
+                Win32UpdateSaveSystem(&save_system, &game_memory);
 
                 // keyboard controller
                 Game_Controller_Input* old_keyboard_controller = &old_input->keyboard_controller;
@@ -802,7 +2961,12 @@ WinMain(HINSTANCE instance, HINSTANCE prev_instance, LPSTR cmd_line, int show_cm
                     new_keyboard_controller->buttons[button_idx].ended_down =
                         old_keyboard_controller->buttons[button_idx].ended_down;
                 }
-                Win32ProcessPendingMessages(new_keyboard_controller);
+                Win32ProcessPendingMessages(new_keyboard_controller, &input_event_queue, &save_system);
+
+                new_input->frame_timestamp     = Win32GetInputTimestamp();
+                new_input->timestamp_frequency = g_perf_count_freq;
+                Win32DrainInputEvents(&input_event_queue, new_input);
+                Win32TagInputEvents(&latency_tracker, new_input);
 
                 if (!g_pause) {
 
@@ -820,95 +2984,7 @@ WinMain(HINSTANCE instance, HINSTANCE prev_instance, LPSTR cmd_line, int show_cm
                             new_controller->is_connected = true;
                             XINPUT_GAMEPAD* gamepad      = &controller_state.Gamepad;
 
-                            // XInput -> Game_Input
-                            Win32ProcessXInputDigitalButton(
-                                gamepad->wButtons,
-                                XINPUT_GAMEPAD_START,
-                                &old_controller->start,
-                                &new_controller->start);
-                            Win32ProcessXInputDigitalButton(
-                                gamepad->wButtons, XINPUT_GAMEPAD_BACK, &old_controller->back, &new_controller->back);
-
-                            Win32ProcessXInputDigitalButton(
-                                gamepad->wButtons,
-                                XINPUT_GAMEPAD_LEFT_SHOULDER,
-                                &old_controller->left_shoulder,
-                                &new_controller->left_shoulder);
-                            Win32ProcessXInputDigitalButton(
-                                gamepad->wButtons,
-                                XINPUT_GAMEPAD_LEFT_SHOULDER,
-                                &old_controller->right_shoulder,
-                                &new_controller->right_shoulder);
-
-                            Win32ProcessXInputDigitalButton(
-                                gamepad->wButtons,
-                                XINPUT_GAMEPAD_X,
-                                &old_controller->action_left,
-                                &new_controller->action_left);
-                            Win32ProcessXInputDigitalButton(
-                                gamepad->wButtons,
-                                XINPUT_GAMEPAD_Y,
-                                &old_controller->action_up,
-                                &new_controller->action_up);
-                            Win32ProcessXInputDigitalButton(
-                                gamepad->wButtons,
-                                XINPUT_GAMEPAD_A,
-                                &old_controller->action_down,
-                                &new_controller->action_down);
-                            Win32ProcessXInputDigitalButton(
-                                gamepad->wButtons,
-                                XINPUT_GAMEPAD_B,
-                                &old_controller->action_right,
-                                &new_controller->action_right);
-
-                            // sticks
-                            new_controller->is_analog = true;
-                            new_controller->stick_avg_x =
-                                Win32NormalizeAnalogStickInput(gamepad->sThumbLX, XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE);
-                            new_controller->stick_avg_y =
-                                Win32NormalizeAnalogStickInput(gamepad->sThumbLY, XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE);
-
-                            bool dpad_up    = gamepad->wButtons & XINPUT_GAMEPAD_DPAD_UP;
-                            bool dpad_down  = gamepad->wButtons & XINPUT_GAMEPAD_DPAD_DOWN;
-                            bool dpad_left  = gamepad->wButtons & XINPUT_GAMEPAD_DPAD_LEFT;
-                            bool dpad_right = gamepad->wButtons & XINPUT_GAMEPAD_DPAD_RIGHT;
-                            if (dpad_up) {
-                                new_controller->stick_avg_y = -1.0;
-                                new_controller->is_analog   = false;
-                            }
-                            if (dpad_down) {
-                                new_controller->stick_avg_y = 1.0;
-                                new_controller->is_analog   = false;
-                            }
-                            if (dpad_left) {
-                                new_controller->stick_avg_x = -1.0;
-                                new_controller->is_analog   = false;
-                            }
-                            if (dpad_right) {
-                                new_controller->stick_avg_x = 1.0;
-                                new_controller->is_analog   = false;
-                            }
-                            float32_t threshold = 0.5f;
-                            Win32ProcessXInputDigitalButton(
-                                new_controller->stick_avg_x < -threshold ? 1 : 0,
-                                1,
-                                &old_controller->move_left,
-                                &new_controller->move_left);
-                            Win32ProcessXInputDigitalButton(
-                                new_controller->stick_avg_x > threshold ? 1 : 0,
-                                1,
-                                &old_controller->move_right,
-                                &new_controller->move_right);
-                            Win32ProcessXInputDigitalButton(
-                                new_controller->stick_avg_y < -threshold ? 1 : 0,
-                                1,
-                                &old_controller->move_up,
-                                &new_controller->move_up);
-                            Win32ProcessXInputDigitalButton(
-                                new_controller->stick_avg_y > threshold ? 1 : 0,
-                                1,
-                                &old_controller->move_down,
-                                &new_controller->move_down);
+                            Win32ProcessXInputGamepad(gamepad, old_controller, new_controller);
 
                             if (new_controller->back.ended_down) {
                                 g_app_running = false;
@@ -918,14 +2994,36 @@ WinMain(HINSTANCE instance, HINSTANCE prev_instance, LPSTR cmd_line, int show_cm
                             new_controller->is_connected = false;
                         }
                     }
+                    Win32ApplyGamepadEventTransitions(new_input);
 
                     Game_Offscreen_Buffer game_buffer = {};
 
                     game_buffer.bytes_per_pixel = g_backbuffer.bytes_per_pixel;
-                    game_buffer.width           = g_backbuffer.width;
-                    game_buffer.height          = g_backbuffer.height;
+                    // NOTE: the game renders into the top left of the backbuffer at the governor's scale
+                    float32_t render_scale      = g_resolution_steps[resolution_governor.step_idx];
+                    game_buffer.width           = (int)(render_scale * (float32_t)g_backbuffer.width);
+                    game_buffer.height          = (int)(render_scale * (float32_t)g_backbuffer.height);
+                    game_buffer.pitch           = g_backbuffer.pitch;
+                    game_buffer.pixel_format    = g_backbuffer.pixel_format;
                     game_buffer.memory          = g_backbuffer.memory;
-                    game.GameUpdateAndRender(&game_memory, new_input, &game_buffer);
+                    Win32BeginFramePhase(&frame_counters, Win32FramePhase_Update);
+                    if (is_netplay) {
+                        Win32UpdateNetplay(
+                            &netplay,
+                            new_keyboard_controller,
+                            game.GameUpdateAndRender,
+                            &game_memory,
+                            new_input,
+                            &game_buffer);
+                        if (netplay.is_out_of_sync) {
+                            OutputDebugStringA("netplay: stopped, running locally\n");
+                            Win32StopNetplay(&netplay);
+                            is_netplay = false;
+                        }
+                    } else {
+                        game.GameUpdateAndRender(&game_memory, new_input, &game_buffer);
+                    }
+                    Win32BeginFramePhase(&frame_counters, Win32FramePhase_Audio);
 
                     LARGE_INTEGER audio_wall_clock = Win32GetWallClock();
                     float32_t     from_beginning_to_audio_ms =
@@ -1007,15 +3105,31 @@ WinMain(HINSTANCE instance, HINSTANCE prev_instance, LPSTR cmd_line, int show_cm
                             bytes_to_write = target_cursor - byte_to_lock;
                         }
 
+                        // NOTE: byte_to_lock is where game_sample_idx goes, the flip is the projected play cursor
+                        // this many bytes away from it, either way round the ring
+                        DWORD   flip_byte = expected_sound_frame_boundary_byte % sound_output.secondary_buffer_size;
+                        int32_t buffer_size       = (int32_t)sound_output.secondary_buffer_size;
+                        int32_t flip_offset_bytes = (int32_t)flip_byte - (int32_t)byte_to_lock;
+                        if (flip_offset_bytes > buffer_size / 2) {
+                            flip_offset_bytes -= buffer_size;
+                        } else if (flip_offset_bytes < -buffer_size / 2) {
+                            flip_offset_bytes += buffer_size;
+                        }
+
                         Game_Sound_Output_Buffer sound_buffer = {};
                         // NOTE: samples per second: 48000, we only need 1/30 of a second, 2 channels
                         sound_buffer.samples_per_second = sound_output.samples_per_second;
                         sound_buffer.sample_count       = bytes_to_write / sound_output.bytes_per_sample;
                         sound_buffer.samples            = samples;
+                        sound_buffer.first_sample_idx   = sound_output.game_sample_idx;
+                        int64_t flip_sample_idx =
+                            (int64_t)sound_output.game_sample_idx + flip_offset_bytes / sound_output.bytes_per_sample;
+                        sound_buffer.flip_sample_idx = flip_sample_idx > 0 ? (uint64_t)flip_sample_idx : 0;
                         game.GameGetSoundSamples(&game_memory, &sound_buffer);
+                        sound_output.game_sample_idx += sound_buffer.sample_count;
 
 #if HANDMADE_INTERNAL
-                        Win32_Debug_Time_Marker* marker   = &debug_time_markers[debug_time_marker_idx];
+                        Debug_Audio_Marker* marker        = &debug_time_markers[debug_time_marker_idx];
                         marker->output_play_cursor        = play_cursor;
                         marker->output_write_cursor       = write_cursor;
                         marker->output_location           = byte_to_lock;
@@ -1050,11 +3164,25 @@ WinMain(HINSTANCE instance, HINSTANCE prev_instance, LPSTR cmd_line, int show_cm
                         is_sound_valid = false;
                     }
 
+                    Win32EndFramePhase(&frame_counters);
+
                     // TODO: enforcing the framerate
-                    LARGE_INTEGER work_counter         = Win32GetWallClock();
-                    float32_t     ms_elapsed_for_work  = Win32GetMilliSecondsElapsed(last_counter, work_counter);
-                    float32_t     ms_elapsed_for_frame = ms_elapsed_for_work;
-                    if (ms_elapsed_for_work < target_ms_per_frame) {
+                    LARGE_INTEGER work_counter        = Win32GetWallClock();
+                    float32_t     ms_elapsed_for_work = Win32GetMilliSecondsElapsed(last_counter, work_counter);
+
+                    // NOTE: idle tasks get the time the frame would spend waiting, the resolution governor only sees
+                    // the frame's own work
+                    float32_t idle_ms     = 0.0f;
+                    float32_t idle_end_ms = target_ms_per_frame - WIN32_IDLE_SAFETY_MS;
+                    if (idle_queue.task_count && ms_elapsed_for_work < idle_end_ms) {
+                        LARGE_INTEGER idle_deadline;
+                        idle_deadline.QuadPart =
+                            last_counter.QuadPart + (int64_t)(idle_end_ms * (float32_t)g_perf_count_freq / 1000.0f);
+                        idle_ms = Win32RunIdleTasks(&idle_queue, idle_deadline);
+                    }
+
+                    float32_t ms_elapsed_for_frame = Win32GetMilliSecondsElapsed(last_counter, Win32GetWallClock());
+                    if (ms_elapsed_for_frame < target_ms_per_frame) {
                         if (sleep_is_granular) {
                             DWORD sleep_ms = (DWORD)(target_ms_per_frame - ms_elapsed_for_frame);
                             if (sleep_ms > 0) {
@@ -1072,8 +3200,17 @@ WinMain(HINSTANCE instance, HINSTANCE prev_instance, LPSTR cmd_line, int show_cm
                             ms_elapsed_for_frame = Win32GetMilliSecondsElapsed(last_counter, Win32GetWallClock());
                         }
                         // Sleep for the rest of the frame time.
-                    } else {
-                        // TODO: logging missed frame
+                    }
+
+                    if (!fixed_resolution && Win32UpdateResolutionGovernor(&resolution_governor, ms_elapsed_for_work)) {
+                        char text_buffer[256];
+                        sprintf_s(
+                            text_buffer,
+                            "render scale %.0f%% (%.2fms of work, budget %.2fms)\n",
+                            100.0f * g_resolution_steps[resolution_governor.step_idx],
+                            ms_elapsed_for_work,
+                            target_ms_per_frame);
+                        OutputDebugStringA(text_buffer);
                     }
 
                     LARGE_INTEGER end_counter     = Win32GetWallClock();
@@ -1082,25 +3219,51 @@ WinMain(HINSTANCE instance, HINSTANCE prev_instance, LPSTR cmd_line, int show_cm
                     float32_t ms_per_frame  = Win32GetMilliSecondsElapsed(last_counter, end_counter);
                     uint64_t  cycle_elapsed = end_cycle_count - last_cycle_count;
                     float32_t mc_per_frame  = cycle_elapsed / 1000.0f / 1000.0f;
-                    char      buffer[256];
-                    sprintf_s(buffer, "%.2f ms/f,  %.2f mc/f\n", ms_per_frame, mc_per_frame);
+                    char      buffer[512];
+                    sprintf_s(
+                        buffer, "%.2f ms/f,  %.2f mc/f,  %.2f ms idle tasks\n", ms_per_frame, mc_per_frame, idle_ms);
                     OutputDebugStringA(buffer);
 
                     // timing
                     last_counter     = end_counter;
                     last_cycle_count = end_cycle_count;
 
+                    Win32BeginFramePhase(&frame_counters, Win32FramePhase_Present);
+                    if (game_buffer.width == g_backbuffer.width && game_buffer.height == g_backbuffer.height) {
+                        g_display_buffer = &g_backbuffer;
+                    } else {
+                        Win32UpscaleBuffer(&g_backbuffer, game_buffer.width, game_buffer.height, &g_upscaled_buffer);
+                        g_display_buffer = &g_upscaled_buffer;
+                    }
+
                     Win32_Window_Dimension dimension = Win32GetWindowDimension(window_handle);
 #if HANDMADE_INTERNAL
-                    Win32DebugSyncDisplay(
-                        &g_backbuffer,
-                        ArrayCount(debug_time_markers),
-                        debug_time_marker_idx - 1,
-                        debug_time_markers,
-                        &sound_output);
+                    if (g_show_debug_overlay) {
+                        Win32DrawDebugOverlay(
+                            &g_debug_overlay,
+                            g_display_buffer,
+                            debug_time_markers,
+                            ArrayCount(debug_time_markers),
+                            debug_time_marker_idx - 1,
+                            &sound_output,
+                            render_scale,
+                            audio_latency_seconds);
+                    }
 #endif
-                    Win32DisplayBufferInWindow(device_ctx, dimension.width, dimension.height, g_backbuffer);
+                    Win32DisplayBufferInWindow(device_ctx, dimension.width, dimension.height, *g_display_buffer);
                     flip_wall_clock = Win32GetWallClock();
+                    Win32RecordLatencyPresent(
+                        &latency_tracker, new_input->consumed_latency_tag, flip_wall_clock.QuadPart);
+                    Win32EndFramePhase(&frame_counters);
+                    ++frame_counters.frame_count;
+#if HANDMADE_INTERNAL
+                    Win32RecordDebugOverlayFrame(&g_debug_overlay, &frame_counters, ms_per_frame);
+                    // NOTE: once a second, averaged over the frames since the last report
+                    if (frame_counters.frame_count >= GAME_REFRESH_HZ) {
+                        Win32FormatFrameCounters(&frame_counters, buffer, sizeof(buffer));
+                        OutputDebugStringA(buffer);
+                    }
+#endif
 
 #if HANDMADE_INTERNAL
                     // record flip sound cursors
@@ -1110,7 +3273,7 @@ WinMain(HINSTANCE instance, HINSTANCE prev_instance, LPSTR cmd_line, int show_cm
                         g_dsound_secondary_buffer->GetCurrentPosition(&flip_play_cursor, &flip_write_cursor);
 
                         Assert(debug_time_marker_idx < ArrayCount(debug_time_markers));
-                        Win32_Debug_Time_Marker* marker = &debug_time_markers[debug_time_marker_idx];
+                        Debug_Audio_Marker* marker = &debug_time_markers[debug_time_marker_idx];
 
                         marker->flip_play_cursor  = flip_play_cursor;
                         marker->flip_write_cursor = flip_write_cursor;
@@ -1121,6 +3284,11 @@ WinMain(HINSTANCE instance, HINSTANCE prev_instance, LPSTR cmd_line, int show_cm
                     }
 #endif
 
+                    if (g_write_memory_report) {
+                        Win32WriteMemoryReport(WIN32_MEMORY_REPORT_FILE_NAME, &game_memory);
+                        g_write_memory_report = false;
+                    }
+
                     // swap old and new inputs
                     // TODO: make a swap macro?
                     Game_Input* temp = new_input;
@@ -1128,6 +3296,23 @@ WinMain(HINSTANCE instance, HINSTANCE prev_instance, LPSTR cmd_line, int show_cm
                     old_input        = temp;
                 } // game loop
             }
+
+            // NOTE: the world's changes go to its file, and don't cut off a save that is still being written
+            Win32CompleteAllWork(&work_queue);
+            Win32FinishIdleTasks(&idle_queue);
+            game.GameShutdown(&game_memory);
+            Win32CompleteAllWork(&io_queue);
+            Win32WriteMemoryReport(WIN32_MEMORY_REPORT_FILE_NAME, &game_memory);
+
+            if (latency_tracker.is_enabled) {
+                char report[4096];
+                Win32FormatLatencyReport(&latency_tracker, report, sizeof(report));
+                OutputDebugStringA(report);
+            }
+
+            if (is_netplay) {
+                Win32StopNetplay(&netplay);
+            }
         }
     } else {
         // handle error
@@ -2,15 +2,24 @@
 #define WIN32_HANDMADE_H
 
 #include <stdint.h>
+#include <winsock2.h>
 #include <Windows.h>
 #include "handmade.h"
 
+// NOTE: BI_BITFIELDS wants the red, green and blue masks right after the header, BITMAPINFO only has room for one
+struct Win32_Bitmap_Info {
+    BITMAPINFOHEADER bmiHeader;
+    DWORD            color_masks[3];
+};
+
 struct Win32_Offscreen_Buffer {
-    BITMAPINFO info;
-    void*      memory;
-    int        width;
-    int        height;
-    int        bytes_per_pixel;
+    Win32_Bitmap_Info info;
+    void*             memory;
+    int               width;
+    int               height;
+    int               pitch;
+    int               bytes_per_pixel;
+    int               pixel_format; // Game_Pixel_Format
 };
 
 struct Win32_Window_Dimension {
@@ -25,22 +34,352 @@ struct Win32_Sound_Output {
     uint32_t running_sample_idx;
     int      bytes_per_sample;
     uint32_t secondary_buffer_size;
+    uint64_t game_sample_idx; // NOTE: next sample the game mixes, only goes up by what it mixed, even through a resync
 
     int latency_sample_count;
     int safety_bytes;
 };
 
-struct Win32_Debug_Time_Marker {
-    // when outputing sound
-    DWORD output_play_cursor;
-    DWORD output_write_cursor;
-    DWORD output_location;
-    DWORD output_bytes;
+// NOTE: what the platform allocates itself, by what it's for. Game storage is a single tag here, the game's arenas
+// break down what's in it (see Memory_Tag). Allocations and frees happen on the main thread.
+enum Win32_Memory_Tag {
+    Win32MemoryTag_GameStorage,
+    Win32MemoryTag_Framebuffer,
+    Win32MemoryTag_Sound,
+    Win32MemoryTag_SaveState,
+    Win32MemoryTag_Rollback,
+    Win32MemoryTag_DebugFile,
+
+    Win32MemoryTag_Count,
+};
+
+// NOTE: a "key value" line for every number, sizes in bytes, so the reports of two runs diff line by line
+#define WIN32_MEMORY_REPORT_FILE_NAME "handmade_memory.txt"
+#define WIN32_MEMORY_REPORT_VERSION   1
+#define WIN32_RESIDENCY_BATCH_PAGES   4096 // pages asked about per QueryWorkingSetEx call
+
+// NOTE: bounded multi-producer/multi-consumer ring, each entry carries a sequence number that tells producers and
+// consumers whose turn it is on that slot (see Dmitry Vyukov's bounded MPMC queue).
+#define WORK_QUEUE_ENTRY_COUNT 1024
+#define WORK_QUEUE_MAX_THREADS 32
+
+struct Platform_Work_Queue_Entry {
+    volatile LONG64               sequence;
+    platform_work_queue_callback* callback;
+    void*                         data;
+};
+
+struct Platform_Work_Queue {
+    // NOTE: producers and consumers hammer different counters, keep them on separate cache lines.
+    volatile LONG64 enqueue_pos;
+    uint8_t         pad0[64 - sizeof(LONG64)];
+    volatile LONG64 dequeue_pos;
+    uint8_t         pad1[64 - sizeof(LONG64)];
+    volatile LONG64 completion_goal;
+    volatile LONG64 completion_count;
+    uint8_t         pad2[64 - 2 * sizeof(LONG64)];
+
+    HANDLE semaphore_handle;
+    int    thread_count;
+
+    Platform_Work_Queue_Entry entries[WORK_QUEUE_ENTRY_COUNT];
+};
+
+struct Win32_Thread_Info {
+    int                  logical_thread_idx;
+    Platform_Work_Queue* queue;
+};
+
+// NOTE: idle tasks run on the main thread between the end of a frame's work and WIN32_IDLE_SAFETY_MS before its
+// deadline, which leaves room for Sleep's granularity and a task's step that runs long
+#define WIN32_MAX_IDLE_TASKS 64
+#define WIN32_IDLE_SAFETY_MS 2.0f
+
+struct Win32_Idle_Task {
+    platform_idle_task_callback* callback;
+    void*                        data;
+};
+
+struct Platform_Idle_Queue {
+    uint32_t        task_count;
+    uint32_t        next_task_idx; // NOTE: the frame after the deadline cut the list short starts where it stopped
+    int64_t         deadline;      // performance counter
+    bool            must_finish;   // tasks never have to yield, set while they're run to the end
+    Win32_Idle_Task tasks[WIN32_MAX_IDLE_TASKS];
+
+    // NOTE: since the queue was made
+    uint64_t  call_count;
+    uint64_t  finished_count;
+    float32_t total_ms;
+    float32_t max_overrun_ms; // past the deadline, what the safety margin is there to absorb
+};
+
+// NOTE: async file ops are overlapped I/O, when the kernel refuses to queue one it runs on the I/O threads instead
+#define WIN32_MAX_FILE_OPS 256
+
+enum Win32_File_Op_State {
+    Win32FileOp_Free,
+    Win32FileOp_Reserved,
+    Win32FileOp_Overlapped,
+    Win32FileOp_Queued,
+    Win32FileOp_Complete,
+    Win32FileOp_Failed,
+};
+
+struct Win32_File_Op {
+    OVERLAPPED overlapped;
+    HANDLE     file_handle;
+    void*      memory;
+    uint32_t   size;
+    bool       is_write;
+
+    volatile LONG state;
+    volatile LONG generation;
+    DWORD         bytes_transferred;
+};
+
+struct Win32_File_IO {
+    Win32_File_Op        ops[WIN32_MAX_FILE_OPS];
+    Platform_Work_Queue* fallback_queue;
+    volatile LONG        next_slot;
+
+    // NOTE: sends every op through the fallback threads, for measuring that path
+    bool force_fallback;
+};
+
+// NOTE: input events from the message loop, the XInput poll thread and Win32InjectInputEvent all go through this
+// ring, the frame thread drains it into Game_Input once per frame. Same sequence scheme as the work queue.
+#define INPUT_EVENT_QUEUE_COUNT 1024
+#define WIN32_MAX_GAMEPADS      4
+
+struct Win32_Input_Event_Queue_Entry {
+    volatile LONG64  sequence;
+    Game_Input_Event event;
+};
+
+struct Win32_Input_Event_Queue {
+    volatile LONG64 enqueue_pos;
+    uint8_t         pad0[64 - sizeof(LONG64)];
+    LONG64          dequeue_pos; // NOTE: only the frame thread consumes
+    volatile LONG   dropped_count;
+
+    Win32_Input_Event_Queue_Entry entries[INPUT_EVENT_QUEUE_COUNT];
+};
+
+// NOTE: samples the gamepads much faster than the frame rate so changes get a timestamp close to when they happened
+struct Win32_XInput_Poller {
+    Win32_Input_Event_Queue* queue;
+
+    // NOTE: last state seen per gamepad, changes against it become events
+    Game_Controller_Input controllers[WIN32_MAX_GAMEPADS];
+    DWORD                 packet_numbers[WIN32_MAX_GAMEPADS];
+};
+
+// NOTE: input-to-present latency. Presses get a tag when they are drained into Game_Input, the game reports the tag
+// it acted on and the time the frame carrying it reaches the window goes into the histogram.
+#define LATENCY_PENDING_COUNT 256
+#define LATENCY_BUCKET_COUNT  64 // 1ms each, the last bucket collects everything slower
+
+struct Win32_Latency_Pending {
+    uint32_t tag;
+    int64_t  input_timestamp;
+};
+
+struct Win32_Latency_Tracker {
+    bool     is_enabled;
+    uint32_t next_tag;
+    uint32_t last_consumed_tag;
+
+    Win32_Latency_Pending pending[LATENCY_PENDING_COUNT];
+
+    uint32_t  buckets[LATENCY_BUCKET_COUNT];
+    uint32_t  sample_count;
+    float32_t min_ms;
+    float32_t max_ms;
+    float32_t total_ms;
+};
+
+// NOTE: render resolution governor. The game renders into the top left of the backbuffer at a scale picked from
+// recent frame costs, the platform upscales that to the full buffer. Dropping a step needs a few frames over budget,
+// raising one needs many frames well under it, so the scale doesn't oscillate around the budget.
+#define RESOLUTION_STEP_COUNT      6
+#define RESOLUTION_DROP_FRACTION   0.9f  // of the budget, average cost above this counts as over
+#define RESOLUTION_RAISE_FRACTION  0.65f // predicted cost at the next step up has to stay below this
+#define RESOLUTION_DROP_FRAMES     4
+#define RESOLUTION_RAISE_FRAMES    30
+#define RESOLUTION_COOLDOWN_FRAMES 15
 
-    // when doing frame flip, at the end of each frame
-    DWORD expected_flip_play_cursor;
-    DWORD flip_play_cursor;
-    DWORD flip_write_cursor;
+struct Win32_Resolution_Governor {
+    float32_t budget_ms;
+    int       step_idx; // 0 is full resolution
+    float32_t average_ms;
+    int       frames_over;
+    int       frames_under;
+    int       cooldown_frames;
+};
+
+// NOTE: counters for each phase of the frame. Wall clock and TSC always work. Thread cycles come from
+// QueryThreadCycleTime and leave out the time the frame thread was switched out. Instructions retired and unhalted
+// core cycles are the fixed PMCs, they are only there when the machine lets user mode read them.
+#define WIN32_PMC_FIXED_INSTRUCTIONS ((1ul << 30) | 0)
+#define WIN32_PMC_FIXED_CORE_CYCLES  ((1ul << 30) | 1)
+
+enum Win32_Frame_Phase {
+    Win32FramePhase_Input,
+    Win32FramePhase_Update,
+    Win32FramePhase_Audio,
+    Win32FramePhase_Present,
+
+    Win32FramePhase_Count,
+};
+
+// NOTE: of the target frame time, what the in-game debug overlay may cost before it drops detail
+#define DEBUG_OVERLAY_BUDGET_FRACTION 0.05f
+
+struct Win32_Phase_Counters {
+    int64_t  wall; // QPC ticks
+    uint64_t tsc;
+    uint64_t thread_cycles;
+    uint64_t instructions;
+    uint64_t core_cycles;
+};
+
+struct Win32_Frame_Counters {
+    HANDLE thread_handle;
+    bool   has_pmc;
+
+    int                  current_phase; // -1 between frames
+    Win32_Phase_Counters phase_start;
+    Win32_Phase_Counters phases[Win32FramePhase_Count]; // summed since the last report
+    int                  frame_count;
+
+    int64_t frame_wall[Win32FramePhase_Count]; // the last frame only, the input phase starts the next one
+};
+
+// NOTE: save states. Permanent storage is allocated with MEM_WRITE_WATCH and mirrored by a shadow copy, so taking a
+// snapshot only copies the pages written since the last one. A worker compresses the shadow, writes it next to the old
+// save, flushes it and renames it over, a crash leaves either the old or the new save behind.
+#define SAVE_FILE_NAME       "handmade.hhs"
+#define SAVE_FILE_MAGIC      RIFF_CODE('h', 'h', 's', 'v')
+#define SAVE_FILE_VERSION    1
+#define SAVE_FILE_BLOCK_SIZE MegaBytes(1)
+
+// NOTE: the header is followed by block_count blocks of [uint32_t size][data], a block whose size is its
+// uncompressed size is stored as is
+#pragma pack(push, 1)
+struct Save_File_Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t block_size;
+    uint32_t block_count;
+    uint64_t storage_size;
+    uint64_t file_size;
+};
+#pragma pack(pop)
+
+enum Win32_Save_State {
+    Win32Save_Idle,
+    Win32Save_Saving,
+    Win32Save_Saved,
+    Win32Save_Loading,
+    Win32Save_Loaded,
+};
+
+struct Win32_Save_System {
+    uint8_t* storage;
+    uint64_t storage_size;
+    uint8_t* shadow;
+    bool     has_write_watch; // NOTE: without it every snapshot copies all of the storage
+
+    // NOTE: write watch has one set of dirty bits, Win32CollectWrittenPages hands them out and keeps a copy here for
+    // the next snapshot
+    void**    dirty_pages;
+    ULONG_PTR max_dirty_pages;
+    DWORD     page_size;
+    uint8_t*  unsaved_pages; // one byte per page
+
+    uint8_t* file_memory; // header and compressed blocks
+    uint64_t file_capacity;
+
+    Platform_Work_Queue* queue;
+    volatile LONG        state;
+    int                  requested_state; // NOTE: Win32Save_Saving or Win32Save_Loading from the F5/F9 keys
+    bool                 succeeded;
+    char                 file_name[MAX_PATH];
+
+    float32_t snapshot_ms; // frame thread
+    uint64_t  snapshot_bytes;
+    float32_t compress_ms;
+    float32_t write_ms; // write, flush and rename
+    float32_t load_ms;  // read and decompress
+    uint64_t  file_size;
+};
+
+// NOTE: rollback keeps, for each of the last ROLLBACK_MAX_FRAMES frames, the pages of permanent storage the frame wrote
+// as an XOR against what they held before, all of the frame's pages LZ compressed together. Undoing a frame XORs them
+// back in. The pages a frame wrote come from the save system's write watch.
+#define ROLLBACK_MAX_FRAMES     8
+#define ROLLBACK_FRAME_CAPACITY MegaBytes(2)
+
+struct Win32_Rollback_Frame {
+    int64_t  frame_idx; // -1 when empty or when the frame wrote too much to keep
+    uint32_t page_count;
+    uint32_t data_size;
+    uint8_t* data; // page_count uint32_t page numbers, then the xor of those pages one after another, compressed
+};
+
+struct Win32_Rollback {
+    Win32_Save_System* save;
+    uint8_t*           mirror;    // storage as of the last recorded frame
+    uint8_t*           scratch;   // ROLLBACK_FRAME_CAPACITY, the xor of a frame's pages before compression
+    int64_t            frame_idx; // the next frame to be recorded
+
+    Win32_Rollback_Frame frames[ROLLBACK_MAX_FRAMES];
+};
+
+// NOTE: rollback netplay between two instances. Every frame each side sends its recent inputs to the other, the
+// remote input for frames that haven't arrived yet is predicted as unchanged. When the real input turns out different
+// the game state is rolled back to that frame and simulated forward again.
+#define NETPLAY_PORT        27015 // player n listens on NETPLAY_PORT + n
+#define NETPLAY_MAGIC       RIFF_CODE('h', 'h', 'n', 'p')
+#define NETPLAY_SEND_FRAMES 8 // inputs repeated in every packet so a lost one doesn't matter
+#define NETPLAY_INPUT_RING  64
+
+#pragma pack(push, 1)
+struct Net_Input {
+    uint16_t  buttons; // bit per Game_Controller_Input::buttons, set when ended_down
+    uint8_t   is_analog;
+    uint8_t   pad;
+    float32_t stick_x;
+    float32_t stick_y;
+};
+
+struct Net_Input_Packet {
+    uint32_t  magic;
+    int64_t   first_frame_idx;
+    uint32_t  input_count;
+    Net_Input inputs[NETPLAY_SEND_FRAMES];
+};
+#pragma pack(pop)
+
+struct Win32_Netplay {
+    SOCKET      socket;
+    sockaddr_in peer_address;
+    int         local_player; // 0 or 1, also the controller index the player's input goes to
+
+    Win32_Rollback* rollback;
+    int64_t         frame_idx; // next frame to simulate
+
+    Net_Input local_inputs[NETPLAY_INPUT_RING];
+    Net_Input remote_inputs[NETPLAY_INPUT_RING]; // real up to remote_confirmed_idx, predicted after
+    int64_t   remote_confirmed_idx;              // -1 until anything arrived
+
+    uint32_t rollback_count;
+    uint32_t resimulated_frame_count;
+    uint32_t max_rollback_depth;
+    uint32_t stall_count; // frames held back because the prediction would reach past the rollback window
+
+    bool is_out_of_sync; // a misprediction couldn't be rolled back, the session is over
 };
 
 struct Win32_Game_Code {
@@ -49,8 +388,38 @@ struct Win32_Game_Code {
 
     game_get_sound_samples* GameGetSoundSamples;
     game_update_and_render* GameUpdateAndRender;
+    game_shutdown*          GameShutdown;
 
     bool is_valid;
 };
 
+// NOTE: the game dll is reloaded when the directory change notification fires. Copying and loading the new dll
+// happens on a background thread, the frame thread only swaps the function pointers once it is ready. The notification
+// fires while the linker is still writing the dll, a load that fails is queued again on the next frame, up to
+// WIN32_RELOAD_MAX_ATTEMPTS times for one build.
+#define WIN32_RELOAD_MAX_ATTEMPTS 100
+
+enum Win32_Game_Code_Reload_State {
+    Win32Reload_Idle,
+    Win32Reload_Loading,
+    Win32Reload_Ready,
+};
+
+struct Win32_Game_Code_Reloader {
+    char source_dll_path[MAX_PATH];
+    // NOTE: the new dll is loaded while the old one is still in use, so the temp copies alternate
+    char temp_dll_paths[2][MAX_PATH];
+    int  next_temp_idx;
+
+    HANDLE               change_handle; // INVALID_HANDLE_VALUE falls back to checking the write time every frame
+    Platform_Work_Queue* load_queue;
+
+    volatile LONG   state;
+    Win32_Game_Code pending;
+    int             failed_attempt_count; // for the build on disk, 0 once it loaded or was given up on
+
+    float32_t load_ms;  // background copy + LoadLibrary
+    float32_t stall_ms; // time the frame thread spent on the swap
+};
+
 #endif